@@ -0,0 +1,43 @@
+﻿
+#pragma once
+
+#include <cstdint>
+
+#include "base/array.hpp"
+
+namespace principia {
+namespace base {
+
+// An encoding of bytes as text, with the URL and filename safe alphabet of
+// RFC 4648, section 5, and without padding.  It produces 4 characters for 3
+// bytes, instead of 6 for the hexadecimal encoding.  The output contains no
+// "//", which KSP would take as the start of a comment if it were stored in a
+// configuration node.
+
+// The number of characters produced by encoding |byte_count| bytes.
+inline std::int64_t Base64EncodedSize(std::int64_t byte_count);
+
+// The number of bytes produced by decoding |character_count| characters.
+inline std::int64_t Base64DecodedSize(std::int64_t character_count);
+
+// |input| and |output| must not overlap.  |output.size| must be at least
+// |Base64EncodedSize(input.size)|.  The range
+// [&output.data[Base64EncodedSize(input.size)], &output.data[output.size][ is
+// left unmodified.
+inline void Base64Encode(Array<std::uint8_t const> input,
+                         Array<std::uint8_t> output);
+
+// Invalid characters are read as 0.  If |input.size % 4 == 1|, the last
+// character of the input is ignored.  |output.data <= input.data| or
+// |&input.data[input.size] <= output.data| must hold, in particular,
+// |input.data == output.data| is valid.  |output.size| must be at least
+// |Base64DecodedSize(input.size)|.  The range
+// [&output.data[Base64DecodedSize(input.size)], &output.data[output.size][ is
+// left unmodified.
+inline void Base64Decode(Array<std::uint8_t const> input,
+                         Array<std::uint8_t> output);
+
+}  // namespace base
+}  // namespace principia
+
+#include "base/base64_body.hpp"
@@ -0,0 +1,143 @@
+﻿
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#include "base/base64.hpp"
+#include "glog/logging.h"
+
+namespace principia {
+namespace base {
+namespace internal_base64 {
+
+constexpr char sextet_to_character[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+// The two characters that encode each 12-bit value, so that the encoder does
+// one lookup for every 1.5 bytes of input, much like the hexadecimal encoder
+// does one lookup per byte.
+inline std::array<char, 2 << 12> const& DuodecetToCharacters() {
+  static auto const* const duodecet_to_characters = []() {
+    auto* const result = new std::array<char, 2 << 12>;
+    for (int duodecet = 0; duodecet < 1 << 12; ++duodecet) {
+      (*result)[2 * duodecet] = sextet_to_character[duodecet >> 6];
+      (*result)[2 * duodecet + 1] = sextet_to_character[duodecet & 0x3F];
+    }
+    return result;
+  }();
+  return *duodecet_to_characters;
+}
+
+// Invalid characters map to 0.
+inline std::array<std::uint8_t, 256> const& CharacterToSextet() {
+  static auto const* const character_to_sextet = []() {
+    auto* const result = new std::array<std::uint8_t, 256>();
+    for (std::uint8_t sextet = 0; sextet < 64; ++sextet) {
+      (*result)[static_cast<std::uint8_t>(sextet_to_character[sextet])] =
+          sextet;
+    }
+    return result;
+  }();
+  return *character_to_sextet;
+}
+
+}  // namespace internal_base64
+
+inline std::int64_t Base64EncodedSize(std::int64_t const byte_count) {
+  // The last one or two bytes, if any, take two or three characters.
+  return (4 * byte_count + 2) / 3;
+}
+
+inline std::int64_t Base64DecodedSize(std::int64_t const character_count) {
+  // A single trailing character does not encode a whole byte and is ignored.
+  return 3 * (character_count >> 2) + std::max<std::int64_t>(
+                                          0, (character_count & 3) - 1);
+}
+
+inline void Base64Encode(Array<std::uint8_t const> input,
+                         Array<std::uint8_t> output) {
+  using internal_base64::sextet_to_character;
+  CHECK_NOTNULL(input.data);
+  CHECK_NOTNULL(output.data);
+  std::int64_t const encoded_size = Base64EncodedSize(input.size);
+  CHECK(&input.data[input.size] <= output.data ||
+        &output.data[encoded_size] <= input.data) << "bad overlap";
+  CHECK_GE(output.size, encoded_size) << "output too small";
+  auto const& duodecet_to_characters =
+      internal_base64::DuodecetToCharacters();
+  std::uint8_t const* const input_end =
+      input.data + input.size - input.size % 3;
+  for (; input.data != input_end; input.data += 3, output.data += 4) {
+    std::uint32_t const bits = (input.data[0] << 16) |
+                               (input.data[1] << 8) |
+                               input.data[2];
+    std::memcpy(output.data, &duodecet_to_characters[2 * (bits >> 12)], 2);
+    std::memcpy(&output.data[2],
+                &duodecet_to_characters[2 * (bits & 0xFFF)],
+                2);
+  }
+  // The last one or two bytes, if any, are not padded.
+  switch (input.size % 3) {
+    case 1: {
+      std::uint32_t const bits = input.data[0] << 16;
+      output.data[0] = sextet_to_character[bits >> 18];
+      output.data[1] = sextet_to_character[(bits >> 12) & 0x3F];
+      break;
+    }
+    case 2: {
+      std::uint32_t const bits = (input.data[0] << 16) | (input.data[1] << 8);
+      output.data[0] = sextet_to_character[bits >> 18];
+      output.data[1] = sextet_to_character[(bits >> 12) & 0x3F];
+      output.data[2] = sextet_to_character[(bits >> 6) & 0x3F];
+      break;
+    }
+  }
+}
+
+inline void Base64Decode(Array<std::uint8_t const> input,
+                         Array<std::uint8_t> output) {
+  CHECK_NOTNULL(input.data);
+  CHECK_NOTNULL(output.data);
+  std::int64_t const decoded_size = Base64DecodedSize(input.size);
+  // |output <= input| is valid because we write at most three bytes of output
+  // after reading four characters of input.  Greater values of |output| would
+  // overwrite input data before it is read, unless there is no overlap, i.e.,
+  // |&input[input_size] <= output|.
+  CHECK(output.data <= input.data ||
+        &input.data[input.size] <= output.data) << "bad overlap";
+  CHECK_GE(output.size, decoded_size) << "output too small";
+  auto const& character_to_sextet = internal_base64::CharacterToSextet();
+  std::uint8_t const* const input_end = input.data + (input.size & ~3);
+  for (; input.data != input_end; input.data += 4, output.data += 3) {
+    std::uint32_t const bits = (character_to_sextet[input.data[0]] << 18) |
+                               (character_to_sextet[input.data[1]] << 12) |
+                               (character_to_sextet[input.data[2]] << 6) |
+                               character_to_sextet[input.data[3]];
+    output.data[0] = static_cast<std::uint8_t>(bits >> 16);
+    output.data[1] = static_cast<std::uint8_t>(bits >> 8);
+    output.data[2] = static_cast<std::uint8_t>(bits);
+  }
+  // The last two or three characters, if any, encode one or two bytes.
+  switch (input.size & 3) {
+    case 2: {
+      std::uint32_t const bits = (character_to_sextet[input.data[0]] << 18) |
+                                 (character_to_sextet[input.data[1]] << 12);
+      output.data[0] = static_cast<std::uint8_t>(bits >> 16);
+      break;
+    }
+    case 3: {
+      std::uint32_t const bits = (character_to_sextet[input.data[0]] << 18) |
+                                 (character_to_sextet[input.data[1]] << 12) |
+                                 (character_to_sextet[input.data[2]] << 6);
+      output.data[0] = static_cast<std::uint8_t>(bits >> 16);
+      output.data[1] = static_cast<std::uint8_t>(bits >> 8);
+      break;
+    }
+  }
+}
+
+}  // namespace base
+}  // namespace principia
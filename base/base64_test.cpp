@@ -0,0 +1,139 @@
+﻿
+#include "base/base64.hpp"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "base/array.hpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::Each;
+using testing::ElementsAre;
+
+namespace principia {
+namespace base {
+
+class Base64Test : public testing::Test {
+ protected:
+  // Encodes |bytes| and returns the result as a string.
+  static std::string Encode(std::string const& bytes) {
+    std::string characters(Base64EncodedSize(bytes.size()), '\0');
+    Base64Encode(
+        {reinterpret_cast<std::uint8_t const*>(bytes.data()), bytes.size()},
+        {reinterpret_cast<std::uint8_t*>(&characters[0]), characters.size()});
+    return characters;
+  }
+
+  // Decodes |characters| and returns the result as a string.
+  static std::string Decode(std::string const& characters) {
+    Array<std::uint8_t const> const input(
+        reinterpret_cast<std::uint8_t const*>(characters.data()),
+        characters.size());
+    std::string bytes(Base64DecodedSize(input.size), '\0');
+    Base64Decode(input,
+                 {reinterpret_cast<std::uint8_t*>(&bytes[0]), bytes.size()});
+    return bytes;
+  }
+};
+
+using Base64DeathTest = Base64Test;
+
+// The test vectors of RFC 4648, section 10, without the padding.
+TEST_F(Base64Test, RFC4648) {
+  EXPECT_EQ("", Encode(""));
+  EXPECT_EQ("Zg", Encode("f"));
+  EXPECT_EQ("Zm8", Encode("fo"));
+  EXPECT_EQ("Zm9v", Encode("foo"));
+  EXPECT_EQ("Zm9vYg", Encode("foob"));
+  EXPECT_EQ("Zm9vYmE", Encode("fooba"));
+  EXPECT_EQ("Zm9vYmFy", Encode("foobar"));
+
+  EXPECT_EQ("", Decode(""));
+  EXPECT_EQ("f", Decode("Zg"));
+  EXPECT_EQ("fo", Decode("Zm8"));
+  EXPECT_EQ("foo", Decode("Zm9v"));
+  EXPECT_EQ("foob", Decode("Zm9vYg"));
+  EXPECT_EQ("fooba", Decode("Zm9vYmE"));
+  EXPECT_EQ("foobar", Decode("Zm9vYmFy"));
+}
+
+// These bytes are "+/+///A=" in the standard alphabet, and that "//" would
+// start a comment in a KSP configuration node.
+TEST_F(Base64Test, UrlSafe) {
+  std::string const bytes("\xFB\xFF\xBF\xFF\xF0", 5);
+  std::string const characters = Encode(bytes);
+  EXPECT_EQ("-_-___A", characters);
+  EXPECT_EQ(bytes, Decode(characters));
+}
+
+TEST_F(Base64Test, AllBytes) {
+  std::string bytes;
+  for (int i = 0; i < 3 * 256 + 1; ++i) {
+    bytes.push_back(static_cast<char>((i * 7) & 0xFF));
+  }
+  std::string const characters = Encode(bytes);
+  EXPECT_EQ(4 * 256 + 2, static_cast<int>(characters.size()));
+  EXPECT_EQ(bytes, Decode(characters));
+}
+
+TEST_F(Base64Test, InPlace) {
+  std::string const bytes("\0\x7F\x80\xFFgh\n\7", 8);
+  std::string buffer = Encode(bytes);
+  Array<std::uint8_t const> const input(
+      reinterpret_cast<std::uint8_t const*>(buffer.data()), buffer.size());
+  Base64Decode(input, {reinterpret_cast<std::uint8_t*>(&buffer[0]), 8});
+  EXPECT_EQ(bytes, buffer.substr(0, 8));
+}
+
+TEST_F(Base64Test, LargeOutput) {
+  std::vector<std::uint8_t> const bytes = {'f', 'o', 'o', 'b'};
+  std::vector<std::uint8_t> characters(6 + 42, 'X');
+  Base64Encode({bytes.data(), bytes.size()},
+               {characters.data(), characters.size()});
+  EXPECT_EQ("Zm9vYg", std::string(characters.begin(),
+                                  characters.begin() + 6));
+  EXPECT_THAT(std::vector<std::uint8_t>(characters.begin() + 6,
+                                        characters.end()),
+              Each('X'));
+  std::vector<std::uint8_t> decoded(4 + 42, 'Y');
+  Base64Decode({characters.data(), 6}, {decoded.data(), decoded.size()});
+  EXPECT_EQ(bytes, std::vector<std::uint8_t>(decoded.begin(),
+                                             decoded.begin() + 4));
+  EXPECT_THAT(std::vector<std::uint8_t>(decoded.begin() + 4, decoded.end()),
+              Each('Y'));
+}
+
+TEST_F(Base64Test, Invalid) {
+  // Invalid characters are read as 0, a single trailing character is ignored.
+  EXPECT_EQ(std::string("\0\0\0", 3), Decode("!!!!"));
+  EXPECT_EQ(std::string("\0\0\0", 3), Decode("+/=="));
+  EXPECT_EQ("foo", Decode("Zm9vY"));
+}
+
+TEST_F(Base64DeathTest, Overlap) {
+  std::vector<std::uint8_t> buffer(8);
+  EXPECT_DEATH({
+    Base64Encode({&buffer[0], 3}, {&buffer[2], 4});
+  }, "bad overlap");
+  EXPECT_DEATH({
+    Base64Decode({&buffer[0], 4}, {&buffer[1], 3});
+  }, "bad overlap");
+}
+
+TEST_F(Base64DeathTest, Size) {
+  std::vector<std::uint8_t> bytes(3);
+  std::vector<std::uint8_t> characters = {'Z', 'm', '9', 'v'};
+  EXPECT_DEATH({
+    Base64Encode({bytes.data(), bytes.size()},
+                 {characters.data(), characters.size() - 1});
+  }, "too small");
+  EXPECT_DEATH({
+    Base64Decode({characters.data(), characters.size()},
+                 {bytes.data(), bytes.size() - 1});
+  }, "too small");
+}
+
+}  // namespace base
+}  // namespace principia
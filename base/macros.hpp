@@ -70,6 +70,16 @@ char const* const Architecture = "x86-64";
 #error "Have you tried a Cray-1?"
 #endif
 
+// The SIMD instruction sets that the compiler may target.  SSE2 is part of
+// x86-64.
+#if defined(__AVX__)
+#define PRINCIPIA_USE_AVX 1
+#endif
+#if defined(__SSE2__) || ARCH_CPU_X86_64 || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PRINCIPIA_USE_SSE2 1
+#endif
+
 #if defined(CDECL)
 #  error "CDECL already defined"
 #else
@@ -0,0 +1,138 @@
+﻿
+#include "base/mapped_file.hpp"
+
+#if OS_WIN
+#define NOGDI
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "glog/logging.h"
+
+namespace principia {
+namespace base {
+
+#if OS_WIN
+
+std::unique_ptr<MappedFile const> MappedFile::Open(
+    std::experimental::filesystem::path const& path) {
+  // The destructor releases whatever was acquired before a failure.
+  std::unique_ptr<MappedFile> mapped_file(new MappedFile);
+  mapped_file->file_ = CreateFileW(path.wstring().c_str(),
+                                   GENERIC_READ,
+                                   FILE_SHARE_READ,
+                                   /*lpSecurityAttributes=*/nullptr,
+                                   OPEN_EXISTING,
+                                   FILE_ATTRIBUTE_NORMAL,
+                                   /*hTemplateFile=*/nullptr);
+  if (mapped_file->file_ == INVALID_HANDLE_VALUE) {
+    mapped_file->file_ = nullptr;
+    LOG(WARNING) << "Cannot open " << path << " " << GetLastError();
+    return nullptr;
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(mapped_file->file_, &size)) {
+    LOG(WARNING) << "Cannot get the size of " << path << " " << GetLastError();
+    return nullptr;
+  }
+  if (size.QuadPart <= 0) {
+    LOG(WARNING) << path << " is empty";
+    return nullptr;
+  }
+  mapped_file->mapping_ =
+      CreateFileMappingW(mapped_file->file_,
+                         /*lpFileMappingAttributes=*/nullptr,
+                         PAGE_READONLY,
+                         /*dwMaximumSizeHigh=*/0,
+                         /*dwMaximumSizeLow=*/0,
+                         /*lpName=*/nullptr);
+  if (mapped_file->mapping_ == nullptr) {
+    LOG(WARNING) << "Cannot map " << path << " " << GetLastError();
+    return nullptr;
+  }
+  mapped_file->data_ = static_cast<std::uint8_t const*>(
+      MapViewOfFile(mapped_file->mapping_,
+                    FILE_MAP_READ,
+                    /*dwFileOffsetHigh=*/0,
+                    /*dwFileOffsetLow=*/0,
+                    /*dwNumberOfBytesToMap=*/0));
+  if (mapped_file->data_ == nullptr) {
+    LOG(WARNING) << "Cannot map " << path << " " << GetLastError();
+    return nullptr;
+  }
+  mapped_file->size_ = size.QuadPart;
+  return std::move(mapped_file);
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) {
+    UnmapViewOfFile(data_);
+  }
+  if (mapping_ != nullptr) {
+    CloseHandle(mapping_);
+  }
+  if (file_ != nullptr) {
+    CloseHandle(file_);
+  }
+}
+
+#else
+
+std::unique_ptr<MappedFile const> MappedFile::Open(
+    std::experimental::filesystem::path const& path) {
+  int const file = open(path.c_str(), O_RDONLY);
+  if (file < 0) {
+    PLOG(WARNING) << "Cannot open " << path;
+    return nullptr;
+  }
+  struct stat status;
+  if (fstat(file, &status) != 0) {
+    PLOG(WARNING) << "Cannot get the size of " << path;
+    close(file);
+    return nullptr;
+  }
+  if (status.st_size <= 0) {
+    LOG(WARNING) << path << " is empty";
+    close(file);
+    return nullptr;
+  }
+  void* const data = mmap(/*addr=*/nullptr,
+                          status.st_size,
+                          PROT_READ,
+                          MAP_SHARED,
+                          file,
+                          /*offset=*/0);
+  // The mapping remains valid after the file is closed.
+  close(file);
+  if (data == MAP_FAILED) {
+    PLOG(WARNING) << "Cannot map " << path;
+    return nullptr;
+  }
+  std::unique_ptr<MappedFile> mapped_file(new MappedFile);
+  mapped_file->data_ = static_cast<std::uint8_t const*>(data);
+  mapped_file->size_ = status.st_size;
+  return std::move(mapped_file);
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) {
+    munmap(const_cast<std::uint8_t*>(data_), size_);
+  }
+}
+
+#endif
+
+std::uint8_t const* MappedFile::data() const {
+  return data_;
+}
+
+std::int64_t MappedFile::size() const {
+  return size_;
+}
+
+}  // namespace base
+}  // namespace principia
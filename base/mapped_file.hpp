@@ -0,0 +1,45 @@
+﻿
+#pragma once
+
+#include <cstdint>
+#include <experimental/filesystem>
+#include <memory>
+
+#include "base/macros.hpp"
+
+namespace principia {
+namespace base {
+
+// A read-only mapping of an entire file in memory.  The contents of the file
+// are paged in lazily by the operating system, so that mapping a large file is
+// cheap.  The file must not be modified while it is mapped.
+class MappedFile {
+ public:
+  // Maps the file at |path|.  Returns null, after logging the reason, if the
+  // file doesn't exist, is empty, or cannot be mapped.
+  static std::unique_ptr<MappedFile const> Open(
+      std::experimental::filesystem::path const& path);
+  ~MappedFile();
+
+  MappedFile(MappedFile const&) = delete;
+  MappedFile(MappedFile&&) = delete;
+  MappedFile& operator=(MappedFile const&) = delete;
+  MappedFile& operator=(MappedFile&&) = delete;
+
+  // The address of the first byte of the file.  Suitably aligned for any type.
+  std::uint8_t const* data() const;
+  std::int64_t size() const;
+
+ private:
+  MappedFile() = default;
+
+  std::uint8_t const* data_ = nullptr;
+  std::int64_t size_ = 0;
+#if OS_WIN
+  void* file_ = nullptr;
+  void* mapping_ = nullptr;
+#endif
+};
+
+}  // namespace base
+}  // namespace principia
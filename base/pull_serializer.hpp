@@ -3,6 +3,7 @@
 
 #include <cstdint>
 #include <condition_variable>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <queue>
@@ -17,6 +18,15 @@
 namespace principia {
 namespace base {
 
+// The compression applied by a |PullSerializer| to the serialized message.
+enum class Compression {
+  None,
+  // A gzip stream (RFC 1952).  It starts with the byte 0x1F, which cannot start
+  // a valid protocol buffer (its wire type would be 7), so |PushDeserializer|
+  // detects compressed input without any other flag.
+  Gzip,
+};
+
 namespace internal {
 // An output stream based on an array that delegates to a function the handling
 // of the case where one array is full.  It calls the |on_full| function passed
@@ -60,8 +70,12 @@ class PullSerializer {
   // The |size| of the data objects returned by |Pull| are never greater than
   // |chunk_size|.  At most |number_of_chunks| chunks are held in the internal
   // queue.  This class uses at most
-  // |number_of_chunks * (chunk_size + O(1)) + O(1)| bytes.
-  PullSerializer(int chunk_size, int number_of_chunks);
+  // |number_of_chunks * (chunk_size + O(1)) + O(1)| bytes.  If |compression|
+  // is not |None|, the data returned by |Pull| is compressed on the thread that
+  // serializes |message|, and the compressor uses O(1) more bytes.
+  PullSerializer(int chunk_size,
+                 int number_of_chunks,
+                 Compression compression = Compression::None);
   ~PullSerializer();
 
   // Starts the serializer, which will proceed to serialize |message|.  This
@@ -69,6 +83,16 @@ class PullSerializer {
   void Start(
       not_null<std::unique_ptr<google::protobuf::Message const>> message);
 
+  // Same as above, except that the message is given in parts: the serializer
+  // repeatedly calls |next_part| on its thread and serializes the part that it
+  // returns, until it returns null.  Since the concatenation of serialized
+  // messages of a type is a serialization of their merge, the client sees the
+  // merge of the parts.  |next_part| may block until a part is available, so
+  // the serialization of the first parts may proceed while the others are
+  // being built.  Each part is destroyed once it has been serialized.
+  void Start(std::function<std::unique_ptr<google::protobuf::Message const>()>
+                 next_part);
+
   // Obtain the next chunk of data from the serializer.  Blocks if no data is
   // available.  Returns a |Bytes| object of |size| 0 at the end of the
   // serialization.  The returned object may become invalid the next time |Pull|
@@ -81,10 +105,21 @@ class PullSerializer {
   // underlying |DelegatingArrayOutputStream|.
   Bytes Push(Bytes bytes);
 
-  std::unique_ptr<google::protobuf::Message const> message_;
+  // Serializes to |stream| the parts returned by |next_part| until it returns
+  // null.
+  static void SerializeParts(
+      std::function<std::unique_ptr<google::protobuf::Message const>()> const&
+          next_part,
+      not_null<google::protobuf::io::ZeroCopyOutputStream*> stream);
+
+  // Favours speed over size: the serializer thread must keep up with the
+  // client.  On the plugin_serialization benchmark, the default zlib level only
+  // makes the output 3% smaller than this level, at 1.5 times the cost.
+  static constexpr int gzip_compression_level = 1;
 
   int const chunk_size_;
   int const number_of_chunks_;
+  Compression const compression_;
 
   // The array supporting the stream and the stream itself.
   std::unique_ptr<std::uint8_t[]> data_;
@@ -4,9 +4,13 @@
 #include "base/pull_serializer.hpp"
 
 #include <algorithm>
+#include <memory>
+
+#include "google/protobuf/io/gzip_stream.h"
 
 namespace principia {
 
+using google::protobuf::io::GzipOutputStream;
 using std::placeholders::_1;
 using std::swap;
 
@@ -65,9 +69,11 @@ inline std::int64_t DelegatingArrayOutputStream::ByteCount() const {
 }  // namespace internal
 
 inline PullSerializer::PullSerializer(int const chunk_size,
-                                      int const number_of_chunks)
+                                      int const number_of_chunks,
+                                      Compression const compression)
     : chunk_size_(chunk_size),
       number_of_chunks_(number_of_chunks),
+      compression_(compression),
       data_(std::make_unique<std::uint8_t[]>(chunk_size_ * number_of_chunks_)),
       stream_(Bytes(data_.get(), chunk_size_),
               std::bind(&PullSerializer::Push, this, _1)) {
@@ -88,10 +94,34 @@ inline PullSerializer::~PullSerializer() {
 
 inline void PullSerializer::Start(
     not_null<std::unique_ptr<google::protobuf::Message const>> message) {
+  // A single part.  The |shared_ptr| makes the function copyable.
+  auto const part =
+      std::make_shared<std::unique_ptr<google::protobuf::Message const>>(
+          std::move(message));
+  Start([part]() { return std::move(*part); });
+}
+
+inline void PullSerializer::Start(
+    std::function<std::unique_ptr<google::protobuf::Message const>()>
+        next_part) {
   CHECK(thread_ == nullptr);
-  message_ = std::move(message);
-  thread_ = std::make_unique<std::thread>([this](){
-    CHECK(message_->SerializeToZeroCopyStream(&stream_));
+  thread_ = std::make_unique<std::thread>([this, next_part](){
+    switch (compression_) {
+      case Compression::None:
+        SerializeParts(next_part, &stream_);
+        break;
+      case Compression::Gzip: {
+        // The compressor sits between the serializer and |stream_|, so the
+        // chunks that it fills are already compressed when they are pushed.
+        GzipOutputStream::Options options;
+        options.format = GzipOutputStream::GZIP;
+        options.compression_level = gzip_compression_level;
+        GzipOutputStream gzip_stream(&stream_, options);
+        SerializeParts(next_part, &gzip_stream);
+        CHECK(gzip_stream.Close());
+        break;
+      }
+    }
     // Put a sentinel at the end of the serialized stream so that the client
     // knows that this is the end.
     Bytes bytes;
@@ -142,5 +172,15 @@ inline Bytes PullSerializer::Push(Bytes const bytes) {
   return result;
 }
 
+inline void PullSerializer::SerializeParts(
+    std::function<std::unique_ptr<google::protobuf::Message const>()> const&
+        next_part,
+    not_null<google::protobuf::io::ZeroCopyOutputStream*> const stream) {
+  // A part need not have the required fields, only the merge of the parts.
+  for (auto part = next_part(); part != nullptr; part = next_part()) {
+    CHECK(part->SerializePartialToZeroCopyStream(stream));
+  }
+}
+
 }  // namespace base
 }  // namespace principia
@@ -7,17 +7,24 @@
 #include <vector>
 
 #include "gmock/gmock.h"
+#include "google/protobuf/io/gzip_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include "serialization/physics.pb.h"
 
 namespace principia {
 
+using google::protobuf::io::ArrayInputStream;
+using google::protobuf::io::GzipInputStream;
 using serialization::DiscreteTrajectory;
 using serialization::Pair;
 using serialization::Point;
 using serialization::Quantity;
 using ::std::placeholders::_1;
+using ::testing::Each;
 using ::testing::ElementsAre;
 using ::testing::ElementsAreArray;
+using ::testing::Le;
+using ::testing::Lt;
 
 namespace base {
 
@@ -117,6 +124,67 @@ TEST_F(PullSerializerTest, SerializationSizes) {
   EXPECT_THAT(actual_sizes, ElementsAreArray(expected_sizes));
 }
 
+TEST_F(PullSerializerTest, CompressedSerialization) {
+  auto const trajectory = BuildTrajectory();
+  int const byte_size = trajectory->ByteSize();
+  pull_serializer_ = std::make_unique<PullSerializer>(
+      chunk_size, number_of_chunks, Compression::Gzip);
+  pull_serializer_->Start(BuildTrajectory());
+  std::string compressed;
+  std::vector<std::int64_t> actual_sizes;
+  for (;;) {
+    Bytes const bytes = pull_serializer_->Pull();
+    if (bytes.size == 0) {
+      break;
+    }
+    actual_sizes.push_back(bytes.size);
+    compressed.append(reinterpret_cast<char const*>(bytes.data),
+                      static_cast<size_t>(bytes.size));
+  }
+  EXPECT_THAT(actual_sizes, Each(Le(chunk_size)));
+  EXPECT_THAT(compressed.size(), Lt(byte_size / 2));
+  EXPECT_EQ(0x1F, static_cast<std::uint8_t>(compressed[0]));
+
+  ArrayInputStream compressed_stream(compressed.data(),
+                                     static_cast<int>(compressed.size()));
+  GzipInputStream decompressed_stream(&compressed_stream,
+                                      GzipInputStream::GZIP);
+  DiscreteTrajectory read_trajectory;
+  EXPECT_TRUE(read_trajectory.ParseFromZeroCopyStream(&decompressed_stream));
+  EXPECT_EQ(trajectory->SerializeAsString(),
+            read_trajectory.SerializeAsString());
+}
+
+TEST_F(PullSerializerTest, SerializationInParts) {
+  auto const trajectory = BuildTrajectory();
+  // Split the trajectory into parts of 7 points.
+  std::vector<std::unique_ptr<DiscreteTrajectory>> parts;
+  for (int i = 0; i < trajectory->timeline_size(); ++i) {
+    if (i % 7 == 0) {
+      parts.push_back(std::make_unique<DiscreteTrajectory>());
+    }
+    *parts.back()->add_timeline() = trajectory->timeline(i);
+  }
+  auto const next_part = std::make_shared<int>(0);
+  pull_serializer_->Start(
+      [&parts, next_part]() -> std::unique_ptr<DiscreteTrajectory const> {
+        if (*next_part == parts.size()) {
+          return nullptr;
+        }
+        return std::move(parts[(*next_part)++]);
+      });
+  std::string serialized;
+  for (;;) {
+    Bytes const bytes = pull_serializer_->Pull();
+    if (bytes.size == 0) {
+      break;
+    }
+    serialized.append(reinterpret_cast<char const*>(bytes.data),
+                      static_cast<size_t>(bytes.size));
+  }
+  EXPECT_EQ(trajectory->SerializeAsString(), serialized);
+}
+
 TEST_F(PullSerializerTest, SerializationThreading) {
   DiscreteTrajectory read_trajectory;
   auto const trajectory = BuildTrajectory();
@@ -52,7 +52,8 @@ class DelegatingArrayInputStream
 // deserialization, and finally destroys the |PushDeserializer|.
 // |PushDeserializer| is intended for use in memory-critical contexts as it
 // bounds the amount of memory used irrespective of the size of the message to
-// deserialize.
+// deserialize.  The data produced by a |PullSerializer| with any |Compression|
+// may be pushed: compressed data is detected and decompressed transparently.
 class PushDeserializer {
  public:
   // The |size| of the data chunks sent to |Pull| are never greater than
@@ -85,6 +86,9 @@ class PushDeserializer {
   // |DelegatingArrayOutputStream|.
   Bytes Pull();
 
+  // The first byte of a gzip stream.
+  static constexpr std::uint8_t gzip_magic_first_byte = 0x1F;
+
   std::unique_ptr<google::protobuf::Message> message_;
 
   int const chunk_size_;
@@ -7,9 +7,12 @@
 
 #include "glog/logging.h"
 #include "google/protobuf/io/coded_stream_inl.h"
+#include "google/protobuf/io/gzip_stream.h"
 
 namespace principia {
 
+using google::protobuf::io::GzipInputStream;
+using google::protobuf::io::ZeroCopyInputStream;
 using std::swap;
 
 namespace base {
@@ -101,13 +104,31 @@ inline void PushDeserializer::Start(
   CHECK(thread_ == nullptr);
   message_ = std::move(message);
   thread_ = std::make_unique<std::thread>([this, done]() {
-    // It is a well-known annoyance that, in order to set the total byte limit,
-    // we have to copy code from MessageLite::ParseFromZeroCopyStream.  Blame
-    // Kenton.
-    google::protobuf::io::CodedInputStream decoder(&stream_);
-    decoder.SetTotalBytesLimit(1 << 29, 1<< 29);
-    CHECK(message_->ParseFromCodedStream(&decoder));
-    CHECK(decoder.ConsumedEntireMessage());
+    // Peek at the first byte to detect compressed input, see |Compression|.
+    // The decompressor, if any, runs on this thread.  If the input is empty,
+    // so is the message, and we must not pull from |stream_| again.
+    void const* data;
+    int size;
+    if (stream_.Next(&data, &size)) {
+      ZeroCopyInputStream* input = &stream_;
+      std::unique_ptr<GzipInputStream> gzip_stream;
+      if (*static_cast<std::uint8_t const*>(data) == gzip_magic_first_byte) {
+        gzip_stream =
+            std::make_unique<GzipInputStream>(&stream_, GzipInputStream::GZIP);
+        input = gzip_stream.get();
+      }
+      stream_.BackUp(size);
+
+      // It is a well-known annoyance that, in order to set the total byte
+      // limit, we have to copy code from MessageLite::ParseFromZeroCopyStream.
+      // Blame Kenton.
+      google::protobuf::io::CodedInputStream decoder(input);
+      decoder.SetTotalBytesLimit(1 << 29, 1<< 29);
+      CHECK(message_->ParseFromCodedStream(&decoder));
+      CHECK(decoder.ConsumedEntireMessage());
+    } else {
+      message_->Clear();
+    }
 
     // Run any remainining chunk callback.
     std::unique_lock<std::mutex> l(lock_);
@@ -206,6 +206,44 @@ TEST_F(PushDeserializerTest, SerializationDeserialization) {
   }
 }
 
+// Same as above, but the data goes through the compressor and is detected as
+// compressed by the deserializer.
+TEST_F(PushDeserializerTest, CompressedSerializationDeserialization) {
+  auto const trajectory = BuildTrajectory();
+  int const byte_size = trajectory->ByteSize();
+  for (int i = 0; i < runs_per_test; ++i) {
+    auto read_trajectory = make_not_null_unique<DiscreteTrajectory>();
+    auto written_trajectory = BuildTrajectory();
+    // The compressed data is smaller than the serialized trajectory.
+    auto storage = std::make_unique<std::uint8_t[]>(byte_size);
+    std::uint8_t* data = &storage[0];
+
+    pull_serializer_ = std::make_unique<PullSerializer>(
+        serializer_chunk_size, number_of_chunks, Compression::Gzip);
+    push_deserializer_ = std::make_unique<PushDeserializer>(
+        deserializer_chunk_size, number_of_chunks);
+
+    pull_serializer_->Start(std::move(written_trajectory));
+    push_deserializer_->Start(
+        std::move(read_trajectory), PushDeserializerTest::CheckSerialization);
+    for (;;) {
+      Bytes const bytes = pull_serializer_->Pull();
+      CHECK_LE(data + bytes.size, &storage[byte_size]);
+      std::memcpy(data, bytes.data, static_cast<size_t>(bytes.size));
+      push_deserializer_->Push(Bytes(data, bytes.size),
+                               std::bind(&PushDeserializerTest::Stomp,
+                                         Bytes(data, bytes.size)));
+      data = &data[bytes.size];
+      if (bytes.size == 0) {
+        break;
+      }
+    }
+
+    pull_serializer_.reset();
+    push_deserializer_.reset();
+  }
+}
+
 // Check that deserialization fails if we stomp on one extra bytes.
 TEST_F(PushDeserializerDeathTest, Stomp) {
   EXPECT_DEATH({
@@ -0,0 +1,62 @@
+﻿
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "base/macros.hpp"
+
+namespace principia {
+namespace base {
+namespace internal_thread_pool {
+
+// A pool of threads which are started once and then execute the functions
+// added to the pool, in the order in which they were added.  Unlike a |Bundle|,
+// which starts its workers in |Add| and joins them in |Join|, a |ThreadPool| is
+// meant to be kept by its owner and used repeatedly, e.g., for each evaluation
+// of a right-hand side or on each frame.
+// The functions executed by a pool must not wait for other functions executed
+// by the same pool, as that may deadlock.
+template<typename Value>
+class ThreadPool {
+ public:
+  // Starts |pool_size| threads, |pool_size| must be positive.
+  explicit ThreadPool(std::int64_t pool_size);
+
+  // Executes the functions already added to the pool, and joins the threads.
+  ~ThreadPool();
+
+  // Adds |function| to the pool and returns a future for its result.  This
+  // function is thread-safe.
+  std::future<Value> Add(std::function<Value()> function);
+
+  // The number of threads of the pool.
+  std::int64_t size() const;
+
+ private:
+  // The loop executed by each of the |threads_|.
+  void DequeueCallAndExecute();
+
+  std::mutex lock_;
+  // Notified when a call is added or when the pool is shut down.
+  std::condition_variable has_calls_or_shutdown_;
+  bool shutdown_ GUARDED_BY(lock_) = false;
+  std::list<std::function<void()>> calls_ GUARDED_BY(lock_);
+
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace internal_thread_pool
+
+using internal_thread_pool::ThreadPool;
+
+}  // namespace base
+}  // namespace principia
+
+#include "base/thread_pool_body.hpp"
@@ -0,0 +1,76 @@
+﻿
+#pragma once
+
+#include "base/thread_pool.hpp"
+
+#include <memory>
+#include <utility>
+
+#include "glog/logging.h"
+
+namespace principia {
+namespace base {
+namespace internal_thread_pool {
+
+template<typename Value>
+ThreadPool<Value>::ThreadPool(std::int64_t const pool_size) {
+  CHECK_LT(0, pool_size);
+  for (std::int64_t i = 0; i < pool_size; ++i) {
+    threads_.emplace_back(&ThreadPool::DequeueCallAndExecute, this);
+  }
+}
+
+template<typename Value>
+ThreadPool<Value>::~ThreadPool() {
+  {
+    std::unique_lock<std::mutex> l(lock_);
+    shutdown_ = true;
+  }
+  has_calls_or_shutdown_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+template<typename Value>
+std::future<Value> ThreadPool<Value>::Add(std::function<Value()> function) {
+  // A |std::function| must be copyable, and a |std::packaged_task| is not.
+  auto const task =
+      std::make_shared<std::packaged_task<Value()>>(std::move(function));
+  std::future<Value> result = task->get_future();
+  {
+    std::unique_lock<std::mutex> l(lock_);
+    CHECK(!shutdown_);
+    calls_.emplace_back([task]() { (*task)(); });
+  }
+  has_calls_or_shutdown_.notify_one();
+  return result;
+}
+
+template<typename Value>
+std::int64_t ThreadPool<Value>::size() const {
+  return threads_.size();
+}
+
+template<typename Value>
+void ThreadPool<Value>::DequeueCallAndExecute() {
+  for (;;) {
+    std::function<void()> call;
+    {
+      std::unique_lock<std::mutex> l(lock_);
+      has_calls_or_shutdown_.wait(
+          l, [this] { return shutdown_ || !calls_.empty(); });
+      // The calls that were added before the shutdown are still executed.
+      if (calls_.empty()) {
+        return;
+      }
+      call = std::move(calls_.front());
+      calls_.pop_front();
+    }
+    call();
+  }
+}
+
+}  // namespace internal_thread_pool
+}  // namespace base
+}  // namespace principia
@@ -0,0 +1,89 @@
+﻿
+#include "base/thread_pool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace principia {
+namespace base {
+
+using ::testing::ElementsAre;
+using ::testing::Eq;
+
+using namespace std::chrono_literals;  // NOLINT(build/namespaces)
+
+class ThreadPoolTest : public ::testing::Test {
+ protected:
+  ThreadPoolTest() : pool_(3) {}
+
+  ThreadPool<void> pool_;
+};
+
+TEST_F(ThreadPoolTest, Size) {
+  EXPECT_EQ(3, pool_.size());
+}
+
+// Checks that the pool is reusable and that the functions run concurrently.
+TEST_F(ThreadPoolTest, ParallelExecution) {
+  for (int iteration = 0; iteration < 10; ++iteration) {
+    std::atomic<int> running = 0;
+    std::atomic<int> max_running = 0;
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 3; ++i) {
+      futures.push_back(pool_.Add([&running, &max_running]() {
+        int const now_running = ++running;
+        int previous_max = max_running;
+        while (previous_max < now_running &&
+               !max_running.compare_exchange_weak(previous_max, now_running)) {
+        }
+        // Wait until all the functions are running.
+        while (max_running < 3) {
+          std::this_thread::sleep_for(1ms);
+        }
+        --running;
+      }));
+    }
+    for (auto& future : futures) {
+      future.wait();
+    }
+    EXPECT_THAT(max_running, Eq(3));
+  }
+}
+
+TEST_F(ThreadPoolTest, Values) {
+  ThreadPool<int> pool(2);
+  std::vector<std::future<int>> futures;
+  for (int i = 0; i < 5; ++i) {
+    futures.push_back(pool.Add([i]() { return i * i; }));
+  }
+  std::vector<int> values;
+  for (auto& future : futures) {
+    values.push_back(future.get());
+  }
+  EXPECT_THAT(values, ElementsAre(0, 1, 4, 9, 16));
+}
+
+// Checks that the destructor executes the functions that were added before it
+// was called.
+TEST_F(ThreadPoolTest, Destruction) {
+  std::atomic<int> executed = 0;
+  {
+    ThreadPool<void> pool(1);
+    for (int i = 0; i < 10; ++i) {
+      pool.Add([&executed]() {
+        std::this_thread::sleep_for(1ms);
+        ++executed;
+      });
+    }
+  }
+  EXPECT_EQ(10, executed);
+}
+
+}  // namespace base
+}  // namespace principia
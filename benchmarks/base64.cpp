@@ -0,0 +1,104 @@
+﻿
+// .\Release\x64\benchmarks.exe --benchmark_filter=(Base64|Hexadecimal)(Encode|Decode)Chunk  // NOLINT(whitespace/line_length)
+
+#define GLOG_NO_ABBREVIATED_SEVERITIES
+#include "base/base64.hpp"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "base/hexadecimal.hpp"
+
+// Must come last to avoid conflicts when defining the CHECK macros.
+#include "benchmark/benchmark.h"
+
+namespace principia {
+namespace base {
+
+namespace {
+
+// The size of the chunks of the serialization of the plugin, see
+// interface.cpp.
+int const chunk_size = 64 << 10;
+
+// The data of a compressed chunk look random.
+std::vector<std::uint8_t> RandomChunk() {
+  std::mt19937_64 random(42);
+  std::uniform_int_distribution<int> byte(0, 255);
+  std::vector<std::uint8_t> result(chunk_size);
+  for (auto& b : result) {
+    b = static_cast<std::uint8_t>(byte(random));
+  }
+  return result;
+}
+
+}  // namespace
+
+// The throughputs are those of the bytes of the serialization, before encoding
+// or after decoding, so that the encodings can be compared.
+
+void BM_Base64EncodeChunk(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  std::vector<std::uint8_t> const bytes = RandomChunk();
+  std::vector<std::uint8_t> characters(Base64EncodedSize(bytes.size()));
+  while (state.KeepRunning()) {
+    Base64Encode({bytes.data(), bytes.size()},
+                 {characters.data(), characters.size()});
+    benchmark::DoNotOptimize(characters.data());
+  }
+  state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+
+void BM_Base64DecodeChunk(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  std::vector<std::uint8_t> const expected_bytes = RandomChunk();
+  std::vector<std::uint8_t> characters(
+      Base64EncodedSize(expected_bytes.size()));
+  Base64Encode({expected_bytes.data(), expected_bytes.size()},
+               {characters.data(), characters.size()});
+  std::vector<std::uint8_t> bytes(expected_bytes.size());
+  while (state.KeepRunning()) {
+    Base64Decode({characters.data(), characters.size()},
+                 {bytes.data(), bytes.size()});
+    benchmark::DoNotOptimize(bytes.data());
+  }
+  state.SetBytesProcessed(state.iterations() * bytes.size());
+  state.SetLabel(bytes == expected_bytes ? "correct" : "INCORRECT");
+}
+
+void BM_HexadecimalEncodeChunk(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  std::vector<std::uint8_t> const bytes = RandomChunk();
+  std::vector<std::uint8_t> digits(bytes.size() << 1);
+  while (state.KeepRunning()) {
+    HexadecimalEncode({bytes.data(), bytes.size()},
+                      {digits.data(), digits.size()});
+    benchmark::DoNotOptimize(digits.data());
+  }
+  state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+
+void BM_HexadecimalDecodeChunk(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  std::vector<std::uint8_t> const expected_bytes = RandomChunk();
+  std::vector<std::uint8_t> digits(expected_bytes.size() << 1);
+  HexadecimalEncode({expected_bytes.data(), expected_bytes.size()},
+                    {digits.data(), digits.size()});
+  std::vector<std::uint8_t> bytes(expected_bytes.size());
+  while (state.KeepRunning()) {
+    HexadecimalDecode({digits.data(), digits.size()},
+                      {bytes.data(), bytes.size()});
+    benchmark::DoNotOptimize(bytes.data());
+  }
+  state.SetBytesProcessed(state.iterations() * bytes.size());
+  state.SetLabel(bytes == expected_bytes ? "correct" : "INCORRECT");
+}
+
+BENCHMARK(BM_Base64EncodeChunk);
+BENCHMARK(BM_Base64DecodeChunk);
+BENCHMARK(BM_HexadecimalEncodeChunk);
+BENCHMARK(BM_HexadecimalDecodeChunk);
+
+}  // namespace base
+}  // namespace principia
@@ -0,0 +1,242 @@
+﻿
+// .\Release\x64\benchmarks.exe --benchmark_filter=DiscreteTrajectory --benchmark_repetitions=5  // NOLINT(whitespace/line_length)
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "base/not_null.hpp"
+#include "geometry/frame.hpp"
+#include "geometry/grassmann.hpp"
+#include "geometry/named_quantities.hpp"
+#include "physics/degrees_of_freedom.hpp"
+#include "physics/discrete_trajectory.hpp"
+#include "quantities/elementary_functions.hpp"
+#include "quantities/named_quantities.hpp"
+#include "quantities/quantities.hpp"
+#include "quantities/si.hpp"
+#include "serialization/geometry.pb.h"
+#include "serialization/physics.pb.h"
+
+// Must come last to avoid conflicts when defining the CHECK macros.
+#include "benchmark/benchmark.h"
+
+namespace principia {
+
+using base::make_not_null_unique;
+using base::not_null;
+using geometry::Displacement;
+using geometry::Frame;
+using geometry::Instant;
+using geometry::Position;
+using geometry::Velocity;
+using quantities::AngularFrequency;
+using quantities::Cos;
+using quantities::Length;
+using quantities::Sin;
+using quantities::Speed;
+using quantities::si::Metre;
+using quantities::si::Radian;
+using quantities::si::Second;
+
+namespace physics {
+
+namespace {
+
+using World = Frame<serialization::Frame::TestTag,
+                    serialization::Frame::TEST, true>;
+
+Instant const t0;
+
+DegreesOfFreedom<World> MakeDegreesOfFreedom(int const i) {
+  return DegreesOfFreedom<World>(
+             World::origin + Displacement<World>({i * Metre,
+                                                  2 * i * Metre,
+                                                  3 * i * Metre}),
+             Velocity<World>({i * Metre / Second,
+                              0 * Metre / Second,
+                              -i * Metre / Second}));
+}
+
+// A trajectory with |points| points, one second apart, starting at |t0|.
+not_null<std::unique_ptr<DiscreteTrajectory<World>>> MakeTrajectory(
+    int const points) {
+  auto trajectory = make_not_null_unique<DiscreteTrajectory<World>>();
+  for (int i = 0; i < points; ++i) {
+    trajectory->Append(t0 + i * Second, MakeDegreesOfFreedom(i));
+  }
+  return trajectory;
+}
+
+// A trajectory with |points| points, ten seconds apart, on a circular low orbit
+// around the Earth, like the histories of the vessels.
+not_null<std::unique_ptr<DiscreteTrajectory<World>>> MakeOrbitTrajectory(
+    int const points) {
+  Length const r = 7e6 * Metre;
+  AngularFrequency const ω = 1.07e-3 * Radian / Second;
+  auto trajectory = make_not_null_unique<DiscreteTrajectory<World>>();
+  for (int i = 0; i < points; ++i) {
+    auto const θ = ω * i * 10 * Second;
+    trajectory->Append(
+        t0 + i * 10 * Second,
+        DegreesOfFreedom<World>(
+            World::origin +
+                Displacement<World>({r * Cos(θ), r * Sin(θ), 0 * Metre}),
+            Velocity<World>({-r * ω * Sin(θ) / Radian,
+                             r * ω * Cos(θ) / Radian,
+                             0 * Metre / Second})));
+  }
+  return trajectory;
+}
+
+}  // namespace
+
+// The argument is the number of points appended.
+void BM_DiscreteTrajectoryAppend(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  int const points = state.range_x();
+  DegreesOfFreedom<World> const degrees_of_freedom = MakeDegreesOfFreedom(1);
+  while (state.KeepRunning()) {
+    DiscreteTrajectory<World> trajectory;
+    for (int i = 0; i < points; ++i) {
+      trajectory.Append(t0 + i * Second, degrees_of_freedom);
+    }
+    state.PauseTiming();
+    // Exclude the destruction of the trajectory from the timing.
+    trajectory.ForgetAfter(t0);
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * points);
+}
+
+// The argument is the number of points in the trajectory.  The iteration goes
+// through a fork in the middle of the trajectory to exercise the logic of
+// |ForkableIterator|.
+void BM_DiscreteTrajectoryIterate(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  int const points = state.range_x();
+  auto const trajectory = MakeTrajectory(points / 2);
+  not_null<DiscreteTrajectory<World>*> const fork =
+      trajectory->NewForkAtLast();
+  for (int i = points / 2; i < points; ++i) {
+    fork->Append(t0 + i * Second, MakeDegreesOfFreedom(i));
+  }
+  Length sum;
+  while (state.KeepRunning()) {
+    for (auto it = fork->Begin(); it != fork->End(); ++it) {
+      sum += (it.degrees_of_freedom().position() - World::origin).
+                 coordinates().x;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * points);
+  state.SetLabel(quantities::DebugString(sum));
+}
+
+// The argument is the number of points in the trajectory.  Looks up existing
+// times in pseudo-random order.
+void BM_DiscreteTrajectoryFind(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  int const lookups_per_iteration = 1000;
+  int const points = state.range_x();
+  auto const trajectory = MakeTrajectory(points);
+  std::mt19937_64 random(42);
+  std::uniform_int_distribution<int> distribution(0, points - 1);
+  std::vector<Instant> times;
+  for (int i = 0; i < lookups_per_iteration; ++i) {
+    times.push_back(t0 + distribution(random) * Second);
+  }
+  Speed sum;
+  while (state.KeepRunning()) {
+    for (Instant const& time : times) {
+      sum += trajectory->Find(time).degrees_of_freedom().velocity().
+                 coordinates().x;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * lookups_per_iteration);
+  state.SetLabel(quantities::DebugString(sum));
+}
+
+// Simulates one frame of the plugin for 300 vessels: each vessel deletes and
+// recreates its prolongation and its prediction, which are forks at the last
+// point of its history, and appends points to them.  The argument is the
+// number of points in each prediction.
+void BM_DiscreteTrajectoryVesselFrame(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  int const vessels = 300;
+  int const prolongation_points = 3;
+  int const prediction_points = state.range_x();
+  std::vector<not_null<std::unique_ptr<DiscreteTrajectory<World>>>> histories;
+  std::vector<DiscreteTrajectory<World>*> prolongations;
+  std::vector<DiscreteTrajectory<World>*> predictions;
+  for (int i = 0; i < vessels; ++i) {
+    histories.push_back(MakeTrajectory(100));
+    prolongations.push_back(histories.back()->NewForkAtLast());
+    predictions.push_back(histories.back()->NewForkAtLast());
+  }
+  Instant const last_time = histories.front()->last().time();
+  DegreesOfFreedom<World> const degrees_of_freedom = MakeDegreesOfFreedom(1);
+  while (state.KeepRunning()) {
+    for (int i = 0; i < vessels; ++i) {
+      auto const& history = histories[i];
+      history->DeleteFork(prolongations[i]);
+      prolongations[i] = history->NewForkAtLast();
+      for (int j = 1; j <= prolongation_points; ++j) {
+        prolongations[i]->Append(last_time + j * Second, degrees_of_freedom);
+      }
+      history->DeleteFork(predictions[i]);
+      predictions[i] = history->NewForkAtLast();
+      for (int j = 1; j <= prediction_points; ++j) {
+        predictions[i]->Append(last_time + j * Second, degrees_of_freedom);
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * vessels);
+}
+
+// The argument is the number of points in the trajectory.  Includes the
+// serialization of the message to bytes, as happens when saving.
+void BM_DiscreteTrajectorySerialization(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  int const points = state.range_x();
+  auto const trajectory = MakeOrbitTrajectory(points);
+  std::string bytes;
+  while (state.KeepRunning()) {
+    serialization::DiscreteTrajectory message;
+    trajectory->WriteToMessage(&message, /*forks=*/{});
+    message.SerializeToString(&bytes);
+  }
+  state.SetItemsProcessed(state.iterations() * points);
+  state.SetLabel(std::to_string(static_cast<double>(bytes.size()) / points) +
+                 " bytes/point");
+}
+
+// The argument is the number of points in the trajectory.  Includes the
+// parsing of the bytes, as happens when loading.
+void BM_DiscreteTrajectoryDeserialization(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  int const points = state.range_x();
+  std::string bytes;
+  {
+    serialization::DiscreteTrajectory message;
+    MakeOrbitTrajectory(points)->WriteToMessage(&message, /*forks=*/{});
+    message.SerializeToString(&bytes);
+  }
+  while (state.KeepRunning()) {
+    serialization::DiscreteTrajectory message;
+    message.ParseFromString(bytes);
+    auto const trajectory =
+        DiscreteTrajectory<World>::ReadFromMessage(message, /*forks=*/{});
+  }
+  state.SetItemsProcessed(state.iterations() * points);
+}
+
+BENCHMARK(BM_DiscreteTrajectoryAppend)->Arg(1000)->Arg(1000000);
+BENCHMARK(BM_DiscreteTrajectoryIterate)->Arg(1000)->Arg(1000000);
+BENCHMARK(BM_DiscreteTrajectoryFind)->Arg(1000)->Arg(1000000);
+BENCHMARK(BM_DiscreteTrajectoryVesselFrame)->Arg(10)->Arg(100)->Arg(1000);
+BENCHMARK(BM_DiscreteTrajectorySerialization)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_DiscreteTrajectoryDeserialization)->Arg(1000)->Arg(100000);
+
+}  // namespace physics
+}  // namespace principia
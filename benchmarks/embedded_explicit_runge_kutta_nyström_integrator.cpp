@@ -4,7 +4,9 @@
 #define GLOG_NO_ABBREVIATED_SEVERITIES
 
 #include <algorithm>
+#include <cstdint>
 #include <functional>
+#include <limits>
 #include <type_traits>
 #include <vector>
 
@@ -13,6 +15,7 @@
 #include "geometry/frame.hpp"
 #include "geometry/grassmann.hpp"
 #include "geometry/named_quantities.hpp"
+#include "integrators/embedded_explicit_runge_kutta_nyström_integrator.hpp"
 #include "integrators/ordinary_differential_equations.hpp"
 #include "integrators/symplectic_runge_kutta_nyström_integrator.hpp"
 #include "glog/logging.h"
@@ -28,6 +31,7 @@ using geometry::Frame;
 using geometry::Position;
 using geometry::Vector;
 using geometry::Velocity;
+using numerics::DoublePrecision;
 using quantities::Abs;
 using quantities::Acceleration;
 using quantities::AngularFrequency;
@@ -36,6 +40,7 @@ using quantities::Length;
 using quantities::Mass;
 using quantities::Speed;
 using quantities::Stiffness;
+using quantities::Time;
 using quantities::si::Metre;
 using quantities::si::Radian;
 using quantities::si::Second;
@@ -59,6 +64,16 @@ void ComputeHarmonicOscillatorAcceleration1D(
   result[0] = -q[0] * (SIUnit<Stiffness>() / SIUnit<Mass>());
 }
 
+// Uncoupled oscillators, one per element of |q|.
+void ComputeHarmonicOscillatorsAcceleration(
+    Instant const& t,
+    std::vector<Length> const& q,
+    std::vector<Acceleration>& result) {
+  for (int k = 0; k < q.size(); ++k) {
+    result[k] = -q[k] * (SIUnit<Stiffness>() / SIUnit<Mass>());
+  }
+}
+
 void ComputeHarmonicOscillatorAcceleration3D(
     Instant const& t,
     std::vector<Position<World>> const& q,
@@ -76,6 +91,21 @@ double HarmonicOscillatorToleranceRatio1D(
                   v_tolerance / Abs(error.velocity_error[0]));
 }
 
+template<typename ODE>
+double HarmonicOscillatorsToleranceRatio(
+    Time const& h,
+    typename ODE::SystemStateError const& error,
+    Length const& q_tolerance,
+    Speed const& v_tolerance) {
+  double result = std::numeric_limits<double>::infinity();
+  for (int k = 0; k < error.position_error.size(); ++k) {
+    result = std::min(result,
+                      std::min(q_tolerance / Abs(error.position_error[k]),
+                               v_tolerance / Abs(error.velocity_error[k])));
+  }
+  return result;
+}
+
 template<typename ODE>
 double HarmonicOscillatorToleranceRatio3D(
     Time const& h,
@@ -202,6 +232,107 @@ void SolveHarmonicOscillatorAndComputeError3D(
   state.ResumeTiming();
 }
 
+// Integrates |state.range_x()| identical uncoupled oscillators.  The
+// integration of a single body uses loops whose bounds are known at compile
+// time, compare the time per oscillator with the other arguments to see the
+// effect of that specialization; see also
+// |BM_EmbeddedExplicitRungeKuttaNyströmIntegratorSolveSingleBody|.
+template<typename Integrator, Integrator const& (*integrator)()>
+void BM_EmbeddedExplicitRungeKuttaNyströmIntegratorSolveHarmonicOscillators(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  using ODE = SpecialSecondOrderDifferentialEquation<Length>;
+
+  int const oscillators = state.range_x();
+  Length const q_initial = 1 * Metre;
+  Speed const v_initial;
+  Instant const t_initial;
+  Instant const t_final = t_initial + 1000 * Second;
+  Length const length_tolerance = 1e-6 * Metre;
+  Speed const speed_tolerance = 1e-6 * Metre / Second;
+
+  ODE harmonic_oscillators;
+  harmonic_oscillators.compute_acceleration =
+      std::bind(ComputeHarmonicOscillatorsAcceleration, _1, _2, _3);
+  IntegrationProblem<ODE> problem;
+  problem.equation = harmonic_oscillators;
+  ODE::SystemState const initial_state = {
+      std::vector<DoublePrecision<Length>>(oscillators, q_initial),
+      std::vector<DoublePrecision<Speed>>(oscillators, v_initial),
+      t_initial};
+  problem.initial_state = &initial_state;
+
+  AdaptiveStepSize<ODE> adaptive_step_size;
+  adaptive_step_size.first_time_step = t_final - t_initial;
+  adaptive_step_size.safety_factor = 0.9;
+  adaptive_step_size.tolerance_to_error_ratio =
+      std::bind(HarmonicOscillatorsToleranceRatio<ODE>,
+                _1, _2, length_tolerance, speed_tolerance);
+  adaptive_step_size.max_steps = std::numeric_limits<std::int64_t>::max();
+
+  std::int64_t steps = 0;
+  while (state.KeepRunning()) {
+    auto const instance = integrator().NewInstance(
+        problem,
+        [&steps](ODE::SystemState const&) { ++steps; },
+        adaptive_step_size);
+    integrator().Solve(t_final, *instance);
+  }
+  state.SetItemsProcessed(steps * oscillators);
+}
+
+// Integrates a single oscillator, through |Solve| if |state.range_x()| is 0,
+// through |SolveSingleBody| (fixed-size state and inlined right-hand side)
+// otherwise.  Both compute the same solution with the same steps.
+template<typename Integrator, Integrator const& (*integrator)()>
+void BM_EmbeddedExplicitRungeKuttaNyströmIntegratorSolveSingleBody(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  using ODE = SpecialSecondOrderDifferentialEquation<Length>;
+
+  bool const single_body = state.range_x() != 0;
+  Length const q_initial = 1 * Metre;
+  Speed const v_initial;
+  Instant const t_initial;
+  Instant const t_final = t_initial + 1000 * Second;
+  Length const length_tolerance = 1e-6 * Metre;
+  Speed const speed_tolerance = 1e-6 * Metre / Second;
+
+  ODE harmonic_oscillator;
+  harmonic_oscillator.compute_acceleration =
+      std::bind(ComputeHarmonicOscillatorAcceleration1D, _1, _2, _3);
+  IntegrationProblem<ODE> problem;
+  problem.equation = harmonic_oscillator;
+  ODE::SystemState const initial_state = {{q_initial}, {v_initial}, t_initial};
+  problem.initial_state = &initial_state;
+
+  AdaptiveStepSize<ODE> adaptive_step_size;
+  adaptive_step_size.first_time_step = t_final - t_initial;
+  adaptive_step_size.safety_factor = 0.9;
+  adaptive_step_size.tolerance_to_error_ratio =
+      std::bind(HarmonicOscillatorToleranceRatio1D<ODE>,
+                _1, _2, length_tolerance, speed_tolerance);
+  adaptive_step_size.max_steps = std::numeric_limits<std::int64_t>::max();
+
+  std::int64_t steps = 0;
+  while (state.KeepRunning()) {
+    auto const instance = integrator().NewInstance(
+        problem,
+        [&steps](ODE::SystemState const&) { ++steps; },
+        adaptive_step_size);
+    if (single_body) {
+      integrator().SolveSingleBody(
+          t_final,
+          *instance,
+          [](Instant const& t, Length const& q) {
+            return -q * (SIUnit<Stiffness>() / SIUnit<Mass>());
+          });
+    } else {
+      integrator().Solve(t_final, *instance);
+    }
+  }
+  state.SetItemsProcessed(steps);
+  state.SetLabel(single_body ? "single body" : "general");
+}
+
 template<typename Integrator, Integrator const& (*integrator)()>
 void BM_EmbeddedExplicitRungeKuttaNyströmIntegratorSolveHarmonicOscillator1D(
     benchmark::State& state) {  // NOLINT(runtime/references)
@@ -237,6 +368,16 @@ BENCHMARK_TEMPLATE2(
     decltype(DormandElMikkawyPrince1986RKN434FM<Length>()),
     &DormandElMikkawyPrince1986RKN434FM<Length>);
 
+BENCHMARK_TEMPLATE2(
+    BM_EmbeddedExplicitRungeKuttaNyströmIntegratorSolveHarmonicOscillators,
+    decltype(DormandElMikkawyPrince1986RKN434FM<Length>()),
+    &DormandElMikkawyPrince1986RKN434FM<Length>)->Arg(1)->Arg(2)->Arg(3);
+
+BENCHMARK_TEMPLATE2(
+    BM_EmbeddedExplicitRungeKuttaNyströmIntegratorSolveSingleBody,
+    decltype(DormandElMikkawyPrince1986RKN434FM<Length>()),
+    &DormandElMikkawyPrince1986RKN434FM<Length>)->Arg(0)->Arg(1);
+
 BENCHMARK_TEMPLATE2(
     BM_EmbeddedExplicitRungeKuttaNyströmIntegratorSolveHarmonicOscillator3D,
     decltype(DormandElMikkawyPrince1986RKN434FM<Position<World>>()),
@@ -2,8 +2,11 @@
 // .\Release\x64\benchmarks.exe --benchmark_repetitions=3 --benchmark_filter=Ephemeris                                                                     // NOLINT(whitespace/line_length)
 
 #include <cmath>
+#include <cstdint>
+#include <experimental/filesystem>
 #include <limits>
 #include <memory>
+#include <random>
 #include <string>
 #include <vector>
 
@@ -18,6 +21,7 @@
 #include "physics/discrete_trajectory.hpp"
 #include "physics/ephemeris.hpp"
 #include "physics/massless_body.hpp"
+#include "physics/solar_system.hpp"
 #include "quantities/astronomy.hpp"
 #include "quantities/bipm.hpp"
 #include "quantities/elementary_functions.hpp"
@@ -34,6 +38,7 @@ namespace principia {
 using astronomy::ICRFJ2000Ecliptic;
 using astronomy::ICRFJ2000Equator;
 using astronomy::equatorial_to_ecliptic;
+using base::make_not_null_unique;
 using base::not_null;
 using geometry::Displacement;
 using geometry::Position;
@@ -43,12 +48,15 @@ using geometry::Velocity;
 using integrators::DormandElMikkawyPrince1986RKN434FM;
 using integrators::McLachlanAtela1992Order5Optimal;
 using quantities::DebugString;
+using quantities::GravitationalParameter;
 using quantities::Length;
 using quantities::Speed;
+using quantities::Time;
 using quantities::Sqrt;
 using quantities::astronomy::JulianYear;
 using quantities::bipm::NauticalMile;
 using quantities::si::AstronomicalUnit;
+using quantities::si::Day;
 using quantities::si::Kilo;
 using quantities::si::Metre;
 using quantities::si::Milli;
@@ -60,10 +68,26 @@ namespace physics {
 
 namespace {
 
+// The memory used by the series of all the bodies of the |ephemeris|.
+std::int64_t SeriesBytes(
+    SolarSystem<ICRFJ2000Equator> const& solar_system,
+    Ephemeris<ICRFJ2000Equator> const& ephemeris) {
+  std::int64_t result = 0;
+  for (std::string const& name : solar_system.names()) {
+    result += solar_system.trajectory(ephemeris, name).series_bytes();
+  }
+  return result;
+}
+
+// The first argument is the logarithm of the fitting tolerance, the second is
+// the number of threads used to compute the accelerations between the massive
+// bodies (0 for sequential computation).
 void EphemerisSolarSystemBenchmark(SolarSystemFactory::Accuracy const accuracy,
                                    benchmark::State& state) {
   Length const fitting_tolerance = 5 * std::pow(10.0, state.range_x()) * Metre;
+  int const workers = state.range_y();
   Length error;
+  std::int64_t series_bytes;
   while (state.KeepRunning()) {
     state.PauseTiming();
     auto const at_спутник_1_launch =
@@ -76,6 +100,7 @@ void EphemerisSolarSystemBenchmark(SolarSystemFactory::Accuracy const accuracy,
             Ephemeris<ICRFJ2000Equator>::FixedStepParameters(
                 McLachlanAtela1992Order5Optimal<Position<ICRFJ2000Equator>>(),
                 /*step=*/45 * Minute));
+    ephemeris->set_massive_bodies_acceleration_workers(workers);
 
     state.ResumeTiming();
     ephemeris->Prolong(final_time);
@@ -89,9 +114,120 @@ void EphemerisSolarSystemBenchmark(SolarSystemFactory::Accuracy const accuracy,
                  SolarSystemFactory::name(SolarSystemFactory::Earth)).
                      EvaluatePosition(final_time, nullptr)).
                  Norm();
+    series_bytes = SeriesBytes(*at_спутник_1_launch, *ephemeris);
+    state.ResumeTiming();
+  }
+  state.SetLabel(quantities::DebugString(error / AstronomicalUnit) + " ua, " +
+                 std::to_string(workers) + " workers, " +
+                 std::to_string(series_bytes / 1024) + " KiB");
+}
+
+// Prolongs the ephemeris by |state.range_x()| steps with |state.range_y()|
+// threads computing the accelerations between the massive bodies (0 for
+// sequential computation).  The prolongations are short, so that this measures
+// the overhead per evaluation of the right-hand side rather than the fitting of
+// the series.
+void EphemerisShortProlongationBenchmark(
+    SolarSystemFactory::Accuracy const accuracy,
+    benchmark::State& state) {
+  int const steps = state.range_x();
+  int const workers = state.range_y();
+  Time const step = 45 * Minute;
+  auto const at_спутник_1_launch =
+      SolarSystemFactory::AtСпутник1Launch(accuracy);
+  Instant const final_time = at_спутник_1_launch->epoch() + steps * step;
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    auto const ephemeris =
+        at_спутник_1_launch->MakeEphemeris(
+            /*fitting_tolerance=*/5 * Milli(Metre),
+            Ephemeris<ICRFJ2000Equator>::FixedStepParameters(
+                McLachlanAtela1992Order5Optimal<Position<ICRFJ2000Equator>>(),
+                step));
+    ephemeris->set_massive_bodies_acceleration_workers(workers);
     state.ResumeTiming();
+    ephemeris->Prolong(final_time);
+  }
+  state.SetItemsProcessed(state.iterations() * steps);
+  state.SetLabel(std::to_string(workers) + " workers");
+}
+
+// Evaluates the positions of all the bodies at pseudo-random times over a
+// century, without hints.  This measures the cost of finding and evaluating the
+// series.
+void EphemerisEvaluationBenchmark(SolarSystemFactory::Accuracy const accuracy,
+                                  benchmark::State& state) {
+  int const evaluations_per_iteration = 1000;
+  auto const at_спутник_1_launch =
+      SolarSystemFactory::AtСпутник1Launch(accuracy);
+  Instant const final_time = at_спутник_1_launch->epoch() + 100 * JulianYear;
+  auto const ephemeris =
+      at_спутник_1_launch->MakeEphemeris(
+          /*fitting_tolerance=*/5 * Milli(Metre),
+          Ephemeris<ICRFJ2000Equator>::FixedStepParameters(
+              McLachlanAtela1992Order5Optimal<Position<ICRFJ2000Equator>>(),
+              /*step=*/45 * Minute));
+  ephemeris->Prolong(final_time);
+
+  std::vector<not_null<ContinuousTrajectory<ICRFJ2000Equator> const*>>
+      trajectories;
+  for (std::string const& name : at_спутник_1_launch->names()) {
+    trajectories.push_back(
+        &at_спутник_1_launch->trajectory(*ephemeris, name));
+  }
+  std::mt19937_64 random(42);
+  std::uniform_real_distribution<double> distribution(0.0, 1.0);
+  Time const duration = ephemeris->t_max() - ephemeris->t_min();
+
+  Length total;
+  while (state.KeepRunning()) {
+    for (int i = 0; i < evaluations_per_iteration; ++i) {
+      Instant const t = ephemeris->t_min() + distribution(random) * duration;
+      for (auto const trajectory : trajectories) {
+        total += (trajectory->EvaluatePosition(t, /*hint=*/nullptr) -
+                  ICRFJ2000Equator::origin).Norm();
+      }
+    }
+  }
+  // Make sure that the evaluations are not optimized away.
+  CHECK_LT(Length(), total);
+  state.SetLabel(
+      std::to_string(SeriesBytes(*at_спутник_1_launch, *ephemeris) / 1024) +
+      " KiB");
+}
+
+// Reads a century of ephemeris from a precomputed file.  Compare with the
+// time needed to integrate it in |EphemerisSolarSystemBenchmark|.
+void EphemerisReadFromPrecomputedFileBenchmark(
+    SolarSystemFactory::Accuracy const accuracy,
+    benchmark::State& state) {
+  std::experimental::filesystem::path const path =
+      "ephemeris_benchmark.precomputed";
+  auto const at_спутник_1_launch =
+      SolarSystemFactory::AtСпутник1Launch(accuracy);
+  Instant const final_time = at_спутник_1_launch->epoch() + 100 * JulianYear;
+  {
+    auto const ephemeris =
+        at_спутник_1_launch->MakeEphemeris(
+            /*fitting_tolerance=*/5 * Milli(Metre),
+            Ephemeris<ICRFJ2000Equator>::FixedStepParameters(
+                McLachlanAtela1992Order5Optimal<Position<ICRFJ2000Equator>>(),
+                /*step=*/45 * Minute));
+    ephemeris->Prolong(final_time);
+    ephemeris->WriteToPrecomputedFile(path);
   }
-  state.SetLabel(quantities::DebugString(error / AstronomicalUnit) + " ua");
+
+  Instant t_max;
+  while (state.KeepRunning()) {
+    auto const ephemeris =
+        Ephemeris<ICRFJ2000Equator>::ReadFromPrecomputedFile(path);
+    t_max = ephemeris->t_max();
+  }
+  CHECK_LE(final_time, t_max);
+  state.SetLabel(
+      std::to_string(std::experimental::filesystem::file_size(path) / 1024) +
+      " KiB");
+  std::experimental::filesystem::remove(path);
 }
 
 void EphemerisL4ProbeBenchmark(SolarSystemFactory::Accuracy const accuracy,
@@ -272,6 +408,88 @@ void EphemerisLEOProbeBenchmark(SolarSystemFactory::Accuracy const accuracy,
                  " nmi");
 }
 
+// Flows the histories of |state.range_x()| vessels in low earth orbit for one
+// day with the fixed step used by the plugin, either in a single call to
+// |FlowWithFixedStep| (if |state.range_y()| is nonzero), or one vessel at a
+// time.
+void EphemerisLEOProbesFixedStepBenchmark(
+    SolarSystemFactory::Accuracy const accuracy,
+    benchmark::State& state) {
+  int const vessels = state.range_x();
+  bool const batched = state.range_y() != 0;
+
+  auto const at_спутник_1_launch =
+      SolarSystemFactory::AtСпутник1Launch(accuracy);
+  Instant const final_time = at_спутник_1_launch->epoch() + 1 * Day;
+
+  auto const ephemeris =
+      at_спутник_1_launch->MakeEphemeris(
+          /*fitting_tolerance=*/5 * Milli(Metre),
+          Ephemeris<ICRFJ2000Equator>::FixedStepParameters(
+              McLachlanAtela1992Order5Optimal<Position<ICRFJ2000Equator>>(),
+              /*step=*/45 * Minute));
+  ephemeris->Prolong(final_time);
+
+  Ephemeris<ICRFJ2000Equator>::FixedStepParameters const parameters(
+      McLachlanAtela1992Order5Optimal<Position<ICRFJ2000Equator>>(),
+      /*step=*/10 * Second);
+
+  DegreesOfFreedom<ICRFJ2000Equator> const earth_degrees_of_freedom =
+      at_спутник_1_launch->initial_state(
+          SolarSystemFactory::name(SolarSystemFactory::Earth));
+  GravitationalParameter const earth_gravitational_parameter =
+      at_спутник_1_launch->gravitational_parameter(
+          SolarSystemFactory::name(SolarSystemFactory::Earth));
+
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    // Probes on circular orbits at slightly different altitudes.
+    std::vector<not_null<std::unique_ptr<DiscreteTrajectory<ICRFJ2000Equator>>>>
+        trajectories;
+    for (int i = 0; i < vessels; ++i) {
+      trajectories.push_back(
+          make_not_null_unique<DiscreteTrajectory<ICRFJ2000Equator>>());
+      Displacement<ICRFJ2000Equator> const earth_probe_displacement(
+          {6371 * Kilo(Metre) + 100 * NauticalMile + i * Kilo(Metre),
+           0 * Metre,
+           0 * Metre});
+      Speed const earth_probe_speed =
+          Sqrt(earth_gravitational_parameter /
+               earth_probe_displacement.Norm());
+      Velocity<ICRFJ2000Equator> const earth_probe_velocity(
+          {0 * Metre / Second, earth_probe_speed, 0 * Metre / Second});
+      trajectories.back()->Append(
+          at_спутник_1_launch->epoch(),
+          DegreesOfFreedom<ICRFJ2000Equator>(
+              earth_degrees_of_freedom.position() + earth_probe_displacement,
+              earth_degrees_of_freedom.velocity() + earth_probe_velocity));
+    }
+
+    state.ResumeTiming();
+    if (batched) {
+      std::vector<not_null<DiscreteTrajectory<ICRFJ2000Equator>*>> batch;
+      for (auto const& trajectory : trajectories) {
+        batch.push_back(trajectory.get());
+      }
+      ephemeris->FlowWithFixedStep(
+          batch,
+          Ephemeris<ICRFJ2000Equator>::NoIntrinsicAccelerations,
+          final_time,
+          parameters);
+    } else {
+      for (auto const& trajectory : trajectories) {
+        ephemeris->FlowWithFixedStep(
+            {trajectory.get()},
+            Ephemeris<ICRFJ2000Equator>::NoIntrinsicAccelerations,
+            final_time,
+            parameters);
+      }
+    }
+  }
+  state.SetLabel(std::to_string(vessels) + " vessels, " +
+                 (batched ? "batched" : "one at a time"));
+}
+
 }  // namespace
 
 void BM_EphemerisSolarSystemMajorBodiesOnly(
@@ -294,6 +512,13 @@ void BM_EphemerisSolarSystemAllBodiesAndOblateness(
       state);
 }
 
+void BM_EphemerisShortProlongationAllBodiesAndOblateness(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  EphemerisShortProlongationBenchmark(
+      SolarSystemFactory::Accuracy::AllBodiesAndOblateness,
+      state);
+}
+
 void BM_EphemerisL4ProbeMajorBodiesOnly(
     benchmark::State& state) {  // NOLINT(runtime/references)
   EphemerisL4ProbeBenchmark(SolarSystemFactory::Accuracy::MajorBodiesOnly,
@@ -332,21 +557,56 @@ void BM_EphemerisLEOProbeAllBodiesAndOblateness(
       state);
 }
 
+void BM_EphemerisLEOProbesFixedStep(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  EphemerisLEOProbesFixedStepBenchmark(
+      SolarSystemFactory::Accuracy::MinorAndMajorBodies,
+      state);
+}
+
+void BM_EphemerisEvaluationMinorAndMajorBodies(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  EphemerisEvaluationBenchmark(
+      SolarSystemFactory::Accuracy::MinorAndMajorBodies,
+      state);
+}
+
+void BM_EphemerisReadFromPrecomputedFileMinorAndMajorBodies(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  EphemerisReadFromPrecomputedFileBenchmark(
+      SolarSystemFactory::Accuracy::MinorAndMajorBodies,
+      state);
+}
+
 void BM_EphemerisFittingTolerance(
     benchmark::State& state) {  // NOLINT(runtime/references)
   EphemerisL4ProbeBenchmark(SolarSystemFactory::Accuracy::MajorBodiesOnly,
                             state);
 }
 
-BENCHMARK(BM_EphemerisSolarSystemMajorBodiesOnly)->Arg(-3);
-BENCHMARK(BM_EphemerisSolarSystemMinorAndMajorBodies)->Arg(-3);
-BENCHMARK(BM_EphemerisSolarSystemAllBodiesAndOblateness)->Arg(-3);
+BENCHMARK(BM_EphemerisSolarSystemMajorBodiesOnly)
+    ->ArgPair(-3, 0)->ArgPair(-3, 1)->ArgPair(-3, 2)->ArgPair(-3, 4);
+BENCHMARK(BM_EphemerisSolarSystemMinorAndMajorBodies)
+    ->ArgPair(-3, 0)->ArgPair(-3, 1)->ArgPair(-3, 2)->ArgPair(-3, 4);
+BENCHMARK(BM_EphemerisSolarSystemAllBodiesAndOblateness)
+    ->ArgPair(-3, 0)->ArgPair(-3, 1)->ArgPair(-3, 2)->ArgPair(-3, 4)
+    ->ArgPair(-3, 8);
+BENCHMARK(BM_EphemerisShortProlongationAllBodiesAndOblateness)
+    ->ArgPair(32, 0)->ArgPair(32, 1)->ArgPair(32, 2)->ArgPair(32, 4)
+    ->ArgPair(32, 8);
 BENCHMARK(BM_EphemerisL4ProbeMajorBodiesOnly)->Arg(-3);
 BENCHMARK(BM_EphemerisL4ProbeMinorAndMajorBodies)->Arg(-3);
 BENCHMARK(BM_EphemerisL4ProbeAllBodiesAndOblateness)->Arg(-3);
 BENCHMARK(BM_EphemerisLEOProbeMajorBodiesOnly)->Arg(-3);
 BENCHMARK(BM_EphemerisLEOProbeMinorAndMajorBodies)->Arg(-3);
 BENCHMARK(BM_EphemerisLEOProbeAllBodiesAndOblateness)->Arg(-3);
+BENCHMARK(BM_EphemerisEvaluationMinorAndMajorBodies);
+BENCHMARK(BM_EphemerisReadFromPrecomputedFileMinorAndMajorBodies);
+BENCHMARK(BM_EphemerisLEOProbesFixedStep)
+    ->ArgPair(1, 0)->ArgPair(1, 1)
+    ->ArgPair(10, 0)->ArgPair(10, 1)
+    ->ArgPair(100, 0)->ArgPair(100, 1)
+    ->ArgPair(300, 0)->ArgPair(300, 1);
 
 BENCHMARK(BM_EphemerisFittingTolerance)->DenseRange(-4, 4);
 
@@ -0,0 +1,181 @@
+﻿
+// .\Release\x64\benchmarks.exe --benchmark_filter=Plugin(Serialization|Deserialization) --benchmark_repetitions=5  // NOLINT(whitespace/line_length)
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/array.hpp"
+#include "base/not_null.hpp"
+#include "base/pull_serializer.hpp"
+#include "base/push_deserializer.hpp"
+#include "geometry/grassmann.hpp"
+#include "geometry/named_quantities.hpp"
+#include "ksp_plugin/frames.hpp"
+#include "physics/degrees_of_freedom.hpp"
+#include "physics/discrete_trajectory.hpp"
+#include "quantities/elementary_functions.hpp"
+#include "quantities/named_quantities.hpp"
+#include "quantities/quantities.hpp"
+#include "quantities/si.hpp"
+#include "serialization/ksp_plugin.pb.h"
+
+// Must come last to avoid conflicts when defining the CHECK macros.
+#include "benchmark/benchmark.h"
+
+namespace principia {
+
+using geometry::Displacement;
+using geometry::Instant;
+using geometry::Velocity;
+using ksp_plugin::Barycentric;
+using physics::DegreesOfFreedom;
+using physics::DiscreteTrajectory;
+using quantities::AngularFrequency;
+using quantities::Cos;
+using quantities::GravitationalParameter;
+using quantities::Length;
+using quantities::Pow;
+using quantities::Sin;
+using quantities::Sqrt;
+using quantities::Time;
+using quantities::si::Metre;
+using quantities::si::Radian;
+using quantities::si::Second;
+
+namespace base {
+
+namespace {
+
+// The same values as in interface.cpp.
+int const chunk_size = 64 << 10;
+int const number_of_chunks = 8;
+
+// The size of the synthetic plugin.  Its serialization is dominated by the
+// histories of the vessels, as is the case in real saves.
+int const vessels = 10;
+int const points_per_history = 20'000;
+Time const history_step = 10 * Second;
+
+// Returns a plugin message whose vessels are on circular orbits around a body
+// with the gravitational parameter of the Earth, at different altitudes.  The
+// other fields are filled with the minimum needed for the message to be
+// initialized.
+not_null<std::unique_ptr<serialization::Plugin const>> MakePlugin() {
+  GravitationalParameter const μ = 3.986004418e14 * Pow<3>(Metre) /
+                                   Pow<2>(Second);
+  Instant const t0;
+  auto plugin = make_not_null_unique<serialization::Plugin>();
+  for (int v = 0; v < vessels; ++v) {
+    Length const r = (6.5e6 + 1.0e5 * v) * Metre;
+    AngularFrequency const ω = Sqrt(μ / Pow<3>(r)) * Radian;
+    DiscreteTrajectory<Barycentric> history;
+    for (int i = 0; i < points_per_history; ++i) {
+      Time const t = i * history_step;
+      auto const θ = ω * t;
+      history.Append(
+          t0 + t,
+          DegreesOfFreedom<Barycentric>(
+              Barycentric::origin +
+                  Displacement<Barycentric>({r * Cos(θ), r * Sin(θ), 0 * r}),
+              Velocity<Barycentric>({-r * ω * Sin(θ) / Radian,
+                                     r * ω * Cos(θ) / Radian,
+                                     0 * Metre / Second})));
+    }
+    auto* const vessel_and_properties = plugin->add_vessel();
+    vessel_and_properties->set_guid("vessel" + std::to_string(v));
+    vessel_and_properties->set_parent_index(0);
+    vessel_and_properties->set_dirty(false);
+    auto* const vessel = vessel_and_properties->mutable_vessel();
+    vessel->mutable_body();
+    history.WriteToMessage(vessel->mutable_history(), /*forks=*/{});
+  }
+  plugin->mutable_bubble()->mutable_body();
+  (0 * Radian).WriteToMessage(plugin->mutable_planetarium_rotation());
+  t0.WriteToMessage(plugin->mutable_current_time());
+  plugin->set_sun_index(0);
+  CHECK(plugin->IsInitialized());
+  return std::move(plugin);
+}
+
+// Returns the chunks produced by a serializer with the given |compression|.
+std::vector<std::string> Serialize(serialization::Plugin const& plugin,
+                                   Compression const compression) {
+  std::vector<std::string> chunks;
+  PullSerializer serializer(chunk_size, number_of_chunks, compression);
+  serializer.Start(make_not_null_unique<serialization::Plugin>(plugin));
+  for (;;) {
+    Bytes const bytes = serializer.Pull();
+    if (bytes.size == 0) {
+      break;
+    }
+    chunks.emplace_back(reinterpret_cast<char const*>(bytes.data),
+                        static_cast<std::size_t>(bytes.size));
+  }
+  return chunks;
+}
+
+void SetBytesLabel(benchmark::State& state,  // NOLINT(runtime/references)
+                   serialization::Plugin const& plugin,
+                   std::vector<std::string> const& chunks) {
+  std::int64_t bytes = 0;
+  for (auto const& chunk : chunks) {
+    bytes += chunk.size();
+  }
+  state.SetLabel(std::to_string(bytes) + " bytes, " +
+                 std::to_string(static_cast<double>(bytes) /
+                                plugin.ByteSize()) +
+                 " of uncompressed");
+}
+
+}  // namespace
+
+// Measures the time taken by the client to pull the entire serialization of the
+// plugin, as |principia__SerializePlugin| does.
+template<Compression compression>
+void BM_PluginSerialization(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  auto const plugin = MakePlugin();
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    // Exclude the copy of the message from the timing.
+    auto message = make_not_null_unique<serialization::Plugin>(*plugin);
+    PullSerializer serializer(chunk_size, number_of_chunks, compression);
+    state.ResumeTiming();
+    serializer.Start(std::move(message));
+    while (serializer.Pull().size != 0) {}
+  }
+  SetBytesLabel(state, *plugin, Serialize(*plugin, compression));
+}
+
+// Measures the time taken to push the serialization of the plugin and to parse
+// it, as |principia__DeserializePlugin| does.  This includes the destruction of
+// the message, which is owned by the deserializer.
+template<Compression compression>
+void BM_PluginDeserialization(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  auto const plugin = MakePlugin();
+  std::vector<std::string> chunks = Serialize(*plugin, compression);
+  while (state.KeepRunning()) {
+    PushDeserializer deserializer(chunk_size, number_of_chunks);
+    deserializer.Start(make_not_null_unique<serialization::Plugin>(),
+                       /*done=*/nullptr);
+    for (auto& chunk : chunks) {
+      deserializer.Push(Bytes(reinterpret_cast<std::uint8_t*>(&chunk[0]),
+                              static_cast<std::int64_t>(chunk.size())),
+                        /*done=*/nullptr);
+    }
+    // Destroying the deserializer waits until deserialization is done.
+    deserializer.Push(Bytes(), /*done=*/nullptr);
+  }
+  SetBytesLabel(state, *plugin, chunks);
+}
+
+BENCHMARK_TEMPLATE(BM_PluginSerialization, Compression::None);
+BENCHMARK_TEMPLATE(BM_PluginSerialization, Compression::Gzip);
+BENCHMARK_TEMPLATE(BM_PluginDeserialization, Compression::None);
+BENCHMARK_TEMPLATE(BM_PluginDeserialization, Compression::Gzip);
+
+}  // namespace base
+}  // namespace principia
@@ -0,0 +1,196 @@
+﻿
+// .\Release\x64\benchmarks.exe --benchmark_filter=ShortSolves  // NOLINT(whitespace/line_length)
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "integrators/embedded_explicit_runge_kutta_nyström_integrator.hpp"
+#include "integrators/ordinary_differential_equations.hpp"
+#include "integrators/symmetric_linear_multistep_integrator.hpp"
+#include "integrators/symplectic_runge_kutta_nyström_integrator.hpp"
+#include "quantities/named_quantities.hpp"
+#include "quantities/quantities.hpp"
+#include "quantities/si.hpp"
+
+// Must come last to avoid conflicts when defining the CHECK macros.
+#include "benchmark/benchmark.h"
+
+namespace {
+
+// Allocations are only counted on a thread while this is true, so that the
+// replacement below behaves like the default |operator new| for the rest of
+// the benchmarks executable.
+thread_local bool count_allocations = false;
+// The number of calls to |operator new| on this thread while
+// |count_allocations| was true.
+thread_local std::int64_t allocations = 0;
+
+}  // namespace
+
+void* operator new(std::size_t const size) {
+  if (count_allocations) {
+    ++allocations;
+  }
+  void* const pointer = std::malloc(size == 0 ? 1 : size);
+  if (pointer == nullptr) {
+    throw std::bad_alloc();
+  }
+  return pointer;
+}
+
+void operator delete(void* const pointer) noexcept {
+  std::free(pointer);
+}
+
+namespace principia {
+
+using quantities::Abs;
+using quantities::Acceleration;
+using quantities::Length;
+using quantities::Mass;
+using quantities::SIUnit;
+using quantities::Speed;
+using quantities::Stiffness;
+using quantities::Time;
+using quantities::si::Metre;
+using quantities::si::Second;
+using ::std::placeholders::_1;
+using ::std::placeholders::_2;
+using ::std::placeholders::_3;
+
+namespace integrators {
+
+namespace {
+
+using ODE = SpecialSecondOrderDifferentialEquation<Length>;
+
+// The number of calls to |Solve| in an iteration of the benchmarks.
+int const solves_per_iteration = 1000;
+// The interval covered by each call to |Solve|.
+Time const solve_interval = 1 * Second;
+
+void ComputeHarmonicOscillatorAcceleration(
+    Instant const& t,
+    std::vector<Length> const& q,
+    std::vector<Acceleration>& result) {
+  result[0] = -q[0] * (SIUnit<Stiffness>() / SIUnit<Mass>());
+}
+
+double HarmonicOscillatorToleranceRatio(
+    Time const& h,
+    ODE::SystemStateError const& error) {
+  return std::min(1e-6 * Metre / Abs(error.position_error[0]),
+                  1e-6 * Metre / Second / Abs(error.velocity_error[0]));
+}
+
+// Calls |Solve| |solves_per_iteration| times on the same |instance|, each time
+// for |solve_interval|, and returns the number of allocations that happened.
+template<typename Integrator>
+std::int64_t SolveRepeatedly(Integrator const& integrator,
+                             IntegrationInstance& instance,
+                             Instant& t_final) {
+  std::int64_t const allocations_before = allocations;
+  count_allocations = true;
+  for (int i = 0; i < solves_per_iteration; ++i) {
+    t_final += solve_interval;
+    integrator.Solve(t_final, instance);
+  }
+  count_allocations = false;
+  return allocations - allocations_before;
+}
+
+void SetAllocationsLabel(benchmark::State& state,  // NOLINT(runtime/references)
+                         std::int64_t const allocations) {
+  state.SetLabel(
+      std::to_string(static_cast<double>(allocations) /
+                     (state.iterations() * solves_per_iteration)) +
+      " allocations/solve");
+}
+
+}  // namespace
+
+// Integrates a harmonic oscillator by many short calls to |Solve| on the same
+// instance, the way the prolongations of the vessels are integrated, and
+// reports the number of allocations per call.
+template<typename Integrator, Integrator const& (*integrator)()>
+void BM_ShortSolvesFixedStep(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  ODE::SystemState last_state;
+  ODE harmonic_oscillator;
+  harmonic_oscillator.compute_acceleration =
+      std::bind(ComputeHarmonicOscillatorAcceleration, _1, _2, _3);
+  Instant t_final;
+  ODE::SystemState const initial_state = {{1 * Metre}, {0 * Metre / Second},
+                                          t_final};
+  auto const instance = integrator().NewInstance(
+      {harmonic_oscillator, &initial_state},
+      [&last_state](ODE::SystemState const& state) {
+        last_state = state;
+      },
+      /*step=*/0.1 * Second);
+  // The startup of the multistep integrators allocates, exclude it.
+  t_final += 10 * solve_interval;
+  integrator().Solve(t_final, *instance);
+
+  std::int64_t allocations = 0;
+  while (state.KeepRunning()) {
+    allocations += SolveRepeatedly(integrator(), *instance, t_final);
+  }
+  SetAllocationsLabel(state, allocations);
+}
+
+template<typename Integrator, Integrator const& (*integrator)()>
+void BM_ShortSolvesAdaptiveStep(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  ODE::SystemState last_state;
+  ODE harmonic_oscillator;
+  harmonic_oscillator.compute_acceleration =
+      std::bind(ComputeHarmonicOscillatorAcceleration, _1, _2, _3);
+  Instant t_final;
+  ODE::SystemState const initial_state = {{1 * Metre}, {0 * Metre / Second},
+                                          t_final};
+  AdaptiveStepSize<ODE> adaptive_step_size;
+  adaptive_step_size.first_time_step = solve_interval;
+  adaptive_step_size.safety_factor = 0.9;
+  adaptive_step_size.tolerance_to_error_ratio =
+      &HarmonicOscillatorToleranceRatio;
+  adaptive_step_size.max_steps = std::numeric_limits<std::int64_t>::max();
+  auto const instance = integrator().NewInstance(
+      {harmonic_oscillator, &initial_state},
+      [&last_state](ODE::SystemState const& state) {
+        last_state = state;
+      },
+      adaptive_step_size);
+
+  std::int64_t allocations = 0;
+  while (state.KeepRunning()) {
+    allocations += SolveRepeatedly(integrator(), *instance, t_final);
+  }
+  SetAllocationsLabel(state, allocations);
+}
+
+// Keep each argument on a single line below, lest it breaks benchmark parsing.
+
+BENCHMARK_TEMPLATE2(
+    BM_ShortSolvesFixedStep,
+    decltype(McLachlanAtela1992Order5Optimal<Length>()),
+    &McLachlanAtela1992Order5Optimal<Length>);
+
+BENCHMARK_TEMPLATE2(
+    BM_ShortSolvesFixedStep,
+    decltype(Quinlan1999Order8A<Length>()),
+    &Quinlan1999Order8A<Length>);
+
+BENCHMARK_TEMPLATE2(
+    BM_ShortSolvesAdaptiveStep,
+    decltype(DormandElMikkawyPrince1986RKN434FM<Length>()),
+    &DormandElMikkawyPrince1986RKN434FM<Length>);
+
+}  // namespace integrators
+}  // namespace principia
@@ -0,0 +1,354 @@
+﻿
+// .\Release\x64\benchmarks.exe --benchmark_filter=BM_SolarSystem --benchmark_format=json  // NOLINT(whitespace/line_length)
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "astronomy/frames.hpp"
+#include "geometry/grassmann.hpp"
+#include "geometry/named_quantities.hpp"
+#include "integrators/embedded_explicit_runge_kutta_nyström_integrator.hpp"
+#include "integrators/ordinary_differential_equations.hpp"
+#include "integrators/symmetric_linear_multistep_integrator.hpp"
+#include "integrators/symplectic_runge_kutta_nyström_integrator.hpp"
+#include "physics/solar_system.hpp"
+#include "quantities/elementary_functions.hpp"
+#include "quantities/named_quantities.hpp"
+#include "quantities/quantities.hpp"
+#include "quantities/si.hpp"
+
+// Must come last to avoid conflicts when defining the CHECK macros.
+#include "benchmark/benchmark.h"
+
+namespace principia {
+
+using astronomy::ICRFJ2000Equator;
+using geometry::Displacement;
+using geometry::InnerProduct;
+using geometry::Position;
+using geometry::Vector;
+using geometry::Velocity;
+using physics::SolarSystem;
+using quantities::Abs;
+using quantities::Acceleration;
+using quantities::DebugString;
+using quantities::Exponentiation;
+using quantities::GravitationalParameter;
+using quantities::Length;
+using quantities::Product;
+using quantities::SpecificEnergy;
+using quantities::Speed;
+using quantities::Sqrt;
+using quantities::Square;
+using quantities::Time;
+using quantities::si::Day;
+using quantities::si::Metre;
+using quantities::si::Minute;
+using quantities::si::Second;
+
+namespace integrators {
+
+namespace {
+
+using ODE = SpecialSecondOrderDifferentialEquation<Position<ICRFJ2000Equator>>;
+
+// The total energy of the bodies multiplied by the gravitational constant, so
+// that it may be computed from the gravitational parameters.
+using GravitationalEnergy = Product<GravitationalParameter, SpecificEnergy>;
+
+// The interval covered by each integration.
+Time const integration_duration = 100 * Day;
+
+// The number of evaluations of the right-hand side since the start of the
+// process.
+std::int64_t evaluations = 0;
+
+// The massive bodies of the solar system at JD2433282.5, as point masses:
+// the oblateness of the bodies doesn't change the relative costs of the
+// integrators, and ignoring it keeps the right-hand side simple enough that the
+// evaluations can be counted.
+struct SolarSystemProblem {
+  std::vector<GravitationalParameter> gravitational_parameters;
+  ODE::SystemState initial_state;
+};
+
+SolarSystemProblem const& Problem() {
+  static SolarSystemProblem const* const problem = [] {
+    SolarSystem<ICRFJ2000Equator> solar_system;
+    solar_system.Initialize(
+        SOLUTION_DIR / "astronomy" / "gravity_model.proto.txt",
+        SOLUTION_DIR / "astronomy" /
+            "initial_state_jd_2433282_500000000.proto.txt");
+    auto* const problem = new SolarSystemProblem;
+    for (std::string const& name : solar_system.names()) {
+      auto const degrees_of_freedom = solar_system.initial_state(name);
+      problem->gravitational_parameters.push_back(
+          solar_system.gravitational_parameter(name));
+      problem->initial_state.positions.emplace_back(
+          degrees_of_freedom.position());
+      problem->initial_state.velocities.emplace_back(
+          degrees_of_freedom.velocity());
+    }
+    problem->initial_state.time =
+        DoublePrecision<Instant>(solar_system.epoch());
+    return problem;
+  }();
+  return *problem;
+}
+
+void ComputeGravitationalAccelerations(
+    Instant const& t,
+    std::vector<Position<ICRFJ2000Equator>> const& q,
+    std::vector<Vector<Acceleration, ICRFJ2000Equator>>& result) {
+  ++evaluations;
+  std::vector<GravitationalParameter> const& μ =
+      Problem().gravitational_parameters;
+  for (auto& acceleration : result) {
+    acceleration = Vector<Acceleration, ICRFJ2000Equator>();
+  }
+  for (int i = 0; i < q.size(); ++i) {
+    for (int j = i + 1; j < q.size(); ++j) {
+      Displacement<ICRFJ2000Equator> const Δq = q[i] - q[j];
+      Square<Length> const Δq² = InnerProduct(Δq, Δq);
+      Exponentiation<Length, -3> const one_over_Δq³ = 1 / (Δq² * Sqrt(Δq²));
+      result[i] -= Δq * μ[j] * one_over_Δq³;
+      result[j] += Δq * μ[i] * one_over_Δq³;
+    }
+  }
+}
+
+GravitationalEnergy Energy(ODE::SystemState const& state) {
+  std::vector<GravitationalParameter> const& μ =
+      Problem().gravitational_parameters;
+  GravitationalEnergy energy;
+  for (int i = 0; i < state.positions.size(); ++i) {
+    Velocity<ICRFJ2000Equator> const& v = state.velocities[i].value;
+    energy += 0.5 * μ[i] * InnerProduct(v, v);
+    for (int j = i + 1; j < state.positions.size(); ++j) {
+      energy -= μ[i] * μ[j] /
+                (state.positions[i].value - state.positions[j].value).Norm();
+    }
+  }
+  return energy;
+}
+
+ODE Equation() {
+  ODE equation;
+  equation.compute_acceleration = &ComputeGravitationalAccelerations;
+  return equation;
+}
+
+// The state at the end of the integration, computed with a sixth-order method
+// and a step short enough that its error is negligible compared to that of the
+// integrations being benchmarked.
+ODE::SystemState const& ReferenceFinalState() {
+  static ODE::SystemState const* const reference_final_state = [] {
+    auto& integrator = BlanesMoan2002SRKN14A<Position<ICRFJ2000Equator>>();
+    auto* const final_state = new ODE::SystemState;
+    auto const instance = integrator.NewInstance(
+        {Equation(), &Problem().initial_state},
+        [final_state](ODE::SystemState const& state) {
+          *final_state = state;
+        },
+        /*step=*/1 * Minute);
+    integrator.Solve(Problem().initial_state.time.value + integration_duration,
+                     *instance);
+    return final_state;
+  }();
+  return *reference_final_state;
+}
+
+double ToleranceToErrorRatio(Length const& length_integration_tolerance,
+                             Speed const& speed_integration_tolerance,
+                             Time const& current_step_size,
+                             ODE::SystemStateError const& error) {
+  Length max_length_error;
+  Speed max_speed_error;
+  for (auto const& position_error : error.position_error) {
+    max_length_error = std::max(max_length_error, position_error.Norm());
+  }
+  for (auto const& velocity_error : error.velocity_error) {
+    max_speed_error = std::max(max_speed_error, velocity_error.Norm());
+  }
+  return std::min(length_integration_tolerance / max_length_error,
+                  speed_integration_tolerance / max_speed_error);
+}
+
+// Reports the work and the precision of an integration ending at
+// |final_state|.  The label is a list of space-separated key=value pairs so
+// that it may be parsed from the output of --benchmark_format=json:
+// - evaluations: the number of evaluations of the right-hand side;
+// - energy_error: the relative error on the total energy;
+// - position_error_m: the largest distance between a body and its position in
+//   the reference integration, in metres.
+void SetWorkPrecisionLabel(
+    benchmark::State& state,  // NOLINT(runtime/references)
+    std::int64_t const evaluations_per_integration,
+    ODE::SystemState const& final_state) {
+  ODE::SystemState const& reference_final_state = ReferenceFinalState();
+  CHECK_EQ(reference_final_state.time.value, final_state.time.value);
+  GravitationalEnergy const initial_energy = Energy(Problem().initial_state);
+  double const energy_error =
+      Abs((Energy(final_state) - initial_energy) / initial_energy);
+  Length position_error;
+  for (int i = 0; i < final_state.positions.size(); ++i) {
+    position_error =
+        std::max(position_error,
+                 (final_state.positions[i].value -
+                  reference_final_state.positions[i].value).Norm());
+  }
+  state.SetLabel("evaluations=" + std::to_string(evaluations_per_integration) +
+                 " energy_error=" + DebugString(energy_error) +
+                 " position_error_m=" + DebugString(position_error / Metre));
+}
+
+}  // namespace
+
+// Integrates the solar system for |integration_duration|.  The argument is the
+// step, in minutes; it must divide |integration_duration|.
+template<typename Integrator, Integrator const& (*integrator)()>
+void BM_SolarSystemFixedStep(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  Time const step = state.range_x() * Minute;
+  Instant const t_final =
+      Problem().initial_state.time.value + integration_duration;
+  ODE::SystemState final_state;
+  std::int64_t evaluations_per_integration;
+  while (state.KeepRunning()) {
+    std::int64_t const evaluations_before = evaluations;
+    auto const instance = integrator().NewInstance(
+        {Equation(), &Problem().initial_state},
+        [&final_state](ODE::SystemState const& state) {
+          final_state = state;
+        },
+        step);
+    integrator().Solve(t_final, *instance);
+    evaluations_per_integration = evaluations - evaluations_before;
+  }
+  SetWorkPrecisionLabel(state, evaluations_per_integration, final_state);
+}
+
+// Integrates the solar system for |integration_duration|.  The argument is the
+// decimal logarithm of the integration tolerances, in metres and metres per
+// second.
+template<typename Integrator, Integrator const& (*integrator)()>
+void BM_SolarSystemAdaptiveStep(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  Length const length_integration_tolerance =
+      std::pow(10.0, state.range_x()) * Metre;
+  Speed const speed_integration_tolerance =
+      std::pow(10.0, state.range_x()) * Metre / Second;
+  Instant const t_final =
+      Problem().initial_state.time.value + integration_duration;
+  AdaptiveStepSize<ODE> adaptive_step_size;
+  adaptive_step_size.first_time_step = integration_duration;
+  adaptive_step_size.safety_factor = 0.9;
+  adaptive_step_size.tolerance_to_error_ratio =
+      [length_integration_tolerance, speed_integration_tolerance](
+          Time const& current_step_size,
+          ODE::SystemStateError const& error) {
+        return ToleranceToErrorRatio(length_integration_tolerance,
+                                     speed_integration_tolerance,
+                                     current_step_size,
+                                     error);
+      };
+  ODE::SystemState final_state;
+  std::int64_t evaluations_per_integration;
+  while (state.KeepRunning()) {
+    std::int64_t const evaluations_before = evaluations;
+    auto const instance = integrator().NewInstance(
+        {Equation(), &Problem().initial_state},
+        [&final_state](ODE::SystemState const& state) {
+          final_state = state;
+        },
+        adaptive_step_size);
+    CHECK_OK(integrator().Solve(t_final, *instance));
+    evaluations_per_integration = evaluations - evaluations_before;
+  }
+  SetWorkPrecisionLabel(state, evaluations_per_integration, final_state);
+}
+
+// Keep each argument on a single line below, lest it breaks benchmark parsing.
+
+BENCHMARK_TEMPLATE2(
+    BM_SolarSystemFixedStep,
+    decltype(McLachlanAtela1992Order4Optimal<Position<ICRFJ2000Equator>>()),
+    &McLachlanAtela1992Order4Optimal<Position<ICRFJ2000Equator>>)
+    ->Arg(5)->Arg(10)->Arg(20)->Arg(45)->Arg(90);
+BENCHMARK_TEMPLATE2(
+    BM_SolarSystemFixedStep,
+    decltype(McLachlan1995SB3A4<Position<ICRFJ2000Equator>>()),
+    &McLachlan1995SB3A4<Position<ICRFJ2000Equator>>)
+    ->Arg(5)->Arg(10)->Arg(20)->Arg(45)->Arg(90);
+BENCHMARK_TEMPLATE2(
+    BM_SolarSystemFixedStep,
+    decltype(McLachlan1995SB3A5<Position<ICRFJ2000Equator>>()),
+    &McLachlan1995SB3A5<Position<ICRFJ2000Equator>>)
+    ->Arg(5)->Arg(10)->Arg(20)->Arg(45)->Arg(90);
+BENCHMARK_TEMPLATE2(
+    BM_SolarSystemFixedStep,
+    decltype(BlanesMoan2002SRKN6B<Position<ICRFJ2000Equator>>()),
+    &BlanesMoan2002SRKN6B<Position<ICRFJ2000Equator>>)
+    ->Arg(5)->Arg(10)->Arg(20)->Arg(45)->Arg(90);
+BENCHMARK_TEMPLATE2(
+    BM_SolarSystemFixedStep,
+    decltype(McLachlanAtela1992Order5Optimal<Position<ICRFJ2000Equator>>()),
+    &McLachlanAtela1992Order5Optimal<Position<ICRFJ2000Equator>>)
+    ->Arg(5)->Arg(10)->Arg(20)->Arg(45)->Arg(90);
+BENCHMARK_TEMPLATE2(
+    BM_SolarSystemFixedStep,
+    decltype(OkunborSkeel1994Order6Method13<Position<ICRFJ2000Equator>>()),
+    &OkunborSkeel1994Order6Method13<Position<ICRFJ2000Equator>>)
+    ->Arg(5)->Arg(10)->Arg(20)->Arg(45)->Arg(90);
+BENCHMARK_TEMPLATE2(
+    BM_SolarSystemFixedStep,
+    decltype(BlanesMoan2002SRKN11B<Position<ICRFJ2000Equator>>()),
+    &BlanesMoan2002SRKN11B<Position<ICRFJ2000Equator>>)
+    ->Arg(5)->Arg(10)->Arg(20)->Arg(45)->Arg(90);
+BENCHMARK_TEMPLATE2(
+    BM_SolarSystemFixedStep,
+    decltype(BlanesMoan2002SRKN14A<Position<ICRFJ2000Equator>>()),
+    &BlanesMoan2002SRKN14A<Position<ICRFJ2000Equator>>)
+    ->Arg(5)->Arg(10)->Arg(20)->Arg(45)->Arg(90);
+BENCHMARK_TEMPLATE2(
+    BM_SolarSystemFixedStep,
+    decltype(Quinlan1999Order8A<Position<ICRFJ2000Equator>>()),
+    &Quinlan1999Order8A<Position<ICRFJ2000Equator>>)
+    ->Arg(5)->Arg(10)->Arg(20)->Arg(45)->Arg(90);
+BENCHMARK_TEMPLATE2(
+    BM_SolarSystemFixedStep,
+    decltype(Quinlan1999Order8B<Position<ICRFJ2000Equator>>()),
+    &Quinlan1999Order8B<Position<ICRFJ2000Equator>>)
+    ->Arg(5)->Arg(10)->Arg(20)->Arg(45)->Arg(90);
+BENCHMARK_TEMPLATE2(
+    BM_SolarSystemFixedStep,
+    decltype(QuinlanTremaine1990Order8<Position<ICRFJ2000Equator>>()),
+    &QuinlanTremaine1990Order8<Position<ICRFJ2000Equator>>)
+    ->Arg(5)->Arg(10)->Arg(20)->Arg(45)->Arg(90);
+BENCHMARK_TEMPLATE2(
+    BM_SolarSystemFixedStep,
+    decltype(QuinlanTremaine1990Order10<Position<ICRFJ2000Equator>>()),
+    &QuinlanTremaine1990Order10<Position<ICRFJ2000Equator>>)
+    ->Arg(5)->Arg(10)->Arg(20)->Arg(45)->Arg(90);
+BENCHMARK_TEMPLATE2(
+    BM_SolarSystemFixedStep,
+    decltype(QuinlanTremaine1990Order12<Position<ICRFJ2000Equator>>()),
+    &QuinlanTremaine1990Order12<Position<ICRFJ2000Equator>>)
+    ->Arg(5)->Arg(10)->Arg(20)->Arg(45)->Arg(90);
+BENCHMARK_TEMPLATE2(
+    BM_SolarSystemFixedStep,
+    decltype(QuinlanTremaine1990Order14<Position<ICRFJ2000Equator>>()),
+    &QuinlanTremaine1990Order14<Position<ICRFJ2000Equator>>)
+    ->Arg(5)->Arg(10)->Arg(20)->Arg(45)->Arg(90);
+
+BENCHMARK_TEMPLATE2(
+    BM_SolarSystemAdaptiveStep,
+    decltype(DormandElMikkawyPrince1986RKN434FM<Position<ICRFJ2000Equator>>()),
+    &DormandElMikkawyPrince1986RKN434FM<Position<ICRFJ2000Equator>>)
+    ->Arg(-3)->Arg(0)->Arg(3);
+
+}  // namespace integrators
+}  // namespace principia
@@ -217,6 +217,75 @@ void BM_EvaluateDisplacement(
   state.SetLabel(ss.str().substr(0, 0));
 }
 
+// Evaluates |state.range_x()| series of degree |state.range_y()| on the same
+// interval, as happens when evaluating the positions of all the celestials of
+// an ephemeris, either one at a time or as a |ЧебышёвSeriesBatch|.
+template<bool batched>
+void EvaluateDisplacements(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  int const number_of_series = state.range_x();
+  int const degree = state.range_y();
+  std::mt19937_64 random(42);
+  Instant const t0;
+  Instant const t_min = t0 + static_cast<double>(random()) * Second;
+  Instant const t_max = t_min + static_cast<double>(random()) * Second;
+  std::vector<ЧебышёвSeries<Displacement<ICRFJ2000Ecliptic>>> all_series;
+  for (int s = 0; s < number_of_series; ++s) {
+    std::vector<Displacement<ICRFJ2000Ecliptic>> coefficients;
+    for (int i = 0; i <= degree; ++i) {
+      coefficients.push_back(
+          Displacement<ICRFJ2000Ecliptic>(
+              {static_cast<double>(random()) * Metre,
+               static_cast<double>(random()) * Metre,
+               static_cast<double>(random()) * Metre}));
+    }
+    all_series.emplace_back(coefficients, t_min, t_max);
+  }
+  std::vector<not_null<ЧебышёвSeries<Displacement<ICRFJ2000Ecliptic>> const*>>
+      series;
+  for (auto const& s : all_series) {
+    series.push_back(&s);
+  }
+
+  Instant t = t_min;
+  Time const Δt = (t_max - t_min) * 1e-9;
+  Displacement<ICRFJ2000Ecliptic> result{};
+  std::vector<Displacement<ICRFJ2000Ecliptic>> values(number_of_series);
+
+  ЧебышёвSeriesBatch<Displacement<ICRFJ2000Ecliptic>> batch;
+  batch.Reset(series);
+
+  while (state.KeepRunning()) {
+    for (int i = 0; i < evaluations_per_iteration; ++i) {
+      if (batched) {
+        batch.Evaluate(t, values);
+      } else {
+        for (int s = 0; s < number_of_series; ++s) {
+          values[s] = series[s]->Evaluate(t);
+        }
+      }
+      result += values.back();
+      t += Δt;
+    }
+  }
+
+  // This weird call to |SetLabel| has no effect except that it uses |result|
+  // and therefore prevents the loop from being optimized away.
+  std::stringstream ss;
+  ss << result;
+  state.SetLabel(ss.str().substr(0, 0));
+}
+
+void BM_EvaluateDisplacementsOneAtATime(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  EvaluateDisplacements</*batched=*/false>(state);
+}
+
+void BM_EvaluateDisplacementsBatch(
+    benchmark::State& state) {  // NOLINT(runtime/references)
+  EvaluateDisplacements</*batched=*/true>(state);
+}
+
 void BM_NewhallApproximation(
     benchmark::State& state) {  // NOLINT(runtime/references)
   int const degree = state.range_x();
@@ -251,6 +320,12 @@ BENCHMARK(BM_EvaluateVectorDouble)->
     Arg(4)->Arg(8)->Arg(15)->Arg(16)->Arg(17)->Arg(18)->Arg(19);
 BENCHMARK(BM_EvaluateDisplacement)->
     Arg(4)->Arg(8)->Arg(15)->Arg(16)->Arg(17)->Arg(18)->Arg(19);
+BENCHMARK(BM_EvaluateDisplacementsOneAtATime)->
+    ArgPair(4, 8)->ArgPair(4, 17)->ArgPair(18, 8)->ArgPair(18, 17)->
+    ArgPair(100, 8)->ArgPair(100, 17);
+BENCHMARK(BM_EvaluateDisplacementsBatch)->
+    ArgPair(4, 8)->ArgPair(4, 17)->ArgPair(18, 8)->ArgPair(18, 17)->
+    ArgPair(100, 8)->ArgPair(100, 17);
 BENCHMARK(BM_NewhallApproximation)->
     Arg(4)->Arg(8)->Arg(16);
 
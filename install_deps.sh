@@ -1,9 +1,9 @@
 #!/bin/bash
 
-echo "Required prerequisites for build: build-essential clang libc++-dev libc++abi-dev monodevelop subversion git"
+echo "Required prerequisites for build: build-essential clang libc++-dev libc++abi-dev zlib1g-dev monodevelop subversion git"
 echo "Required runtime dependencies: libc++1"
 
-#sudo apt-get install clang git unzip wget libc++-dev binutils make automake libtool curl cmake subversion
+#sudo apt-get install clang git unzip wget libc++-dev zlib1g-dev binutils make automake libtool curl cmake subversion
 
 BASE_FLAGS="-fPIC -O3 -g"
 # determine platform for bitness
@@ -34,7 +34,8 @@ pushd protobuf
 if [ "$PLATFORM" == "Linux" ]; then
     ./autogen.sh # Really definitely needs to run twice on Ubuntu for some reason.
 fi
-./configure CC=clang CXX=clang++ CXXFLAGS="$CXX_FLAGS" LDFLAGS="$LD_FLAGS" LIBS="-lc++ -lc++abi"
+# The gzip streams used by the plugin serialization require zlib.
+./configure CC=clang CXX=clang++ CXXFLAGS="$CXX_FLAGS" LDFLAGS="$LD_FLAGS" LIBS="-lc++ -lc++abi" --with-zlib
 make -j8
 popd
 
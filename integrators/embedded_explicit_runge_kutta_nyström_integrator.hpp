@@ -9,11 +9,15 @@
 #ifndef PRINCIPIA_INTEGRATORS_EMBEDDED_EXPLICIT_RUNGE_KUTTA_NYSTRÖM_INTEGRATOR_HPP_  // NOLINT(whitespace/line_length)
 #define PRINCIPIA_INTEGRATORS_EMBEDDED_EXPLICIT_RUNGE_KUTTA_NYSTRÖM_INTEGRATOR_HPP_  // NOLINT(whitespace/line_length)
 
+#include <array>
+#include <experimental/optional>
 #include <functional>
+#include <utility>
 #include <vector>
 
 #include "base/not_null.hpp"
 #include "base/status.hpp"
+#include "geometry/sign.hpp"
 #include "numerics/fixed_arrays.hpp"
 #include "integrators/ordinary_differential_equations.hpp"
 #include "quantities/named_quantities.hpp"
@@ -23,6 +27,7 @@ namespace principia {
 
 using base::not_null;
 using base::Status;
+using geometry::Sign;
 using numerics::FixedStrictlyLowerTriangularMatrix;
 using numerics::FixedVector;
 using quantities::Time;
@@ -83,22 +88,252 @@ class EmbeddedExplicitRungeKuttaNyströmIntegrator
   Status Solve(Instant const& t_final,
                IntegrationInstance& instance) const override;
 
+  std::vector<Status> SolveInLockstep(
+      std::vector<Instant> const& t_finals,
+      std::vector<not_null<IntegrationInstance*>> const& instances,
+      typename ODE::BatchedRightHandSideComputation const&
+          compute_accelerations) const override;
+
+  // Same as |Solve|, for an |instance| whose system has dimension 1, but the
+  // right-hand side is |compute_acceleration| instead of the
+  // |compute_acceleration| of the equation of the |instance|.  It is called as
+  // |compute_acceleration(t, q)| and returns the acceleration at time |t| and
+  // position |q|.  Since it is inlined in the stages, which are held in
+  // fixed-size arrays, this is faster than |Solve| for a single body.
+  template<typename RightHandSide>
+  Status SolveSingleBody(
+      Instant const& t_final,
+      IntegrationInstance& instance,
+      RightHandSide const& compute_acceleration) const;
+
+  not_null<std::unique_ptr<IntegrationInstance>> NewInstance(
+    IntegrationProblem<ODE> const& problem,
+    IntegrationInstance::AppendState<ODE> append_state,
+    AdaptiveStepSize<ODE> const& adaptive_step_size) const override;
+
   not_null<std::unique_ptr<IntegrationInstance>> NewInstance(
     IntegrationProblem<ODE> const& problem,
     IntegrationInstance::AppendState<ODE> append_state,
+    IntegrationInstance::AppendDenseOutput<ODE> append_dense_output,
+    AdaptiveStepSize<ODE> const& adaptive_step_size) const override;
+
+  not_null<std::unique_ptr<IntegrationInstance>> NewInstance(
+    IntegrationProblem<ODE> const& problem,
+    IntegrationInstance::AppendState<ODE> append_state,
+    IntegrationInstance::AppendDenseOutput<ODE> append_dense_output,
+    std::vector<IntegrationEvent<ODE>> events,
+    IntegrationInstance::AppendEvent<ODE> append_event,
     AdaptiveStepSize<ODE> const& adaptive_step_size) const override;
 
  protected:
   struct Instance : public IntegrationInstance {
     Instance(IntegrationProblem<ODE> problem,
              AppendState<ODE> append_state,
+             AppendDenseOutput<ODE> append_dense_output,
+             std::vector<IntegrationEvent<ODE>> events,
+             AppendEvent<ODE> append_event,
              AdaptiveStepSize<ODE> adaptive_step_size);
     ODE equation;
     typename ODE::SystemState current_state;
     AppendState<ODE> const append_state;
+    // May be empty, in which case no dense output is computed unless there are
+    // |events|.
+    AppendDenseOutput<ODE> const append_dense_output;
+    std::vector<IntegrationEvent<ODE>> const events;
+    AppendEvent<ODE> const append_event;
     AdaptiveStepSize<ODE> const adaptive_step_size;
+
+    // For each of the |events|, the last nonzero value of its function, or 0
+    // if it has only vanished so far.  An event occurs when the sign of the
+    // function differs from that of this value.
+    std::vector<double> event_values;
+
+    // The following fields are scratch storage for the integration.  They are
+    // sized once and for all by the constructor, so that the calls to |Solve|
+    // don't allocate.
+    // Position increment (high-order).
+    std::vector<typename ODE::Displacement> Δq_hat;
+    // Velocity increment (high-order).
+    std::vector<typename ODE::Velocity> Δv_hat;
+    // Difference between the low- and high-order approximations.
+    typename ODE::SystemStateError error_estimate;
+    // Current Runge-Kutta-Nyström stage.
+    std::vector<Position> q_stage;
+    // Accelerations at each stage.
+    // TODO(egg): this is a rectangular container, use something more
+    // appropriate.
+    std::vector<std::vector<typename ODE::Acceleration>> g;
+    // The interpolant over the last step, if a dense output is needed.
+    typename ODE::DenseOutput dense_output;
+    // State before the last, truncated step.
+    typename ODE::SystemState final_state;
+    // The values of the event functions at the end of the step.
+    std::vector<double> new_event_values;
+    // The times and indices of the events that occur during the step.
+    std::vector<std::pair<Instant, int>> event_occurrences;
+    // The arguments of the event functions.
+    std::vector<Position> event_positions;
+    std::vector<typename ODE::Velocity> event_velocities;
+    // The state at an event.
+    typename ODE::SystemState event_state;
+  };
+
+  // The state of the integration of an instance by |Solve|.
+  struct Integration {
+    Integration(Instant const& t_final, not_null<Instance*> instance);
+
+    Instant const t_final;
+    not_null<Instance*> const instance;
+    Sign const integration_direction;
+
+    // Time step.
+    Time h;
+    double tolerance_to_error_ratio;
+    // False until the first step has been tried, since there is no step size
+    // control on the first step.
+    bool first_step_tried = false;
+    // True if the step being tried is truncated to reach |t_final|, in which
+    // case |instance->final_state| is the state before that step.
+    bool at_end = false;
+    // The first stage of the Runge-Kutta-Nyström iteration.  In the FSAL case,
+    // |first_stage == 1| after the first step, since the first RHS evaluation
+    // has already occured in the previous step.  In the non-FSAL case and in
+    // the first step of the FSAL case, |first_stage == 0|.
+    int first_stage = 0;
+    // The number of steps already performed.
+    std::int64_t step_count = 0;
+    // Set when the integration terminates.
+    std::experimental::optional<Status> status;
+  };
+
+  // The coordinates used by the steps of an integration: the high-order
+  // solution at the beginning of the step, its increments, and the positions
+  // and accelerations of the stages.  These are the |std::vector|s of the
+  // |instance|, and the right-hand side is that of its |equation|.
+  struct InstanceCoordinates {
+    explicit InstanceCoordinates(Instance& instance);
+
+    // Computes the accelerations |g[i]| at time |t| and positions |q_stage|.
+    void ComputeAcceleration(Instant const& t, int i);
+    // Copies the high-order solution to the |current_state| of the |instance|;
+    // a no-op since it is the |current_state|.
+    void StoreState() const;
+    // Resets the |dense_output| of the |instance| to the interpolant over the
+    // step of size |h| that starts at its |current_state|.
+    void ResetDenseOutput(Time const& h) const;
+
+    Instance& instance;
+    std::vector<DoublePrecision<Position>>& q_hat;
+    std::vector<DoublePrecision<typename ODE::Velocity>>& v_hat;
+    std::vector<typename ODE::Displacement>& Δq_hat;
+    std::vector<typename ODE::Velocity>& Δv_hat;
+    std::vector<Position>& q_stage;
+    std::vector<std::vector<typename ODE::Acceleration>>& g;
+  };
+
+  // Same as above for a system of dimension 1 whose right-hand side is
+  // |compute_acceleration|, see |SolveSingleBody|.  The coordinates are
+  // fixed-size arrays, and are copied to the |instance| only when a state is
+  // appended or a dense output is needed.
+  template<typename RightHandSide>
+  struct SingleBodyCoordinates {
+    SingleBodyCoordinates(Instance& instance,
+                          RightHandSide const& compute_acceleration);
+
+    void ComputeAcceleration(Instant const& t, int i);
+    void StoreState() const;
+    void ResetDenseOutput(Time const& h) const;
+
+    Instance& instance;
+    RightHandSide const& compute_acceleration;
+    std::array<DoublePrecision<Position>, 1> q_hat;
+    std::array<DoublePrecision<typename ODE::Velocity>, 1> v_hat;
+    std::array<typename ODE::Displacement, 1> Δq_hat;
+    std::array<typename ODE::Velocity, 1> Δv_hat;
+    std::array<Position, 1> q_stage;
+    std::array<std::array<typename ODE::Acceleration, 1>, stages> g;
   };
 
+  // Same as |InstanceCoordinates|, for the instance of index |system| in an
+  // integration in lockstep.  The accelerations of the stages are computed in
+  // batches by |IntegrateInLockstep|, so |ComputeAcceleration| is only called
+  // for the evaluation at the end of a step, and computes a batch of one.
+  struct LockstepCoordinates : InstanceCoordinates {
+    LockstepCoordinates(Instance& instance,
+                        int system,
+                        typename ODE::BatchedRightHandSideComputation const&
+                            compute_accelerations);
+
+    void ComputeAcceleration(Instant const& t, int i);
+
+    int const system;
+    typename ODE::BatchedRightHandSideComputation const& compute_accelerations;
+    std::vector<typename ODE::RightHandSideEvaluation> evaluations;
+  };
+
+  // The state of the integration of one of the instances of
+  // |SolveInLockstep|.
+  struct Lane {
+    Lane(Instant const& t_final,
+         not_null<Instance*> instance,
+         int system,
+         typename ODE::BatchedRightHandSideComputation const&
+             compute_accelerations);
+
+    Integration integration;
+    LockstepCoordinates coordinates;
+  };
+
+  // The value of |static_dimension| below when the dimension of the systems is
+  // only known at run time.
+  static constexpr int dynamic_dimension = 0;
+
+  // Advances the |integration| until it terminates, using the given
+  // |coordinates|, an |InstanceCoordinates| or a |SingleBodyCoordinates|.  If
+  // |static_dimension| is not |dynamic_dimension|, it must be the dimension of
+  // the system, and the loops over the coordinates have bounds known at
+  // compile time.
+  template<int static_dimension, typename Coordinates>
+  void Integrate(Integration& integration, Coordinates& coordinates) const;
+
+  // Advances the |lanes| in lockstep until the integration of each of them has
+  // terminated.  Each lane tries its own steps, but the stages of all the lanes
+  // are evaluated together by |compute_accelerations|, one stage at a time.
+  // The |system| of an evaluation is the index of its lane in |lanes|.
+  template<int static_dimension>
+  void IntegrateInLockstep(
+      std::vector<Lane>& lanes,
+      typename ODE::BatchedRightHandSideComputation const&
+          compute_accelerations) const;
+
+  // The steps of the |integration|.
+  // Chooses the step size of the next step to be tried.  Sets
+  // |integration.status| if the step size vanishes.
+  void PrepareStep(Integration& integration) const;
+  // Computes the positions |q_stage| of stage |i| of the step of
+  // |integration|, and returns the time of that stage.
+  template<int static_dimension, typename Coordinates>
+  Instant PrepareStage(int i,
+                       Integration const& integration,
+                       Coordinates& coordinates) const;
+  // Computes stage |i| of the step of |integration|.
+  template<int static_dimension, typename Coordinates>
+  void ComputeStage(int i,
+                    Integration& integration,
+                    Coordinates& coordinates) const;
+  // Accepts or rejects the step of |integration| once all its stages have been
+  // computed.  Sets |integration.status| if the integration terminates.
+  template<int static_dimension, typename Coordinates>
+  void FinishStep(Integration& integration, Coordinates& coordinates) const;
+
+  // Detects the occurrences of the events of |instance| during the step
+  // described by |dense_output|, which ends at |instance.current_state|, and
+  // passes them to its |append_event| in chronological order.  If one of them
+  // is terminal, the later ones are ignored, |instance.current_state| is
+  // replaced by the state at that event, and the result is true.
+  bool DetectEvents(typename ODE::DenseOutput const& dense_output,
+                    Instance& instance) const;
+
   FixedVector<double, stages> const c_;
   FixedStrictlyLowerTriangularMatrix<double, stages> const a_;
   FixedVector<double, stages> const b_hat_;
@@ -4,18 +4,25 @@
 #include "integrators/embedded_explicit_runge_kutta_nyström_integrator.hpp"
 
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <ctime>
 #include <experimental/optional>
+#include <string>
+#include <utility>
 #include <vector>
 
+#include "base/bundle.hpp"
 #include "geometry/sign.hpp"
 #include "glog/logging.h"
+#include "numerics/root_finders.hpp"
 #include "quantities/quantities.hpp"
 
 namespace principia {
 
-using geometry::Sign;
+using base::AbortRequested;
+using base::dynamic_cast_not_null;
+using numerics::Bisect;
 using quantities::DebugString;
 using quantities::Difference;
 using quantities::Quotient;
@@ -47,6 +54,12 @@ DormandElMikkawyPrince1986RKN434FM() {
   return integrator;
 }
 
+template<typename Position, int higher_order, int lower_order, int stages,
+         bool first_same_as_last>
+constexpr int EmbeddedExplicitRungeKuttaNyströmIntegrator<
+    Position, higher_order, lower_order, stages, first_same_as_last>::
+    dynamic_dimension;
+
 template<typename Position, int higher_order, int lower_order, int stages,
          bool first_same_as_last>
 EmbeddedExplicitRungeKuttaNyströmIntegrator<Position, higher_order, lower_order,
@@ -90,179 +103,161 @@ Status EmbeddedExplicitRungeKuttaNyströmIntegrator<Position,
                                                    first_same_as_last>::Solve(
     Instant const& t_final,
     IntegrationInstance& instance) const {
-  using Displacement = typename ODE::Displacement;
-  using Velocity = typename ODE::Velocity;
-  using Acceleration = typename ODE::Acceleration;
-
   Instance& down_cast_instance = dynamic_cast<Instance&>(instance);
-  auto const& equation = down_cast_instance.equation;
-  auto const& append_state = down_cast_instance.append_state;
-  auto const& adaptive_step_size = down_cast_instance.adaptive_step_size;
-
-  // Gets updated as the integration progresses to allow restartability.
-  typename ODE::SystemState& current_state = down_cast_instance.current_state;
-
-  // State before the last, truncated step.
-  std::experimental::optional<typename ODE::SystemState> final_state;
-
-  // Argument checks.
-  int const dimension = current_state.positions.size();
-  CHECK_NE(Time(), adaptive_step_size.first_time_step);
-  Sign const integration_direction =
-      Sign(adaptive_step_size.first_time_step);
-  if (integration_direction.Positive()) {
-    // Integrating forward.
-    CHECK_LT(current_state.time.value, t_final);
+  Integration integration(t_final, &down_cast_instance);
+  InstanceCoordinates coordinates(down_cast_instance);
+  // Most integrations, e.g., those of the flights plans and predictions, are
+  // those of a single body.
+  if (down_cast_instance.current_state.positions.size() == 1) {
+    Integrate</*static_dimension=*/1>(integration, coordinates);
   } else {
-    // Integrating backward.
-    CHECK_GT(current_state.time.value, t_final);
+    Integrate<dynamic_dimension>(integration, coordinates);
   }
-  CHECK_GT(adaptive_step_size.safety_factor, 0);
-  CHECK_LT(adaptive_step_size.safety_factor, 1);
-
-  // Time step.
-  Time h = adaptive_step_size.first_time_step;
-  // Current time.  This is a non-const reference whose purpose is to make the
-  // equations more readable.
-  DoublePrecision<Instant>& t = current_state.time;
-
-  // Position increment (high-order).
-  std::vector<Displacement> Δq_hat(dimension);
-  // Velocity increment (high-order).
-  std::vector<Velocity> Δv_hat(dimension);
-  // Current position.  This is a non-const reference whose purpose is to make
-  // the equations more readable.
-  std::vector<DoublePrecision<Position>>& q_hat = current_state.positions;
-  // Current velocity.  This is a non-const reference whose purpose is to make
-  // the equations more readable.
-  std::vector<DoublePrecision<Velocity>>& v_hat = current_state.velocities;
-
-  // Difference between the low- and high-order approximations.
-  typename ODE::SystemStateError error_estimate;
-  error_estimate.position_error.resize(dimension);
-  error_estimate.velocity_error.resize(dimension);
+  return *integration.status;
+}
 
-  // Current Runge-Kutta-Nyström stage.
-  std::vector<Position> q_stage(dimension);
-  // Accelerations at each stage.
-  // TODO(egg): this is a rectangular container, use something more appropriate.
-  std::vector<std::vector<Acceleration>> g(stages);
-  for (auto& g_stage : g) {
-    g_stage.resize(dimension);
+template<typename Position, int higher_order, int lower_order, int stages,
+         bool first_same_as_last>
+std::vector<Status>
+EmbeddedExplicitRungeKuttaNyströmIntegrator<Position,
+                                            higher_order,
+                                            lower_order,
+                                            stages,
+                                            first_same_as_last>::
+SolveInLockstep(
+    std::vector<Instant> const& t_finals,
+    std::vector<not_null<IntegrationInstance*>> const& instances,
+    typename ODE::BatchedRightHandSideComputation const&
+        compute_accelerations) const {
+  CHECK_EQ(t_finals.size(), instances.size());
+  std::vector<Lane> lanes;
+  lanes.reserve(instances.size());
+  for (int system = 0; system < instances.size(); ++system) {
+    lanes.emplace_back(t_finals[system],
+                       dynamic_cast_not_null<Instance*>(instances[system]),
+                       system,
+                       compute_accelerations);
   }
 
-  bool at_end = false;
-  double tolerance_to_error_ratio;
-
-  // The first stage of the Runge-Kutta-Nyström iteration.  In the FSAL case,
-  // |first_stage == 1| after the first step, since the first RHS evaluation has
-  // already occured in the previous step.  In the non-FSAL case and in the
-  // first step of the FSAL case, |first_stage == 0|.
-  int first_stage = 0;
+  bool const single_body =
+      std::all_of(lanes.begin(), lanes.end(), [](Lane const& lane) {
+        return lane.integration.instance->current_state.positions.size() == 1;
+      });
+  if (single_body) {
+    IntegrateInLockstep</*static_dimension=*/1>(lanes, compute_accelerations);
+  } else {
+    IntegrateInLockstep<dynamic_dimension>(lanes, compute_accelerations);
+  }
 
-  // The number of steps already performed.
-  std::int64_t step_count = 0;
+  std::vector<Status> statuses;
+  statuses.reserve(lanes.size());
+  for (auto const& lane : lanes) {
+    statuses.push_back(*lane.integration.status);
+  }
+  return statuses;
+}
 
-  // No step size control on the first step.
-  goto runge_kutta_nyström_step;
-
-  while (!at_end) {
-    // Compute the next step with decreasing step sizes until the error is
-    // tolerable.
-    do {
-      // Adapt step size.
-      // TODO(egg): find out whether there's a smarter way to compute that root,
-      // especially since we make the order compile-time.
-      h *= adaptive_step_size.safety_factor *
-               std::pow(tolerance_to_error_ratio, 1.0 / (lower_order + 1));
-      // TODO(egg): should we check whether it vanishes in double precision
-      // instead?
-      if (t.value + (t.error + h) == t.value) {
-        return Status(termination_condition::VanishingStepSize,
-                      "At time " + DebugString(t.value) +
-                          ", step size is effectively zero.  Singularity or "
-                          "stiff system suspected.");
-      }
+template<typename Position, int higher_order, int lower_order, int stages,
+         bool first_same_as_last>
+template<typename RightHandSide>
+Status EmbeddedExplicitRungeKuttaNyströmIntegrator<Position,
+                                            higher_order,
+                                            lower_order,
+                                            stages,
+                                            first_same_as_last>::
+SolveSingleBody(Instant const& t_final,
+                IntegrationInstance& instance,
+                RightHandSide const& compute_acceleration) const {
+  Instance& down_cast_instance = dynamic_cast<Instance&>(instance);
+  CHECK_EQ(1, down_cast_instance.current_state.positions.size());
+  Integration integration(t_final, &down_cast_instance);
+  SingleBodyCoordinates<RightHandSide> coordinates(down_cast_instance,
+                                                         compute_acceleration);
+  Integrate</*static_dimension=*/1>(integration, coordinates);
+  return *integration.status;
+}
 
-    runge_kutta_nyström_step:
-      // Termination condition.
-      Time const time_to_end = (t_final - t.value) - t.error;
-      at_end = integration_direction * h >= integration_direction * time_to_end;
-      if (at_end) {
-        // The chosen step size will overshoot.  Clip it to just reach the end,
-        // and terminate if the step is accepted.
-        h = time_to_end;
-        final_state = current_state;
-      }
+template<typename Position, int higher_order, int lower_order, int stages,
+         bool first_same_as_last>
+template<int static_dimension, typename Coordinates>
+void EmbeddedExplicitRungeKuttaNyströmIntegrator<Position,
+                                            higher_order,
+                                            lower_order,
+                                            stages,
+                                            first_same_as_last>::
+Integrate(Integration& integration, Coordinates& coordinates) const {
+  for (;;) {
+    PrepareStep(integration);
+    if (integration.status) {
+      return;
+    }
+    // Runge-Kutta-Nyström iteration; fills |g|.
+    for (int i = integration.first_stage; i < stages; ++i) {
+      ComputeStage<static_dimension>(i, integration, coordinates);
+    }
+    FinishStep<static_dimension>(integration, coordinates);
+    if (integration.status) {
+      return;
+    }
+  }
+}
 
-      // Runge-Kutta-Nyström iteration; fills |g|.
-      for (int i = first_stage; i < stages; ++i) {
-        Instant const t_stage = t.value + c_[i] * h;
-        for (int k = 0; k < dimension; ++k) {
-          Acceleration Σj_a_ij_g_jk{};
-          for (int j = 0; j < i; ++j) {
-            Σj_a_ij_g_jk += a_[i][j] * g[j][k];
-          }
-          q_stage[k] = q_hat[k].value +
-                           h * (c_[i] * v_hat[k].value + h * Σj_a_ij_g_jk);
+template<typename Position, int higher_order, int lower_order, int stages,
+         bool first_same_as_last>
+template<int static_dimension>
+void EmbeddedExplicitRungeKuttaNyströmIntegrator<Position,
+                                            higher_order,
+                                            lower_order,
+                                            stages,
+                                            first_same_as_last>::
+IntegrateInLockstep(
+    std::vector<Lane>& lanes,
+    typename ODE::BatchedRightHandSideComputation const&
+        compute_accelerations) const {
+  std::vector<typename ODE::RightHandSideEvaluation> evaluations;
+  evaluations.reserve(lanes.size());
+  int active_lanes = lanes.size();
+  while (active_lanes > 0) {
+    // Each lane tries one step, which is accepted or rejected independently of
+    // the other lanes.
+    for (auto& lane : lanes) {
+      if (!lane.integration.status) {
+        PrepareStep(lane.integration);
+        if (lane.integration.status) {
+          --active_lanes;
         }
-        equation.compute_acceleration(t_stage, q_stage, g[i]);
       }
+    }
 
-      // Increment computation and step size control.
-      for (int k = 0; k < dimension; ++k) {
-        Acceleration Σi_b_hat_i_g_ik{};
-        Acceleration Σi_b_i_g_ik{};
-        Acceleration Σi_b_prime_hat_i_g_ik{};
-        Acceleration Σi_b_prime_i_g_ik{};
-        // Please keep the eight assigments below aligned, they become illegible
-        // otherwise.
-        for (int i = 0; i < stages; ++i) {
-          Σi_b_hat_i_g_ik       += b_hat_[i] * g[i][k];
-          Σi_b_i_g_ik           += b_[i] * g[i][k];
-          Σi_b_prime_hat_i_g_ik += b_prime_hat_[i] * g[i][k];
-          Σi_b_prime_i_g_ik     += b_prime_[i] * g[i][k];
+    // Runge-Kutta-Nyström iteration; fills |g|.  The evaluations of all the
+    // lanes are done together, one stage at a time.
+    for (int i = 0; i < stages; ++i) {
+      evaluations.clear();
+      for (int system = 0; system < lanes.size(); ++system) {
+        auto& lane = lanes[system];
+        if (!lane.integration.status && i >= lane.integration.first_stage) {
+          Instant const t_stage = PrepareStage<static_dimension>(
+              i, lane.integration, lane.coordinates);
+          evaluations.push_back({system,
+                                 t_stage,
+                                 &lane.coordinates.q_stage,
+                                 &lane.coordinates.g[i]});
         }
-        // The hat-less Δq and Δv are the low-order increments.
-        Δq_hat[k]               = h * (h * (Σi_b_hat_i_g_ik) + v_hat[k].value);
-        Displacement const Δq_k = h * (h * (Σi_b_i_g_ik) + v_hat[k].value);
-        Δv_hat[k]               = h * Σi_b_prime_hat_i_g_ik;
-        Velocity const Δv_k     = h * Σi_b_prime_i_g_ik;
-
-        error_estimate.position_error[k] = Δq_k - Δq_hat[k];
-        error_estimate.velocity_error[k] = Δv_k - Δv_hat[k];
       }
-      tolerance_to_error_ratio =
-          adaptive_step_size.tolerance_to_error_ratio(h, error_estimate);
-    } while (tolerance_to_error_ratio < 1.0);
-
-    if (first_same_as_last) {
-      using std::swap;
-      swap(g.front(), g.back());
-      first_stage = 1;
+      if (!evaluations.empty()) {
+        compute_accelerations(evaluations);
+      }
     }
 
-    // Increment the solution with the high-order approximation.
-    t.Increment(h);
-    for (int k = 0; k < dimension; ++k) {
-      q_hat[k].Increment(Δq_hat[k]);
-      v_hat[k].Increment(Δv_hat[k]);
-    }
-    append_state(current_state);
-    ++step_count;
-    if (step_count == adaptive_step_size.max_steps && !at_end) {
-      return Status(termination_condition::ReachedMaximalStepCount,
-                    "Reached maximum step count " +
-                        std::to_string(adaptive_step_size.max_steps) +
-                        " at time " + DebugString(t.value) +
-                        "; requested t_final is " + DebugString(t_final) +
-                        ".");
+    for (auto& lane : lanes) {
+      if (!lane.integration.status) {
+        FinishStep<static_dimension>(lane.integration, lane.coordinates);
+        if (lane.integration.status) {
+          --active_lanes;
+        }
+      }
     }
   }
-  // The resolution is restartable from the last non-truncated state.
-  CHECK(final_state);
-  current_state = *final_state;
-  return Status(termination_condition::Done, "");
 }
 
 template<typename Position, int higher_order, int lower_order, int stages,
@@ -277,8 +272,53 @@ NewInstance(
     IntegrationProblem<ODE> const& problem,
     IntegrationInstance::AppendState<ODE> append_state,
     AdaptiveStepSize<ODE> const& adaptive_step_size) const {
+  return NewInstance(problem,
+                     std::move(append_state),
+                     /*append_dense_output=*/nullptr,
+                     adaptive_step_size);
+}
+
+template<typename Position, int higher_order, int lower_order, int stages,
+         bool first_same_as_last>
+not_null<std::unique_ptr<IntegrationInstance>>
+EmbeddedExplicitRungeKuttaNyströmIntegrator<Position,
+                                            higher_order,
+                                            lower_order,
+                                            stages,
+                                            first_same_as_last>::
+NewInstance(
+    IntegrationProblem<ODE> const& problem,
+    IntegrationInstance::AppendState<ODE> append_state,
+    IntegrationInstance::AppendDenseOutput<ODE> append_dense_output,
+    AdaptiveStepSize<ODE> const& adaptive_step_size) const {
+  return NewInstance(problem,
+                     std::move(append_state),
+                     std::move(append_dense_output),
+                     /*events=*/{},
+                     /*append_event=*/nullptr,
+                     adaptive_step_size);
+}
+
+template<typename Position, int higher_order, int lower_order, int stages,
+         bool first_same_as_last>
+not_null<std::unique_ptr<IntegrationInstance>>
+EmbeddedExplicitRungeKuttaNyströmIntegrator<Position,
+                                            higher_order,
+                                            lower_order,
+                                            stages,
+                                            first_same_as_last>::
+NewInstance(
+    IntegrationProblem<ODE> const& problem,
+    IntegrationInstance::AppendState<ODE> append_state,
+    IntegrationInstance::AppendDenseOutput<ODE> append_dense_output,
+    std::vector<IntegrationEvent<ODE>> events,
+    IntegrationInstance::AppendEvent<ODE> append_event,
+    AdaptiveStepSize<ODE> const& adaptive_step_size) const {
   return make_not_null_unique<Instance>(problem,
                                         std::move(append_state),
+                                        std::move(append_dense_output),
+                                        std::move(events),
+                                        std::move(append_event),
                                         adaptive_step_size);
 }
 
@@ -291,13 +331,579 @@ EmbeddedExplicitRungeKuttaNyströmIntegrator<Position,
                                             first_same_as_last>::
 Instance::Instance(IntegrationProblem<ODE> problem,
                    AppendState<ODE> append_state,
+                   AppendDenseOutput<ODE> append_dense_output,
+                   std::vector<IntegrationEvent<ODE>> events,
+                   AppendEvent<ODE> append_event,
                    AdaptiveStepSize<ODE> adaptive_step_size)
     : equation(std::move(problem.equation)),
       current_state(*problem.initial_state),
       append_state(std::move(append_state)),
+      append_dense_output(std::move(append_dense_output)),
+      events(std::move(events)),
+      append_event(std::move(append_event)),
       adaptive_step_size(std::move(adaptive_step_size)) {
   CHECK_EQ(current_state.positions.size(),
            current_state.velocities.size());
+
+  int const dimension = current_state.positions.size();
+  Δq_hat.resize(dimension);
+  Δv_hat.resize(dimension);
+  error_estimate.position_error.resize(dimension);
+  error_estimate.velocity_error.resize(dimension);
+  q_stage.resize(dimension);
+  g.resize(stages);
+  for (auto& g_stage : g) {
+    g_stage.resize(dimension);
+  }
+  final_state = current_state;
+
+  // The parameters |events| and |append_event| have been moved from.
+  if (!this->events.empty()) {
+    CHECK(this->append_event);
+    new_event_values.resize(this->events.size());
+    event_occurrences.reserve(this->events.size());
+    event_positions.resize(dimension);
+    event_velocities.resize(dimension);
+    event_state = current_state;
+    for (int k = 0; k < dimension; ++k) {
+      event_positions[k] = current_state.positions[k].value;
+      event_velocities[k] = current_state.velocities[k].value;
+    }
+    for (auto const& event : this->events) {
+      event_values.push_back(event.function(current_state.time.value,
+                                            event_positions,
+                                            event_velocities));
+    }
+  }
+}
+
+template<typename Position, int higher_order, int lower_order, int stages,
+         bool first_same_as_last>
+EmbeddedExplicitRungeKuttaNyströmIntegrator<Position,
+                                            higher_order,
+                                            lower_order,
+                                            stages,
+                                            first_same_as_last>::
+InstanceCoordinates::InstanceCoordinates(Instance& instance)
+    : instance(instance),
+      q_hat(instance.current_state.positions),
+      v_hat(instance.current_state.velocities),
+      Δq_hat(instance.Δq_hat),
+      Δv_hat(instance.Δv_hat),
+      q_stage(instance.q_stage),
+      g(instance.g) {}
+
+template<typename Position, int higher_order, int lower_order, int stages,
+         bool first_same_as_last>
+void EmbeddedExplicitRungeKuttaNyströmIntegrator<Position,
+                                            higher_order,
+                                            lower_order,
+                                            stages,
+                                            first_same_as_last>::
+InstanceCoordinates::ComputeAcceleration(Instant const& t, int const i) {
+  instance.equation.compute_acceleration(t, q_stage, g[i]);
+}
+
+template<typename Position, int higher_order, int lower_order, int stages,
+         bool first_same_as_last>
+void EmbeddedExplicitRungeKuttaNyströmIntegrator<Position,
+                                            higher_order,
+                                            lower_order,
+                                            stages,
+                                            first_same_as_last>::
+InstanceCoordinates::StoreState() const {}
+
+template<typename Position, int higher_order, int lower_order, int stages,
+         bool first_same_as_last>
+void EmbeddedExplicitRungeKuttaNyströmIntegrator<Position,
+                                            higher_order,
+                                            lower_order,
+                                            stages,
+                                            first_same_as_last>::
+InstanceCoordinates::ResetDenseOutput(Time const& h) const {
+  instance.dense_output.Reset(instance.current_state.time.value, h,
+                              q_hat, v_hat,
+                              g.front(),
+                              Δq_hat, Δv_hat,
+                              g.back());
+}
+
+template<typename Position, int higher_order, int lower_order, int stages,
+         bool first_same_as_last>
+EmbeddedExplicitRungeKuttaNyströmIntegrator<Position,
+                                            higher_order,
+                                            lower_order,
+                                            stages,
+                                            first_same_as_last>::
+LockstepCoordinates::LockstepCoordinates(
+    Instance& instance,
+    int const system,
+    typename ODE::BatchedRightHandSideComputation const&
+        compute_accelerations)
+    : InstanceCoordinates(instance),
+      system(system),
+      compute_accelerations(compute_accelerations) {
+  evaluations.reserve(1);
+}
+
+template<typename Position, int higher_order, int lower_order, int stages,
+         bool first_same_as_last>
+void EmbeddedExplicitRungeKuttaNyströmIntegrator<Position,
+                                            higher_order,
+                                            lower_order,
+                                            stages,
+                                            first_same_as_last>::
+LockstepCoordinates::ComputeAcceleration(Instant const& t, int const i) {
+  evaluations.clear();
+  evaluations.push_back({system, t, &this->q_stage, &this->g[i]});
+  compute_accelerations(evaluations);
+}
+
+template<typename Position, int higher_order, int lower_order, int stages,
+         bool first_same_as_last>
+EmbeddedExplicitRungeKuttaNyströmIntegrator<Position,
+                                            higher_order,
+                                            lower_order,
+                                            stages,
+                                            first_same_as_last>::
+Lane::Lane(Instant const& t_final,
+           not_null<Instance*> const instance,
+           int const system,
+           typename ODE::BatchedRightHandSideComputation const&
+               compute_accelerations)
+    : integration(t_final, instance),
+      coordinates(*instance, system, compute_accelerations) {}
+
+template<typename Position, int higher_order, int lower_order, int stages,
+         bool first_same_as_last>
+template<typename RightHandSide>
+EmbeddedExplicitRungeKuttaNyströmIntegrator<Position,
+                                            higher_order,
+                                            lower_order,
+                                            stages,
+                                            first_same_as_last>::
+SingleBodyCoordinates<RightHandSide>::SingleBodyCoordinates(
+    Instance& instance,
+    RightHandSide const& compute_acceleration)
+    : instance(instance),
+      compute_acceleration(compute_acceleration),
+      q_hat({{instance.current_state.positions[0]}}),
+      v_hat({{instance.current_state.velocities[0]}}) {}
+
+template<typename Position, int higher_order, int lower_order, int stages,
+         bool first_same_as_last>
+template<typename RightHandSide>
+void EmbeddedExplicitRungeKuttaNyströmIntegrator<Position,
+                                            higher_order,
+                                            lower_order,
+                                            stages,
+                                            first_same_as_last>::
+SingleBodyCoordinates<RightHandSide>::ComputeAcceleration(
+    Instant const& t,
+    int const i) {
+  g[i][0] = compute_acceleration(t, q_stage[0]);
+}
+
+template<typename Position, int higher_order, int lower_order, int stages,
+         bool first_same_as_last>
+template<typename RightHandSide>
+void EmbeddedExplicitRungeKuttaNyströmIntegrator<Position,
+                                            higher_order,
+                                            lower_order,
+                                            stages,
+                                            first_same_as_last>::
+SingleBodyCoordinates<RightHandSide>::StoreState() const {
+  instance.current_state.positions[0] = q_hat[0];
+  instance.current_state.velocities[0] = v_hat[0];
+}
+
+template<typename Position, int higher_order, int lower_order, int stages,
+         bool first_same_as_last>
+template<typename RightHandSide>
+void EmbeddedExplicitRungeKuttaNyströmIntegrator<Position,
+                                            higher_order,
+                                            lower_order,
+                                            stages,
+                                            first_same_as_last>::
+SingleBodyCoordinates<RightHandSide>::ResetDenseOutput(
+    Time const& h) const {
+  // The |current_state| is that at the beginning of the step, and the vectors
+  // of the |instance| have dimension 1, so this doesn't allocate.
+  instance.Δq_hat[0] = Δq_hat[0];
+  instance.Δv_hat[0] = Δv_hat[0];
+  instance.g.front()[0] = g.front()[0];
+  instance.g.back()[0] = g.back()[0];
+  instance.dense_output.Reset(instance.current_state.time.value, h,
+                              instance.current_state.positions,
+                              instance.current_state.velocities,
+                              instance.g.front(),
+                              instance.Δq_hat, instance.Δv_hat,
+                              instance.g.back());
+}
+
+template<typename Position, int higher_order, int lower_order, int stages,
+         bool first_same_as_last>
+EmbeddedExplicitRungeKuttaNyströmIntegrator<Position,
+                                            higher_order,
+                                            lower_order,
+                                            stages,
+                                            first_same_as_last>::
+Integration::Integration(Instant const& t_final,
+                         not_null<Instance*> const instance)
+    : t_final(t_final),
+      instance(instance),
+      integration_direction(Sign(instance->adaptive_step_size.first_time_step)),
+      h(instance->adaptive_step_size.first_time_step) {
+  auto const& adaptive_step_size = instance->adaptive_step_size;
+  auto const& current_state = instance->current_state;
+
+  // Argument checks.
+  CHECK_NE(Time(), adaptive_step_size.first_time_step);
+  if (integration_direction.Positive()) {
+    // Integrating forward.
+    CHECK_LT(current_state.time.value, t_final);
+  } else {
+    // Integrating backward.
+    CHECK_GT(current_state.time.value, t_final);
+  }
+  CHECK_GT(adaptive_step_size.safety_factor, 0);
+  CHECK_LT(adaptive_step_size.safety_factor, 1);
+}
+
+template<typename Position, int higher_order, int lower_order, int stages,
+         bool first_same_as_last>
+void EmbeddedExplicitRungeKuttaNyströmIntegrator<Position,
+                                            higher_order,
+                                            lower_order,
+                                            stages,
+                                            first_same_as_last>::
+PrepareStep(Integration& integration) const {
+  auto const& adaptive_step_size = integration.instance->adaptive_step_size;
+  typename ODE::SystemState const& current_state =
+      integration.instance->current_state;
+  // Current time.  This is a reference whose purpose is to make the equations
+  // more readable.
+  DoublePrecision<Instant> const& t = current_state.time;
+  Time& h = integration.h;
+
+  // No step size control on the first step.
+  if (integration.first_step_tried) {
+    // Adapt step size.
+    // TODO(egg): find out whether there's a smarter way to compute that root,
+    // especially since we make the order compile-time.
+    h *= adaptive_step_size.safety_factor *
+             std::pow(integration.tolerance_to_error_ratio,
+                      1.0 / (lower_order + 1));
+    // TODO(egg): should we check whether it vanishes in double precision
+    // instead?
+    if (t.value + (t.error + h) == t.value) {
+      integration.status =
+          Status(termination_condition::VanishingStepSize,
+                 "At time " + DebugString(t.value) +
+                     ", step size is effectively zero.  "
+                     "Singularity or stiff system suspected.");
+      return;
+    }
+  }
+  integration.first_step_tried = true;
+
+  // Termination condition.
+  Time const time_to_end = (integration.t_final - t.value) - t.error;
+  integration.at_end = integration.integration_direction * h >=
+                       integration.integration_direction * time_to_end;
+  if (integration.at_end) {
+    // The chosen step size will overshoot.  Clip it to just reach the end,
+    // and terminate if the step is accepted.
+    h = time_to_end;
+    integration.instance->final_state = current_state;
+  }
+}
+
+template<typename Position, int higher_order, int lower_order, int stages,
+         bool first_same_as_last>
+template<int static_dimension, typename Coordinates>
+Instant EmbeddedExplicitRungeKuttaNyströmIntegrator<Position,
+                                            higher_order,
+                                            lower_order,
+                                            stages,
+                                            first_same_as_last>::
+PrepareStage(int const i,
+             Integration const& integration,
+             Coordinates& coordinates) const {
+  using Acceleration = typename ODE::Acceleration;
+  DoublePrecision<Instant> const& t =
+      integration.instance->current_state.time;
+  auto const& q_hat = coordinates.q_hat;
+  auto const& v_hat = coordinates.v_hat;
+  Time const& h = integration.h;
+  auto const& g = coordinates.g;
+  auto& q_stage = coordinates.q_stage;
+  int const dimension =
+      static_dimension == dynamic_dimension ? q_hat.size() : static_dimension;
+  DCHECK_EQ(dimension, q_hat.size());
+
+  Instant const t_stage = t.value + c_[i] * h;
+  for (int k = 0; k < dimension; ++k) {
+    Acceleration Σj_a_ij_g_jk{};
+    for (int j = 0; j < i; ++j) {
+      Σj_a_ij_g_jk += a_[i][j] * g[j][k];
+    }
+    q_stage[k] = q_hat[k].value +
+                     h * (c_[i] * v_hat[k].value + h * Σj_a_ij_g_jk);
+  }
+  return t_stage;
+}
+
+template<typename Position, int higher_order, int lower_order, int stages,
+         bool first_same_as_last>
+template<int static_dimension, typename Coordinates>
+void EmbeddedExplicitRungeKuttaNyströmIntegrator<Position,
+                                            higher_order,
+                                            lower_order,
+                                            stages,
+                                            first_same_as_last>::
+ComputeStage(int const i,
+             Integration& integration,
+             Coordinates& coordinates) const {
+  coordinates.ComputeAcceleration(
+      PrepareStage<static_dimension>(i, integration, coordinates), i);
+}
+
+template<typename Position, int higher_order, int lower_order, int stages,
+         bool first_same_as_last>
+template<int static_dimension, typename Coordinates>
+void EmbeddedExplicitRungeKuttaNyströmIntegrator<Position,
+                                            higher_order,
+                                            lower_order,
+                                            stages,
+                                            first_same_as_last>::
+FinishStep(Integration& integration, Coordinates& coordinates) const {
+  using Displacement = typename ODE::Displacement;
+  using Velocity = typename ODE::Velocity;
+  using Acceleration = typename ODE::Acceleration;
+
+  Instance& instance = *integration.instance;
+  auto const& append_state = instance.append_state;
+  auto const& append_dense_output = instance.append_dense_output;
+  auto const& adaptive_step_size = instance.adaptive_step_size;
+
+  // Gets updated as the integration progresses to allow restartability.
+  typename ODE::SystemState& current_state = instance.current_state;
+  // These are non-const references whose purpose is to make the equations more
+  // readable.
+  DoublePrecision<Instant>& t = current_state.time;
+  auto& q_hat = coordinates.q_hat;
+  auto& v_hat = coordinates.v_hat;
+  Time const& h = integration.h;
+  auto& Δq_hat = coordinates.Δq_hat;
+  auto& Δv_hat = coordinates.Δv_hat;
+  auto& error_estimate = instance.error_estimate;
+  auto& g = coordinates.g;
+  int const dimension =
+      static_dimension == dynamic_dimension ? q_hat.size() : static_dimension;
+  DCHECK_EQ(dimension, q_hat.size());
+
+  // Increment computation and step size control.
+  for (int k = 0; k < dimension; ++k) {
+    Acceleration Σi_b_hat_i_g_ik{};
+    Acceleration Σi_b_i_g_ik{};
+    Acceleration Σi_b_prime_hat_i_g_ik{};
+    Acceleration Σi_b_prime_i_g_ik{};
+    // Please keep the eight assigments below aligned, they become illegible
+    // otherwise.
+    for (int i = 0; i < stages; ++i) {
+      Σi_b_hat_i_g_ik       += b_hat_[i] * g[i][k];
+      Σi_b_i_g_ik           += b_[i] * g[i][k];
+      Σi_b_prime_hat_i_g_ik += b_prime_hat_[i] * g[i][k];
+      Σi_b_prime_i_g_ik     += b_prime_[i] * g[i][k];
+    }
+    // The hat-less Δq and Δv are the low-order increments.
+    Δq_hat[k]               = h * (h * (Σi_b_hat_i_g_ik) + v_hat[k].value);
+    Displacement const Δq_k = h * (h * (Σi_b_i_g_ik) + v_hat[k].value);
+    Δv_hat[k]               = h * Σi_b_prime_hat_i_g_ik;
+    Velocity const Δv_k     = h * Σi_b_prime_i_g_ik;
+
+    error_estimate.position_error[k] = Δq_k - Δq_hat[k];
+    error_estimate.velocity_error[k] = Δv_k - Δv_hat[k];
+  }
+  integration.tolerance_to_error_ratio =
+      adaptive_step_size.tolerance_to_error_ratio(h, error_estimate);
+  if (integration.tolerance_to_error_ratio < 1.0) {
+    // The step is rejected, it will be retried with a smaller step size.
+    return;
+  }
+
+  // The events are located on the interpolant.
+  bool const needs_dense_output =
+      append_dense_output || !instance.events.empty();
+  typename ODE::DenseOutput const& dense_output = instance.dense_output;
+  if (needs_dense_output) {
+    // The interpolant needs the accelerations at the end of the step.  With
+    // the FSAL property they are those of the last stage; otherwise they are
+    // evaluated here and reused as the first stage of the next step.  They
+    // must therefore be evaluated at the state that the compensated summation
+    // below will produce, lest the solution depend on the dense output.
+    if (!first_same_as_last) {
+      DoublePrecision<Instant> t_end = t;
+      t_end.Increment(h);
+      for (int k = 0; k < dimension; ++k) {
+        DoublePrecision<Position> q_end = q_hat[k];
+        q_end.Increment(Δq_hat[k]);
+        coordinates.q_stage[k] = q_end.value;
+      }
+      coordinates.ComputeAcceleration(t_end.value, stages - 1);
+    }
+    coordinates.ResetDenseOutput(h);
+    if (append_dense_output) {
+      append_dense_output(dense_output);
+    }
+  }
+
+  if (first_same_as_last || needs_dense_output) {
+    using std::swap;
+    swap(g.front(), g.back());
+    integration.first_stage = 1;
+  }
+
+  // Increment the solution with the high-order approximation.
+  t.Increment(h);
+  for (int k = 0; k < dimension; ++k) {
+    q_hat[k].Increment(Δq_hat[k]);
+    v_hat[k].Increment(Δv_hat[k]);
+  }
+  coordinates.StoreState();
+  if (!instance.events.empty() && DetectEvents(dense_output, instance)) {
+    // The resolution is restartable from the state at the event.
+    append_state(current_state);
+    integration.status =
+        Status(termination_condition::TerminalEvent,
+               "Terminal event at time " + DebugString(t.value) +
+                   "; requested t_final is " +
+                   DebugString(integration.t_final) + ".");
+    return;
+  }
+  append_state(current_state);
+  ++integration.step_count;
+
+  if (integration.at_end) {
+    // The resolution is restartable from the last non-truncated state.
+    current_state = instance.final_state;
+    integration.status = Status(termination_condition::Done, "");
+  } else if (integration.step_count == adaptive_step_size.max_steps) {
+    integration.status =
+        Status(termination_condition::ReachedMaximalStepCount,
+               "Reached maximum step count " +
+                   std::to_string(adaptive_step_size.max_steps) +
+                   " at time " + DebugString(t.value) +
+                   "; requested t_final is " +
+                   DebugString(integration.t_final) + ".");
+  } else if (AbortRequested()) {
+    integration.status =
+        Status(termination_condition::Cancelled,
+               "Aborted at time " + DebugString(t.value) +
+                   "; requested t_final is " +
+                   DebugString(integration.t_final) + ".");
+  }
+}
+
+template<typename Position, int higher_order, int lower_order, int stages,
+         bool first_same_as_last>
+bool EmbeddedExplicitRungeKuttaNyströmIntegrator<Position,
+                                            higher_order,
+                                            lower_order,
+                                            stages,
+                                            first_same_as_last>::
+DetectEvents(typename ODE::DenseOutput const& dense_output,
+             Instance& instance) const {
+  auto const& events = instance.events;
+  typename ODE::SystemState& current_state = instance.current_state;
+  auto& event_values = instance.event_values;
+  auto& new_event_values = instance.new_event_values;
+  auto& event_occurrences = instance.event_occurrences;
+  auto& q = instance.event_positions;
+  auto& v = instance.event_velocities;
+  auto& event_state = instance.event_state;
+  int const dimension = current_state.positions.size();
+  Instant const& t_start = dense_output.first_time();
+  Instant const t_end = dense_output.last_time();
+
+  for (int k = 0; k < dimension; ++k) {
+    q[k] = current_state.positions[k].value;
+    v[k] = current_state.velocities[k].value;
+  }
+  event_occurrences.clear();
+  for (int i = 0; i < events.size(); ++i) {
+    auto const& function = events[i].function;
+    double const new_value = function(current_state.time.value, q, v);
+    new_event_values[i] = new_value;
+    double const value = event_values[i];
+    if (value == 0 || new_value == 0 || (value > 0) == (new_value > 0)) {
+      continue;
+    }
+    // At the ends of the step we use the values computed from the states
+    // rather than from the interpolant, which may differ in the last bits, so
+    // that the bisection sees a change of sign.
+    Instant const t_event = Bisect(
+        [&dense_output, &function, &q, &v,
+         dimension, value, new_value, t_start, t_end](Instant const& t) {
+          if (t == t_start) {
+            return value;
+          }
+          if (t == t_end) {
+            return new_value;
+          }
+          for (int k = 0; k < dimension; ++k) {
+            q[k] = dense_output.EvaluatePosition(t, k);
+            v[k] = dense_output.EvaluateVelocity(t, k);
+          }
+          return function(t, q, v);
+        },
+        t_start,
+        t_end);
+    event_occurrences.emplace_back(t_event, i);
+  }
+
+  // The events are reported in the order of integration, and in the order of
+  // |events| if they occur at the same time.
+  bool const forward = t_start < t_end;
+  std::stable_sort(event_occurrences.begin(),
+                   event_occurrences.end(),
+                   [forward](std::pair<Instant, int> const& left,
+                             std::pair<Instant, int> const& right) {
+                     return forward ? left.first < right.first
+                                    : right.first < left.first;
+                   });
+  bool terminated = false;
+  for (int j = 0; j < event_occurrences.size(); ++j) {
+    Instant const& t_event = event_occurrences[j].first;
+    int const i = event_occurrences[j].second;
+    event_state.time = DoublePrecision<Instant>(t_event);
+    for (int k = 0; k < dimension; ++k) {
+      event_state.positions[k] =
+          DoublePrecision<Position>(dense_output.EvaluatePosition(t_event, k));
+      event_state.velocities[k] = DoublePrecision<typename ODE::Velocity>(
+          dense_output.EvaluateVelocity(t_event, k));
+    }
+    instance.append_event(i, event_state);
+    if (events[i].terminal) {
+      // The integration resumes at |t_event|: the events not yet reported must
+      // be detected again.
+      for (int l = j + 1; l < event_occurrences.size(); ++l) {
+        int const later = event_occurrences[l].second;
+        new_event_values[later] = event_values[later];
+      }
+      current_state = event_state;
+      terminated = true;
+      break;
+    }
+  }
+
+  for (int i = 0; i < events.size(); ++i) {
+    if (new_event_values[i] != 0) {
+      event_values[i] = new_event_values[i];
+    }
+  }
+  return terminated;
 }
 
 }  // namespace integrators
@@ -2,8 +2,14 @@
 #include "integrators/embedded_explicit_runge_kutta_nyström_integrator.hpp"
 
 #include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <tuple>
 #include <vector>
 
+#include "base/bundle.hpp"
 #include "base/macros.hpp"
 #include "glog/logging.h"
 #include "gmock/gmock.h"
@@ -15,10 +21,17 @@
 
 namespace principia {
 
+using base::AbortRequested;
+using base::not_null;
+using numerics::DoublePrecision;
 using quantities::Abs;
+using quantities::Acceleration;
 using quantities::AngularFrequency;
 using quantities::Length;
+using quantities::Mass;
+using quantities::SIUnit;
 using quantities::SpecificImpulse;
+using quantities::Stiffness;
 using quantities::si::Centi;
 using quantities::si::Kilogram;
 using quantities::si::Metre;
@@ -34,6 +47,7 @@ using ::std::placeholders::_2;
 using ::std::placeholders::_3;
 using ::testing::AllOf;
 using ::testing::Ge;
+using ::testing::Gt;
 using ::testing::Le;
 using ::testing::Lt;
 
@@ -231,6 +245,772 @@ TEST_F(EmbeddedExplicitRungeKuttaNyströmIntegratorTest,
   }
 }
 
+TEST_F(EmbeddedExplicitRungeKuttaNyströmIntegratorTest, Abort) {
+  AdaptiveStepSizeIntegrator<ODE> const& integrator =
+      DormandElMikkawyPrince1986RKN434FM<Length>();
+  Length const x_initial = 1 * Metre;
+  Speed const v_initial = 0 * Metre / Second;
+  Time const period = 2 * π * Second;
+  Instant const t_initial;
+  Instant const t_final = t_initial + 10 * period;
+  Length const length_tolerance = 1 * Milli(Metre);
+  Speed const speed_tolerance = 1 * Milli(Metre) / Second;
+
+  auto const step_size_callback = [](bool tolerable) {};
+
+  std::vector<ODE::SystemState> solution;
+  ODE harmonic_oscillator;
+  harmonic_oscillator.compute_acceleration =
+      std::bind(ComputeHarmonicOscillatorAcceleration,
+                _1, _2, _3, /*evaluations=*/nullptr);
+  IntegrationProblem<ODE> problem;
+  problem.equation = harmonic_oscillator;
+  ODE::SystemState const initial_state = {{x_initial}, {v_initial}, t_initial};
+  problem.initial_state = &initial_state;
+  auto const append_state = [&solution](ODE::SystemState const& state) {
+    solution.push_back(state);
+  };
+  AdaptiveStepSize<ODE> adaptive_step_size;
+  adaptive_step_size.first_time_step = t_final - t_initial;
+  adaptive_step_size.safety_factor = 0.9;
+  adaptive_step_size.tolerance_to_error_ratio =
+      std::bind(HarmonicOscillatorToleranceRatio,
+                _1, _2, length_tolerance, speed_tolerance, step_size_callback);
+  adaptive_step_size.max_steps = std::numeric_limits<std::int64_t>::max();
+
+  auto const instance =
+      integrator.NewInstance(problem, append_state, adaptive_step_size);
+
+  // Abort after 10 steps.
+  auto const previous_abort_requested = AbortRequested;
+  AbortRequested = [&solution]() { return solution.size() >= 10; };
+  auto outcome = integrator.Solve(t_final, *instance);
+  EXPECT_EQ(termination_condition::Cancelled, outcome.error());
+  EXPECT_EQ(10, solution.size());
+  EXPECT_THAT(solution.back().time.value, Lt(t_final));
+
+  // The integration may be resumed.
+  AbortRequested = previous_abort_requested;
+  outcome = integrator.Solve(t_final, *instance);
+  EXPECT_EQ(termination_condition::Done, outcome.error());
+  EXPECT_EQ(t_final, solution.back().time.value);
+}
+
+TEST_F(EmbeddedExplicitRungeKuttaNyströmIntegratorTest, Lockstep) {
+  AdaptiveStepSizeIntegrator<ODE> const& integrator =
+      DormandElMikkawyPrince1986RKN434FM<Length>();
+  Time const period = 2 * π * Second;
+  Instant const t_initial;
+  Length const length_tolerance = 1 * Milli(Metre);
+  Speed const speed_tolerance = 1 * Milli(Metre) / Second;
+
+  auto const step_size_callback = [](bool tolerable) {};
+
+  // Three oscillators with different initial conditions and final times.  The
+  // last one is limited in its number of steps.
+  std::vector<Length> const x_initials = {1 * Metre, 2 * Metre, 0 * Metre};
+  std::vector<Speed> const v_initials =
+      {0 * Metre / Second, 1 * Metre / Second, 3 * Metre / Second};
+  std::vector<Instant> const t_finals = {t_initial + 10 * period,
+                                         t_initial + 3 * period,
+                                         t_initial + 7 * period};
+  std::vector<std::int64_t> const max_steps =
+      {std::numeric_limits<std::int64_t>::max(),
+       std::numeric_limits<std::int64_t>::max(),
+       50};
+  int const systems = x_initials.size();
+
+  std::vector<ODE::SystemState> initial_states;
+  for (int system = 0; system < systems; ++system) {
+    initial_states.push_back(
+        {{x_initials[system]}, {v_initials[system]}, t_initial});
+  }
+
+  ODE harmonic_oscillator;
+  harmonic_oscillator.compute_acceleration =
+      std::bind(ComputeHarmonicOscillatorAcceleration,
+                _1, _2, _3, /*evaluations=*/nullptr);
+  auto const new_instance = [&](int const system,
+                                std::vector<ODE::SystemState>& solution) {
+    IntegrationProblem<ODE> problem;
+    problem.equation = harmonic_oscillator;
+    problem.initial_state = &initial_states[system];
+    AdaptiveStepSize<ODE> adaptive_step_size;
+    adaptive_step_size.first_time_step = t_finals[system] - t_initial;
+    adaptive_step_size.safety_factor = 0.9;
+    adaptive_step_size.tolerance_to_error_ratio =
+        std::bind(HarmonicOscillatorToleranceRatio,
+                  _1, _2,
+                  length_tolerance, speed_tolerance,
+                  step_size_callback);
+    adaptive_step_size.max_steps = max_steps[system];
+    return integrator.NewInstance(
+        problem,
+        [&solution](ODE::SystemState const& state) {
+          solution.push_back(state);
+        },
+        adaptive_step_size);
+  };
+
+  // Integrate each system on its own.
+  std::vector<std::vector<ODE::SystemState>> expected_solutions(systems);
+  std::vector<base::Error> expected_outcomes;
+  for (int system = 0; system < systems; ++system) {
+    auto const instance = new_instance(system, expected_solutions[system]);
+    expected_outcomes.push_back(
+        integrator.Solve(t_finals[system], *instance).error());
+  }
+  EXPECT_EQ(termination_condition::Done, expected_outcomes[0]);
+  EXPECT_EQ(termination_condition::Done, expected_outcomes[1]);
+  EXPECT_EQ(termination_condition::ReachedMaximalStepCount,
+            expected_outcomes[2]);
+
+  // Integrate them in lockstep.
+  std::vector<std::vector<ODE::SystemState>> solutions(systems);
+  std::vector<not_null<std::unique_ptr<IntegrationInstance>>> instances;
+  std::vector<not_null<IntegrationInstance*>> instance_pointers;
+  for (int system = 0; system < systems; ++system) {
+    instances.push_back(new_instance(system, solutions[system]));
+    instance_pointers.push_back(instances.back().get());
+  }
+  int batches = 0;
+  int evaluations = 0;
+  auto const outcomes = integrator.SolveInLockstep(
+      t_finals,
+      instance_pointers,
+      [&batches, &evaluations](
+          std::vector<ODE::RightHandSideEvaluation> const& batch) {
+        ++batches;
+        for (auto const& evaluation : batch) {
+          ++evaluations;
+          ComputeHarmonicOscillatorAcceleration(evaluation.time,
+                                                *evaluation.positions,
+                                                *evaluation.accelerations,
+                                                /*evaluations=*/nullptr);
+        }
+      });
+
+  // The results are identical, but the evaluations are batched.
+  ASSERT_EQ(systems, outcomes.size());
+  for (int system = 0; system < systems; ++system) {
+    EXPECT_EQ(expected_outcomes[system], outcomes[system].error());
+    ASSERT_EQ(expected_solutions[system].size(), solutions[system].size());
+    for (int i = 0; i < solutions[system].size(); ++i) {
+      auto const& expected_state = expected_solutions[system][i];
+      auto const& state = solutions[system][i];
+      EXPECT_EQ(expected_state.time.value, state.time.value);
+      EXPECT_EQ(expected_state.positions[0].value, state.positions[0].value);
+      EXPECT_EQ(expected_state.velocities[0].value,
+                state.velocities[0].value);
+    }
+  }
+  EXPECT_THAT(batches, Lt(evaluations));
+}
+
+// The integration of a single body is specialized at compile time, check that
+// it matches the general case.
+TEST_F(EmbeddedExplicitRungeKuttaNyströmIntegratorTest, SeveralBodies) {
+  AdaptiveStepSizeIntegrator<ODE> const& integrator =
+      DormandElMikkawyPrince1986RKN434FM<Length>();
+  Length const x_initial = 1 * Metre;
+  Speed const v_initial = 0 * Metre / Second;
+  Time const period = 2 * π * Second;
+  Instant const t_initial;
+  Instant const t_final = t_initial + 10 * period;
+  Length const length_tolerance = 1 * Milli(Metre);
+  Speed const speed_tolerance = 1 * Milli(Metre) / Second;
+
+  auto const step_size_callback = [](bool tolerable) {};
+
+  // Integrates |bodies| identical uncoupled oscillators.
+  auto const solve = [&](int const bodies) {
+    std::vector<ODE::SystemState> solution;
+    ODE harmonic_oscillators;
+    harmonic_oscillators.compute_acceleration =
+        [](Instant const& t,
+           std::vector<Length> const& q,
+           std::vector<Acceleration>& result) {
+          for (int k = 0; k < q.size(); ++k) {
+            result[k] = -q[k] * (SIUnit<Stiffness>() / SIUnit<Mass>());
+          }
+        };
+    IntegrationProblem<ODE> problem;
+    problem.equation = harmonic_oscillators;
+    ODE::SystemState const initial_state = {
+        std::vector<DoublePrecision<Length>>(bodies, x_initial),
+        std::vector<DoublePrecision<Speed>>(bodies, v_initial),
+        t_initial};
+    problem.initial_state = &initial_state;
+    AdaptiveStepSize<ODE> adaptive_step_size;
+    adaptive_step_size.first_time_step = t_final - t_initial;
+    adaptive_step_size.safety_factor = 0.9;
+    adaptive_step_size.tolerance_to_error_ratio =
+        std::bind(HarmonicOscillatorToleranceRatio,
+                  _1, _2, length_tolerance, speed_tolerance,
+                  step_size_callback);
+    adaptive_step_size.max_steps = std::numeric_limits<std::int64_t>::max();
+    auto const instance = integrator.NewInstance(
+        problem,
+        [&solution](ODE::SystemState const& state) {
+          solution.push_back(state);
+        },
+        adaptive_step_size);
+    EXPECT_EQ(termination_condition::Done,
+              integrator.Solve(t_final, *instance).error());
+    return solution;
+  };
+
+  auto const one_body_solution = solve(1);
+  auto const three_body_solution = solve(3);
+  ASSERT_EQ(one_body_solution.size(), three_body_solution.size());
+  for (int i = 0; i < one_body_solution.size(); ++i) {
+    auto const& expected_state = one_body_solution[i];
+    auto const& state = three_body_solution[i];
+    EXPECT_EQ(expected_state.time.value, state.time.value);
+    for (int k = 0; k < 3; ++k) {
+      EXPECT_EQ(expected_state.positions[0].value, state.positions[k].value);
+      EXPECT_EQ(expected_state.velocities[0].value,
+                state.velocities[k].value);
+    }
+  }
+}
+
+// The specialized integration of a single body, with fixed-size arrays and an
+// inlined right-hand side, matches the general one, including across calls to
+// |Solve| and for the dense output.
+TEST_F(EmbeddedExplicitRungeKuttaNyströmIntegratorTest, SolveSingleBody) {
+  auto const& integrator = DormandElMikkawyPrince1986RKN434FM<Length>();
+  Length const x_initial = 1 * Metre;
+  Speed const v_initial = 0 * Metre / Second;
+  Time const period = 2 * π * Second;
+  Instant const t_initial;
+  Instant const t_middle = t_initial + 3.5 * period;
+  Instant const t_final = t_initial + 10 * period;
+  Length const length_tolerance = 1 * Milli(Metre);
+  Speed const speed_tolerance = 1 * Milli(Metre) / Second;
+
+  auto const step_size_callback = [](bool tolerable) {};
+
+  auto const solve = [&](bool const single_body) {
+    std::vector<ODE::SystemState> solution;
+    std::vector<Length> interpolated_positions;
+    int evaluations = 0;
+    ODE harmonic_oscillator;
+    harmonic_oscillator.compute_acceleration =
+        std::bind(ComputeHarmonicOscillatorAcceleration,
+                  _1, _2, _3, &evaluations);
+    IntegrationProblem<ODE> problem;
+    problem.equation = harmonic_oscillator;
+    ODE::SystemState const initial_state =
+        {{x_initial}, {v_initial}, t_initial};
+    problem.initial_state = &initial_state;
+    AdaptiveStepSize<ODE> adaptive_step_size;
+    adaptive_step_size.first_time_step = t_final - t_initial;
+    adaptive_step_size.safety_factor = 0.9;
+    adaptive_step_size.tolerance_to_error_ratio =
+        std::bind(HarmonicOscillatorToleranceRatio,
+                  _1, _2, length_tolerance, speed_tolerance,
+                  step_size_callback);
+    auto const instance = integrator.NewInstance(
+        problem,
+        [&solution](ODE::SystemState const& state) {
+          solution.push_back(state);
+        },
+        [&interpolated_positions](ODE::DenseOutput const& dense_output) {
+          interpolated_positions.push_back(dense_output.EvaluatePosition(
+              dense_output.first_time() +
+                  0.5 * (dense_output.last_time() -
+                         dense_output.first_time()),
+              /*index=*/0));
+        },
+        adaptive_step_size);
+    for (Instant const& t : {t_middle, t_final}) {
+      if (single_body) {
+        EXPECT_EQ(termination_condition::Done,
+                  integrator.SolveSingleBody(
+                      t,
+                      *instance,
+                      [&evaluations](Instant const& t, Length const& q) {
+                        ++evaluations;
+                        return -q * (SIUnit<Stiffness>() / SIUnit<Mass>());
+                      }).error());
+      } else {
+        EXPECT_EQ(termination_condition::Done,
+                  integrator.Solve(t, *instance).error());
+      }
+    }
+    return std::make_tuple(solution, interpolated_positions, evaluations);
+  };
+
+  auto const general = solve(/*single_body=*/false);
+  auto const specialized = solve(/*single_body=*/true);
+  auto const& general_solution = std::get<0>(general);
+  auto const& specialized_solution = std::get<0>(specialized);
+  ASSERT_EQ(general_solution.size(), specialized_solution.size());
+  for (int i = 0; i < general_solution.size(); ++i) {
+    EXPECT_EQ(general_solution[i].time.value,
+              specialized_solution[i].time.value);
+    EXPECT_EQ(general_solution[i].positions[0].value,
+              specialized_solution[i].positions[0].value);
+    EXPECT_EQ(general_solution[i].positions[0].error,
+              specialized_solution[i].positions[0].error);
+    EXPECT_EQ(general_solution[i].velocities[0].value,
+              specialized_solution[i].velocities[0].value);
+  }
+  EXPECT_EQ(std::get<1>(general), std::get<1>(specialized));
+  EXPECT_EQ(std::get<2>(general), std::get<2>(specialized));
+}
+
+TEST_F(EmbeddedExplicitRungeKuttaNyströmIntegratorTest, DenseOutput) {
+  AdaptiveStepSizeIntegrator<ODE> const& integrator =
+      DormandElMikkawyPrince1986RKN434FM<Length>();
+  Length const x_initial = 1 * Metre;
+  Speed const v_initial = 0 * Metre / Second;
+  Speed const v_amplitude = 1 * Metre / Second;
+  Time const period = 2 * π * Second;
+  AngularFrequency const ω = 1 * Radian / Second;
+  Instant const t_initial;
+  Instant const t_final = t_initial + 10 * period;
+  Length const length_tolerance = 1 * Milli(Metre);
+  Speed const speed_tolerance = 1 * Milli(Metre) / Second;
+  int const steps_forward = 132;
+
+  auto const step_size_callback = [](bool tolerable) {};
+
+  int evaluations = 0;
+  std::vector<ODE::SystemState> solution;
+  std::vector<ODE::DenseOutput> dense_outputs;
+  ODE harmonic_oscillator;
+  harmonic_oscillator.compute_acceleration =
+      std::bind(ComputeHarmonicOscillatorAcceleration,
+                _1, _2, _3, &evaluations);
+  IntegrationProblem<ODE> problem;
+  problem.equation = harmonic_oscillator;
+  ODE::SystemState const initial_state = {{x_initial}, {v_initial}, t_initial};
+  problem.initial_state = &initial_state;
+  auto const append_state = [&solution](ODE::SystemState const& state) {
+    solution.push_back(state);
+  };
+  auto const append_dense_output =
+      [&dense_outputs](ODE::DenseOutput const& dense_output) {
+        dense_outputs.push_back(dense_output);
+      };
+  AdaptiveStepSize<ODE> adaptive_step_size;
+  adaptive_step_size.first_time_step = t_final - t_initial;
+  adaptive_step_size.safety_factor = 0.9;
+  adaptive_step_size.tolerance_to_error_ratio =
+      std::bind(HarmonicOscillatorToleranceRatio,
+                _1, _2, length_tolerance, speed_tolerance, step_size_callback);
+
+  auto const instance = integrator.NewInstance(problem,
+                                               append_state,
+                                               append_dense_output,
+                                               adaptive_step_size);
+  auto const outcome = integrator.Solve(t_final, *instance);
+
+  EXPECT_EQ(termination_condition::Done, outcome.error());
+  EXPECT_EQ(steps_forward, solution.size());
+  ASSERT_EQ(steps_forward, dense_outputs.size());
+  // The dense output doesn't require any additional evaluations thanks to the
+  // FSAL property.
+  EXPECT_EQ(4 * (1 + 1) + 3 * (steps_forward - 1 + 3), evaluations);
+
+  // The errors of the integrator at the ends of the steps.
+  Length max_step_position_error;
+  Speed max_step_velocity_error;
+  for (auto const& state : solution) {
+    Time const elapsed = state.time.value - t_initial;
+    max_step_position_error =
+        std::max(max_step_position_error,
+                 AbsoluteError(x_initial * Cos(ω * elapsed),
+                               state.positions[0].value));
+    max_step_velocity_error =
+        std::max(max_step_velocity_error,
+                 AbsoluteError(-v_amplitude * Sin(ω * elapsed),
+                               state.velocities[0].value));
+  }
+
+  // The errors of the interpolants within the steps.
+  Length max_position_error;
+  Speed max_velocity_error;
+  for (int i = 0; i < steps_forward; ++i) {
+    auto const& dense_output = dense_outputs[i];
+    Instant const t_min = i == 0 ? t_initial : solution[i - 1].time.value;
+    Instant const t_max = solution[i].time.value;
+    EXPECT_EQ(1, dense_output.dimension());
+    EXPECT_EQ(t_min, dense_output.first_time());
+    EXPECT_THAT(dense_output.last_time(), AlmostEquals(t_max, 0, 1));
+
+    // The interpolant goes through the state at the end of the step.
+    EXPECT_THAT(AbsoluteError(solution[i].positions[0].value,
+                              dense_output.EvaluatePosition(t_max, 0)),
+                Le(1e-14 * Metre));
+    EXPECT_THAT(AbsoluteError(solution[i].velocities[0].value,
+                              dense_output.EvaluateVelocity(t_max, 0)),
+                Le(1e-14 * Metre / Second));
+
+    for (double const θ : {0.1, 0.25, 0.5, 0.75, 0.9}) {
+      Instant const t = t_min + θ * (t_max - t_min);
+      Time const elapsed = t - t_initial;
+      max_position_error =
+          std::max(max_position_error,
+                   AbsoluteError(x_initial * Cos(ω * elapsed),
+                                 dense_output.EvaluatePosition(t, 0)));
+      max_velocity_error =
+          std::max(max_velocity_error,
+                   AbsoluteError(-v_amplitude * Sin(ω * elapsed),
+                                 dense_output.EvaluateVelocity(t, 0)));
+    }
+  }
+
+  // The interpolation doesn't degrade the accuracy of the integration.
+  EXPECT_THAT(max_position_error, AllOf(Ge(2e-3 * Metre), Le(3e-3 * Metre)));
+  EXPECT_THAT(max_velocity_error,
+              AllOf(Ge(2e-3 * Metre / Second), Le(3e-3 * Metre / Second)));
+  EXPECT_THAT(max_position_error, Le(1.05 * max_step_position_error));
+  EXPECT_THAT(max_velocity_error, Le(1.05 * max_step_velocity_error));
+}
+
+// The dense output must not change the solution, even for a method that
+// doesn't have the FSAL property and must evaluate the accelerations at the end
+// of each step to build the interpolant.
+TEST_F(EmbeddedExplicitRungeKuttaNyströmIntegratorTest,
+       DenseOutputDoesNotChangeSolution) {
+  // The coefficients of |DormandElMikkawyPrince1986RKN434FM|, without using
+  // the FSAL property.
+  EmbeddedExplicitRungeKuttaNyströmIntegrator<
+      Length,
+      /*higher_order=*/4,
+      /*lower_order=*/3,
+      /*stages=*/4,
+      /*first_same_as_last=*/false> const non_fsal_integrator(
+          serialization::AdaptiveStepSizeIntegrator::
+              DORMAND_ELMIKKAWY_PRINCE_1986_RKN_434FM,
+          { 0.0         ,   1.0 /   4.0,   7.0 /  10.0,  1.0},
+          {
+            1.0 /   32.0,
+            7.0 / 1000.0, 119.0 / 500.0,
+            1.0 /   14.0,   8.0 /  27.0,  25.0 / 189.0},
+          { 1.0 /   14.0,   8.0 /  27.0,  25.0 / 189.0,  0.0},
+          { 1.0 /   14.0,  32.0 /  81.0, 250.0 / 567.0,  5.0 / 54.0},
+          {-7.0 /  150.0,  67.0 / 150.0,   3.0 /  20.0, -1.0 / 20.0},
+          {13.0 /   21.0, -20.0 /  27.0, 275.0 / 189.0, -1.0 /  3.0});
+  Length const x_initial = 1 * Metre;
+  Speed const v_initial = 0 * Metre / Second;
+  Time const period = 2 * π * Second;
+  Instant const t_initial;
+  Instant const t_final = t_initial + 10 * period;
+  Length const length_tolerance = 1 * Milli(Metre);
+  Speed const speed_tolerance = 1 * Milli(Metre) / Second;
+
+  auto const step_size_callback = [](bool tolerable) {};
+
+  auto const solve = [&](AdaptiveStepSizeIntegrator<ODE> const& integrator,
+                         bool const with_dense_output) {
+    int evaluations = 0;
+    std::vector<ODE::SystemState> solution;
+    ODE harmonic_oscillator;
+    harmonic_oscillator.compute_acceleration =
+        std::bind(ComputeHarmonicOscillatorAcceleration,
+                  _1, _2, _3, &evaluations);
+    IntegrationProblem<ODE> problem;
+    problem.equation = harmonic_oscillator;
+    ODE::SystemState const initial_state =
+        {{x_initial}, {v_initial}, t_initial};
+    problem.initial_state = &initial_state;
+    auto const append_state = [&solution](ODE::SystemState const& state) {
+      solution.push_back(state);
+    };
+    AdaptiveStepSize<ODE> adaptive_step_size;
+    adaptive_step_size.first_time_step = t_final - t_initial;
+    adaptive_step_size.safety_factor = 0.9;
+    adaptive_step_size.tolerance_to_error_ratio =
+        std::bind(HarmonicOscillatorToleranceRatio,
+                  _1, _2,
+                  length_tolerance, speed_tolerance, step_size_callback);
+    auto const instance =
+        with_dense_output
+            ? integrator.NewInstance(problem,
+                                     append_state,
+                                     [](ODE::DenseOutput const&) {},
+                                     adaptive_step_size)
+            : integrator.NewInstance(problem,
+                                     append_state,
+                                     adaptive_step_size);
+    EXPECT_EQ(termination_condition::Done,
+              integrator.Solve(t_final, *instance).error());
+    return solution;
+  };
+
+  for (AdaptiveStepSizeIntegrator<ODE> const* const integrator :
+           {static_cast<AdaptiveStepSizeIntegrator<ODE> const*>(
+                &DormandElMikkawyPrince1986RKN434FM<Length>()),
+            static_cast<AdaptiveStepSizeIntegrator<ODE> const*>(
+                &non_fsal_integrator)}) {
+    auto const solution = solve(*integrator, /*with_dense_output=*/false);
+    auto const dense_solution = solve(*integrator, /*with_dense_output=*/true);
+    ASSERT_EQ(solution.size(), dense_solution.size());
+    for (int i = 0; i < solution.size(); ++i) {
+      EXPECT_EQ(solution[i].time.value, dense_solution[i].time.value);
+      EXPECT_EQ(solution[i].time.error, dense_solution[i].time.error);
+      EXPECT_EQ(solution[i].positions[0].value,
+                dense_solution[i].positions[0].value);
+      EXPECT_EQ(solution[i].positions[0].error,
+                dense_solution[i].positions[0].error);
+      EXPECT_EQ(solution[i].velocities[0].value,
+                dense_solution[i].velocities[0].value);
+      EXPECT_EQ(solution[i].velocities[0].error,
+                dense_solution[i].velocities[0].error);
+    }
+  }
+}
+
+TEST_F(EmbeddedExplicitRungeKuttaNyströmIntegratorTest, Events) {
+  AdaptiveStepSizeIntegrator<ODE> const& integrator =
+      DormandElMikkawyPrince1986RKN434FM<Length>();
+  Length const x_initial = 1 * Metre;
+  Speed const v_initial = 0 * Metre / Second;
+  Time const period = 2 * π * Second;
+  Instant const t_initial;
+  Instant const t_final = t_initial + 10.125 * period;
+  Length const length_tolerance = 1 * Milli(Metre);
+  Speed const speed_tolerance = 1 * Milli(Metre) / Second;
+
+  auto const step_size_callback = [](bool tolerable) {};
+
+  int evaluations = 0;
+  std::vector<ODE::SystemState> solution;
+  // The states at the nodes (zeros of the position) and at the turning points
+  // (zeros of the velocity).
+  std::vector<ODE::SystemState> nodes;
+  std::vector<ODE::SystemState> turning_points;
+  ODE harmonic_oscillator;
+  harmonic_oscillator.compute_acceleration =
+      std::bind(ComputeHarmonicOscillatorAcceleration,
+                _1, _2, _3, &evaluations);
+  IntegrationProblem<ODE> problem;
+  problem.equation = harmonic_oscillator;
+  ODE::SystemState const initial_state = {{x_initial}, {v_initial}, t_initial};
+  problem.initial_state = &initial_state;
+  auto const append_state = [&solution](ODE::SystemState const& state) {
+    solution.push_back(state);
+  };
+  IntegrationEvent<ODE> node;
+  node.function = [](Instant const& t,
+                     std::vector<Length> const& positions,
+                     std::vector<Speed> const& velocities) {
+    return positions[0] / Metre;
+  };
+  IntegrationEvent<ODE> turning_point;
+  turning_point.function = [](Instant const& t,
+                              std::vector<Length> const& positions,
+                              std::vector<Speed> const& velocities) {
+    return velocities[0] / (Metre / Second);
+  };
+  auto const append_event = [&nodes, &turning_points](
+                                int const event,
+                                ODE::SystemState const& state) {
+    (event == 0 ? nodes : turning_points).push_back(state);
+  };
+  AdaptiveStepSize<ODE> adaptive_step_size;
+  adaptive_step_size.first_time_step = t_final - t_initial;
+  adaptive_step_size.safety_factor = 0.9;
+  adaptive_step_size.tolerance_to_error_ratio =
+      std::bind(HarmonicOscillatorToleranceRatio,
+                _1, _2, length_tolerance, speed_tolerance, step_size_callback);
+
+  auto const instance = integrator.NewInstance(problem,
+                                               append_state,
+                                               /*append_dense_output=*/nullptr,
+                                               {node, turning_point},
+                                               append_event,
+                                               adaptive_step_size);
+  auto const outcome = integrator.Solve(t_final, *instance);
+
+  EXPECT_EQ(termination_condition::Done, outcome.error());
+  // The velocity vanishes in the initial state, but doesn't change sign there.
+  ASSERT_EQ(20, nodes.size());
+  ASSERT_EQ(20, turning_points.size());
+
+  // The events are located as accurately as the solution is computed, and
+  // don't require any additional evaluations.
+  EXPECT_EQ(4 * (1 + 1) + 3 * (solution.size() - 1 + 3), evaluations);
+  Time max_node_error;
+  Time max_turning_point_error;
+  for (int i = 0; i < nodes.size(); ++i) {
+    EXPECT_THAT(Abs(nodes[i].positions[0].value), Le(1e-14 * Metre));
+    max_node_error =
+        std::max(max_node_error,
+                 AbsoluteError(t_initial + (i + 0.5) * π * Second,
+                               nodes[i].time.value));
+  }
+  for (int i = 0; i < turning_points.size(); ++i) {
+    EXPECT_THAT(Abs(turning_points[i].velocities[0].value),
+                Le(1e-14 * Metre / Second));
+    EXPECT_THAT(Abs(turning_points[i].positions[0].value),
+                AllOf(Ge(0.99 * Metre), Le(1.01 * Metre)));
+    max_turning_point_error =
+        std::max(max_turning_point_error,
+                 AbsoluteError(t_initial + (i + 1) * π * Second,
+                               turning_points[i].time.value));
+  }
+  EXPECT_THAT(max_node_error, AllOf(Ge(2e-3 * Second), Le(3e-3 * Second)));
+  EXPECT_THAT(max_turning_point_error,
+              AllOf(Ge(2e-3 * Second), Le(3e-3 * Second)));
+}
+
+// The velocity changes sign within a step, whose ends are not on the
+// interpolant of the velocity.
+TEST_F(EmbeddedExplicitRungeKuttaNyströmIntegratorTest, VelocityEvent) {
+  AdaptiveStepSizeIntegrator<ODE> const& integrator =
+      DormandElMikkawyPrince1986RKN434FM<Length>();
+  Length const x_initial = 0 * Metre;
+  Speed const v_initial = 1 * Metre / Second;
+  Instant const t_initial;
+  Instant const t_final = t_initial + π * Second;
+  Length const length_tolerance = 1 * Centi(Metre);
+  Speed const speed_tolerance = 1 * Centi(Metre) / Second;
+
+  auto const step_size_callback = [](bool tolerable) {};
+
+  int evaluations = 0;
+  std::vector<ODE::SystemState> solution;
+  std::vector<ODE::SystemState> turning_points;
+  ODE harmonic_oscillator;
+  harmonic_oscillator.compute_acceleration =
+      std::bind(ComputeHarmonicOscillatorAcceleration,
+                _1, _2, _3, &evaluations);
+  IntegrationProblem<ODE> problem;
+  problem.equation = harmonic_oscillator;
+  ODE::SystemState const initial_state = {{x_initial}, {v_initial}, t_initial};
+  problem.initial_state = &initial_state;
+  auto const append_state = [&solution](ODE::SystemState const& state) {
+    solution.push_back(state);
+  };
+  IntegrationEvent<ODE> turning_point;
+  turning_point.function = [](Instant const& t,
+                              std::vector<Length> const& positions,
+                              std::vector<Speed> const& velocities) {
+    return velocities[0] / (Metre / Second);
+  };
+  auto const append_event = [&turning_points](int const event,
+                                              ODE::SystemState const& state) {
+    EXPECT_EQ(0, event);
+    turning_points.push_back(state);
+  };
+  AdaptiveStepSize<ODE> adaptive_step_size;
+  adaptive_step_size.first_time_step = t_final - t_initial;
+  adaptive_step_size.safety_factor = 0.9;
+  adaptive_step_size.tolerance_to_error_ratio =
+      std::bind(HarmonicOscillatorToleranceRatio,
+                _1, _2, length_tolerance, speed_tolerance, step_size_callback);
+
+  auto const instance = integrator.NewInstance(problem,
+                                               append_state,
+                                               /*append_dense_output=*/nullptr,
+                                               {turning_point},
+                                               append_event,
+                                               adaptive_step_size);
+  auto const outcome = integrator.Solve(t_final, *instance);
+
+  EXPECT_EQ(termination_condition::Done, outcome.error());
+  ASSERT_EQ(1, turning_points.size());
+  Instant const& t_event = turning_points[0].time.value;
+  // The event is strictly inside a step.
+  auto const after = std::find_if(solution.begin(),
+                                  solution.end(),
+                                  [&t_event](ODE::SystemState const& state) {
+                                    return state.time.value >= t_event;
+                                  });
+  ASSERT_TRUE(after != solution.begin() && after != solution.end());
+  EXPECT_THAT(after->time.value, Gt(t_event));
+  EXPECT_THAT(std::prev(after)->time.value, Lt(t_event));
+  EXPECT_THAT(Abs(turning_points[0].velocities[0].value),
+              Le(1e-14 * Metre / Second));
+  EXPECT_THAT(AbsoluteError(t_initial + π / 2 * Second, t_event),
+              Le(1e-1 * Second));
+}
+
+TEST_F(EmbeddedExplicitRungeKuttaNyströmIntegratorTest, TerminalEvent) {
+  AdaptiveStepSizeIntegrator<ODE> const& integrator =
+      DormandElMikkawyPrince1986RKN434FM<Length>();
+  Length const x_initial = 1 * Metre;
+  Speed const v_initial = 0 * Metre / Second;
+  Time const period = 2 * π * Second;
+  Instant const t_initial;
+  Instant const t_final = t_initial + 2 * period;
+  Length const length_tolerance = 1 * Milli(Metre);
+  Speed const speed_tolerance = 1 * Milli(Metre) / Second;
+
+  auto const step_size_callback = [](bool tolerable) {};
+
+  int evaluations = 0;
+  std::vector<ODE::SystemState> solution;
+  std::vector<ODE::SystemState> crossings;
+  ODE harmonic_oscillator;
+  harmonic_oscillator.compute_acceleration =
+      std::bind(ComputeHarmonicOscillatorAcceleration,
+                _1, _2, _3, &evaluations);
+  IntegrationProblem<ODE> problem;
+  problem.equation = harmonic_oscillator;
+  ODE::SystemState const initial_state = {{x_initial}, {v_initial}, t_initial};
+  problem.initial_state = &initial_state;
+  auto const append_state = [&solution](ODE::SystemState const& state) {
+    solution.push_back(state);
+  };
+  // Crossing the plane x = -0.5 m in either direction.
+  IntegrationEvent<ODE> crossing;
+  crossing.function = [](Instant const& t,
+                         std::vector<Length> const& positions,
+                         std::vector<Speed> const& velocities) {
+    return positions[0] / Metre + 0.5;
+  };
+  crossing.terminal = true;
+  auto const append_event = [&crossings](int const event,
+                                         ODE::SystemState const& state) {
+    EXPECT_EQ(0, event);
+    crossings.push_back(state);
+  };
+  AdaptiveStepSize<ODE> adaptive_step_size;
+  adaptive_step_size.first_time_step = t_final - t_initial;
+  adaptive_step_size.safety_factor = 0.9;
+  adaptive_step_size.tolerance_to_error_ratio =
+      std::bind(HarmonicOscillatorToleranceRatio,
+                _1, _2, length_tolerance, speed_tolerance, step_size_callback);
+
+  auto const instance = integrator.NewInstance(problem,
+                                               append_state,
+                                               /*append_dense_output=*/nullptr,
+                                               {crossing},
+                                               append_event,
+                                               adaptive_step_size);
+
+  // The integration stops at each crossing and resumes from there.
+  std::vector<Instant> const expected_crossings = {
+      t_initial + 2 * π / 3 * Second,
+      t_initial + 4 * π / 3 * Second,
+      t_initial + 8 * π / 3 * Second,
+      t_initial + 10 * π / 3 * Second};
+  for (int i = 0; i < expected_crossings.size(); ++i) {
+    auto const outcome = integrator.Solve(t_final, *instance);
+    EXPECT_EQ(termination_condition::TerminalEvent, outcome.error());
+    ASSERT_EQ(i + 1, crossings.size());
+    EXPECT_EQ(crossings.back().time.value, solution.back().time.value);
+    EXPECT_EQ(crossings.back().positions[0].value,
+              solution.back().positions[0].value);
+    EXPECT_THAT(AbsoluteError(-0.5 * Metre,
+                              crossings.back().positions[0].value),
+                Le(2e-15 * Metre));
+    EXPECT_THAT(AbsoluteError(expected_crossings[i],
+                              crossings.back().time.value),
+                Le(4e-4 * Second));
+  }
+  auto const outcome = integrator.Solve(t_final, *instance);
+  EXPECT_EQ(termination_condition::Done, outcome.error());
+  EXPECT_EQ(4, crossings.size());
+  EXPECT_EQ(t_final, solution.back().time.value);
+}
+
 TEST_F(EmbeddedExplicitRungeKuttaNyströmIntegratorTest, Singularity) {
   // Integrating the position of an ideal rocket,
   //   x"(t) = m' I_sp / m(t),
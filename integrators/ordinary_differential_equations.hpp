@@ -2,6 +2,7 @@
 #ifndef PRINCIPIA_INTEGRATORS_ORDINARY_DIFFERENTIAL_EQUATIONS_HPP_
 #define PRINCIPIA_INTEGRATORS_ORDINARY_DIFFERENTIAL_EQUATIONS_HPP_
 
+#include <array>
 #include <experimental/optional>
 #include <functional>
 #include <limits>
@@ -43,6 +44,22 @@ struct SpecialSecondOrderDifferentialEquation {
                std::vector<Position> const& positions,
                std::vector<Acceleration>& accelerations)>;
 
+  // The arguments and results of one of the evaluations of a
+  // |BatchedRightHandSideComputation|.  |system| identifies the system being
+  // evaluated, e.g., the index of its instance in an integration in lockstep.
+  struct RightHandSideEvaluation {
+    int system;
+    Instant time;
+    not_null<std::vector<Position> const*> positions;
+    not_null<std::vector<Acceleration>*> accelerations;
+  };
+  // A functor that computes f(q, t) for several independent systems at once,
+  // possibly at different times, and stores them in the |*accelerations| of
+  // the |evaluations|.  Useful to share the work between the systems.
+  using BatchedRightHandSideComputation =
+      std::function<
+          void(std::vector<RightHandSideEvaluation> const& evaluations)>;
+
   struct SystemState {
     std::vector<DoublePrecision<Position>> positions;
     std::vector<DoublePrecision<Velocity>> velocities;
@@ -59,6 +76,61 @@ struct SpecialSecondOrderDifferentialEquation {
     std::vector<Velocity> velocity_error;
   };
 
+  // A continuous extension of the solution over one step [t₀, t₀ + h] of an
+  // integrator: for each dimension, the quintic Hermite polynomial matching
+  // the positions, velocities and accelerations at both ends of the step.  Its
+  // local error is O(h⁶) on the positions and O(h⁵) on the velocities, so it
+  // does not degrade the accuracy of the integrators of order at most 5.
+  class DenseOutput {
+   public:
+    // An interpolant that must be |Reset| before use.
+    DenseOutput() = default;
+
+    // |q0|, |v0| and |a0| are the positions, velocities and accelerations at
+    // |t0|, |Δq| and |Δv| the increments of the positions and velocities over
+    // the step, and |a1| the accelerations at |t0 + h|.
+    DenseOutput(Instant const& t0,
+                Time const& h,
+                std::vector<DoublePrecision<Position>> const& q0,
+                std::vector<DoublePrecision<Velocity>> const& v0,
+                std::vector<Acceleration> const& a0,
+                std::vector<Displacement> const& Δq,
+                std::vector<Velocity> const& Δv,
+                std::vector<Acceleration> const& a1);
+
+    // Makes this object the interpolant over another step, with the same
+    // meaning of the parameters as for the constructor.  Doesn't allocate if
+    // the dimension doesn't increase, so an integrator may use a single object
+    // for all its steps.
+    void Reset(Instant const& t0,
+               Time const& h,
+               std::vector<DoublePrecision<Position>> const& q0,
+               std::vector<DoublePrecision<Velocity>> const& v0,
+               std::vector<Acceleration> const& a0,
+               std::vector<Displacement> const& Δq,
+               std::vector<Velocity> const& Δv,
+               std::vector<Acceleration> const& a1);
+
+    // The times at the beginning and at the end of the step.  |first_time()|
+    // is after |last_time()| when integrating backward.
+    Instant const& first_time() const;
+    Instant last_time() const;
+
+    int dimension() const;
+
+    // |t| should lie between |first_time()| and |last_time()|, the result is
+    // an extrapolation otherwise.  |index| must be in [0, dimension()[.
+    Position EvaluatePosition(Instant const& t, int index) const;
+    Velocity EvaluateVelocity(Instant const& t, int index) const;
+
+   private:
+    Instant t0_;
+    Time h_;
+    std::vector<Position> q0_;
+    // The coefficients of θ, θ², ..., θ⁵ in q(t₀ + θh) - q₀.
+    std::vector<std::array<Displacement, 5>> coefficients_;
+  };
+
   // A functor that computes f(q, t) and stores it in |*accelerations|.
   // This functor must be called with |accelerations->size()| equal to
   // |positions->size()|, but there is no requirement on the values in
@@ -78,6 +150,12 @@ struct IntegrationInstance {
   template<typename ODE>
   using AppendState =
       std::function<void(typename ODE::SystemState const& state)>;
+  template<typename ODE>
+  using AppendDenseOutput =
+      std::function<void(typename ODE::DenseOutput const& dense_output)>;
+  template<typename ODE>
+  using AppendEvent =
+      std::function<void(int event, typename ODE::SystemState const& state)>;
   virtual ~IntegrationInstance() = default;  // Makes the type polymorphic.
 };
 
@@ -107,6 +185,24 @@ struct AdaptiveStepSize {
   std::int64_t max_steps = std::numeric_limits<std::int64_t>::max();
 };
 
+// An event detected during an adaptive step size integration: a change of sign
+// of |function| along the solution, e.g., of the radial velocity with respect
+// to a body at its apsides, or of the distance to a sphere when crossing it.
+// The event is only detected if the signs of |function| at the ends of a step
+// differ, so an even number of sign changes within a step goes unnoticed.
+template<typename ODE>
+struct IntegrationEvent {
+  using EventFunction =
+      std::function<
+          double(Instant const& t,
+                 std::vector<typename ODE::Position> const& positions,
+                 std::vector<typename ODE::Velocity> const& velocities)>;
+  // Must be continuous along the solution.
+  EventFunction function;
+  // If true, the integration stops at the first occurrence of this event.
+  bool terminal = false;
+};
+
 // A base class for integrators.
 template<typename DifferentialEquation>
 class Integrator {
@@ -131,6 +227,23 @@ class FixedStepSizeIntegrator : public Integrator<DifferentialEquation> {
     IntegrationInstance::AppendState<ODE> append_state,
     Time const& step) const = 0;
 
+  // Same as above, but the integration continues an earlier integration of
+  // |problem.equation| with the same |step|.  |history| contains the states
+  // passed to the |append_state| of that integration before
+  // |*problem.initial_state|, in chronological order.  A multistep integrator
+  // uses the last |history_length()| of them instead of doing a startup
+  // integration, the other integrators ignore them.  The integration is then
+  // bit-for-bit identical to the continuation of the earlier one.
+  virtual not_null<std::unique_ptr<IntegrationInstance>> NewInstance(
+    IntegrationProblem<ODE> const& problem,
+    IntegrationInstance::AppendState<ODE> append_state,
+    Time const& step,
+    std::vector<typename ODE::SystemState> const& history) const;
+
+  // The number of states of the |history| used by |NewInstance|.  0 for the
+  // integrators that only need the initial state.
+  virtual int history_length() const;
+
   void WriteToMessage(
       not_null<serialization::FixedStepSizeIntegrator*> const message) const;
   static FixedStepSizeIntegrator const& ReadFromMessage(
@@ -152,6 +265,12 @@ constexpr Error Done = Error::OK;
 constexpr Error ReachedMaximalStepCount = Error::ABORTED;
 // A singularity.
 constexpr Error VanishingStepSize = Error::FAILED_PRECONDITION;
+// The integration was cooperatively aborted, see |base::AbortRequested|.  It
+// may be retried with the same arguments and progress will happen.
+constexpr Error Cancelled = Error::CANCELLED;
+// A terminal |IntegrationEvent| occurred.  The integration may be retried
+// with the same arguments and progress will happen.
+constexpr Error TerminalEvent = Error::OUT_OF_RANGE;
 }  // namespace termination_condition
 
 // An integrator using a fixed step size.
@@ -163,9 +282,46 @@ class AdaptiveStepSizeIntegrator : public Integrator<DifferentialEquation> {
   virtual Status Solve(Instant const& t_final,
                        IntegrationInstance& instance) const = 0;
 
+  // Integrates each of the |instances| until the corresponding element of
+  // |t_finals|.  The instances are advanced in lockstep, each with its own
+  // step size control, but at each stage the evaluations of the right-hand
+  // side for all the instances are done by a single call to
+  // |compute_accelerations|, with |system| the index of the instance in
+  // |instances|.  The |equation|s of the instances are not used.  Returns, for
+  // each instance, the status that |Solve| would have returned if
+  // |compute_accelerations| computes the same accelerations as its |equation|.
+  virtual std::vector<Status> SolveInLockstep(
+      std::vector<Instant> const& t_finals,
+      std::vector<not_null<IntegrationInstance*>> const& instances,
+      typename ODE::BatchedRightHandSideComputation const&
+          compute_accelerations) const = 0;
+
+  virtual not_null<std::unique_ptr<IntegrationInstance>> NewInstance(
+    IntegrationProblem<ODE> const& problem,
+    IntegrationInstance::AppendState<ODE> append_state,
+    AdaptiveStepSize<ODE> const& adaptive_step_size) const = 0;
+
+  // Same as above, but |append_dense_output| is also called after each step
+  // with an interpolant of the solution over that step, unless it is empty.
+  virtual not_null<std::unique_ptr<IntegrationInstance>> NewInstance(
+    IntegrationProblem<ODE> const& problem,
+    IntegrationInstance::AppendState<ODE> append_state,
+    IntegrationInstance::AppendDenseOutput<ODE> append_dense_output,
+    AdaptiveStepSize<ODE> const& adaptive_step_size) const = 0;
+
+  // Same as above, but the |events| are also detected.  For each occurrence,
+  // in chronological order, |append_event| is called with the index of the
+  // event in |events| and with the state at which it occurs, located by
+  // bisection on the interpolant of the step.  When a terminal event occurs,
+  // that state is passed to |append_state| instead of the state at the end of
+  // the step, the integration resumes from it, and |Solve| returns
+  // |TerminalEvent|.  |append_dense_output| may be empty.
   virtual not_null<std::unique_ptr<IntegrationInstance>> NewInstance(
     IntegrationProblem<ODE> const& problem,
     IntegrationInstance::AppendState<ODE> append_state,
+    IntegrationInstance::AppendDenseOutput<ODE> append_dense_output,
+    std::vector<IntegrationEvent<ODE>> events,
+    IntegrationInstance::AppendEvent<ODE> append_event,
     AdaptiveStepSize<ODE> const& adaptive_step_size) const = 0;
 
   void WriteToMessage(
@@ -40,10 +40,116 @@ SpecialSecondOrderDifferentialEquation<Position>::SystemState::ReadFromMessage(
   return system_state;
 }
 
+template<typename Position>
+SpecialSecondOrderDifferentialEquation<Position>::DenseOutput::DenseOutput(
+    Instant const& t0,
+    Time const& h,
+    std::vector<DoublePrecision<Position>> const& q0,
+    std::vector<DoublePrecision<Velocity>> const& v0,
+    std::vector<Acceleration> const& a0,
+    std::vector<Displacement> const& Δq,
+    std::vector<Velocity> const& Δv,
+    std::vector<Acceleration> const& a1) {
+  Reset(t0, h, q0, v0, a0, Δq, Δv, a1);
+}
+
+template<typename Position>
+void SpecialSecondOrderDifferentialEquation<Position>::DenseOutput::Reset(
+    Instant const& t0,
+    Time const& h,
+    std::vector<DoublePrecision<Position>> const& q0,
+    std::vector<DoublePrecision<Velocity>> const& v0,
+    std::vector<Acceleration> const& a0,
+    std::vector<Displacement> const& Δq,
+    std::vector<Velocity> const& Δv,
+    std::vector<Acceleration> const& a1) {
+  CHECK_EQ(q0.size(), v0.size());
+  CHECK_EQ(q0.size(), a0.size());
+  CHECK_EQ(q0.size(), Δq.size());
+  CHECK_EQ(q0.size(), Δv.size());
+  CHECK_EQ(q0.size(), a1.size());
+  t0_ = t0;
+  h_ = h;
+  int const dimension = q0.size();
+  q0_.resize(dimension);
+  coefficients_.resize(dimension);
+  for (int k = 0; k < dimension; ++k) {
+    // The Taylor terms of degree 1 and 2 are determined by the state at t₀,
+    // the terms of degree 3 to 5 by the residuals of these Taylor terms at the
+    // end of the step.
+    Displacement const d1 = h * v0[k].value;
+    Displacement const d2 = 0.5 * h * h * a0[k];
+    Displacement const Δ = Δq[k] - d1 - d2;
+    Displacement const V = h * (Δv[k] - h * a0[k]);
+    Displacement const A = h * h * (a1[k] - a0[k]);
+    q0_[k] = q0[k].value;
+    coefficients_[k] = {{d1,
+                         d2,
+                         10 * Δ - 4 * V + 0.5 * A,
+                         -15 * Δ + 7 * V - A,
+                         6 * Δ - 3 * V + 0.5 * A}};
+  }
+}
+
+template<typename Position>
+Instant const&
+SpecialSecondOrderDifferentialEquation<Position>::DenseOutput::first_time()
+    const {
+  return t0_;
+}
+
+template<typename Position>
+Instant
+SpecialSecondOrderDifferentialEquation<Position>::DenseOutput::last_time()
+    const {
+  return t0_ + h_;
+}
+
+template<typename Position>
+int SpecialSecondOrderDifferentialEquation<Position>::DenseOutput::dimension()
+    const {
+  return q0_.size();
+}
+
+template<typename Position>
+Position
+SpecialSecondOrderDifferentialEquation<Position>::DenseOutput::
+EvaluatePosition(Instant const& t, int const index) const {
+  double const θ = (t - t0_) / h_;
+  auto const& d = coefficients_[index];
+  return q0_[index] + θ * (d[0] + θ * (d[1] + θ * (d[2] + θ * (d[3] +
+                                                              θ * d[4]))));
+}
+
+template<typename Position>
+typename SpecialSecondOrderDifferentialEquation<Position>::Velocity
+SpecialSecondOrderDifferentialEquation<Position>::DenseOutput::
+EvaluateVelocity(Instant const& t, int const index) const {
+  double const θ = (t - t0_) / h_;
+  auto const& d = coefficients_[index];
+  return (d[0] + θ * (2 * d[1] + θ * (3 * d[2] + θ * (4 * d[3] +
+                                                      θ * 5 * d[4])))) / h_;
+}
+
 template<typename DifferentialEquation>
 FixedStepSizeIntegrator<DifferentialEquation>::FixedStepSizeIntegrator(
     serialization::FixedStepSizeIntegrator::Kind const kind) : kind_(kind) {}
 
+template<typename DifferentialEquation>
+not_null<std::unique_ptr<IntegrationInstance>>
+FixedStepSizeIntegrator<DifferentialEquation>::NewInstance(
+    IntegrationProblem<ODE> const& problem,
+    IntegrationInstance::AppendState<ODE> append_state,
+    Time const& step,
+    std::vector<typename ODE::SystemState> const& history) const {
+  return NewInstance(problem, std::move(append_state), step);
+}
+
+template<typename DifferentialEquation>
+int FixedStepSizeIntegrator<DifferentialEquation>::history_length() const {
+  return 0;
+}
+
 template<typename DifferentialEquation>
 void FixedStepSizeIntegrator<DifferentialEquation>::WriteToMessage(
     not_null<serialization::FixedStepSizeIntegrator*> const message) const {
@@ -75,6 +181,22 @@ FixedStepSizeIntegrator<DifferentialEquation>::ReadFromMessage(
     case FSSI::OKUNBOR_SKEEL_1994_ORDER_6_METHOD_13:
       return OkunborSkeel1994Order6Method13<
                  typename DifferentialEquation::Position>();
+    case FSSI::QUINLAN_1999_ORDER_8A:
+      return Quinlan1999Order8A<typename DifferentialEquation::Position>();
+    case FSSI::QUINLAN_1999_ORDER_8B:
+      return Quinlan1999Order8B<typename DifferentialEquation::Position>();
+    case FSSI::QUINLAN_TREMAINE_1990_ORDER_8:
+      return QuinlanTremaine1990Order8<
+                 typename DifferentialEquation::Position>();
+    case FSSI::QUINLAN_TREMAINE_1990_ORDER_10:
+      return QuinlanTremaine1990Order10<
+                 typename DifferentialEquation::Position>();
+    case FSSI::QUINLAN_TREMAINE_1990_ORDER_12:
+      return QuinlanTremaine1990Order12<
+                 typename DifferentialEquation::Position>();
+    case FSSI::QUINLAN_TREMAINE_1990_ORDER_14:
+      return QuinlanTremaine1990Order14<
+                 typename DifferentialEquation::Position>();
     default:
       LOG(FATAL) << message.kind();
       base::noreturn();
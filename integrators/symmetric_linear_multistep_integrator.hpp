@@ -9,7 +9,6 @@
 #ifndef PRINCIPIA_INTEGRATORS_SYMMETRIC_LINEAR_MULTISTEP_INTEGRATOR_HPP_
 #define PRINCIPIA_INTEGRATORS_SYMMETRIC_LINEAR_MULTISTEP_INTEGRATOR_HPP_
 
-#include <list>
 #include <vector>
 
 #include "base/status.hpp"
@@ -52,6 +51,15 @@ class SymmetricLinearMultistepIntegrator
     IntegrationInstance::AppendState<ODE> append_state,
     Time const& step) const;
 
+  not_null<std::unique_ptr<IntegrationInstance>> NewInstance(
+    IntegrationProblem<ODE> const& problem,
+    IntegrationInstance::AppendState<ODE> append_state,
+    Time const& step,
+    std::vector<typename ODE::SystemState> const& history) const override;
+
+  // The previous steps other than the initial state.
+  int history_length() const override;
+
   static constexpr int order = order_;
 
  private:
@@ -65,16 +73,34 @@ class SymmetricLinearMultistepIntegrator
   };
 
   struct Instance : public IntegrationInstance {
+    // If |history| has at least |order_ - 1| elements, the previous steps are
+    // filled from its last elements and no startup integration is needed.
     Instance(IntegrationProblem<ODE> problem,
              AppendState<ODE> append_state,
-             Time step);
+             Time step,
+             std::vector<typename ODE::SystemState> const& history);
+    // Returns the |j|-th element of |previous_steps|, in chronological order.
+    Step& previous_step(int j);
+
     ODE const equation;
-    std::list<Step> previous_steps;  // At most |order_ - 1| elements.
+    // At most |order_| elements, in a ring buffer whose oldest element is at
+    // index |oldest_step|.  During startup the buffer is filled in
+    // chronological order and |oldest_step| is 0.  Once it is full, each new
+    // step reuses the storage of the oldest one.
+    std::vector<Step> previous_steps;
+    int oldest_step = 0;
     // During startup the following field is updated more frequently than once
     // every |step|.
     typename ODE::SystemState current_state;
     AppendState<ODE> const append_state;
     Time const step;
+
+    // The following fields are scratch storage for the integration.  They are
+    // sized once and for all by the constructor, so that the calls to |Solve|
+    // don't allocate.
+    std::vector<Position> positions;
+    std::vector<DoublePrecision<Position>> Σj_minus_ɑj_qj;
+    std::vector<typename ODE::Acceleration> Σj_βj_numerator_aj;
   };
 
   // Performs the startup integration, i.e., computes enough states to either
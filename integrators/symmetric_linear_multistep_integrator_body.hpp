@@ -47,50 +47,60 @@ Solve(Instant const& t_final,
   Time const& step = down_cast_instance.step;
 
   auto& previous_steps = down_cast_instance.previous_steps;
+  int& oldest_step = down_cast_instance.oldest_step;
 
   if (previous_steps.size() < order_ - 1) {
     StartupSolve(t_final, down_cast_instance);
   }
+  int const number_of_previous_steps = previous_steps.size();
 
   // Argument checks.
-  int const dimension = previous_steps.back().displacements.size();
+  int const dimension = previous_steps.front().displacements.size();
   CHECK_LT(Time(), step);
 
   // Time step.
   Time const& h = step;
   // Current time.
-  DoublePrecision<Instant> t = previous_steps.back().time;
+  DoublePrecision<Instant> t =
+      down_cast_instance.previous_step(number_of_previous_steps - 1).time;
   // Order.
   int const k = order_;
 
-  std::vector<Position> positions(dimension);
+  std::vector<Position>& positions = down_cast_instance.positions;
 
-  std::vector<DoublePrecision<Position>> Σj_minus_ɑj_qj(dimension);
-  std::vector<Acceleration> Σj_βj_numerator_aj(dimension);
+  std::vector<DoublePrecision<Position>>& Σj_minus_ɑj_qj =
+      down_cast_instance.Σj_minus_ɑj_qj;
+  std::vector<Acceleration>& Σj_βj_numerator_aj =
+      down_cast_instance.Σj_βj_numerator_aj;
   while (h <= (t_final - t.value) - t.error) {
-    // We take advantage of the symmetry to iterate on the list of previous
-    // steps from both ends.
-    auto front_it = previous_steps.begin();
-    auto back_it = previous_steps.rbegin();
+    // We take advantage of the symmetry to iterate on the previous steps from
+    // both ends.
 
     // This block corresponds to j = 0.  We must not pair it with j = k.
     {
-      std::vector<Displacement> const& qj = front_it->displacements;
-      std::vector<Acceleration> const& aj = front_it->accelerations;
+      Step const& step_j = down_cast_instance.previous_step(0);
+      std::vector<Displacement> const& qj = step_j.displacements;
+      std::vector<Acceleration> const& aj = step_j.accelerations;
       double const ɑj = ɑ_[0];
       double const βj_numerator = β_numerator_[0];
       for (int d = 0; d < dimension; ++d) {
-        Σj_minus_ɑj_qj[d] = -ɑj * qj[d];
+        // The ɑj sum to 0 and ɑk is 1, so this sum is a barycentre of the
+        // positions with weights -ɑj, which we accumulate from the origin.
+        Σj_minus_ɑj_qj[d] = DoublePrecision<Position>(Position() - ɑj * qj[d]);
         Σj_βj_numerator_aj[d] = βj_numerator * aj[d];
       }
-      ++front_it;
     }
     // The generic value of j, paired with k - j.
     for (int j = 1; j < k / 2; ++j) {
-      std::vector<Displacement> const& qj = front_it->displacements;
-      std::vector<Displacement> const& qk_minus_j = back_it->displacements;
-      std::vector<Acceleration> const& aj = front_it->accelerations;
-      std::vector<Acceleration> const& ak_minus_j = back_it->accelerations;
+      Step const& step_j = down_cast_instance.previous_step(j);
+      Step const& step_k_minus_j = down_cast_instance.previous_step(
+          number_of_previous_steps - j);
+      std::vector<Displacement> const& qj = step_j.displacements;
+      std::vector<Displacement> const& qk_minus_j =
+          step_k_minus_j.displacements;
+      std::vector<Acceleration> const& aj = step_j.accelerations;
+      std::vector<Acceleration> const& ak_minus_j =
+          step_k_minus_j.accelerations;
       double const ɑj = ɑ_[j];
       double const βj_numerator = β_numerator_[j];
       for (int d = 0; d < dimension; ++d) {
@@ -98,13 +108,12 @@ Solve(Instant const& t_final,
         Σj_minus_ɑj_qj[d].Increment(-ɑj * qk_minus_j[d]);
         Σj_βj_numerator_aj[d] += βj_numerator * (aj[d] + ak_minus_j[d]);
       }
-      ++front_it;
-      ++back_it;
     }
     // This block corresponds to j = k / 2.  We must not pair it with j = k / 2.
     {
-      std::vector<Displacement> const& qj = front_it->displacements;
-      std::vector<Acceleration> const& aj = front_it->accelerations;
+      Step const& step_j = down_cast_instance.previous_step(k / 2);
+      std::vector<Displacement> const& qj = step_j.displacements;
+      std::vector<Acceleration> const& aj = step_j.accelerations;
       double const ɑj = ɑ_[k / 2];
       double const βj_numerator = β_numerator_[k / 2];
       for (int d = 0; d < dimension; ++d) {
@@ -113,13 +122,12 @@ Solve(Instant const& t_final,
       }
     }
 
-    // Create a new step in the instance.
+    // Create a new step in the instance, reusing the storage of the oldest
+    // step.
     t.Increment(h);
-    previous_steps.pop_front();
-    previous_steps.emplace_back();
-    Step& current_step = previous_steps.back();
+    Step& current_step = previous_steps[oldest_step];
+    oldest_step = (oldest_step + 1) % number_of_previous_steps;
     current_step.time = t;
-    current_step.accelerations.resize(dimension);
 
     // Fill the new step.  We skip the division by ɑk as it is equal to 1.0.
     double const ɑk = ɑ_[0];
@@ -128,7 +136,7 @@ Solve(Instant const& t_final,
       DoublePrecision<Position>& current_position = Σj_minus_ɑj_qj[d];
       current_position.Increment(
           h * h * Σj_βj_numerator_aj[d] / β_denominator_);
-      current_step.displacements.push_back(current_position.value - Position());
+      current_step.displacements[d] = current_position.value - Position();
       positions[d] = current_position.value;
       system_state.positions[d] = current_position;
     }
@@ -150,16 +158,34 @@ SymmetricLinearMultistepIntegrator<Position, order_>::
 NewInstance(IntegrationProblem<ODE> const& problem,
             IntegrationInstance::AppendState<ODE> append_state,
             Time const& step) const {
+  return NewInstance(problem, std::move(append_state), step, /*history=*/{});
+}
+
+template<typename Position, int order_>
+not_null<std::unique_ptr<IntegrationInstance>>
+SymmetricLinearMultistepIntegrator<Position, order_>::
+NewInstance(IntegrationProblem<ODE> const& problem,
+            IntegrationInstance::AppendState<ODE> append_state,
+            Time const& step,
+            std::vector<typename ODE::SystemState> const& history) const {
   return make_not_null_unique<Instance>(problem,
                                         std::move(append_state),
-                                        step);
+                                        step,
+                                        history);
+}
+
+template<typename Position, int order_>
+int SymmetricLinearMultistepIntegrator<Position, order_>::
+history_length() const {
+  return order_ - 1;
 }
 
 template<typename Position, int order_>
 SymmetricLinearMultistepIntegrator<Position, order_>::
 Instance::Instance(IntegrationProblem<ODE> problem,
                    AppendState<ODE> append_state,
-                   Time step)
+                   Time step,
+                   std::vector<typename ODE::SystemState> const& history)
     : equation(std::move(problem.equation)),
       current_state(*problem.initial_state),
       append_state(std::move(append_state)),
@@ -167,10 +193,32 @@ Instance::Instance(IntegrationProblem<ODE> problem,
   CHECK_EQ(problem.initial_state->positions.size(),
            problem.initial_state->velocities.size());
 
+  int const dimension = current_state.positions.size();
+  positions.resize(dimension);
+  Σj_minus_ɑj_qj.resize(dimension);
+  Σj_βj_numerator_aj.resize(dimension);
+
+  previous_steps.reserve(order_);
+  if (history.size() >= order_ - 1) {
+    // The states of the |history| were computed at intervals of |step|, the
+    // last of them just before the |current_state|.
+    CHECK_LT(history.back().time.value, current_state.time.value);
+    for (auto it = history.end() - (order_ - 1); it != history.end(); ++it) {
+      previous_steps.emplace_back();
+      FillStepFromSystemState(equation, *it, previous_steps.back());
+    }
+  }
   previous_steps.emplace_back();
   FillStepFromSystemState(equation, current_state, previous_steps.back());
 }
 
+template<typename Position, int order_>
+typename SymmetricLinearMultistepIntegrator<Position, order_>::Step&
+SymmetricLinearMultistepIntegrator<Position, order_>::Instance::previous_step(
+    int const j) {
+  return previous_steps[(oldest_step + j) % previous_steps.size()];
+}
+
 template<typename Position, int order_>
 void SymmetricLinearMultistepIntegrator<Position, order_>::
 StartupSolve(Instant const& t_final,
@@ -225,12 +273,14 @@ void SymmetricLinearMultistepIntegrator<Position, order_>::
   using Velocity = typename ODE::Velocity;
   for (int d = 0; d < dimension; ++d) {
     DoublePrecision<Velocity>& velocity = instance.current_state.velocities[d];
-    auto it = instance.previous_steps.rbegin();
+    int const number_of_previous_steps = instance.previous_steps.size();
     Acceleration weighted_acceleration;
     for (int i = 0; i < velocity_integrator_.numerators.size; ++i) {
       double const numerator = velocity_integrator_.numerators[i];
-      weighted_acceleration += numerator * it->accelerations[d];
-      ++it;
+      weighted_acceleration +=
+          numerator *
+          instance.previous_step(number_of_previous_steps - 1 - i).
+              accelerations[d];
     }
     velocity.Increment(instance.step * weighted_acceleration /
                        velocity_integrator_.denominator);
@@ -242,13 +292,15 @@ void SymmetricLinearMultistepIntegrator<Position, order_>::
 FillStepFromSystemState(ODE const& equation,
                         typename ODE::SystemState const& state,
                         Step& step) {
+  std::vector<Position> positions;
   step.time = state.time;
   for (auto const& position : state.positions) {
+    positions.push_back(position.value);
     step.displacements.push_back(position.value - Position());
   }
   step.accelerations.resize(step.displacements.size());
   equation.compute_acceleration(step.time.value,
-                                step.displacements,
+                                positions,
                                 step.accelerations);
 }
 
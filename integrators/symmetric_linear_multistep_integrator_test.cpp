@@ -301,6 +301,69 @@ void TestSymplecticity(Integrator const& integrator,
   EXPECT_EQ(expected_energy_error, max_energy_error);
 }
 
+// Test that an integration resumed from the history of an earlier integration
+// doesn't do a startup, and is identical to the continuation of the earlier
+// integration.
+template<typename Integrator>
+void TestHistory(Integrator const& integrator) {
+  Length const q_initial = 1 * Metre;
+  Speed const v_initial = 0 * Metre / Second;
+  Instant const t_initial;
+  Instant const t_final = t_initial + 100 * Second;
+  Time const step = 0.1 * Second;
+  int const order = Integrator::order;
+
+  int evaluations = 0;
+
+  std::vector<ODE::SystemState> solution;
+  ODE harmonic_oscillator;
+  harmonic_oscillator.compute_acceleration =
+      std::bind(ComputeHarmonicOscillatorAcceleration,
+                _1, _2, _3, &evaluations);
+  IntegrationProblem<ODE> problem;
+  problem.equation = harmonic_oscillator;
+  ODE::SystemState const initial_state = {{q_initial}, {v_initial}, t_initial};
+  problem.initial_state = &initial_state;
+
+  auto const instance = integrator.NewInstance(
+      problem,
+      [&solution](ODE::SystemState const& state) {
+        solution.push_back(state);
+      },
+      step);
+  integrator.Solve(t_final, *instance);
+
+  // Resume the integration well after the end of the startup.
+  int const resumption = 500;
+  EXPECT_EQ(order - 1, integrator.history_length());
+  std::vector<ODE::SystemState> const history(
+      solution.begin() + resumption - integrator.history_length(),
+      solution.begin() + resumption);
+  problem.initial_state = &solution[resumption];
+
+  std::vector<ODE::SystemState> resumed_solution;
+  evaluations = 0;
+  auto const resumed_instance = integrator.NewInstance(
+      problem,
+      [&resumed_solution](ODE::SystemState const& state) {
+        resumed_solution.push_back(state);
+      },
+      step,
+      history);
+  integrator.Solve(t_final, *resumed_instance);
+
+  // One evaluation for each of the previous steps, and one per step.
+  EXPECT_EQ(order + resumed_solution.size(), evaluations);
+  ASSERT_EQ(solution.size() - resumption - 1, resumed_solution.size());
+  for (int i = 0; i < resumed_solution.size(); ++i) {
+    auto const& expected_state = solution[resumption + 1 + i];
+    auto const& state = resumed_solution[i];
+    EXPECT_EQ(expected_state.time.value, state.time.value);
+    EXPECT_EQ(expected_state.positions[0].value, state.positions[0].value);
+    EXPECT_EQ(expected_state.velocities[0].value, state.velocities[0].value);
+  }
+}
+
 class SimpleHarmonicMotionTestInstance {
  public:
   template<typename Integrator>
@@ -324,6 +387,7 @@ class SimpleHarmonicMotionTestInstance {
             std::bind(TestSymplecticity<Integrator>,
                       integrator,
                       expected_energy_error)),
+        test_history_(std::bind(TestHistory<Integrator>, integrator)),
         name_(name) {}
 
   std::string const& name() const {
@@ -346,11 +410,16 @@ class SimpleHarmonicMotionTestInstance {
     test_symplecticity_();
   }
 
+  void RunHistory() const {
+    test_history_();
+  }
+
  private:
   std::function<void()> test_termination_;
   std::function<void()> test_1000_seconds_at_1_millisecond_;
   std::function<void()> test_convergence_;
   std::function<void()> test_symplecticity_;
+  std::function<void()> test_history_;
   std::string name_;
 };
 
@@ -426,5 +495,10 @@ TEST_P(SymmetricLinearMultistepIntegratorTest, LongIntegration) {
   GetParam().Run1000SecondsAt1Millisecond();
 }
 
+TEST_P(SymmetricLinearMultistepIntegratorTest, History) {
+  LOG(INFO) << GetParam();
+  GetParam().RunHistory();
+}
+
 }  // namespace integrators
 }  // namespace principia
@@ -9,6 +9,8 @@
 #ifndef PRINCIPIA_INTEGRATORS_SYMPLECTIC_RUNGE_KUTTA_NYSTRÖM_INTEGRATOR_HPP_
 #define PRINCIPIA_INTEGRATORS_SYMPLECTIC_RUNGE_KUTTA_NYSTRÖM_INTEGRATOR_HPP_
 
+#include <vector>
+
 #include "integrators/ordinary_differential_equations.hpp"
 #include "numerics/fixed_arrays.hpp"
 
@@ -104,6 +106,18 @@ class SymplecticRungeKuttaNyströmIntegrator
     typename ODE::SystemState current_state;
     AppendState<ODE> const append_state;
     Time const step;
+
+    // The following fields are scratch storage for the integration.  They are
+    // sized once and for all by the constructor, so that the calls to |Solve|
+    // don't allocate.
+    // Position increment.
+    std::vector<typename ODE::Displacement> Δq;
+    // Velocity increment.
+    std::vector<typename ODE::Velocity> Δv;
+    // Current Runge-Kutta-Nyström stage.
+    std::vector<Position> q_stage;
+    // Accelerations at the current stage.
+    std::vector<typename ODE::Acceleration> g;
   };
 
   FixedVector<double, stages_> const a_;
@@ -106,10 +106,9 @@ void SymplecticRungeKuttaNyströmIntegrator<Position, order, time_reversible,
   // equations more readable.
   DoublePrecision<Instant>& t = current_state.time;
 
-  // Position increment.
-  std::vector<Displacement> Δq(dimension);
-  // Velocity increment.
-  std::vector<Velocity> Δv(dimension);
+  // Position and velocity increments.
+  std::vector<Displacement>& Δq = down_cast_instance.Δq;
+  std::vector<Velocity>& Δv = down_cast_instance.Δv;
   // Current position.  This is a non-const reference whose purpose is to make
   // the equations more readable.
   std::vector<DoublePrecision<Position>>& q = current_state.positions;
@@ -118,9 +117,9 @@ void SymplecticRungeKuttaNyströmIntegrator<Position, order, time_reversible,
   std::vector<DoublePrecision<Velocity>>& v = current_state.velocities;
 
   // Current Runge-Kutta-Nyström stage.
-  std::vector<Position> q_stage(dimension);
+  std::vector<Position>& q_stage = down_cast_instance.q_stage;
   // Accelerations at the current stage.
-  std::vector<Acceleration> g(dimension);
+  std::vector<Acceleration>& g = down_cast_instance.g;
 
   // The first full stage of the step, i.e. the first stage where
   // exp(bᵢ h B) exp(aᵢ h A) must be entirely computed.
@@ -203,6 +202,12 @@ Instance::Instance(IntegrationProblem<ODE> problem,
       step(std::move(step)) {
   CHECK_EQ(current_state.positions.size(),
            current_state.velocities.size());
+
+  int const dimension = current_state.positions.size();
+  Δq.resize(dimension);
+  Δv.resize(dimension);
+  q_stage.resize(dimension);
+  g.resize(dimension);
 }
 
 template<typename Position>
@@ -19,7 +19,9 @@ using interface::Iterator;
 using interface::KSPPart;
 using interface::NavigationFrameParameters;
 using interface::NavigationManoeuvre;
+using interface::PluginMessage;
 using interface::QP;
+using interface::VesselGuid;
 using interface::WXYZ;
 using interface::XYZ;
 using ksp_plugin::NavigationFrame;
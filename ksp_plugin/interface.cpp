@@ -2,6 +2,7 @@
 #include "ksp_plugin/interface.hpp"
 
 #include <cctype>
+#include <chrono>
 #include <cstring>
 #include <string>
 #include <utility>
@@ -14,6 +15,7 @@
 
 #include "astronomy/epoch.hpp"
 #include "base/array.hpp"
+#include "base/base64.hpp"
 #include "base/hexadecimal.hpp"
 #include "base/macros.hpp"
 #include "base/not_null.hpp"
@@ -35,8 +37,14 @@ namespace principia {
 namespace interface {
 
 using astronomy::J2000;
+using base::Array;
+using base::Base64Decode;
+using base::Base64DecodedSize;
+using base::Base64Encode;
+using base::Base64EncodedSize;
 using base::Bytes;
 using base::check_not_null;
+using base::Compression;
 using base::HexadecimalDecode;
 using base::HexadecimalEncode;
 using base::make_not_null_unique;
@@ -129,6 +137,93 @@ base::not_null<std::unique_ptr<MassiveBody>> MakeMassiveBody(
   return SolarSystem<Barycentric>::MakeMassiveBody(gravity_model);
 }
 
+// Pulls the next chunk of the serialization of |*serializer|, which must have
+// been started.  At the end of the serialization, deletes |*serializer|, sets
+// it to null, and returns an empty |Bytes|.  The result is owned by the
+// serializer and stays valid until the next call.
+Bytes PullSerializationChunk(PullSerializer** const serializer) {
+  Bytes const bytes = (*serializer)->Pull();
+  if (bytes.size == 0) {
+    TakeOwnership(serializer);
+  }
+  return bytes;
+}
+
+// Same as above, except that if |*serializer| is null, creates and starts a
+// serializer for |plugin| and stores it in |*serializer|.
+Bytes PullSerializationChunk(Plugin const& plugin,
+                             PullSerializer** const serializer) {
+  if (*serializer == nullptr) {
+    // The serializer streams the parts of the message as they are built.
+    *serializer =
+        new PullSerializer(chunk_size, number_of_chunks, Compression::Gzip);
+    (*serializer)->Start(plugin.WriteToMessageParts());
+  }
+  return PullSerializationChunk(serializer);
+}
+
+// Returns the base 64 representation of |bytes| as a null-terminated string
+// owned by the caller.
+char const* NewBase64String(Bytes const& bytes) {
+  std::int64_t const base64_size = Base64EncodedSize(bytes.size) + 1;
+  UniqueBytes base64(base64_size);
+  Base64Encode(bytes, base64.get());
+  base64.data.get()[base64_size - 1] = '\0';
+  return reinterpret_cast<char const*>(base64.data.release());
+}
+
+// Returns the bytes whose base 64 representation is the |size| characters at
+// |base64|.
+UniqueBytes Base64DecodeString(char const* const base64, int const size) {
+  Array<std::uint8_t const> const characters(
+      reinterpret_cast<uint8_t const*>(base64), size);
+  UniqueBytes bytes(Base64DecodedSize(characters.size));
+  Base64Decode(characters, bytes.get());
+  return bytes;
+}
+
+// Pushes |bytes|, a chunk of a serialization, to |*deserializer|, which takes
+// ownership of them.  If |*deserializer| is null, creates a deserializer,
+// starts it by calling |start|, and stores it in |*deserializer|.  If |bytes|
+// is empty, this is the end of the serialization: deletes |*deserializer|,
+// which ensures that the callback given to |Start| has run, and sets it to
+// null.
+void PushDeserializationChunk(
+    UniqueBytes bytes,
+    PushDeserializer** const deserializer,
+    std::function<void(PushDeserializer& deserializer)> const& start) {
+  if (*deserializer == nullptr) {
+    *deserializer = new PushDeserializer(chunk_size, number_of_chunks);
+    start(**deserializer);
+  }
+
+  std::int64_t const size = bytes.size;
+  std::uint8_t* const data = bytes.data.release();
+  (*deserializer)->Push(Bytes(data, size), [data]() { delete[] data; });
+
+  if (size == 0) {
+    TakeOwnership(deserializer);
+  }
+}
+
+// Same as above, for the serialization of a plugin, which is stored in
+// |*plugin| at the end of the serialization.
+void PushDeserializationChunk(UniqueBytes bytes,
+                              PushDeserializer** const deserializer,
+                              Plugin const** const plugin) {
+  PushDeserializationChunk(
+      std::move(bytes),
+      deserializer,
+      [plugin](PushDeserializer& deserializer) {
+        deserializer.Start(
+            make_not_null_unique<serialization::Plugin>(),
+            [plugin](google::protobuf::Message const& message) {
+              *plugin = Plugin::ReadFromMessage(
+                  static_cast<serialization::Plugin const&>(message)).release();
+            });
+      });
+}
+
 }  // namespace
 
 // If |activate| is true and there is no active journal, create one and
@@ -297,6 +392,8 @@ void principia__DeleteString(char const** const native_string) {
 // successive calls.  The caller must perform an extra call with
 // |serialization_size| set to 0 to indicate the end of the input stream.  When
 // this last call returns, |*plugin| is not null and may be used by the caller.
+// The serialization may or may not be compressed, so that saves written before
+// the introduction of compression remain readable.
 void principia__DeserializePlugin(char const* const serialization,
                                   int const serialization_size,
                                   PushDeserializer** const deserializer,
@@ -311,36 +408,102 @@ void principia__DeserializePlugin(char const* const serialization,
   CHECK_NOTNULL(deserializer);
   CHECK_NOTNULL(plugin);
 
-  // Create and start a deserializer if the caller didn't provide one.
-  if (*deserializer == nullptr) {
-    *deserializer = new PushDeserializer(chunk_size, number_of_chunks);
-    auto message = make_not_null_unique<serialization::Plugin>();
-    (*deserializer)->Start(
-        std::move(message),
-        [plugin](google::protobuf::Message const& message) {
-          *plugin = Plugin::ReadFromMessage(
-              static_cast<serialization::Plugin const&>(message)).release();
-        });
-  }
-
   // Decode the hexadecimal representation.
   uint8_t const* const hexadecimal =
       reinterpret_cast<uint8_t const*>(serialization);
   int const hexadecimal_size = serialization_size;
-  int const byte_size = hexadecimal_size >> 1;
-  // Ownership of the following pointer is transfered to the deserializer using
-  // the callback to |Push|.
-  std::uint8_t* bytes = new uint8_t[byte_size];
-  HexadecimalDecode({hexadecimal, hexadecimal_size}, {bytes, byte_size});
-
-  // Push the data, taking ownership of it.
-  (*deserializer)->Push(Bytes(&bytes[0], byte_size),
-                        [bytes]() { delete[] bytes; });
-
-  // If the data was empty, delete the deserializer.  This ensures that
-  // |*plugin| is filled.
-  if (byte_size == 0) {
-    TakeOwnership(deserializer);
+  UniqueBytes bytes(hexadecimal_size >> 1);
+  HexadecimalDecode({hexadecimal, hexadecimal_size}, bytes.get());
+
+  PushDeserializationChunk(std::move(bytes), deserializer, plugin);
+  return m.Return();
+}
+
+// Same as above, except that |serialization| is in base 64, as produced by
+// |principia__SerializePluginBase64|.
+void principia__DeserializePluginBase64(char const* const serialization,
+                                        int const serialization_size,
+                                        PushDeserializer** const deserializer,
+                                        Plugin const** const plugin) {
+  journal::Method<journal::DeserializePluginBase64> m({serialization,
+                                                       serialization_size,
+                                                       deserializer,
+                                                       plugin},
+                                                      {deserializer, plugin});
+  LOG(INFO) << __FUNCTION__;
+  CHECK_NOTNULL(serialization);
+  CHECK_NOTNULL(deserializer);
+  CHECK_NOTNULL(plugin);
+
+  UniqueBytes bytes = Base64DecodeString(serialization, serialization_size);
+  PushDeserializationChunk(std::move(bytes), deserializer, plugin);
+  return m.Return();
+}
+
+// Deserializes a plugin saved by |principia__SerializePluginDelta|: a full
+// serialization, written with |compact| true, followed by the deltas written
+// after it, with |compact| false.  Each serialization is passed in turn as for
+// |principia__DeserializePluginBase64|, including the extra call with
+// |serialization_size| set to 0 at its end, and with the value of |compact|
+// with which it was written.  At the end of the full serialization, the
+// message that it contains is stored in |*plugin_message|; at the end of each
+// delta, the delta is applied to |**plugin_message|.  Once the last delta has
+// been deserialized, |principia__ReadPluginFromMessage| returns the plugin.
+// |*plugin_message| must be null on the first call.  No transfer of ownership
+// of |*serialization| or |**deserializer|.  The caller takes ownership of
+// |**plugin_message| when it is not null.
+void principia__DeserializePluginDelta(char const* const serialization,
+                                       int const serialization_size,
+                                       bool const compact,
+                                       PushDeserializer** const deserializer,
+                                       PluginMessage** const plugin_message) {
+  journal::Method<journal::DeserializePluginDelta> m(
+      {serialization,
+       serialization_size,
+       compact,
+       deserializer,
+       plugin_message},
+      {deserializer, plugin_message});
+  LOG(INFO) << __FUNCTION__;
+  CHECK_NOTNULL(serialization);
+  CHECK_NOTNULL(deserializer);
+  CHECK_NOTNULL(plugin_message);
+  if (*deserializer == nullptr) {
+    if (compact) {
+      CHECK(*plugin_message == nullptr)
+          << "The full serialization must come first";
+    } else {
+      CHECK(*plugin_message != nullptr)
+          << "A delta must follow a full serialization";
+    }
+  }
+
+  UniqueBytes bytes = Base64DecodeString(serialization, serialization_size);
+  if (compact) {
+    PushDeserializationChunk(
+        std::move(bytes),
+        deserializer,
+        [plugin_message](PushDeserializer& deserializer) {
+          deserializer.Start(
+              make_not_null_unique<serialization::Plugin>(),
+              [plugin_message](google::protobuf::Message const& message) {
+                *plugin_message = new PluginMessage(
+                    static_cast<serialization::Plugin const&>(message));
+              });
+        });
+  } else {
+    PushDeserializationChunk(
+        std::move(bytes),
+        deserializer,
+        [plugin_message](PushDeserializer& deserializer) {
+          deserializer.Start(
+              make_not_null_unique<serialization::PluginDelta>(),
+              [plugin_message](google::protobuf::Message const& message) {
+                Plugin::ApplyDeltaToMessage(
+                    static_cast<serialization::PluginDelta const&>(message),
+                    *plugin_message);
+              });
+        });
   }
   return m.Return();
 }
@@ -634,6 +797,21 @@ bool principia__PhysicsBubbleIsEmpty(Plugin const* const plugin) {
   return m.Return(plugin->PhysicsBubbleIsEmpty());
 }
 
+// Returns the plugin whose serialization is |**plugin_message|, as obtained
+// by |principia__DeserializePluginDelta|.  Deletes |*plugin_message| and nulls
+// it.  The caller takes ownership of the result.
+Plugin const* principia__ReadPluginFromMessage(
+    PluginMessage** const plugin_message) {
+  journal::Method<journal::ReadPluginFromMessage> m({plugin_message},
+                                                    {plugin_message});
+  LOG(INFO) << __FUNCTION__;
+  CHECK_NOTNULL(plugin_message);
+  CHECK_NOTNULL(*plugin_message);
+  std::unique_ptr<PluginMessage const> const message =
+      TakeOwnership(plugin_message);
+  return m.Return(Plugin::ReadFromMessage(*message).release());
+}
+
 Iterator* principia__RenderedPrediction(Plugin* const plugin,
                                         char const* const vessel_guid,
                                         XYZ const sun_world_position) {
@@ -709,7 +887,8 @@ char const* principia__SayHello() {
 // |plugin| must not be null.  The caller takes ownership of the result, except
 // when it is null (at the end of the stream).  No transfer of ownership of
 // |*plugin|.  |*serializer| must be null on the first call and must be passed
-// unchanged to the successive calls; its ownership is not transferred.
+// unchanged to the successive calls; its ownership is not transferred.  The
+// serialization is compressed.
 char const* principia__SerializePlugin(Plugin const* const plugin,
                                        PullSerializer** const serializer) {
   journal::Method<journal::SerializePlugin> m({plugin, serializer},
@@ -718,22 +897,10 @@ char const* principia__SerializePlugin(Plugin const* const plugin,
   CHECK_NOTNULL(plugin);
   CHECK_NOTNULL(serializer);
 
-  // Create and start a serializer if the caller didn't provide one.
-  if (*serializer == nullptr) {
-    *serializer = new PullSerializer(chunk_size, number_of_chunks);
-    auto message = make_not_null_unique<serialization::Plugin>();
-    plugin->WriteToMessage(message.get());
-    (*serializer)->Start(std::move(message));
-  }
-
-  // Pull a chunk.
-  Bytes bytes;
-  bytes = (*serializer)->Pull();
+  Bytes const bytes = PullSerializationChunk(*plugin, serializer);
 
-  // If this is the end of the serialization, delete the serializer and return a
-  // nullptr.
+  // If this is the end of the serialization, return a nullptr.
   if (bytes.size == 0) {
-    TakeOwnership(serializer);
     return m.Return(nullptr);
   }
 
@@ -745,6 +912,75 @@ char const* principia__SerializePlugin(Plugin const* const plugin,
   return m.Return(reinterpret_cast<char const*>(hexadecimal.data.release()));
 }
 
+// Same as above, except that the result is in base 64, which is 2/3 of the
+// size of the hexadecimal representation.
+char const* principia__SerializePluginBase64(
+    Plugin const* const plugin,
+    PullSerializer** const serializer) {
+  journal::Method<journal::SerializePluginBase64> m({plugin, serializer},
+                                                    {serializer});
+  LOG(INFO) << __FUNCTION__;
+  CHECK_NOTNULL(plugin);
+  CHECK_NOTNULL(serializer);
+
+  Bytes const bytes = PullSerializationChunk(*plugin, serializer);
+
+  // If this is the end of the serialization, return a nullptr.
+  if (bytes.size == 0) {
+    return m.Return(nullptr);
+  }
+
+  // Convert to base 64 and return to the client.
+  return m.Return(NewBase64String(bytes));
+}
+
+// Same as above, except that the serialization becomes the checkpoint of
+// |plugin|, i.e., the base of the next delta.  If |compact| is true, |plugin|
+// is serialized in full, which supersedes the previous checkpoint and the
+// deltas written after it.  Otherwise only the changes since the previous
+// checkpoint are serialized (see |Plugin::WriteDeltaToMessage|); there must be
+// one, i.e., |plugin| must have been serialized by this function or
+// deserialized.  The serializations are read by
+// |principia__DeserializePluginDelta|.
+char const* principia__SerializePluginDelta(Plugin* const plugin,
+                                            bool const compact,
+                                            PullSerializer** const serializer) {
+  journal::Method<journal::SerializePluginDelta> m({plugin,
+                                                    compact,
+                                                    serializer},
+                                                   {serializer});
+  LOG(INFO) << __FUNCTION__;
+  CHECK_NOTNULL(plugin);
+  CHECK_NOTNULL(serializer);
+
+  if (*serializer == nullptr) {
+    // The checkpoint is recorded from the message, before the plugin changes,
+    // so the message is built in full before being streamed.
+    *serializer =
+        new PullSerializer(chunk_size, number_of_chunks, Compression::Gzip);
+    if (compact) {
+      auto message = make_not_null_unique<serialization::Plugin>();
+      plugin->WriteToMessage(message.get());
+      plugin->SetSerializationCheckpoint(*message);
+      (*serializer)->Start(std::move(message));
+    } else {
+      auto delta = make_not_null_unique<serialization::PluginDelta>();
+      plugin->WriteDeltaToMessage(delta.get());
+      plugin->SetSerializationCheckpoint(*delta);
+      (*serializer)->Start(std::move(delta));
+    }
+  }
+  Bytes const bytes = PullSerializationChunk(serializer);
+
+  // If this is the end of the serialization, return a nullptr.
+  if (bytes.size == 0) {
+    return m.Return(nullptr);
+  }
+
+  // Convert to base 64 and return to the client.
+  return m.Return(NewBase64String(bytes));
+}
+
 // Sets the maximum number of seconds which logs may be buffered for.
 void principia__SetBufferDuration(int const seconds) {
   journal::Method<journal::SetBufferDuration> m({seconds});
@@ -850,6 +1086,40 @@ void principia__UpdatePrediction(Plugin const* const plugin,
   return m.Return();
 }
 
+// Returns false if the predictions could not all be computed within
+// |time_limit_in_seconds| of wall-clock time, in which case some of them are
+// shorter than requested.
+bool principia__UpdatePredictions(Plugin const* const plugin,
+                                  VesselGuid const* const vessel_guids,
+                                  int const count,
+                                  double const time_limit_in_seconds) {
+  journal::Method<journal::UpdatePredictions> m({plugin,
+                                                 vessel_guids,
+                                                 count,
+                                                 time_limit_in_seconds});
+  CHECK_NOTNULL(plugin);
+  std::vector<std::string> guids;
+  guids.reserve(count);
+  for (VesselGuid const* vessel_guid = vessel_guids;
+       vessel_guid < vessel_guids + count;
+       ++vessel_guid) {
+    guids.emplace_back(vessel_guid->guid);
+  }
+  auto const status = plugin->UpdatePredictions(
+      guids,
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(time_limit_in_seconds)));
+  return m.Return(status.ok());
+}
+
+void principia__UsePrecomputedEphemeris(Plugin* const plugin,
+                                        char const* const path) {
+  journal::Method<journal::UsePrecomputedEphemeris> m({plugin, path});
+  CHECK_NOTNULL(plugin);
+  plugin->UsePrecomputedEphemeris(path);
+  return m.Return();
+}
+
 // Calls |plugin->VesselFromParent| with the arguments given.
 // |plugin| must not be null.  No transfer of ownership.
 QP principia__VesselFromParent(Plugin const* const plugin,
@@ -31,6 +31,10 @@ using ksp_plugin::Vessel;
 using ksp_plugin::World;
 using physics::DiscreteTrajectory;
 
+// A serialization of a plugin, into which |principia__DeserializePluginDelta|
+// folds the deltas that follow it.
+using PluginMessage = serialization::Plugin;
+
 // A wrapper for a container and an iterator into that container.
 class Iterator {
  public:
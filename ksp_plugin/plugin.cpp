@@ -3,14 +3,20 @@
 
 #include <algorithm>
 #include <cmath>
+#include <functional>
+#include <future>
 #include <ios>
 #include <limits>
 #include <map>
+#include <memory>
+#include <random>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 #include <set>
 
+#include "astronomy/epoch.hpp"
 #include "base/hexadecimal.hpp"
 #include "base/map_util.hpp"
 #include "base/not_null.hpp"
@@ -38,10 +44,12 @@ namespace ksp_plugin {
 namespace internal_plugin {
 
 using base::dynamic_cast_not_null;
+using base::Error;
 using base::FindOrDie;
 using base::FingerprintCat2011;
 using base::make_not_null_unique;
 using base::not_null;
+using base::Status;
 using geometry::AffineMap;
 using geometry::AngularVelocity;
 using geometry::BarycentreCalculator;
@@ -64,7 +72,9 @@ using physics::Frenet;
 using physics::KeplerianElements;
 using physics::RotatingBody;
 using quantities::Force;
+using quantities::IsFinite;
 using quantities::Length;
+using quantities::si::Day;
 using quantities::si::Milli;
 using quantities::si::Minute;
 using quantities::si::Radian;
@@ -73,6 +83,9 @@ using ::operator<<;
 namespace {
 
 Length const fitting_tolerance = 1 * Milli(Metre);
+// How far ahead of the current time the ephemeris is prolonged in the
+// background.
+Time const ephemeris_prolongation_horizon = 1 * Day;
 
 std::uint64_t const ksp_stock_system_fingerprint = 0xD15286A27180CD31u;
 std::uint64_t const ksp_fixed_system_fingerprint = 0x648C354716008328u;
@@ -87,6 +100,14 @@ Ephemeris<Barycentric>::FixedStepParameters DefaultEphemerisParameters() {
              /*step=*/45 * Minute);
 }
 
+// A random identifier for a serialization, so that those of different plugins
+// or sessions are unlikely to be confused.
+std::uint64_t NewSerializationId() {
+  std::random_device random_device;
+  return static_cast<std::uint64_t>(random_device()) << 32 |
+         static_cast<std::uint32_t>(random_device());
+}
+
 }  // namespace
 
 Plugin::Plugin(Instant const& game_epoch,
@@ -175,6 +196,13 @@ void Plugin::InsertCelestialJacobiKeplerian(
                                                 *unowned_body)).second);
 }
 
+void Plugin::UsePrecomputedEphemeris(
+    std::experimental::filesystem::path const& path) {
+  LOG(INFO) << __FUNCTION__ << " " << path;
+  CHECK(initializing_);
+  precomputed_ephemeris_path_ = path;
+}
+
 void Plugin::EndInitialization() {
   CHECK(initializing_);
   if (hierarchical_initialization_) {
@@ -210,13 +238,18 @@ void Plugin::EndInitialization() {
   }
   CHECK(absolute_initialization_);
   CHECK_NOTNULL(sun_);
-  main_body_ = CHECK_NOTNULL(
-      dynamic_cast_not_null<RotatingBody<Barycentric> const*>(sun_->body()));
   initializing_.Flop();
 
-  InitializeEphemerisAndSetCelestialTrajectories();
+  bool const is_precomputed = InitializeEphemerisAndSetCelestialTrajectories();
+  // The celestials are only final once the ephemeris has been initialized.
+  main_body_ = CHECK_NOTNULL(
+      dynamic_cast_not_null<RotatingBody<Barycentric> const*>(sun_->body()));
 
-  // Log the serialized ephemeris.
+  // Log the serialized ephemeris, unless it comes from a file, in which case
+  // it is much too large and the file is a better record anyway.
+  if (is_precomputed) {
+    return;
+  }
   serialization::Ephemeris ephemeris_message;
   ephemeris_->WriteToMessage(&ephemeris_message);
   std::string const bytes = ephemeris_message.SerializeAsString();
@@ -365,12 +398,14 @@ void Plugin::AdvanceTime(Instant const& t, Angle const& planetarium_rotation) {
   bubble_->Prepare(BarycentricToWorldSun(), current_time_, t);
 
   EvolveBubble(t);
+  std::vector<not_null<Vessel*>> vessels_not_in_bubble;
   for (auto const& pair : vessels_) {
     not_null<std::unique_ptr<Vessel>> const& vessel = pair.second;
     if (!bubble_->contains(vessel.get())) {
-      vessel->AdvanceTimeNotInBubble(t);
+      vessels_not_in_bubble.push_back(vessel.get());
     }
   }
+  Vessel::AdvanceTimeNotInBubble(vessels_not_in_bubble, t);
 
   VLOG(1) << "Time has been advanced" << '\n'
           << "from : " << current_time_ << '\n'
@@ -431,6 +466,49 @@ void Plugin::UpdatePrediction(GUID const& vessel_guid) const {
       current_time_ + prediction_length_);
 }
 
+Status Plugin::UpdatePredictions(
+    std::vector<GUID> const& vessel_guids,
+    std::chrono::steady_clock::duration const Δt) const {
+  CHECK(!initializing_);
+  // The flows must not prolong the ephemeris, since they run concurrently.
+  Instant const last_time = current_time_ + prediction_length_;
+  if (IsFinite(prediction_length_)) {
+    ephemeris_->Prolong(last_time);
+  }
+  Instant const prediction_last_time = std::min(last_time, ephemeris_->t_max());
+
+  // The integrations check |AbortRequested| and stop at the deadline.
+  auto const deadline = std::chrono::steady_clock::now() + Δt;
+  std::vector<std::future<void>> futures;
+  for (auto const& vessel_guid : vessel_guids) {
+    not_null<Vessel*> const vessel =
+        find_vessel_by_guid_or_die(vessel_guid).get();
+    futures.push_back(vessel_thread_pool_->Add(
+        [deadline, prediction_last_time, vessel]() {
+          base::AbortRequested = [deadline]() {
+            return std::chrono::steady_clock::now() >= deadline;
+          };
+          vessel->UpdatePrediction(prediction_last_time);
+          base::AbortRequested = []() { return false; };
+        }));
+  }
+
+  // The tasks modify the vessels, so we must wait for all of them even if the
+  // deadline has passed; they return promptly in that case.
+  bool deadline_exceeded = false;
+  for (auto& future : futures) {
+    if (future.wait_until(deadline) == std::future_status::timeout) {
+      deadline_exceeded = true;
+      future.wait();
+    }
+  }
+  if (deadline_exceeded) {
+    return Status(Error::DEADLINE_EXCEEDED,
+                  "Predictions not computed within the allotted time");
+  }
+  return Status::OK;
+}
+
 void Plugin::CreateFlightPlan(GUID const& vessel_guid,
                               Instant const& final_time,
                               Mass const& initial_mass) const {
@@ -768,66 +846,174 @@ Instant Plugin::CurrentTime() const {
 void Plugin::WriteToMessage(
     not_null<serialization::Plugin*> const message) const {
   LOG(INFO) << __FUNCTION__;
+  WriteToMessage(message, /*delta=*/nullptr);
+}
+
+void Plugin::WriteDeltaToMessage(
+    not_null<serialization::PluginDelta*> const message) const {
+  LOG(INFO) << __FUNCTION__;
+  CHECK(serialization_checkpoint_)
+      << "No previous serialization to write a delta against";
+  WriteToMessage(message->mutable_plugin(), message);
+}
+
+void Plugin::SetSerializationCheckpoint(
+    serialization::Plugin const& message) {
+  CHECK(message.has_serialization_id());
+  SetSerializationCheckpoint(message.serialization_id(),
+                             message.ephemeris(),
+                             astronomy::InfinitePast);
+}
+
+void Plugin::SetSerializationCheckpoint(
+    serialization::PluginDelta const& delta) {
+  CHECK(serialization_checkpoint_);
+  CHECK_EQ(serialization_checkpoint_->serialization_id,
+           delta.base_serialization_id());
+  SetSerializationCheckpoint(
+      delta.plugin().serialization_id(),
+      delta.plugin().ephemeris(),
+      Instant::ReadFromMessage(delta.ephemeris_forget_after()));
+}
+
+void Plugin::WriteToMessage(
+    not_null<serialization::Plugin*> const message,
+    serialization::PluginDelta* const delta) const {
   CHECK(!initializing_);
   ephemeris_->Prolong(current_time_);
-  std::map<not_null<Celestial const*>, Index const> celestial_to_index;
-  for (auto const& pair : celestials_) {
-    Index const index = pair.first;
-    auto const& owned_celestial = pair.second;
-    celestial_to_index.emplace(owned_celestial.get(), index);
-  }
-  for (auto const& pair : celestials_) {
-    Index const index = pair.first;
-    auto const& owned_celestial = pair.second.get();
-    auto* const celestial_message = message->add_celestial();
-    celestial_message->set_index(index);
-    if (owned_celestial->has_parent()) {
-      Index const parent_index =
-          FindOrDie(celestial_to_index, owned_celestial->parent());
-      celestial_message->set_parent_index(parent_index);
-    }
-  }
-  std::map<not_null<Vessel const*>, GUID const> vessel_to_guid;
+  WriteCelestialsAndParametersToMessage(message);
+
+  // The vessels and the ephemeris are serialized in parallel into sub-messages
+  // allocated beforehand, so the order of the output does not depend on the
+  // scheduling.  Each write only touches its own sub-message.
+  std::map<not_null<Celestial const*>, Index const> const celestial_to_index =
+      CelestialToIndex();
+  std::vector<std::future<void>> writes;
   for (auto const& pair : vessels_) {
     std::string const& guid = pair.first;
-    not_null<Vessel*> const vessel = pair.second.get();
-    vessel_to_guid.emplace(vessel, guid);
-    auto* const vessel_message = message->add_vessel();
-    vessel_message->set_guid(guid);
-    vessel->WriteToMessage(vessel_message->mutable_vessel());
+    not_null<Vessel const*> const vessel = pair.second.get();
     Index const parent_index = FindOrDie(celestial_to_index, vessel->parent());
-    vessel_message->set_parent_index(parent_index);
-    vessel_message->set_dirty(vessel->is_dirty());
+    // The time up to which the history is in the previous serialization, if
+    // this is a delta and the vessel is in the previous serialization.
+    Instant const* history_forget_after = nullptr;
+    if (delta != nullptr) {
+      auto const it =
+          serialization_checkpoint_->history_forget_after.find(guid);
+      if (it != serialization_checkpoint_->history_forget_after.end()) {
+        history_forget_after = &it->second;
+        auto* const history_tail = delta->add_history_tail();
+        history_tail->set_guid(guid);
+        vessel->history().Begin().time().WriteToMessage(
+            history_tail->mutable_forget_before());
+        history_forget_after->WriteToMessage(
+            history_tail->mutable_forget_after());
+      }
+    }
+    not_null<serialization::Plugin::VesselAndProperties*> const
+        vessel_message = message->add_vessel();
+    writes.push_back(vessel_thread_pool_->Add(
+        [&guid, vessel, parent_index, history_forget_after, vessel_message]() {
+          WriteVesselToMessage(guid,
+                               vessel,
+                               parent_index,
+                               history_forget_after,
+                               vessel_message);
+        }));
   }
 
-  ephemeris_->WriteToMessage(message->mutable_ephemeris());
-
-  history_parameters_.WriteToMessage(message->mutable_history_parameters());
-  prolongation_parameters_.WriteToMessage(
-      message->mutable_prolongation_parameters());
-  prediction_parameters_.WriteToMessage(
-      message->mutable_prediction_parameters());
-
-  bubble_->WriteToMessage(
-      [&vessel_to_guid](not_null<Vessel const*> const vessel) -> GUID {
-        return FindOrDie(vessel_to_guid, vessel);
-      },
-      message->mutable_bubble());
+  not_null<serialization::Ephemeris*> const ephemeris_message =
+      message->mutable_ephemeris();
+  if (delta == nullptr) {
+    writes.push_back(vessel_thread_pool_->Add([this, ephemeris_message]() {
+      ephemeris_->WriteToMessage(ephemeris_message);
+    }));
+  } else {
+    delta->set_base_serialization_id(
+        serialization_checkpoint_->serialization_id);
+    Instant const& forget_after =
+        serialization_checkpoint_->ephemeris_forget_after;
+    forget_after.WriteToMessage(delta->mutable_ephemeris_forget_after());
+    writes.push_back(
+        vessel_thread_pool_->Add([this, ephemeris_message, &forget_after]() {
+          ephemeris_->WriteToMessage(ephemeris_message, forget_after);
+        }));
+  }
 
-  planetarium_rotation_.WriteToMessage(message->mutable_planetarium_rotation());
-  if (!is_pre_cardano_) {
-    // A pre-Cardano save stays pre-Cardano; we cannot pull rotational
-    // properties out of thin air.
-    game_epoch_.WriteToMessage(message->mutable_game_epoch());
+  for (auto& write : writes) {
+    write.wait();
   }
-  current_time_.WriteToMessage(message->mutable_current_time());
-  Index const sun_index = FindOrDie(celestial_to_index, sun_);
-  message->set_sun_index(sun_index);
-  plotting_frame_->WriteToMessage(message->mutable_plotting_frame());
+
   LOG(INFO) << NAMED(message->SpaceUsed());
   LOG(INFO) << NAMED(message->ByteSize());
 }
 
+std::function<std::unique_ptr<serialization::Plugin const>()>
+Plugin::WriteToMessageParts() const {
+  LOG(INFO) << __FUNCTION__;
+  CHECK(!initializing_);
+  ephemeris_->Prolong(current_time_);
+
+  // The state shared by the workers and the consumer.  The parts are built in
+  // |messages|, each by the task that owns the corresponding element of
+  // |builds|.
+  struct Parts {
+    ~Parts() {
+      // The tasks of the parts that were not consumed may still be running.
+      for (auto& build : builds) {
+        if (build.valid()) {
+          build.wait();
+        }
+      }
+    }
+    std::vector<std::unique_ptr<serialization::Plugin>> messages;
+    std::vector<std::future<void>> builds;
+    int next_part = 0;
+  };
+  auto const state = std::make_shared<Parts>();
+
+  // The first part is cheap and is built here, the others on the thread pool.
+  state->messages.push_back(std::make_unique<serialization::Plugin>());
+  WriteCelestialsAndParametersToMessage(state->messages.back().get());
+  state->builds.emplace_back();
+
+  std::map<not_null<Celestial const*>, Index const> const celestial_to_index =
+      CelestialToIndex();
+  for (auto const& pair : vessels_) {
+    std::string const& guid = pair.first;
+    not_null<Vessel const*> const vessel = pair.second.get();
+    Index const parent_index = FindOrDie(celestial_to_index, vessel->parent());
+    state->messages.push_back(std::make_unique<serialization::Plugin>());
+    not_null<serialization::Plugin::VesselAndProperties*> const
+        vessel_message = state->messages.back()->add_vessel();
+    state->builds.push_back(vessel_thread_pool_->Add(
+        [&guid, vessel, parent_index, vessel_message]() {
+          WriteVesselToMessage(guid,
+                               vessel,
+                               parent_index,
+                               /*history_forget_after=*/nullptr,
+                               vessel_message);
+        }));
+  }
+  state->messages.push_back(std::make_unique<serialization::Plugin>());
+  not_null<serialization::Ephemeris*> const ephemeris_message =
+      state->messages.back()->mutable_ephemeris();
+  state->builds.push_back(
+      vessel_thread_pool_->Add([this, ephemeris_message]() {
+        ephemeris_->WriteToMessage(ephemeris_message);
+      }));
+
+  return [state]() -> std::unique_ptr<serialization::Plugin const> {
+    if (state->next_part == state->messages.size()) {
+      return nullptr;
+    }
+    int const i = state->next_part++;
+    if (state->builds[i].valid()) {
+      state->builds[i].get();
+    }
+    return std::move(state->messages[i]);
+  };
+}
+
 not_null<std::unique_ptr<Plugin>> Plugin::ReadFromMessage(
     serialization::Plugin const& message) {
   LOG(INFO) << __FUNCTION__;
@@ -923,9 +1109,87 @@ not_null<std::unique_ptr<Plugin>> Plugin::ReadFromMessage(
   } else {
     plugin->SetPlottingFrame(std::move(plotting_frame));
   }
+  // A delta may only be written against a serialization in the current
+  // format.
+  if (!is_pre_bourbaki && message.has_serialization_id() &&
+      std::all_of(message.vessel().begin(),
+                  message.vessel().end(),
+                  [](serialization::Plugin::VesselAndProperties const&
+                         vessel_message) {
+                    return vessel_message.vessel().has_history();
+                  })) {
+    plugin->SetSerializationCheckpoint(message);
+  }
+  plugin->ephemeris_->StartAsynchronousProlongation(
+      ephemeris_prolongation_horizon);
   return std::move(plugin);
 }
 
+void Plugin::ApplyDeltaToMessage(
+    serialization::PluginDelta const& delta,
+    not_null<serialization::Plugin*> const message) {
+  LOG(INFO) << __FUNCTION__;
+  CHECK_EQ(message->serialization_id(), delta.base_serialization_id())
+      << "The delta is not relative to this serialization";
+  // Everything but the trajectories is taken from the delta.  The series and
+  // the points of |message| are moved, not copied.
+  serialization::Plugin result = delta.plugin();
+
+  Instant const ephemeris_forget_after =
+      Instant::ReadFromMessage(delta.ephemeris_forget_after());
+  auto& trajectories = *result.mutable_ephemeris()->mutable_trajectory();
+  auto& base_trajectories = *message->mutable_ephemeris()->mutable_trajectory();
+  CHECK_EQ(base_trajectories.size(), trajectories.size());
+  for (int i = 0; i < trajectories.size(); ++i) {
+    auto& trajectory = trajectories[i];
+    google::protobuf::RepeatedPtrField<serialization::ChebyshevSeries> series;
+    // A trajectory without a first time has no series, see
+    // |ContinuousTrajectory::ForgetBefore|.
+    if (trajectory.has_first_time()) {
+      Instant const first_time =
+          Instant::ReadFromMessage(trajectory.first_time());
+      for (auto& s : *base_trajectories[i].mutable_series()) {
+        Instant const t_max = Instant::ReadFromMessage(s.t_max());
+        if (first_time <= t_max && t_max <= ephemeris_forget_after) {
+          series.Add()->Swap(&s);
+        }
+      }
+    }
+    for (auto& s : *trajectory.mutable_series()) {
+      series.Add()->Swap(&s);
+    }
+    trajectory.mutable_series()->Swap(&series);
+  }
+
+  std::map<GUID, not_null<serialization::Vessel*>> base_vessels;
+  for (auto& vessel_message : *message->mutable_vessel()) {
+    base_vessels.emplace(vessel_message.guid(),
+                         vessel_message.mutable_vessel());
+  }
+  std::map<GUID, not_null<serialization::Vessel*>> vessels;
+  for (auto& vessel_message : *result.mutable_vessel()) {
+    vessels.emplace(vessel_message.guid(), vessel_message.mutable_vessel());
+  }
+  for (auto const& history_tail : delta.history_tail()) {
+    serialization::Vessel& base_vessel =
+        *FindOrDie(base_vessels, history_tail.guid());
+    serialization::Vessel& vessel = *FindOrDie(vessels, history_tail.guid());
+    // The prolongation is the only fork of the history in the serialization,
+    // and it is forked at the last point.
+    DiscreteTrajectory<Barycentric>* prolongation = nullptr;
+    auto const history = DiscreteTrajectory<Barycentric>::ReadFromMessage(
+                             base_vessel.history(), {&prolongation});
+    history->DeleteFork(prolongation);
+    history->ForgetBefore(
+        Instant::ReadFromMessage(history_tail.forget_before()));
+    history->ForgetAfter(Instant::ReadFromMessage(history_tail.forget_after()));
+    history->AppendFromMessage(vessel.history(), {&prolongation});
+    vessel.clear_history();
+    history->WriteToMessage(vessel.mutable_history(), {prolongation});
+  }
+  message->Swap(&result);
+}
+
 std::unique_ptr<Ephemeris<Barycentric>> Plugin::NewEphemeris(
     std::vector<not_null<std::unique_ptr<MassiveBody const>>> bodies,
     std::vector<DegreesOfFreedom<Barycentric>> const& initial_state,
@@ -977,23 +1241,162 @@ Plugin::Plugin(
 }
 
 
-void Plugin::InitializeEphemerisAndSetCelestialTrajectories() {
-  std::vector<not_null<std::unique_ptr<MassiveBody const>>> bodies;
-  std::vector<DegreesOfFreedom<Barycentric>> initial_state;
-  for (auto& pair : absolute_initialization_->bodies) {
-    auto& body = pair.second;
-    bodies.emplace_back(std::move(body));
+std::map<not_null<Celestial const*>, Index const>
+Plugin::CelestialToIndex() const {
+  std::map<not_null<Celestial const*>, Index const> celestial_to_index;
+  for (auto const& pair : celestials_) {
+    Index const index = pair.first;
+    auto const& owned_celestial = pair.second;
+    celestial_to_index.emplace(owned_celestial.get(), index);
   }
-  for (auto const& pair : absolute_initialization_->initial_state) {
-    auto const& degrees_of_freedom = pair.second;
-    initial_state.emplace_back(degrees_of_freedom);
+  return celestial_to_index;
+}
+
+void Plugin::WriteCelestialsAndParametersToMessage(
+    not_null<serialization::Plugin*> const message) const {
+  std::map<not_null<Celestial const*>, Index const> const celestial_to_index =
+      CelestialToIndex();
+  for (auto const& pair : celestials_) {
+    Index const index = pair.first;
+    auto const& owned_celestial = pair.second.get();
+    auto* const celestial_message = message->add_celestial();
+    celestial_message->set_index(index);
+    if (owned_celestial->has_parent()) {
+      Index const parent_index =
+          FindOrDie(celestial_to_index, owned_celestial->parent());
+      celestial_message->set_parent_index(parent_index);
+    }
   }
-  absolute_initialization_ = std::experimental::nullopt;
-  ephemeris_ = NewEphemeris(std::move(bodies),
-                            initial_state,
-                            current_time_,
-                            fitting_tolerance,
-                            DefaultEphemerisParameters());
+
+  history_parameters_.WriteToMessage(message->mutable_history_parameters());
+  prolongation_parameters_.WriteToMessage(
+      message->mutable_prolongation_parameters());
+  prediction_parameters_.WriteToMessage(
+      message->mutable_prediction_parameters());
+
+  std::map<not_null<Vessel const*>, GUID const> vessel_to_guid;
+  for (auto const& pair : vessels_) {
+    vessel_to_guid.emplace(pair.second.get(), pair.first);
+  }
+  bubble_->WriteToMessage(
+      [&vessel_to_guid](not_null<Vessel const*> const vessel) -> GUID {
+        return FindOrDie(vessel_to_guid, vessel);
+      },
+      message->mutable_bubble());
+
+  planetarium_rotation_.WriteToMessage(message->mutable_planetarium_rotation());
+  if (!is_pre_cardano_) {
+    // A pre-Cardano save stays pre-Cardano; we cannot pull rotational
+    // properties out of thin air.
+    game_epoch_.WriteToMessage(message->mutable_game_epoch());
+  }
+  current_time_.WriteToMessage(message->mutable_current_time());
+  message->set_sun_index(FindOrDie(celestial_to_index, sun_));
+  plotting_frame_->WriteToMessage(message->mutable_plotting_frame());
+  message->set_serialization_id(NewSerializationId());
+}
+
+void Plugin::WriteVesselToMessage(
+    GUID const& guid,
+    not_null<Vessel const*> const vessel,
+    Index const parent_index,
+    Instant const* const history_forget_after,
+    not_null<serialization::Plugin::VesselAndProperties*> const message) {
+  message->set_guid(guid);
+  message->set_parent_index(parent_index);
+  message->set_dirty(vessel->is_dirty());
+  if (history_forget_after == nullptr) {
+    vessel->WriteToMessage(message->mutable_vessel());
+  } else {
+    vessel->WriteToMessage(message->mutable_vessel(), *history_forget_after);
+  }
+}
+
+void Plugin::SetSerializationCheckpoint(
+    std::uint64_t const serialization_id,
+    serialization::Ephemeris const& ephemeris_message,
+    Instant const& ephemeris_forget_after) {
+  SerializationCheckpoint checkpoint;
+  checkpoint.serialization_id = serialization_id;
+  // The series of the trajectories should all end at the same time, but we
+  // take the earliest end to be safe.
+  checkpoint.ephemeris_forget_after = astronomy::InfiniteFuture;
+  for (auto const& trajectory : ephemeris_message.trajectory()) {
+    int const size = trajectory.series_size();
+    checkpoint.ephemeris_forget_after = std::min(
+        checkpoint.ephemeris_forget_after,
+        size == 0
+            ? ephemeris_forget_after
+            : Instant::ReadFromMessage(trajectory.series(size - 1).t_max()));
+  }
+  for (auto const& pair : vessels_) {
+    GUID const& guid = pair.first;
+    Vessel const& vessel = *pair.second;
+    checkpoint.history_forget_after.emplace(
+        guid, vessel.history().last_stable_time());
+  }
+  serialization_checkpoint_ = checkpoint;
+}
+
+bool Plugin::InitializeEphemerisAndSetCelestialTrajectories() {
+  std::unique_ptr<Ephemeris<Barycentric>> precomputed_ephemeris;
+  if (precomputed_ephemeris_path_) {
+    precomputed_ephemeris =
+        ReadPrecomputedEphemeris(absolute_initialization_->bodies,
+                                 absolute_initialization_->initial_state);
+    precomputed_ephemeris_path_ = std::experimental::nullopt;
+  }
+  bool const is_precomputed = precomputed_ephemeris != nullptr;
+
+  if (is_precomputed) {
+    ephemeris_ = std::move(precomputed_ephemeris);
+    // The celestials point to the bodies that were inserted, which are not
+    // those of the ephemeris: rebuild them, matching the bodies by name.
+    std::map<std::string, not_null<MassiveBody const*>> bodies_by_name;
+    for (auto const body : ephemeris_->bodies()) {
+      bodies_by_name.emplace(body->name(), body);
+    }
+    std::map<Celestial const*, Index> indices;
+    IndexToOwnedCelestial celestials;
+    for (auto const& pair : celestials_) {
+      Index const celestial_index = pair.first;
+      Celestial const& celestial = *pair.second;
+      indices.emplace(&celestial, celestial_index);
+      celestials.emplace(
+          celestial_index,
+          make_not_null_unique<Celestial>(
+              FindOrDie(bodies_by_name, celestial.body()->name())));
+    }
+    for (auto const& pair : celestials_) {
+      Celestial const& celestial = *pair.second;
+      if (celestial.has_parent()) {
+        FindOrDie(celestials, pair.first)->set_parent(
+            FindOrDie(celestials,
+                      FindOrDie(indices, celestial.parent())).get());
+      }
+    }
+    sun_ = FindOrDie(celestials, FindOrDie(indices, sun_)).get();
+    celestials_ = std::move(celestials);
+    absolute_initialization_ = std::experimental::nullopt;
+  } else {
+    std::vector<not_null<std::unique_ptr<MassiveBody const>>> bodies;
+    std::vector<DegreesOfFreedom<Barycentric>> initial_state;
+    for (auto& pair : absolute_initialization_->bodies) {
+      auto& body = pair.second;
+      bodies.emplace_back(std::move(body));
+    }
+    for (auto const& pair : absolute_initialization_->initial_state) {
+      auto const& degrees_of_freedom = pair.second;
+      initial_state.emplace_back(degrees_of_freedom);
+    }
+    absolute_initialization_ = std::experimental::nullopt;
+    ephemeris_ = NewEphemeris(std::move(bodies),
+                              initial_state,
+                              current_time_,
+                              fitting_tolerance,
+                              DefaultEphemerisParameters());
+  }
+  ephemeris_->StartAsynchronousProlongation(ephemeris_prolongation_horizon);
   for (auto const& pair : celestials_) {
     auto& celestial = *pair.second;
     celestial.set_trajectory(ephemeris_->trajectory(celestial.body()));
@@ -1008,6 +1411,63 @@ void Plugin::InitializeEphemerisAndSetCelestialTrajectories() {
           BodyCentredNonRotatingDynamicFrame<Barycentric, Navigation>>(
           ephemeris_.get(),
           sun_->body()));
+  return is_precomputed;
+}
+
+std::unique_ptr<Ephemeris<Barycentric>> Plugin::ReadPrecomputedEphemeris(
+    IndexToMassiveBody const& bodies,
+    IndexToDegreesOfFreedom const& initial_state) const {
+  std::experimental::filesystem::path const& path =
+      *precomputed_ephemeris_path_;
+  if (!std::experimental::filesystem::exists(path)) {
+    LOG(WARNING) << "No precomputed ephemeris at " << path;
+    return nullptr;
+  }
+  std::unique_ptr<Ephemeris<Barycentric>> ephemeris =
+      Ephemeris<Barycentric>::ReadFromPrecomputedFile(path);
+  if (ephemeris == nullptr) {
+    LOG(WARNING) << "Cannot use the precomputed ephemeris at " << path;
+    return nullptr;
+  }
+  if (ephemeris->t_min() != current_time_ ||
+      ephemeris->bodies().size() != bodies.size()) {
+    LOG(WARNING) << "The precomputed ephemeris at " << path << " starts at "
+                 << ephemeris->t_min() << " with " << ephemeris->bodies().size()
+                 << " bodies, expected " << current_time_ << " with "
+                 << bodies.size() << " bodies";
+    return nullptr;
+  }
+  std::map<std::string, not_null<MassiveBody const*>> precomputed_bodies;
+  for (auto const body : ephemeris->bodies()) {
+    precomputed_bodies.emplace(body->name(), body);
+  }
+  for (auto const& pair : bodies) {
+    MassiveBody const& body = *pair.second;
+    auto const it = precomputed_bodies.find(body.name());
+    if (it == precomputed_bodies.end() ||
+        it->second->gravitational_parameter() !=
+            body.gravitational_parameter() ||
+        it->second->is_oblate() != body.is_oblate()) {
+      LOG(WARNING) << "The precomputed ephemeris at " << path
+                   << " has no body matching " << body.name();
+      return nullptr;
+    }
+    // The series of the continuous trajectories go through the initial
+    // positions, so they match up to rounding.
+    Length const distance =
+        (ephemeris->trajectory(it->second)->EvaluatePosition(
+             current_time_, /*hint=*/nullptr) -
+         FindOrDie(initial_state, pair.first).position()).Norm();
+    if (distance > fitting_tolerance) {
+      LOG(WARNING) << "The precomputed ephemeris at " << path << " places "
+                   << body.name() << " " << distance
+                   << " away from its initial state";
+      return nullptr;
+    }
+  }
+  LOG(INFO) << "Using the precomputed ephemeris at " << path << " until "
+            << ephemeris->t_max();
+  return ephemeris;
 }
 
 not_null<std::unique_ptr<Vessel>> const& Plugin::find_vessel_by_guid_or_die(
@@ -1058,6 +1518,11 @@ void Plugin::FreeVessels() {
       ++it;
     } else {
       LOG(INFO) << "Removing vessel with GUID " << it->first;
+      // A vessel with the same GUID that is added later must be serialized in
+      // full.
+      if (serialization_checkpoint_) {
+        serialization_checkpoint_->history_forget_after.erase(it->first);
+      }
       it = vessels_.erase(it);
     }
   }
@@ -1,15 +1,23 @@
 ﻿
 #pragma once
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <experimental/filesystem>
+#include <functional>
 #include <limits>
 #include <map>
 #include <memory>
 #include <set>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
 #include "base/monostable.hpp"
+#include "base/status.hpp"
+#include "base/thread_pool.hpp"
 #include "geometry/named_quantities.hpp"
 #include "geometry/point.hpp"
 #include "gtest/gtest.h"
@@ -108,6 +116,14 @@ class Plugin {
           physics::KeplerianElements<Barycentric>> const& keplerian_elements,
       not_null<std::unique_ptr<MassiveBody>> body);
 
+  // Makes |EndInitialization| read the ephemeris from the file at |path|,
+  // written by |Ephemeris::WriteToPrecomputedFile|, instead of integrating it.
+  // The file is ignored if it doesn't exist or if it was not integrated from
+  // the celestials inserted in this plugin, starting at its current time.
+  // Initialization must be ongoing.
+  virtual void UsePrecomputedEphemeris(
+      std::experimental::filesystem::path const& path);
+
   // Ends initialization.  The sun must have been inserted.
   virtual void EndInitialization();
 
@@ -202,6 +218,17 @@ class Plugin {
   // Updates the prediction for the vessel with guid |vessel_guid|.
   void UpdatePrediction(GUID const& vessel_guid) const;
 
+  // Updates the predictions for the vessels with guids |vessel_guids|
+  // concurrently on the |vessel_thread_pool_|.  Returns
+  // |Error::DEADLINE_EXCEEDED| if they were not all computed within |Δt|, in
+  // which case the unfinished predictions stop at the last point that was
+  // computed.  In all cases, returns only once no computation is running.  The
+  // ephemeris is prolonged beforehand on the calling thread.  If the prediction
+  // length is infinite, the predictions stop at the end of the ephemeris.
+  virtual base::Status UpdatePredictions(
+      std::vector<GUID> const& vessel_guids,
+      std::chrono::steady_clock::duration const Δt) const;
+
   virtual void CreateFlightPlan(GUID const& vessel_guid,
                                 Instant const& final_time,
                                 Mass const& initial_mass) const;
@@ -323,11 +350,52 @@ class Plugin {
 
   virtual Instant CurrentTime() const;
 
-  // Must be called after initialization.
+  // Must be called after initialization.  The vessels and the ephemeris are
+  // serialized in parallel on the |vessel_thread_pool_|.
   virtual void WriteToMessage(
       not_null<serialization::Plugin*> const message) const;
+  // Same as above, except that the serialization is built in parts on the
+  // |vessel_thread_pool_|, and that the returned function yields these parts
+  // in a fixed order, waiting for each of them to be built, and returns null
+  // after the last one.  The merge of the parts (e.g., the parse of the concatenation of
+  // their serializations) is the message written by |WriteToMessage|, so a
+  // |PullSerializer| may stream the first parts while the others are still
+  // being built.  The returned function must be called until it returns null
+  // before this plugin is used in any other way.
+  virtual std::function<std::unique_ptr<serialization::Plugin const>()>
+  WriteToMessageParts() const;
+  // The interface exposes the delta serialization below through
+  // |principia__SerializePluginDelta| and |principia__DeserializePluginDelta|.
+
+  // Serializes the changes to this plugin since the serialization recorded by
+  // the last call to |SetSerializationCheckpoint|: the series of the ephemeris
+  // and the points of the histories that were computed since then, and the
+  // rest of the state in full.  Thus the size of |message| is proportional to
+  // the time elapsed since that serialization, not to the length of the
+  // histories.  Must be called after initialization, once a checkpoint has
+  // been recorded.
+  virtual void WriteDeltaToMessage(
+      not_null<serialization::PluginDelta*> const message) const;
+  // Records |message| as the base of the deltas written by
+  // |WriteDeltaToMessage|.  |message| must have just been written by
+  // |WriteToMessage| (or by |WriteToMessageParts|, merged), before any other
+  // call that changes this plugin.  |ReadFromMessage| records the message that
+  // it reads.
+  void SetSerializationCheckpoint(serialization::Plugin const& message);
+  // Same as above, for a |delta| just written by |WriteDeltaToMessage|: the
+  // base becomes the result of applying |delta| to the previous base.
+  void SetSerializationCheckpoint(serialization::PluginDelta const& delta);
   static not_null<std::unique_ptr<Plugin>> ReadFromMessage(
       serialization::Plugin const& message);
+  // Applies |delta| to |message|, which must be the serialization that |delta|
+  // is relative to, as written by |WriteToMessage| or obtained by a previous
+  // call to this function; this is checked using their identifiers.  On return
+  // |message| is equivalent to the message that |WriteToMessage| would have
+  // written instead of |delta|.  A base serialization and its deltas are
+  // compacted into a single serialization by applying the deltas in order.
+  static void ApplyDeltaToMessage(
+      serialization::PluginDelta const& delta,
+      not_null<serialization::Plugin*> const message);
 
  protected:
   // May be overriden in tests to inject a mock.
@@ -368,9 +436,49 @@ class Plugin {
          Index const sun_index,
          bool const is_pre_cardano);
 
+  // Serializes this plugin to |message|.  If |delta| is not null, |message|
+  // must be |delta->mutable_plugin()|, only the parts of the trajectories that
+  // are not in the serialization designated by |serialization_checkpoint_| are
+  // serialized, and the rest of |delta| is filled.
+  void WriteToMessage(not_null<serialization::Plugin*> const message,
+                      serialization::PluginDelta* const delta) const;
+
+  std::map<not_null<Celestial const*>, Index const> CelestialToIndex() const;
+
+  // Writes to |message| the parts of the serialization of this plugin other
+  // than the vessels and the ephemeris, including a new |serialization_id|.
+  void WriteCelestialsAndParametersToMessage(
+      not_null<serialization::Plugin*> const message) const;
+
+  // Writes |vessel| to |message|.  If |history_forget_after| is not null, only
+  // the points of the history after |*history_forget_after| are written.
+  static void WriteVesselToMessage(
+      GUID const& guid,
+      not_null<Vessel const*> const vessel,
+      Index const parent_index,
+      Instant const* const history_forget_after,
+      not_null<serialization::Plugin::VesselAndProperties*> const message);
+
+  // Sets |serialization_checkpoint_| to designate the serialization of this
+  // plugin identified by |serialization_id| whose ephemeris is
+  // |ephemeris_message|.  The trajectories of |ephemeris_message| that have no
+  // series are taken to have been serialized up to |ephemeris_forget_after|.
+  void SetSerializationCheckpoint(
+      std::uint64_t const serialization_id,
+      serialization::Ephemeris const& ephemeris_message,
+      Instant const& ephemeris_forget_after);
+
   // We virtualize this function for testing purposes.
-  // Requires |absolute_initialization_| and consumes it.
-  virtual void InitializeEphemerisAndSetCelestialTrajectories();
+  // Requires |absolute_initialization_| and consumes it.  Returns true if the
+  // ephemeris was read from |*precomputed_ephemeris_path_|.
+  virtual bool InitializeEphemerisAndSetCelestialTrajectories();
+
+  // Reads the ephemeris at |*precomputed_ephemeris_path_| if it exists, is
+  // valid, and was integrated from the given |bodies| and |initial_state| at
+  // |current_time_|.  Returns null otherwise.
+  std::unique_ptr<Ephemeris<Barycentric>> ReadPrecomputedEphemeris(
+      IndexToMassiveBody const& bodies,
+      IndexToDegreesOfFreedom const& initial_state) const;
 
   not_null<std::unique_ptr<Vessel>> const& find_vessel_by_guid_or_die(
       GUID const& vessel_guid) const;
@@ -435,6 +543,10 @@ class Plugin {
   std::experimental::optional<HierarchicalInitializationObjects>
       hierarchical_initialization_;
 
+  // Set by |UsePrecomputedEphemeris|, only used during initialization.
+  std::experimental::optional<std::experimental::filesystem::path>
+      precomputed_ephemeris_path_;
+
   // Null if and only if |initializing_|.
   std::unique_ptr<Ephemeris<Barycentric>> ephemeris_;
 
@@ -468,6 +580,26 @@ class Plugin {
   // Compatibility.
   bool is_pre_cardano_ = false;
 
+  // Used for the computations that are done for each vessel, so that threads
+  // are not created on every frame.  Declared after the vessels so that it is
+  // destroyed before them.
+  std::unique_ptr<base::ThreadPool<void>> const vessel_thread_pool_ =
+      std::make_unique<base::ThreadPool<void>>(std::max<std::int64_t>(
+          1, std::thread::hardware_concurrency()));
+
+  // What the serialization recorded by |SetSerializationCheckpoint| contains,
+  // for use by |WriteDeltaToMessage|.
+  struct SerializationCheckpoint {
+    std::uint64_t serialization_id;
+    // The series of the ephemeris that end at or before this time.
+    Instant ephemeris_forget_after;
+    // For each vessel, the points of its history up to the given time.  These
+    // points cannot change anymore.
+    std::map<GUID, Instant> history_forget_after;
+  };
+  std::experimental::optional<SerializationCheckpoint>
+      serialization_checkpoint_;
+
   friend class NavballFrameField;
   friend class TestablePlugin;
 };
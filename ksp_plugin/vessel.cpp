@@ -4,8 +4,11 @@
 #include <algorithm>
 #include <limits>
 #include <list>
+#include <map>
+#include <tuple>
 #include <vector>
 
+#include "astronomy/epoch.hpp"
 #include "integrators/embedded_explicit_runge_kutta_nyström_integrator.hpp"
 #include "ksp_plugin/pile_up.hpp"
 #include "quantities/si.hpp"
@@ -18,13 +21,27 @@ namespace internal_vessel {
 using base::make_not_null_unique;
 using geometry::Position;
 using integrators::DormandElMikkawyPrince1986RKN434FM;
+using integrators::FixedStepSizeIntegrator;
 using integrators::McLachlanAtela1992Order5Optimal;
 using quantities::IsFinite;
+using quantities::Length;
+using quantities::Speed;
 using quantities::si::Kilogram;
 using quantities::si::Metre;
 using quantities::si::Milli;
 using quantities::si::Second;
 
+// The histories are downsampled every |max_dense_intervals| points, retaining
+// only the points needed to reconstruct them within these tolerances.
+constexpr std::int64_t max_dense_intervals = 10'000;
+constexpr Length downsampling_length_tolerance = 10 * Metre;
+constexpr Speed downsampling_speed_tolerance = 100 * Milli(Metre) / Second;
+// The prediction is rendered as a polyline: rather than integrating it with a
+// tolerance tight enough for its steps to be short, points are added inside
+// the steps from the dense output of the integrator, so that the chords don't
+// deviate from it by more than this.
+constexpr Length prediction_max_chord_deviation = 100 * Metre;
+
 Vessel::~Vessel() {
   CHECK(!is_piled_up());
 }
@@ -113,6 +130,9 @@ void Vessel::CreateHistoryAndForkProlongation(
   CHECK(!is_initialized());
   history_ = std::make_unique<DiscreteTrajectory<Barycentric>>();
   history_->Append(time, degrees_of_freedom);
+  history_->SetDownsampling(max_dense_intervals,
+                            downsampling_length_tolerance,
+                            downsampling_speed_tolerance);
   prolongation_ = history_->NewForkAtLast();
   prediction_ = history_->NewForkAtLast();
 }
@@ -123,6 +143,52 @@ void Vessel::AdvanceTimeNotInBubble(Instant const& time) {
   FlowProlongation(time);
 }
 
+void Vessel::AdvanceTimeNotInBubble(
+    std::vector<not_null<Vessel*>> const& vessels,
+    Instant const& time) {
+  // The histories which may be flowed together.  |FlowWithFixedStep| requires
+  // that they all end at the same time.
+  using Grid = std::tuple<Ephemeris<Barycentric>*,
+                          FixedStepSizeIntegrator<
+                              Ephemeris<Barycentric>::NewtonianMotionEquation>
+                              const*,
+                          Time,
+                          Instant>;
+  std::map<Grid, std::vector<not_null<Vessel*>>> vessels_by_grid;
+  for (not_null<Vessel*> const vessel : vessels) {
+    CHECK(vessel->is_initialized());
+    if (vessel->PrepareHistoryAdvance(time)) {
+      auto const& parameters = vessel->history_fixed_step_parameters_;
+      vessels_by_grid[Grid(vessel->ephemeris_,
+                           &parameters.integrator(),
+                           parameters.step(),
+                           vessel->history_->last().time())].push_back(vessel);
+    }
+  }
+
+  for (auto const& pair : vessels_by_grid) {
+    std::vector<not_null<Vessel*>> const& grid_vessels = pair.second;
+    std::vector<not_null<DiscreteTrajectory<Barycentric>*>> histories;
+    histories.reserve(grid_vessels.size());
+    for (not_null<Vessel*> const vessel : grid_vessels) {
+      histories.push_back(vessel->history_.get());
+    }
+    Vessel const& first_vessel = *grid_vessels.front();
+    first_vessel.ephemeris_->FlowWithFixedStep(
+        histories,
+        Ephemeris<Barycentric>::NoIntrinsicAccelerations,
+        time,
+        first_vessel.history_fixed_step_parameters_);
+    for (not_null<Vessel*> const vessel : grid_vessels) {
+      vessel->FinishHistoryAdvance();
+    }
+  }
+
+  for (not_null<Vessel*> const vessel : vessels) {
+    vessel->FlowProlongation(time);
+  }
+}
+
 void Vessel::AdvanceTimeInBubble(
     Instant const& time,
     DegreesOfFreedom<Barycentric> const& degrees_of_freedom) {
@@ -177,13 +243,21 @@ void Vessel::UpdatePrediction(Instant const& last_time) {
 
 void Vessel::WriteToMessage(
     not_null<serialization::Vessel*> const message) const {
+  WriteToMessage(message, astronomy::InfinitePast);
+}
+
+void Vessel::WriteToMessage(
+    not_null<serialization::Vessel*> const message,
+    Instant const& history_after) const {
   CHECK(is_initialized());
   body_.WriteToMessage(message->mutable_body());
   prolongation_adaptive_step_parameters_.WriteToMessage(
       message->mutable_prolongation_adaptive_step_parameters());
   history_fixed_step_parameters_.WriteToMessage(
       message->mutable_history_fixed_step_parameters());
-  history_->WriteToMessage(message->mutable_history(), {prolongation_});
+  history_->WriteToMessage(message->mutable_history(),
+                           {prolongation_},
+                           history_after);
   prediction_->Fork().time().WriteToMessage(
       message->mutable_prediction_fork_time());
   prediction_->last().time().WriteToMessage(
@@ -270,6 +344,13 @@ not_null<std::unique_ptr<Vessel>> Vessel::ReadFromMessage(
     }
     vessel->is_dirty_ = message.is_dirty();
   }
+  // The downsampling state is serialized with the history, except in saves
+  // that predate downsampling, whose points are left as they are.
+  if (!(message.has_history() && message.history().has_downsampling())) {
+    vessel->history_->SetDownsampling(max_dense_intervals,
+                                      downsampling_length_tolerance,
+                                      downsampling_speed_tolerance);
+  }
   return std::move(vessel);
 }
 
@@ -308,6 +389,13 @@ Vessel::Vessel()
       subset_node_(make_not_null_unique<Subset<Vessel>::Node>()) {}
 
 void Vessel::AdvanceHistoryIfNeeded(Instant const& time) {
+  if (PrepareHistoryAdvance(time)) {
+    FlowHistory(time);
+    FinishHistoryAdvance();
+  }
+}
+
+bool Vessel::PrepareHistoryAdvance(Instant const& time) {
   Instant const& history_last_time = history_->last().time();
   Time const& Δt = history_fixed_step_parameters_.step();
 
@@ -318,10 +406,14 @@ void Vessel::AdvanceHistoryIfNeeded(Instant const& time) {
                        prolongation_->last().degrees_of_freedom());
       is_dirty_ = false;
     }
-    FlowHistory(time);
-    history_->DeleteFork(prolongation_);
-    prolongation_ = history_->NewForkAtLast();
+    return true;
   }
+  return false;
+}
+
+void Vessel::FinishHistoryAdvance() {
+  history_->DeleteFork(prolongation_);
+  prolongation_ = history_->NewForkAtLast();
 }
 
 void Vessel::FlowHistory(Instant const& time) {
@@ -350,13 +442,15 @@ void Vessel::FlowPrediction(Instant const& time) {
   if (time > prediction_->last().time()) {
     bool const finite_time = IsFinite(time - prediction_->last().time());
     Instant const t = finite_time ? time : ephemeris_->t_max();
+    auto parameters = prediction_adaptive_step_parameters_;
+    parameters.set_max_chord_deviation(prediction_max_chord_deviation);
     // This will not prolong the ephemeris if |time| is infinite (but it may do
     // so if it is finite).
     bool const reached_t = ephemeris_->FlowWithAdaptiveStep(
         prediction_,
         Ephemeris<Barycentric>::NoIntrinsicAcceleration,
         t,
-        prediction_adaptive_step_parameters_,
+        parameters,
         FlightPlan::max_ephemeris_steps_per_frame);
     if (!finite_time && reached_t) {
       // This will prolong the ephemeris by |max_ephemeris_steps_per_frame|.
@@ -364,7 +458,7 @@ void Vessel::FlowPrediction(Instant const& time) {
         prediction_,
         Ephemeris<Barycentric>::NoIntrinsicAcceleration,
         time,
-        prediction_adaptive_step_parameters_,
+        parameters,
         FlightPlan::max_ephemeris_steps_per_frame);
     }
   }
@@ -105,6 +105,16 @@ class Vessel {
   // vessel.
   virtual void AdvanceTimeNotInBubble(Instant const& time);
 
+  // Same as above for all the |vessels|, none of which may be in the physics
+  // bubble.  The histories that end at the same time and use the same
+  // parameters are flowed together by a single call to
+  // |Ephemeris::FlowWithFixedStep|, so that the positions of the celestials are
+  // only evaluated once per step for all of them.  The results are the same as
+  // if each vessel had been advanced separately.
+  static void AdvanceTimeNotInBubble(
+      std::vector<not_null<Vessel*>> const& vessels,
+      Instant const& time);
+
   // Advances time for a vessel in the physics bubble.  This dirties the vessel.
   virtual void AdvanceTimeInBubble(
       Instant const& time,
@@ -130,6 +140,11 @@ class Vessel {
   // The vessel must satisfy |is_initialized()|.
   virtual void WriteToMessage(
       not_null<serialization::Vessel*> const message) const;
+  // Same as above, except that only the points of the history (strictly) after
+  // |history_after| are serialized.
+  virtual void WriteToMessage(
+      not_null<serialization::Vessel*> const message,
+      Instant const& history_after) const;
   static not_null<std::unique_ptr<Vessel>> ReadFromMessage(
       serialization::Vessel const& message,
       not_null<Ephemeris<Barycentric>*> const ephemeris,
@@ -152,6 +167,12 @@ class Vessel {
 
  private:
   void AdvanceHistoryIfNeeded(Instant const& time);
+  // The parts of |AdvanceHistoryIfNeeded| that come before and after the
+  // history is flowed.  |PrepareHistoryAdvance| returns false if the history
+  // doesn't need to be advanced, in which case neither |FlowHistory| nor
+  // |FinishHistoryAdvance| must be called.
+  bool PrepareHistoryAdvance(Instant const& time);
+  void FinishHistoryAdvance();
   void FlowHistory(Instant const& time);
   void FlowProlongation(Instant const& time);
   void FlowPrediction(Instant const& time);
@@ -16,12 +16,23 @@ public partial class PrincipiaPluginAdapter
     : ScenarioModule,
       WindowRenderer.ManagerInterface {
 
+  // Saves written before base 64 was introduced use hexadecimal.
   private const String principia_key = "serialized_plugin";
+  private const String principia_base64_key = "serialized_plugin_base64";
+  // Each of these nodes holds a delta relative to the serialization that
+  // precedes it, under |principia_base64_key|.
+  private const String principia_delta_node_name = "serialized_plugin_delta";
+  // The number of deltas written after a full serialization before the next
+  // full serialization, which compacts them.
+  private const int deltas_per_full_serialization = 16;
   private const String principia_initial_state_config_name =
       "principia_initial_state";
   private const String principia_gravity_model_config_name =
       "principia_gravity_model";
   private const double Δt = 10;
+  // The wall-clock time allotted to the computation of the predictions on each
+  // frame.
+  private const double prediction_time_limit_in_seconds = 0.1;
 
   private KSP.UI.Screens.ApplicationLauncherButton toolbar_button_;
   private bool hide_all_gui_ = false;
@@ -41,6 +52,14 @@ public partial class PrincipiaPluginAdapter
 
   private IntPtr plugin_ = IntPtr.Zero;
 
+  // The chunks of the last full serialization written by |OnSave|, and those
+  // of the deltas written since.  They are all written by each |OnSave|, so
+  // that a save only needs to serialize the changes since the previous one.
+  // Empty if no full serialization was written since the plugin was created or
+  // loaded.
+  private List<String> full_serialization_ = new List<String>();
+  private List<List<String>> delta_serializations_ = new List<List<String>>();
+
   private bool display_patched_conics_ = false;
   [KSPField(isPersistant = true)]
   private bool fix_navball_in_plotting_frame_ = true;
@@ -48,7 +67,7 @@ public partial class PrincipiaPluginAdapter
   private readonly double[] prediction_length_tolerances_ =
       {1e-3, 1e-2, 1e0, 1e1, 1e2, 1e3, 1e4};
   [KSPField(isPersistant = true)]
-  private int prediction_length_tolerance_index_ = 1;
+  private int prediction_length_tolerance_index_ = 2;
   private readonly double[] prediction_steps_ =
       {1 << 2, 1 << 4, 1 << 6, 1 << 8, 1 << 10, 1 << 12, 1 << 14, 1 << 16,
        1 << 18, 1 << 20, 1 << 22, 1 << 24};
@@ -415,14 +434,33 @@ where is_in_physics_bubble(vessel)
   public override void OnSave(ConfigNode node) {
     base.OnSave(node);
     if (PluginRunning()) {
-      String serialization;
+      bool compact =
+          full_serialization_.Count == 0 ||
+          delta_serializations_.Count >= deltas_per_full_serialization;
+      var chunks = new List<String>();
       IntPtr serializer = IntPtr.Zero;
       for (;;) {
-        serialization = plugin_.SerializePlugin(ref serializer);
+        String serialization =
+            plugin_.SerializePluginDelta(compact, ref serializer);
         if (serialization == null) {
           break;
         }
-        node.AddValue(principia_key, serialization);
+        chunks.Add(serialization);
+      }
+      if (compact) {
+        full_serialization_ = chunks;
+        delta_serializations_.Clear();
+      } else {
+        delta_serializations_.Add(chunks);
+      }
+      foreach (String serialization in full_serialization_) {
+        node.AddValue(principia_base64_key, serialization);
+      }
+      foreach (List<String> delta in delta_serializations_) {
+        ConfigNode delta_node = node.AddNode(principia_delta_node_name);
+        foreach (String serialization in delta) {
+          delta_node.AddValue(principia_base64_key, serialization);
+        }
       }
     }
   }
@@ -432,7 +470,7 @@ where is_in_physics_bubble(vessel)
     if (must_record_journal_) {
       Log.ActivateRecorder(true);
     }
-    if (node.HasValue(principia_key)) {
+    if (node.HasValue(principia_base64_key) || node.HasValue(principia_key)) {
       Cleanup();
       SetRotatingFrameThresholds();
       RemoveBuggyTidalLocking();
@@ -442,17 +480,68 @@ where is_in_physics_bubble(vessel)
       Log.SetVerboseLogging(verbose_logging_);
 
       IntPtr deserializer = IntPtr.Zero;
-      String[] serializations = node.GetValues(principia_key);
-      Log.Info("Serialization has " + serializations.Length + " chunks");
-      foreach (String serialization in serializations) {
-        Log.Info("serialization is " + serialization.Length +
-                 " characters long");
-        Interface.DeserializePlugin(serialization,
-                                    serialization.Length,
-                                    ref deserializer,
-                                    ref plugin_);
+      bool is_base64 = node.HasValue(principia_base64_key);
+      String[] serializations =
+          node.GetValues(is_base64 ? principia_base64_key : principia_key);
+      ConfigNode[] delta_nodes = node.GetNodes(principia_delta_node_name);
+      Log.Info("Serialization has " + serializations.Length + " chunks" +
+               (is_base64 ? " in base 64" : " in hexadecimal") + " and " +
+               delta_nodes.Length + " deltas");
+      if (delta_nodes.Length > 0) {
+        // Fold the deltas into the full serialization.
+        IntPtr plugin_message = IntPtr.Zero;
+        foreach (String serialization in serializations) {
+          Interface.DeserializePluginDelta(serialization,
+                                           serialization.Length,
+                                           compact : true,
+                                           deserializer : ref deserializer,
+                                           plugin_message : ref plugin_message);
+        }
+        Interface.DeserializePluginDelta("",
+                                         0,
+                                         compact : true,
+                                         deserializer : ref deserializer,
+                                         plugin_message : ref plugin_message);
+        foreach (ConfigNode delta_node in delta_nodes) {
+          String[] delta = delta_node.GetValues(principia_base64_key);
+          foreach (String serialization in delta) {
+            Interface.DeserializePluginDelta(
+                serialization,
+                serialization.Length,
+                compact : false,
+                deserializer : ref deserializer,
+                plugin_message : ref plugin_message);
+          }
+          Interface.DeserializePluginDelta("",
+                                           0,
+                                           compact : false,
+                                           deserializer : ref deserializer,
+                                           plugin_message : ref plugin_message);
+        }
+        plugin_ = Interface.ReadPluginFromMessage(ref plugin_message);
+      } else {
+        foreach (String serialization in serializations) {
+          Log.Info("serialization is " + serialization.Length +
+                   " characters long");
+          if (is_base64) {
+            Interface.DeserializePluginBase64(serialization,
+                                              serialization.Length,
+                                              ref deserializer,
+                                              ref plugin_);
+          } else {
+            Interface.DeserializePlugin(serialization,
+                                        serialization.Length,
+                                        ref deserializer,
+                                        ref plugin_);
+          }
+        }
+        if (is_base64) {
+          Interface.DeserializePluginBase64("", 0, ref deserializer,
+                                            ref plugin_);
+        } else {
+          Interface.DeserializePlugin("", 0, ref deserializer, ref plugin_);
+        }
       }
-      Interface.DeserializePlugin("", 0, ref deserializer, ref plugin_);
 
       plotting_frame_selector_.reset(
           new ReferenceFrameSelector(this, 
@@ -747,7 +836,13 @@ where is_in_physics_bubble(vessel)
       }
       plugin_.AdvanceTime(universal_time, Planetarium.InverseRotAngle);
       if (ready_to_draw_active_vessel_trajectory) {
-        plugin_.UpdatePrediction(active_vessel.id.ToString());
+        VesselGuid[] vessel_guids =
+            {new VesselGuid{guid = active_vessel.id.ToString()}};
+        // If the time limit is exceeded, the prediction is merely shorter.
+        plugin_.UpdatePredictions(
+            vessel_guids          : vessel_guids,
+            count                 : vessel_guids.Length,
+            time_limit_in_seconds : prediction_time_limit_in_seconds);
       }
       plugin_.ForgetAllHistoriesBefore(
           universal_time - history_lengths_[history_length_index_]);
@@ -1002,6 +1097,9 @@ where is_in_physics_bubble(vessel)
     map_node_pool_.Clear();
     map_renderer_ = null;
     Interface.DeletePlugin(ref plugin_);
+    // The next save of the new plugin is a full serialization.
+    full_serialization_.Clear();
+    delta_serializations_.Clear();
     plotting_frame_selector_.reset();
     flight_planner_.reset();
     navball_changed_ = true;
@@ -1428,6 +1526,14 @@ where is_in_physics_bubble(vessel)
         };
         insert_body(Planetarium.fetch.Sun);
         ApplyToBodyTree(insert_body);
+        // The precomputed ephemeris, if any, is given relative to GameData.
+        // The plugin ignores it if it doesn't match the initial state.
+        if (initial_states.HasValue("precomputed_ephemeris")) {
+          plugin_.UsePrecomputedEphemeris(
+              KSPUtil.ApplicationRootPath + Path.DirectorySeparatorChar +
+              "GameData" + Path.DirectorySeparatorChar +
+              initial_states.GetValue("precomputed_ephemeris"));
+        }
         plugin_.EndInitialization();
         plugin_.AdvanceTime(Planetarium.GetUniversalTime(),
                             Planetarium.InverseRotAngle);
@@ -1,15 +1,25 @@
 ﻿
 #include "ksp_plugin/interface.hpp"
 
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <experimental/filesystem>
 #include <limits>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "astronomy/epoch.hpp"
+#include "base/base64.hpp"
+#include "base/hexadecimal.hpp"
 #include "base/not_null.hpp"
 #include "base/pull_serializer.hpp"
 #include "base/push_deserializer.hpp"
 #include "geometry/named_quantities.hpp"
 #include "gmock/gmock.h"
+#include "google/protobuf/io/gzip_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include "gtest/gtest.h"
 #include "journal/recorder.hpp"
 #include "ksp_plugin/frames.hpp"
@@ -26,7 +36,11 @@ namespace principia {
 namespace interface {
 
 using astronomy::ModifiedJulianDate;
+using base::Base64Encode;
+using base::Base64EncodedSize;
 using base::check_not_null;
+using base::HexadecimalDecode;
+using base::HexadecimalEncode;
 using base::make_not_null_unique;
 using base::PullSerializer;
 using base::PushDeserializer;
@@ -37,6 +51,10 @@ using geometry::OrthogonalMap;
 using geometry::Rotation;
 using geometry::Vector;
 using geometry::Velocity;
+using google::protobuf::io::ArrayInputStream;
+using google::protobuf::io::GzipInputStream;
+using google::protobuf::io::GzipOutputStream;
+using google::protobuf::io::StringOutputStream;
 using ksp_plugin::AliceSun;
 using ksp_plugin::Barycentric;
 using ksp_plugin::Index;
@@ -352,6 +370,14 @@ TEST_F(InterfaceTest, UpdateCelestialHierarchy) {
                                       parent_index);
 }
 
+TEST_F(InterfaceTest, UsePrecomputedEphemeris) {
+  char const path[] = "solar_system.ephemeris";
+  EXPECT_CALL(
+      *plugin_,
+      UsePrecomputedEphemeris(std::experimental::filesystem::path(path)));
+  principia__UsePrecomputedEphemeris(plugin_.get(), path);
+}
+
 TEST_F(InterfaceTest, EndInitialization) {
   EXPECT_CALL(*plugin_,
               EndInitialization());
@@ -387,6 +413,24 @@ TEST_F(InterfaceTest, SetVesselStateOffset) {
                                   parent_relative_degrees_of_freedom);
 }
 
+TEST_F(InterfaceTest, UpdatePredictions) {
+  VesselGuid const vessel_guids[] = {{vessel_guid}, {"NCC-1701-E"}};
+  EXPECT_CALL(*plugin_,
+              UpdatePredictions(ElementsAre(vessel_guid, "NCC-1701-E"),
+                                std::chrono::steady_clock::duration(
+                                    std::chrono::milliseconds(5))))
+      .WillOnce(Return(base::Status::OK))
+      .WillOnce(Return(base::Status(base::Error::DEADLINE_EXCEEDED, "")));
+  EXPECT_TRUE(principia__UpdatePredictions(plugin_.get(),
+                                           vessel_guids,
+                                           /*count=*/2,
+                                           /*time_limit_in_seconds=*/5e-3));
+  EXPECT_FALSE(principia__UpdatePredictions(plugin_.get(),
+                                            vessel_guids,
+                                            /*count=*/2,
+                                            /*time_limit_in_seconds=*/5e-3));
+}
+
 TEST_F(InterfaceTest, AdvanceTime) {
   EXPECT_CALL(*plugin_,
               AdvanceTime(t0_ + time * SIUnit<Time>(),
@@ -795,11 +839,45 @@ TEST_F(InterfaceTest, SerializePlugin) {
   principia::serialization::Plugin message;
   message.ParseFromString(message_bytes);
 
-  EXPECT_CALL(*plugin_, WriteToMessage(_)).WillOnce(SetArgPointee<0>(message));
+  // The message is given in two parts, the vessels and the rest.
+  auto vessels = std::make_unique<principia::serialization::Plugin>();
+  auto rest = std::make_unique<principia::serialization::Plugin>(message);
+  vessels->mutable_vessel()->Swap(rest->mutable_vessel());
+  auto const parts = std::make_shared<
+      std::vector<std::unique_ptr<principia::serialization::Plugin const>>>();
+  parts->push_back(std::move(rest));
+  parts->push_back(std::move(vessels));
+  auto const next_part = std::make_shared<int>(0);
+  EXPECT_CALL(*plugin_, WriteToMessageParts())
+      .WillOnce(Return(
+          [parts, next_part]()
+              -> std::unique_ptr<principia::serialization::Plugin const> {
+            if (*next_part == parts->size()) {
+              return nullptr;
+            }
+            return std::move((*parts)[(*next_part)++]);
+          }));
   char const* serialization =
       principia__SerializePlugin(plugin_.get(), &serializer);
-  EXPECT_STREQ(hexadecimal_boring_plugin, serialization);
   EXPECT_EQ(nullptr, principia__SerializePlugin(plugin_.get(), &serializer));
+
+  // The serialization is compressed, so we cannot compare it with
+  // |hexadecimal_boring_plugin|, as the bytes depend on the version of zlib.
+  // Decompress it instead.
+  std::int64_t const hexadecimal_size = std::strlen(serialization);
+  std::string compressed(hexadecimal_size >> 1, '\0');
+  HexadecimalDecode(
+      {reinterpret_cast<std::uint8_t const*>(serialization), hexadecimal_size},
+      {reinterpret_cast<std::uint8_t*>(&compressed[0]),
+       static_cast<std::int64_t>(compressed.size())});
+  EXPECT_EQ('\x1F', compressed[0]);
+  ArrayInputStream compressed_stream(compressed.data(),
+                                     static_cast<int>(compressed.size()));
+  GzipInputStream decompressed_stream(&compressed_stream,
+                                      GzipInputStream::GZIP);
+  principia::serialization::Plugin actual_message;
+  EXPECT_TRUE(actual_message.ParseFromZeroCopyStream(&decompressed_stream));
+  EXPECT_EQ(message_bytes, actual_message.SerializeAsString());
   principia__DeleteString(&serialization);
   EXPECT_THAT(serialization, IsNull());
 }
@@ -836,6 +914,135 @@ TEST_F(InterfaceTest, DeserializePlugin) {
   principia__DeletePlugin(&plugin);
 }
 
+TEST_F(InterfaceTest, DeserializeCompressedPlugin) {
+  std::string compressed;
+  {
+    StringOutputStream string_stream(&compressed);
+    GzipOutputStream::Options options;
+    options.format = GzipOutputStream::GZIP;
+    GzipOutputStream gzip_stream(&string_stream, options);
+    principia::serialization::Plugin message;
+    message.ParseFromString(
+        std::string(serialized_boring_plugin,
+                    (sizeof(serialized_boring_plugin) - 1) / sizeof(char)));
+    EXPECT_TRUE(message.SerializeToZeroCopyStream(&gzip_stream));
+    EXPECT_TRUE(gzip_stream.Close());
+  }
+  std::string hexadecimal(compressed.size() << 1, '\0');
+  HexadecimalEncode(
+      {reinterpret_cast<std::uint8_t const*>(compressed.data()),
+       static_cast<std::int64_t>(compressed.size())},
+      {reinterpret_cast<std::uint8_t*>(&hexadecimal[0]),
+       static_cast<std::int64_t>(hexadecimal.size())});
+
+  PushDeserializer* deserializer = nullptr;
+  Plugin const* plugin = nullptr;
+  principia__DeserializePlugin(hexadecimal.c_str(),
+                               static_cast<int>(hexadecimal.size()),
+                               &deserializer,
+                               &plugin);
+  principia__DeserializePlugin(hexadecimal.c_str(),
+                               0,
+                               &deserializer,
+                               &plugin);
+  EXPECT_THAT(plugin, NotNull());
+  EXPECT_EQ(Instant(), plugin->CurrentTime());
+  principia__DeletePlugin(&plugin);
+}
+
+TEST_F(InterfaceTest, DeserializePluginBase64) {
+  std::string base64(Base64EncodedSize(sizeof(serialized_boring_plugin) - 1),
+                     '\0');
+  Base64Encode(
+      {reinterpret_cast<std::uint8_t const*>(serialized_boring_plugin),
+       static_cast<std::int64_t>(sizeof(serialized_boring_plugin) - 1)},
+      {reinterpret_cast<std::uint8_t*>(&base64[0]),
+       static_cast<std::int64_t>(base64.size())});
+
+  PushDeserializer* deserializer = nullptr;
+  Plugin const* plugin = nullptr;
+  principia__DeserializePluginBase64(base64.c_str(),
+                                     static_cast<int>(base64.size()),
+                                     &deserializer,
+                                     &plugin);
+  principia__DeserializePluginBase64(base64.c_str(),
+                                     0,
+                                     &deserializer,
+                                     &plugin);
+  EXPECT_THAT(plugin, NotNull());
+  EXPECT_EQ(Instant(), plugin->CurrentTime());
+  principia__DeletePlugin(&plugin);
+}
+
+TEST_F(InterfaceTest, SerializeAndDeserializePluginDelta) {
+  std::uint64_t const full_serialization_id = 1;
+  std::uint64_t const delta_serialization_id = 2;
+  // A full serialization, and a delta relative to it that changes the current
+  // time.
+  principia::serialization::Plugin full_message;
+  full_message.ParseFromString(
+      std::string(serialized_boring_plugin,
+                  (sizeof(serialized_boring_plugin) - 1) / sizeof(char)));
+  full_message.set_serialization_id(full_serialization_id);
+  principia::serialization::PluginDelta delta_message;
+  *delta_message.mutable_plugin() = full_message;
+  delta_message.mutable_plugin()->set_serialization_id(delta_serialization_id);
+  (Instant() + 1 * Second).WriteToMessage(
+      delta_message.mutable_plugin()->mutable_current_time());
+  Instant().WriteToMessage(delta_message.mutable_ephemeris_forget_after());
+  delta_message.set_base_serialization_id(full_serialization_id);
+  EXPECT_CALL(*plugin_, WriteToMessage(_))
+      .WillOnce(SetArgPointee<0>(full_message));
+  EXPECT_CALL(*plugin_, WriteDeltaToMessage(_))
+      .WillOnce(SetArgPointee<0>(delta_message));
+
+  auto const serialize = [this](bool const compact) {
+    std::vector<std::string> chunks;
+    PullSerializer* serializer = nullptr;
+    for (;;) {
+      char const* chunk =
+          principia__SerializePluginDelta(plugin_.get(), compact, &serializer);
+      if (chunk == nullptr) {
+        break;
+      }
+      chunks.emplace_back(chunk);
+      principia__DeleteString(&chunk);
+    }
+    EXPECT_THAT(serializer, IsNull());
+    return chunks;
+  };
+  // The delta is written against the checkpoint recorded by the full
+  // serialization.
+  std::vector<std::string> const full = serialize(/*compact=*/true);
+  std::vector<std::string> const delta = serialize(/*compact=*/false);
+
+  PluginMessage* message = nullptr;
+  auto const deserialize = [&message](std::vector<std::string> const& chunks,
+                                      bool const compact) {
+    PushDeserializer* deserializer = nullptr;
+    for (auto const& chunk : chunks) {
+      principia__DeserializePluginDelta(chunk.c_str(),
+                                        static_cast<int>(chunk.size()),
+                                        compact,
+                                        &deserializer,
+                                        &message);
+    }
+    principia__DeserializePluginDelta("", 0, compact, &deserializer, &message);
+    EXPECT_THAT(deserializer, IsNull());
+  };
+  deserialize(full, /*compact=*/true);
+  ASSERT_THAT(message, NotNull());
+  EXPECT_EQ(full_serialization_id, message->serialization_id());
+  deserialize(delta, /*compact=*/false);
+  EXPECT_EQ(delta_serialization_id, message->serialization_id());
+
+  Plugin const* plugin = principia__ReadPluginFromMessage(&message);
+  EXPECT_THAT(message, IsNull());
+  ASSERT_THAT(plugin, NotNull());
+  EXPECT_EQ(Instant() + 1 * Second, plugin->CurrentTime());
+  principia__DeletePlugin(&plugin);
+}
+
 TEST_F(InterfaceDeathTest, SettersAndGetters) {
   // We use EXPECT_EXITs in this test to avoid interfering with the execution of
   // the other tests.
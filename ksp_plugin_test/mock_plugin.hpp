@@ -1,6 +1,8 @@
 ﻿
 #pragma once
 
+#include <chrono>
+#include <experimental/filesystem>
 #include <string>
 #include <vector>
 
@@ -32,6 +34,9 @@ class MockPlugin : public Plugin {
            DegreesOfFreedom<Barycentric> const& initial_state,
            base::not_null<std::unique_ptr<MassiveBody const>> const& body));
 
+  MOCK_METHOD1(UsePrecomputedEphemeris,
+               void(std::experimental::filesystem::path const& path));
+
   MOCK_METHOD0(EndInitialization,
                void());
 
@@ -62,6 +67,10 @@ class MockPlugin : public Plugin {
                      RelativeDegreesOfFreedom<AliceSun>(
                          Index const celestial_index));
 
+  MOCK_CONST_METHOD2(UpdatePredictions,
+                     base::Status(std::vector<GUID> const& vessel_guids,
+                                  std::chrono::steady_clock::duration const Δt));
+
   MOCK_CONST_METHOD3(CreateFlightPlan,
                      void(GUID const& vessel_guid,
                           Instant const& final_time,
@@ -180,6 +189,11 @@ class MockPlugin : public Plugin {
 
   MOCK_CONST_METHOD1(WriteToMessage,
                      void(not_null<serialization::Plugin*> const message));
+  MOCK_CONST_METHOD0(
+      WriteToMessageParts,
+      std::function<std::unique_ptr<serialization::Plugin const>()>());
+  MOCK_CONST_METHOD1(WriteDeltaToMessage,
+                     void(not_null<serialization::PluginDelta*> const message));
 };
 
 }  // namespace internal_plugin
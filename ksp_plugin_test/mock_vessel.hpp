@@ -48,6 +48,9 @@ class MockVessel : public Vessel {
 
   MOCK_CONST_METHOD1(WriteToMessage, void(
       not_null<serialization::Vessel*> const message));
+  MOCK_CONST_METHOD2(WriteToMessage, void(
+      not_null<serialization::Vessel*> const message,
+      Instant const& history_after));
 };
 
 }  // namespace internal_vessel
@@ -44,6 +44,7 @@ using geometry::Permutation;
 using geometry::Trivector;
 using integrators::McLachlanAtela1992Order5Optimal;
 using physics::ContinuousTrajectory;
+using physics::DiscreteTrajectory;
 using physics::KeplerianElements;
 using physics::KeplerOrbit;
 using physics::MockDynamicFrame;
@@ -119,6 +120,13 @@ ACTION(AppendToDiscreteTrajectory) {
   arg0->Append(arg2, {Barycentric::origin, Velocity<Barycentric>()});
 }
 
+// The serialization of |message| without its |serialization_id|, which is
+// different for each call to |WriteToMessage|.
+std::string SerializeAsStringWithoutId(serialization::Plugin message) {
+  message.clear_serialization_id();
+  return message.SerializeAsString();
+}
+
 }  // namespace
 
 class TestablePlugin : public Plugin {
@@ -265,6 +273,49 @@ class PluginTest : public testing::Test {
     }
   }
 
+  // Returns an actual |Plugin|, not a |TestablePlugin|, whose initialization
+  // with the major bodies of the solar system has ended.  Tests of
+  // serialization need it since that's what |ReadFromMessage| returns.
+  not_null<std::unique_ptr<Plugin>> NewSolarSystemPlugin() {
+    auto plugin = make_not_null_unique<Plugin>(
+                      initial_time_,
+                      initial_time_,
+                      planetarium_rotation_);
+    plugin->InsertCelestialJacobiKeplerian(
+        SolarSystemFactory::Sun,
+        /*parent_index=*/std::experimental::nullopt,
+        /*keplerian_elements=*/std::experimental::nullopt,
+        std::move(sun_body_));
+    for (int index = SolarSystemFactory::Sun + 1;
+         index <= SolarSystemFactory::LastMajorBody;
+         ++index) {
+      std::string const name = SolarSystemFactory::name(index);
+      Index const parent_index = SolarSystemFactory::parent(index);
+      std::string const parent_name = SolarSystemFactory::name(parent_index);
+      RelativeDegreesOfFreedom<Barycentric> const state_vectors =
+          Identity<ICRFJ2000Equator, Barycentric>()(
+              solar_system_->initial_state(name) -
+              solar_system_->initial_state(parent_name));
+      Instant const t;
+      auto body = make_not_null_unique<RotatingBody<Barycentric>>(
+          solar_system_->gravitational_parameter(name),
+          body_rotation_);
+      KeplerianElements<Barycentric> elements = KeplerOrbit<Barycentric>(
+          /*primary=*/MassiveBody(
+              solar_system_->gravitational_parameter(parent_name)),
+          /*secondary=*/*body,
+          state_vectors,
+          /*epoch=*/t).elements_at_epoch();
+      elements.semimajor_axis = std::experimental::nullopt;
+      plugin->InsertCelestialJacobiKeplerian(index,
+                                             parent_index,
+                                             elements,
+                                             std::move(body));
+    }
+    plugin->EndInitialization();
+    return std::move(plugin);
+  }
+
   // The time of the |step|th history step of |plugin_|.  |HistoryTime(0)| is
   // |initial_time_|.
   Instant HistoryTime(Instant const time, int const step) {
@@ -338,44 +389,7 @@ TEST_F(PluginDeathTest, SerializationError) {
 
 TEST_F(PluginTest, Serialization) {
   GUID const satellite = "satellite";
-  // We need an actual |Plugin| here rather than a |TestablePlugin|, since
-  // that's what |ReadFromMessage| returns.
-  auto plugin = make_not_null_unique<Plugin>(
-                    initial_time_,
-                    initial_time_,
-                    planetarium_rotation_);
-  plugin->InsertCelestialJacobiKeplerian(
-      SolarSystemFactory::Sun,
-      /*parent_index=*/std::experimental::nullopt,
-      /*keplerian_elements=*/std::experimental::nullopt,
-      std::move(sun_body_));
-  for (int index = SolarSystemFactory::Sun + 1;
-       index <= SolarSystemFactory::LastMajorBody;
-       ++index) {
-    std::string const name = SolarSystemFactory::name(index);
-    Index const parent_index = SolarSystemFactory::parent(index);
-    std::string const parent_name = SolarSystemFactory::name(parent_index);
-    RelativeDegreesOfFreedom<Barycentric> const state_vectors =
-        Identity<ICRFJ2000Equator, Barycentric>()(
-            solar_system_->initial_state(name) -
-            solar_system_->initial_state(parent_name));
-    Instant const t;
-    auto body = make_not_null_unique<RotatingBody<Barycentric>>(
-        solar_system_->gravitational_parameter(name),
-        body_rotation_);
-    KeplerianElements<Barycentric> elements = KeplerOrbit<Barycentric>(
-        /*primary=*/MassiveBody(
-            solar_system_->gravitational_parameter(parent_name)),
-        /*secondary=*/*body,
-        state_vectors,
-        /*epoch=*/t).elements_at_epoch();
-    elements.semimajor_axis = std::experimental::nullopt;
-    plugin->InsertCelestialJacobiKeplerian(index,
-                                           parent_index,
-                                           elements,
-                                           std::move(body));
-  }
-  plugin->EndInitialization();
+  auto plugin = NewSolarSystemPlugin();
   plugin->InsertOrKeepVessel(satellite, SolarSystemFactory::Earth);
   plugin->SetVesselStateOffset(satellite,
                                RelativeDegreesOfFreedom<AliceSun>(
@@ -404,7 +418,8 @@ TEST_F(PluginTest, Serialization) {
   plugin = Plugin::ReadFromMessage(message);
   serialization::Plugin second_message;
   plugin->WriteToMessage(&second_message);
-  EXPECT_EQ(message.SerializeAsString(), second_message.SerializeAsString())
+  EXPECT_EQ(SerializeAsStringWithoutId(message),
+            SerializeAsStringWithoutId(second_message))
       << "FIRST\n" << message.DebugString()
       << "SECOND\n" << second_message.DebugString();
   EXPECT_EQ(SolarSystemFactory::LastMajorBody - SolarSystemFactory::Sun + 1,
@@ -429,9 +444,12 @@ TEST_F(PluginTest, Serialization) {
   EXPECT_EQ((HistoryTime(time, 6) - shift - Instant()) / (1 * Second),
             vessel_0_history.timeline(1).instant().scalar().magnitude());
 #else
-  EXPECT_EQ(3, vessel_0_history.timeline_size());
-  EXPECT_EQ((HistoryTime(time, 4) - Instant()) / (1 * Second),
-            vessel_0_history.timeline(0).instant().scalar().magnitude());
+  EXPECT_EQ(3, vessel_0_history.packed_timeline().size());
+  DiscreteTrajectory<Barycentric>* prolongation = nullptr;
+  auto const vessel_0_trajectory =
+      DiscreteTrajectory<Barycentric>::ReadFromMessage(vessel_0_history,
+                                                       {&prolongation});
+  EXPECT_EQ(HistoryTime(time, 4), vessel_0_trajectory->Begin().time());
 #endif
   EXPECT_FALSE(message.bubble().has_current());
   EXPECT_TRUE(message.has_plotting_frame());
@@ -443,6 +461,132 @@ TEST_F(PluginTest, Serialization) {
                     centre());
 }
 
+TEST_F(PluginTest, SerializationInParts) {
+  GUID const satellite = "satellite";
+  GUID const other_satellite = "other_satellite";
+  auto plugin = NewSolarSystemPlugin();
+  for (GUID const& guid : {satellite, other_satellite}) {
+    plugin->InsertOrKeepVessel(guid, SolarSystemFactory::Earth);
+    plugin->SetVesselStateOffset(guid,
+                                 RelativeDegreesOfFreedom<AliceSun>(
+                                     satellite_initial_displacement_,
+                                     satellite_initial_velocity_));
+  }
+  plugin->AdvanceTime(HistoryTime(initial_time_, 10), Angle());
+
+  serialization::Plugin message;
+  plugin->WriteToMessage(&message);
+
+  // The parts are the cheap part, one part per vessel, and the ephemeris.
+  auto const next_part = plugin->WriteToMessageParts();
+  std::string serialized_parts;
+  int number_of_parts = 0;
+  for (auto part = next_part(); part != nullptr; part = next_part()) {
+    serialized_parts += part->SerializeAsString();
+    ++number_of_parts;
+  }
+  EXPECT_EQ(4, number_of_parts);
+  serialization::Plugin merged_message;
+  EXPECT_TRUE(merged_message.ParseFromString(serialized_parts));
+  EXPECT_EQ(SerializeAsStringWithoutId(message),
+            SerializeAsStringWithoutId(merged_message));
+}
+
+TEST_F(PluginTest, DeltaSerialization) {
+  GUID const satellite = "satellite";
+  GUID const late_satellite = "late_satellite";
+  auto plugin = NewSolarSystemPlugin();
+  plugin->InsertOrKeepVessel(satellite, SolarSystemFactory::Earth);
+  plugin->SetVesselStateOffset(satellite,
+                               RelativeDegreesOfFreedom<AliceSun>(
+                                   satellite_initial_displacement_,
+                                   satellite_initial_velocity_));
+  Instant const time = initial_time_ + 1 * Second;
+  plugin->AdvanceTime(time, Angle());
+  plugin->InsertOrKeepVessel(satellite, SolarSystemFactory::Earth);
+  plugin->AdvanceTime(HistoryTime(time, 10), Angle());
+
+  serialization::Plugin message;
+  plugin->WriteToMessage(&message);
+  plugin->SetSerializationCheckpoint(message);
+
+  // The first delta has a vessel whose history was partly forgotten, and a
+  // vessel that is not in |message|.
+  plugin->InsertOrKeepVessel(satellite, SolarSystemFactory::Earth);
+  plugin->AdvanceTime(HistoryTime(time, 20), Angle());
+  plugin->ForgetAllHistoriesBefore(HistoryTime(time, 5));
+  plugin->InsertOrKeepVessel(satellite, SolarSystemFactory::Earth);
+  plugin->InsertOrKeepVessel(late_satellite, SolarSystemFactory::Earth);
+  plugin->SetVesselStateOffset(late_satellite,
+                               RelativeDegreesOfFreedom<AliceSun>(
+                                   satellite_initial_displacement_,
+                                   satellite_initial_velocity_));
+  plugin->AdvanceTime(HistoryTime(time, 30), Angle());
+  serialization::PluginDelta first_delta;
+  plugin->WriteDeltaToMessage(&first_delta);
+  plugin->SetSerializationCheckpoint(first_delta);
+  EXPECT_EQ(message.serialization_id(), first_delta.base_serialization_id());
+  ASSERT_EQ(1, first_delta.history_tail_size());
+  EXPECT_EQ(satellite, first_delta.history_tail(0).guid());
+
+  // The second delta has a vessel that was removed.
+  plugin->InsertOrKeepVessel(late_satellite, SolarSystemFactory::Earth);
+  plugin->AdvanceTime(HistoryTime(time, 40), Angle());
+  plugin->CreateFlightPlan(late_satellite,
+                           HistoryTime(time, 50),
+                           4 * Kilogram);
+  serialization::PluginDelta second_delta;
+  plugin->WriteDeltaToMessage(&second_delta);
+  plugin->SetSerializationCheckpoint(second_delta);
+  ASSERT_EQ(1, second_delta.history_tail_size());
+  EXPECT_EQ(late_satellite, second_delta.history_tail(0).guid());
+
+  serialization::Plugin full_message;
+  plugin->WriteToMessage(&full_message);
+  EXPECT_LT(second_delta.ByteSize(), full_message.ByteSize());
+
+  // Compacting the deltas yields the full serialization.
+  Plugin::ApplyDeltaToMessage(first_delta, &message);
+  Plugin::ApplyDeltaToMessage(second_delta, &message);
+  EXPECT_EQ(second_delta.plugin().serialization_id(),
+            message.serialization_id());
+  EXPECT_EQ(SerializeAsStringWithoutId(full_message),
+            SerializeAsStringWithoutId(message))
+      << "FULL\n" << full_message.DebugString()
+      << "COMPACTED\n" << message.DebugString();
+
+  // A plugin that was read may write deltas against the message it was read
+  // from.
+  plugin = Plugin::ReadFromMessage(message);
+  plugin->InsertOrKeepVessel(late_satellite, SolarSystemFactory::Earth);
+  plugin->AdvanceTime(HistoryTime(time, 60), Angle());
+  serialization::PluginDelta third_delta;
+  plugin->WriteDeltaToMessage(&third_delta);
+  plugin->WriteToMessage(&full_message);
+  Plugin::ApplyDeltaToMessage(third_delta, &message);
+  EXPECT_EQ(SerializeAsStringWithoutId(full_message),
+            SerializeAsStringWithoutId(message));
+}
+
+TEST_F(PluginDeathTest, DeltaSerializationError) {
+  auto plugin = NewSolarSystemPlugin();
+  serialization::Plugin message;
+  plugin->WriteToMessage(&message);
+  EXPECT_DEATH({
+    serialization::PluginDelta delta;
+    plugin->WriteDeltaToMessage(&delta);
+  }, "No previous serialization");
+  plugin->SetSerializationCheckpoint(message);
+  serialization::PluginDelta delta;
+  plugin->WriteDeltaToMessage(&delta);
+  // |full_message| is not the base of |delta|.
+  serialization::Plugin full_message;
+  plugin->WriteToMessage(&full_message);
+  EXPECT_DEATH({
+    Plugin::ApplyDeltaToMessage(delta, &full_message);
+  }, "not relative to this serialization");
+}
+
 TEST_F(PluginTest, Initialization) {
   InsertAllSolarSystemBodies();
   EXPECT_CALL(plugin_->mock_ephemeris(), WriteToMessage(_))
@@ -744,6 +888,50 @@ TEST_F(PluginTest, ForgetAllHistoriesBeforeAfterPredictionFork) {
       plugin_->RenderedPrediction(guid, World::origin);
 }
 
+TEST_F(PluginTest, UpdatePredictions) {
+  std::vector<GUID> const guids = {"Test Satellite 1", "Test Satellite 2"};
+
+  InsertAllSolarSystemBodies();
+  EXPECT_CALL(plugin_->mock_ephemeris(), WriteToMessage(_))
+      .WillOnce(SetArgPointee<0>(valid_ephemeris_message_));
+  plugin_->EndInitialization();
+
+  EXPECT_CALL(plugin_->mock_ephemeris(), t_max())
+      .WillRepeatedly(Return(astronomy::InfiniteFuture));
+  EXPECT_CALL(plugin_->mock_ephemeris(), empty()).WillRepeatedly(Return(false));
+  EXPECT_CALL(plugin_->mock_ephemeris(), Prolong(_)).Times(AnyNumber());
+  EXPECT_CALL(plugin_->mock_ephemeris(), FlowWithAdaptiveStep(_, _, _, _, _))
+      .WillRepeatedly(DoAll(AppendToDiscreteTrajectory(), Return(true)));
+  EXPECT_CALL(plugin_->mock_ephemeris(), FlowWithFixedStep(_, _, _, _))
+      .WillRepeatedly(AppendToDiscreteTrajectories());
+  EXPECT_CALL(plugin_->mock_ephemeris(), planetary_integrator())
+      .WillRepeatedly(
+          ReturnRef(McLachlanAtela1992Order5Optimal<Position<Barycentric>>()));
+
+  for (auto const& guid : guids) {
+    plugin_->InsertOrKeepVessel(guid, SolarSystemFactory::Earth);
+    plugin_->SetVesselStateOffset(guid,
+                                  RelativeDegreesOfFreedom<AliceSun>(
+                                      satellite_initial_displacement_,
+                                      satellite_initial_velocity_));
+  }
+  Instant const time = initial_time_ + 1 * Second;
+  plugin_->AdvanceTime(time, Angle());
+
+  // Each prediction is flowed once, possibly on another thread, up to the end
+  // of the prediction.
+  EXPECT_CALL(plugin_->mock_ephemeris(),
+              FlowWithAdaptiveStep(_, _, time + 1 * Hour, _, _))
+      .Times(guids.size())
+      .WillRepeatedly(DoAll(AppendToDiscreteTrajectory(), Return(true)));
+  EXPECT_TRUE(
+      plugin_->UpdatePredictions(guids, std::chrono::seconds(60)).ok());
+  for (auto const& guid : guids) {
+    EXPECT_EQ(time + 1 * Hour,
+              plugin_->GetVessel(guid)->prediction().last().time()) << guid;
+  }
+}
+
 TEST_F(PluginDeathTest, VesselFromParentError) {
   GUID const guid = "Test Satellite";
   EXPECT_DEATH({
@@ -2,6 +2,7 @@
 #include "ksp_plugin/vessel.hpp"
 
 #include <limits>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -152,6 +153,54 @@ TEST_F(VesselTest, AdvanceTimeNotInBubble) {
   EXPECT_FALSE(vessel_->is_dirty());
 }
 
+TEST_F(VesselTest, AdvanceTimeNotInBubbleBatched) {
+  // Vessels whose histories end at different times and some of which are
+  // dirty, advanced together and one at a time.
+  std::vector<std::unique_ptr<Vessel>> batched_vessels;
+  std::vector<std::unique_ptr<Vessel>> separate_vessels;
+  for (int i = 0; i < 6; ++i) {
+    for (auto* const vessels : {&batched_vessels, &separate_vessels}) {
+      vessels->push_back(std::make_unique<Vessel>(earth_.get(),
+                                                  ephemeris_.get(),
+                                                  history_fixed_parameters_,
+                                                  adaptive_parameters_,
+                                                  adaptive_parameters_));
+      Vessel& vessel = *vessels->back();
+      DegreesOfFreedom<Barycentric> const& d = i % 2 == 0 ? d1_ : d2_;
+      vessel.CreateHistoryAndForkProlongation(
+          t0_ + i * Second,
+          {d.position() + Displacement<Barycentric>(
+                              {i * Metre, 0 * Metre, 0 * Metre}),
+           d.velocity()});
+      if (i % 3 == 0) {
+        vessel.AdvanceTimeInBubble(t1_ + i * Second, d);
+      }
+    }
+  }
+
+  std::vector<not_null<Vessel*>> vessels;
+  for (auto const& vessel : batched_vessels) {
+    vessels.push_back(vessel.get());
+  }
+  Vessel::AdvanceTimeNotInBubble(vessels, t2_);
+  for (auto const& vessel : separate_vessels) {
+    vessel->AdvanceTimeNotInBubble(t2_);
+  }
+
+  for (int i = 0; i < batched_vessels.size(); ++i) {
+    Vessel const& batched = *batched_vessels[i];
+    Vessel const& separate = *separate_vessels[i];
+    EXPECT_FALSE(batched.is_dirty());
+    EXPECT_EQ(separate.history().last().time(),
+              batched.history().last().time());
+    EXPECT_EQ(separate.history().last().degrees_of_freedom(),
+              batched.history().last().degrees_of_freedom());
+    EXPECT_EQ(t2_, batched.prolongation().last().time());
+    EXPECT_EQ(separate.prolongation().last().degrees_of_freedom(),
+              batched.prolongation().last().degrees_of_freedom());
+  }
+}
+
 TEST_F(VesselTest, Prediction) {
   vessel_->CreateHistoryAndForkProlongation(t1_, d1_);
   vessel_->AdvanceTimeNotInBubble(t2_);
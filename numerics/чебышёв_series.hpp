@@ -1,9 +1,13 @@
 ﻿
 #pragma once
 
+#include <cstdint>
+#include <deque>
+#include <memory>
 #include <vector>
 
 #include "geometry/named_quantities.hpp"
+#include "geometry/r3_element.hpp"
 #include "quantities/quantities.hpp"
 #include "serialization/numerics.pb.h"
 
@@ -15,10 +19,48 @@ using ЧебышёвSeries = ChebyshevSeries;
 }  // namespace serialization
 
 using geometry::Instant;
+using geometry::Multivector;
+using geometry::R3Element;
 using quantities::Time;
 using quantities::Variation;
 
 namespace numerics {
+
+template<typename Vector>
+class ЧебышёвSeries;
+
+// Storage for the coefficients of many Чебышёв series with values in a
+// three-dimensional space.  The coefficients are allocated in large chunks
+// which are never moved, so that the series may point into them.  The chunks
+// are freed in the order in which they were allocated.
+class ЧебышёвSeriesArena {
+ public:
+  ЧебышёвSeriesArena() = default;
+  ЧебышёвSeriesArena(ЧебышёвSeriesArena&& other) = default;
+  ЧебышёвSeriesArena& operator=(ЧебышёвSeriesArena&& other) = default;
+
+  // Returns storage for |size| consecutive coefficients.
+  R3Element<double>* Allocate(int const size);
+
+  // Frees the chunks allocated before the one that holds the coefficients of
+  // |first_retained|.  Does nothing if these coefficients are not in this
+  // arena.
+  template<typename Vector>
+  void ReleaseBefore(ЧебышёвSeries<Vector> const& first_retained);
+
+  // The number of bytes allocated by this object.
+  std::int64_t allocated_bytes() const;
+
+ private:
+  struct Chunk {
+    std::unique_ptr<R3Element<double>[]> coefficients;
+    int size;
+    int used;
+  };
+
+  std::deque<Chunk> chunks_;
+};
+
 namespace internal {
 
 // A helper class for implementing |Evaluate| that can be specialized for speed.
@@ -42,6 +84,9 @@ class EvaluationHelper {
 
 }  // namespace internal
 
+template<typename Vector>
+class ЧебышёвSeriesBatch;
+
 // A Чебышёв series with values in the vector space |Vector|.  The argument is
 // an |Instant|.
 template<typename Vector>
@@ -79,6 +124,26 @@ class ЧебышёвSeries {
   static ЧебышёвSeries ReadFromMessage(
       serialization::ЧебышёвSeries const& message);
 
+  // Moves the coefficients of this series to storage allocated in |arena|,
+  // which must outlive this object.  Only implemented for multivectors.
+  void MoveCoefficientsTo(not_null<ЧебышёвSeriesArena*> const arena);
+
+  // Writes the |degree() + 1| coefficients of this series, in SI units, at
+  // |coefficients|.  Only implemented for multivectors.
+  void WriteCoefficients(not_null<R3Element<double>*> const coefficients) const;
+  // Returns a series whose coefficients are the |degree + 1| elements, in SI
+  // units, at |coefficients|.  The coefficients are not copied, so they must
+  // outlive the result.  Suitable for coefficients that are memory-mapped from
+  // a file.  Only implemented for multivectors.
+  static ЧебышёвSeries ViewCoefficients(
+      not_null<R3Element<double> const*> const coefficients,
+      int const degree,
+      Instant const& t_min,
+      Instant const& t_max);
+  // Returns a series that evaluates like this one and views its coefficients,
+  // which must outlive the result.  Only implemented for multivectors.
+  ЧебышёвSeries View() const;
+
   // Computes a Newhall approximation of the given |degree|.  |q| and |v| are
   // the positions and velocities over a constant division of [t_min, t_max].
   static ЧебышёвSeries NewhallApproximation(
@@ -89,10 +154,64 @@ class ЧебышёвSeries {
       Instant const& t_max);
 
  private:
+  ЧебышёвSeries(internal::EvaluationHelper<Vector>&& helper,
+                Instant const& t_min,
+                Instant const& t_max);
+
   Instant t_min_;
   Instant t_max_;
   Time::Inverse one_over_duration_;
   internal::EvaluationHelper<Vector> helper_;
+
+  template<typename V>
+  friend class ЧебышёвSeriesBatch;
+  friend class ЧебышёвSeriesArena;
+};
+
+// A set of Чебышёв series which are evaluated together at the same time.  The
+// coefficients of the series are copied into a structure of arrays, so that
+// the Clenshaw recurrence may be vectorized across series.  Copying the
+// coefficients costs about as much as evaluating the series, so a batch is only
+// useful if it is evaluated many times between calls to |Reset|.  Only
+// implemented for multivectors.
+template<typename Scalar, typename Frame, int rank>
+class ЧебышёвSeriesBatch<Multivector<Scalar, Frame, rank>> {
+ public:
+  using Series = ЧебышёвSeries<Multivector<Scalar, Frame, rank>>;
+
+  ЧебышёвSeriesBatch() = default;
+
+  // Replaces the contents of this batch with the coefficients of |series|.  The
+  // |series| need not be on the same interval nor of the same degree.  The
+  // batch keeps pointers to the |series|, which must not be moved or destroyed
+  // as long as |Evaluate| is called.
+  void Reset(std::vector<not_null<Series const*>> const& series);
+
+  // The number of series passed to the last call to |Reset|.
+  int size() const;
+
+  // Sets |values[i]| to the value of the |i|th series passed to |Reset| at |t|,
+  // which must be in the range of all the series.  The results are bit-for-bit
+  // identical to those of |ЧебышёвSeries::Evaluate|.  Not const because the
+  // scratch storage is reused from call to call.
+  void Evaluate(Instant const& t,
+                std::vector<Multivector<Scalar, Frame, rank>>& values);
+
+ private:
+  std::vector<Series const*> series_;
+  // The largest degree of the |series_|.  The coefficients of the series of
+  // smaller degree are padded with zeros.
+  int degree_ = 0;
+  // The coordinate |xyz| of the coefficient of Tₖ of the |i|th series is at
+  // index |(3 * k + xyz) * series_.size() + i|.
+  std::vector<double> coefficients_;
+
+  // Scratch storage for |Evaluate|, with |3 * series_.size()| elements.
+  std::vector<double> scaled_t_;
+  std::vector<double> two_scaled_t_;
+  std::vector<double> b_i_;
+  std::vector<double> b_j_;
+  std::vector<double> result_;
 };
 
 }  // namespace numerics
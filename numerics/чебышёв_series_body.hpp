@@ -1,6 +1,7 @@
 ﻿
 #include "numerics/чебышёв_series.hpp"
 
+#include <algorithm>
 #include <vector>
 
 #include "geometry/grassmann.hpp"
@@ -27,6 +28,8 @@ class EvaluationHelper<Multivector<Scalar, Frame, rank>> {
   EvaluationHelper(
       std::vector<Multivector<Scalar, Frame, rank>> const& coefficients,
       int const degree);
+  // The |coefficients| are not copied.
+  EvaluationHelper(R3Element<double> const* coefficients, int const degree);
   EvaluationHelper(EvaluationHelper&& other) = default;
   EvaluationHelper& operator=(EvaluationHelper&& other) = default;
 
@@ -36,11 +39,21 @@ class EvaluationHelper<Multivector<Scalar, Frame, rank>> {
   Multivector<Scalar, Frame, rank> coefficients(int const index) const;
   int degree() const;
 
+  // Moves the coefficients to storage allocated in |arena|.
+  void MoveTo(not_null<ЧебышёвSeriesArena*> const arena);
+  R3Element<double> const* data() const;
+
  private:
-  std::vector<R3Element<double>> coefficients_;
+  // Empty if the coefficients are in an arena or were not copied.
+  std::vector<R3Element<double>> owned_coefficients_;
+  R3Element<double> const* coefficients_;
   int degree_;
 };
 
+// The number of coefficients in a chunk of a |ЧебышёвSeriesArena|.  Large
+// enough for many series of the largest degree that we use.
+int const arena_chunk_size = 1024;
+
 template<typename Vector>
 EvaluationHelper<Vector>::EvaluationHelper(
     std::vector<Vector> const& coefficients,
@@ -95,10 +108,17 @@ EvaluationHelper<Multivector<Scalar, Frame, rank>>::EvaluationHelper(
     std::vector<Multivector<Scalar, Frame, rank>> const& coefficients,
     int const degree) : degree_(degree) {
   for (auto const& coefficient : coefficients) {
-    coefficients_.push_back(coefficient.coordinates() / SIUnit<Scalar>());
+    owned_coefficients_.push_back(
+        coefficient.coordinates() / SIUnit<Scalar>());
   }
+  coefficients_ = owned_coefficients_.data();
 }
 
+template<typename Scalar, typename Frame, int rank>
+EvaluationHelper<Multivector<Scalar, Frame, rank>>::EvaluationHelper(
+    R3Element<double> const* const coefficients,
+    int const degree) : coefficients_(coefficients), degree_(degree) {}
+
 template<typename Scalar, typename Frame, int rank>
 Multivector<Scalar, Frame, rank>
 EvaluationHelper<Multivector<Scalar, Frame, rank>>::EvaluateImplementation(
@@ -156,8 +176,59 @@ int EvaluationHelper<Multivector<Scalar, Frame, rank>>::degree() const {
   return degree_;
 }
 
+template<typename Scalar, typename Frame, int rank>
+void EvaluationHelper<Multivector<Scalar, Frame, rank>>::MoveTo(
+    not_null<ЧебышёвSeriesArena*> const arena) {
+  R3Element<double>* const coefficients = arena->Allocate(degree_ + 1);
+  std::copy(coefficients_, coefficients_ + degree_ + 1, coefficients);
+  coefficients_ = coefficients;
+  owned_coefficients_.clear();
+  owned_coefficients_.shrink_to_fit();
+}
+
+template<typename Scalar, typename Frame, int rank>
+R3Element<double> const*
+EvaluationHelper<Multivector<Scalar, Frame, rank>>::data() const {
+  return coefficients_;
+}
+
 }  // namespace internal
 
+inline R3Element<double>* ЧебышёвSeriesArena::Allocate(int const size) {
+  if (chunks_.empty() || chunks_.back().used + size > chunks_.back().size) {
+    int const chunk_size = std::max(size, internal::arena_chunk_size);
+    chunks_.push_back(
+        {std::make_unique<R3Element<double>[]>(chunk_size), chunk_size, 0});
+  }
+  Chunk& chunk = chunks_.back();
+  R3Element<double>* const result = &chunk.coefficients[chunk.used];
+  chunk.used += size;
+  return result;
+}
+
+template<typename Vector>
+void ЧебышёвSeriesArena::ReleaseBefore(
+    ЧебышёвSeries<Vector> const& first_retained) {
+  R3Element<double> const* const coefficients = first_retained.helper_.data();
+  auto const it = std::find_if(
+      chunks_.begin(), chunks_.end(),
+      [coefficients](Chunk const& chunk) {
+        return chunk.coefficients.get() <= coefficients &&
+               coefficients < chunk.coefficients.get() + chunk.used;
+      });
+  if (it != chunks_.end()) {
+    chunks_.erase(chunks_.begin(), it);
+  }
+}
+
+inline std::int64_t ЧебышёвSeriesArena::allocated_bytes() const {
+  std::int64_t result = 0;
+  for (auto const& chunk : chunks_) {
+    result += chunk.size * sizeof(R3Element<double>);
+  }
+  return result;
+}
+
 template<typename Vector>
 ЧебышёвSeries<Vector>::ЧебышёвSeries(std::vector<Vector> const& coefficients,
                                      Instant const& t_min,
@@ -173,6 +244,19 @@ template<typename Vector>
   one_over_duration_ = 1 / duration;
 }
 
+template<typename Vector>
+ЧебышёвSeries<Vector>::ЧебышёвSeries(
+    internal::EvaluationHelper<Vector>&& helper,
+    Instant const& t_min,
+    Instant const& t_max)
+    : t_min_(t_min),
+      t_max_(t_max),
+      helper_(std::move(helper)) {
+  CHECK_LE(0, helper_.degree()) << "Degree must be at least 0";
+  CHECK_LT(t_min_, t_max_) << "Time interval must not be empty";
+  Time const duration = t_max_ - t_min_;
+  one_over_duration_ = 1 / duration;
+}
 
 template<typename Vector>
 bool ЧебышёвSeries<Vector>::operator==(ЧебышёвSeries const& right) const {
@@ -289,6 +373,156 @@ template<typename Vector>
                        Instant::ReadFromMessage(message.t_max()));
 }
 
+template<typename Scalar, typename Frame, int rank>
+void ЧебышёвSeriesBatch<Multivector<Scalar, Frame, rank>>::Reset(
+    std::vector<not_null<Series const*>> const& series) {
+  series_.assign(series.begin(), series.end());
+  std::size_t const lanes = series_.size();
+  std::size_t const width = 3 * lanes;
+  degree_ = 0;
+  for (Series const* const s : series_) {
+    degree_ = std::max(degree_, s->helper_.degree());
+  }
+
+  // The Clenshaw recurrence propagates exact zeros until it reaches the actual
+  // degree of a series, so the padding doesn't change the results.
+  coefficients_.assign((degree_ + 1) * width, 0.0);
+  for (std::size_t i = 0; i < lanes; ++i) {
+    auto const& helper = series_[i]->helper_;
+    for (int k = 0; k <= helper.degree(); ++k) {
+      R3Element<double> const coefficient =
+          helper.coefficients(k).coordinates() / SIUnit<Scalar>();
+      coefficients_[(3 * k + 0) * lanes + i] = coefficient.x;
+      coefficients_[(3 * k + 1) * lanes + i] = coefficient.y;
+      coefficients_[(3 * k + 2) * lanes + i] = coefficient.z;
+    }
+  }
+  scaled_t_.resize(width);
+  two_scaled_t_.resize(width);
+  b_i_.resize(width);
+  b_j_.resize(width);
+  result_.resize(width);
+}
+
+template<typename Scalar, typename Frame, int rank>
+int ЧебышёвSeriesBatch<Multivector<Scalar, Frame, rank>>::size() const {
+  return series_.size();
+}
+
+template<typename Scalar, typename Frame, int rank>
+void ЧебышёвSeriesBatch<Multivector<Scalar, Frame, rank>>::Evaluate(
+    Instant const& t,
+    std::vector<Multivector<Scalar, Frame, rank>>& values) {
+  std::size_t const lanes = series_.size();
+  values.resize(lanes);
+  if (degree_ < 2) {
+    for (std::size_t i = 0; i < lanes; ++i) {
+      values[i] = series_[i]->Evaluate(t);
+    }
+    return;
+  }
+
+  for (std::size_t i = 0; i < lanes; ++i) {
+    Series const& s = *series_[i];
+    // See the comments in |ЧебышёвSeries::Evaluate|.
+    double const scaled_t =
+        ((t - s.t_max_) + (t - s.t_min_)) * s.one_over_duration_;
+#ifdef _DEBUG
+    CHECK_LE(scaled_t, 1.1);
+    CHECK_GE(scaled_t, -1.1);
+#endif
+    for (std::size_t xyz = 0; xyz < 3; ++xyz) {
+      scaled_t_[xyz * lanes + i] = scaled_t;
+      two_scaled_t_[xyz * lanes + i] = scaled_t + scaled_t;
+    }
+  }
+
+  // The operations below are those of the |EvaluationHelper|, in the same
+  // order, but each loop on |m| processes all the series and all the
+  // coordinates and is trivially vectorizable.
+  std::size_t const width = 3 * lanes;
+  double const* const c = coefficients_.data();
+  double const* const scaled_t = scaled_t_.data();
+  double const* const two_scaled_t = two_scaled_t_.data();
+  double* const b_i = b_i_.data();
+  double* const b_j = b_j_.data();
+  double* const result = result_.data();
+
+  double const* const c_degree = c + degree_ * width;
+  double const* const c_degreeminus1 = c + (degree_ - 1) * width;
+  for (std::size_t m = 0; m < width; ++m) {
+    // b_degree   = c_degree.
+    b_i[m] = c_degree[m];
+    // b_degree-1 = c_degree-1 + 2 t b_degree.
+    b_j[m] = c_degreeminus1[m] + two_scaled_t[m] * b_i[m];
+  }
+  int k = degree_ - 3;
+  for (; k >= 1; k -= 2) {
+    double const* const c_kplus1 = c + (k + 1) * width;
+    double const* const c_k = c + k * width;
+    for (std::size_t m = 0; m < width; ++m) {
+      // b_k+1 = c_k+1 + 2 t b_k+2 - b_k+3.
+      b_i[m] = c_kplus1[m] + two_scaled_t[m] * b_j[m] - b_i[m];
+      // b_k   = c_k   + 2 t b_k+1 - b_k+2.
+      b_j[m] = c_k[m] + two_scaled_t[m] * b_i[m] - b_j[m];
+    }
+  }
+  double const* const c_0 = c;
+  if (k == 0) {
+    double const* const c_1 = c + width;
+    for (std::size_t m = 0; m < width; ++m) {
+      // b_1 = c_1 + 2 t b_2 - b_3.
+      b_i[m] = c_1[m] + two_scaled_t[m] * b_j[m] - b_i[m];
+      // c_0 + t b_1 - b_2.
+      result[m] = c_0[m] + scaled_t[m] * b_i[m] - b_j[m];
+    }
+  } else {
+    for (std::size_t m = 0; m < width; ++m) {
+      // c_0 + t b_1 - b_2.
+      result[m] = c_0[m] + scaled_t[m] * b_j[m] - b_i[m];
+    }
+  }
+
+  for (std::size_t i = 0; i < lanes; ++i) {
+    values[i] = Multivector<double, Frame, rank>(
+                    R3Element<double>(result[i],
+                                      result[lanes + i],
+                                      result[2 * lanes + i])) *
+                SIUnit<Scalar>();
+  }
+}
+
+template<typename Vector>
+void ЧебышёвSeries<Vector>::MoveCoefficientsTo(
+    not_null<ЧебышёвSeriesArena*> const arena) {
+  helper_.MoveTo(arena);
+}
+
+template<typename Vector>
+void ЧебышёвSeries<Vector>::WriteCoefficients(
+    not_null<R3Element<double>*> const coefficients) const {
+  std::copy(helper_.data(),
+            helper_.data() + helper_.degree() + 1,
+            static_cast<R3Element<double>*>(coefficients));
+}
+
+template<typename Vector>
+ЧебышёвSeries<Vector> ЧебышёвSeries<Vector>::ViewCoefficients(
+    not_null<R3Element<double> const*> const coefficients,
+    int const degree,
+    Instant const& t_min,
+    Instant const& t_max) {
+  return ЧебышёвSeries(
+      internal::EvaluationHelper<Vector>(coefficients, degree),
+      t_min,
+      t_max);
+}
+
+template<typename Vector>
+ЧебышёвSeries<Vector> ЧебышёвSeries<Vector>::View() const {
+  return ViewCoefficients(helper_.data(), helper_.degree(), t_min_, t_max_);
+}
+
 template<typename Vector>
 ЧебышёвSeries<Vector> ЧебышёвSeries<Vector>::NewhallApproximation(
     int const degree,
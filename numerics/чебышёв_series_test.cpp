@@ -3,6 +3,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <random>
 #include <vector>
 
 #include "astronomy/frames.hpp"
@@ -19,6 +20,7 @@ namespace principia {
 
 using astronomy::ICRFJ2000Ecliptic;
 using geometry::Instant;
+using geometry::R3Element;
 using geometry::Vector;
 using quantities::Length;
 using quantities::Speed;
@@ -210,6 +212,94 @@ TEST_F(ЧебышёвSeriesTest, X6Vector) {
             x6.Evaluate(t0_ + 3 * Second));
 }
 
+TEST_F(ЧебышёвSeriesTest, Batch) {
+  using V = Vector<Length, ICRFJ2000Ecliptic>;
+  std::mt19937_64 random(42);
+  std::vector<ЧебышёвSeries<V>> all_series;
+  // Series of different degrees and on different intervals, including degrees
+  // that are handled specially by |Evaluate|.
+  for (int degree : {0, 1, 2, 3, 7, 8, 12, 17}) {
+    std::vector<V> coefficients;
+    for (int k = 0; k <= degree; ++k) {
+      coefficients.push_back(V({static_cast<double>(random()) * Metre,
+                                static_cast<double>(random()) * Metre,
+                                static_cast<double>(random()) * Metre}));
+    }
+    all_series.emplace_back(coefficients,
+                            t_min_ - degree * Second,
+                            t_max_ + degree * Second);
+  }
+  std::vector<not_null<ЧебышёвSeries<V> const*>> series;
+  for (auto const& s : all_series) {
+    series.push_back(&s);
+  }
+
+  ЧебышёвSeriesBatch<V> batch;
+  batch.Reset(series);
+  EXPECT_EQ(series.size(), batch.size());
+  std::vector<V> values;
+  for (Instant t = t_min_; t <= t_max_; t += 0.1 * Second) {
+    batch.Evaluate(t, values);
+    ASSERT_EQ(series.size(), values.size());
+    for (int i = 0; i < series.size(); ++i) {
+      EXPECT_EQ(series[i]->Evaluate(t), values[i]) << i;
+    }
+  }
+
+  // A batch of series of low degree.
+  series.erase(series.begin() + 2, series.end());
+  batch.Reset(series);
+  EXPECT_EQ(2, batch.size());
+  batch.Evaluate(t0_, values);
+  ASSERT_EQ(2, values.size());
+  EXPECT_EQ(series[0]->Evaluate(t0_), values[0]);
+  EXPECT_EQ(series[1]->Evaluate(t0_), values[1]);
+}
+
+TEST_F(ЧебышёвSeriesTest, Arena) {
+  using V = Vector<Length, ICRFJ2000Ecliptic>;
+  std::mt19937_64 random(42);
+  ЧебышёвSeriesArena arena;
+  EXPECT_EQ(0, arena.allocated_bytes());
+
+  // Enough series to fill several chunks.
+  std::vector<ЧебышёвSeries<V>> series;
+  std::vector<V> expected_values;
+  for (int i = 0; i < 1000; ++i) {
+    std::vector<V> coefficients;
+    for (int k = 0; k <= 10; ++k) {
+      coefficients.push_back(V({static_cast<double>(random()) * Metre,
+                                static_cast<double>(random()) * Metre,
+                                static_cast<double>(random()) * Metre}));
+    }
+    series.emplace_back(coefficients, t_min_, t_max_);
+    expected_values.push_back(series.back().Evaluate(t0_));
+    series.back().MoveCoefficientsTo(&arena);
+  }
+  std::int64_t const allocated_bytes = arena.allocated_bytes();
+  EXPECT_LE(1000 * 11 * sizeof(R3Element<double>), allocated_bytes);
+  for (int i = 0; i < series.size(); ++i) {
+    EXPECT_EQ(expected_values[i], series[i].Evaluate(t0_));
+  }
+
+  // Releasing the beginning of the arena frees some chunks, but doesn't affect
+  // the series that follow.
+  series.erase(series.begin(), series.begin() + 500);
+  expected_values.erase(expected_values.begin(),
+                        expected_values.begin() + 500);
+  arena.ReleaseBefore(series.front());
+  EXPECT_GT(allocated_bytes, arena.allocated_bytes());
+  for (int i = 0; i < series.size(); ++i) {
+    EXPECT_EQ(expected_values[i], series[i].Evaluate(t0_));
+  }
+
+  // A series which is not in the arena doesn't release anything.
+  std::int64_t const retained_bytes = arena.allocated_bytes();
+  ЧебышёвSeries<V> const owning({V(), V()}, t_min_, t_max_);
+  arena.ReleaseBefore(owning);
+  EXPECT_EQ(retained_bytes, arena.allocated_bytes());
+}
+
 TEST_F(ЧебышёвSeriesDeathTest, SerializationError) {
   ЧебышёвSeries<Speed> v({1 * Metre / Second,
                           -2 * Metre / Second,
@@ -1,11 +1,17 @@
 ﻿
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <experimental/optional>
+#include <memory>
+#include <ostream>
 #include <vector>
 #include <utility>
 
+#include "base/mapped_file.hpp"
 #include "base/status.hpp"
+#include "base/status_or.hpp"
 #include "geometry/named_quantities.hpp"
 #include "numerics/чебышёв_series.hpp"
 #include "physics/degrees_of_freedom.hpp"
@@ -16,7 +22,9 @@ namespace principia {
 namespace physics {
 namespace internal_continuous_trajectory {
 
+using base::MappedFile;
 using base::Status;
+using base::StatusOr;
 using geometry::Displacement;
 using geometry::Instant;
 using geometry::Position;
@@ -34,6 +42,10 @@ class ContinuousTrajectory {
   // is passed to all the calls.
   class Hint;
 
+  // A |BatchHint| plays for |EvaluatePositions| the role that a |Hint| plays
+  // for |EvaluatePosition|.
+  class BatchHint;
+
   // A |Checkpoint| contains the impermanent state of a trajectory, i.e., the
   // state that gets incrementally updated as the Чебышёв polynomials are
   // constructed.  The client may get a |Checkpoint| at any time and use it to
@@ -41,6 +53,15 @@ class ContinuousTrajectory {
   // |Checkpoint|.
   class Checkpoint;
 
+  // The series of a trajectory are published as immutable snapshots: the
+  // functions that modify the series build a new snapshot and replace the
+  // current one with an atomic pointer swap.  Thus the functions that evaluate
+  // the trajectory, or return its |t_min| or |t_max|, never block and may be
+  // called on any thread, even while the thread that owns the trajectory calls
+  // |Append|, |ForgetBefore|, |Publish| or |ReadSeriesFromPrecomputedFile|.
+  // However, the trajectory must not be evaluated at a time that is being
+  // forgotten.
+
   // Constructs a trajectory with the given time |step|.  Because the Чебышёв
   // polynomials have values in the range [-1, 1], the error resulting of
   // truncating the infinite Чебышёв series to a finite degree are a small
@@ -69,6 +90,10 @@ class ContinuousTrajectory {
   // benchmarking or analyzing performance.  Do not use in real code.
   double average_degree() const;
 
+  // The number of bytes used by the series of this trajectory.  Only useful for
+  // benchmarking or analyzing performance.  Do not use in real code.
+  std::int64_t series_bytes() const;
+
   // Appends one point to the trajectory.  |time| must be after the last time
   // passed to |Append| if the trajectory is not empty.  The |time|s passed to
   // successive calls to |Append| must be equally spaced with the |step| given
@@ -79,6 +104,21 @@ class ContinuousTrajectory {
   // Removes all data for times strictly less than |time|.
   void ForgetBefore(Instant const& time);
 
+  // Returns a trajectory without series that continues this one: the points
+  // that follow the last point appended to this trajectory may be appended to
+  // the result, and they produce the series that this trajectory would have
+  // produced.  This makes it possible to prolong this trajectory on another
+  // thread while it is being evaluated.
+  not_null<std::unique_ptr<ContinuousTrajectory>> MakeStaging() const;
+
+  // Moves the series of |staging|, which must have been returned by
+  // |MakeStaging| for this trajectory and since only be appended to, at the end
+  // of this trajectory, and makes this trajectory continue where |staging|
+  // stops.  On return |staging| has no series but may still be appended to.
+  // The series are published in a single snapshot, so a concurrent evaluation
+  // sees either all of them or none of them.
+  void Publish(not_null<ContinuousTrajectory*> const staging);
+
   // Evaluates the trajectory at the given |time|, which must be in
   // [t_min(), t_max()].  The |hint| may be used to speed up evaluation
   // in increasing time order.  It may be a nullptr (in which case no speed-up
@@ -91,6 +131,17 @@ class ContinuousTrajectory {
       Instant const& time,
       Hint* const hint) const;
 
+  // Evaluates all the |trajectories| at the given |time|, which must be in
+  // [t_min(), t_max()] for each of them, and stores the results in |positions|,
+  // indexed like |trajectories|.  The results are the same as those of
+  // |EvaluatePosition|, but the series of all the trajectories are evaluated
+  // together.  The |hint| must always be used with the same |trajectories|.
+  static void EvaluatePositions(
+      std::vector<not_null<ContinuousTrajectory const*>> const& trajectories,
+      Instant const& time,
+      not_null<BatchHint*> const hint,
+      std::vector<Position<Frame>>& positions);
+
   // Returns a checkpoint for the current state of this object.
   Checkpoint GetCheckpoint() const;
 
@@ -102,16 +153,82 @@ class ContinuousTrajectory {
   void WriteToMessage(
       not_null<serialization::ContinuousTrajectory*> const message,
       Checkpoint const& checkpoint) const;
+  // Same as above, except that the series that end at or before |after| are
+  // not serialized.
+  void WriteToMessage(
+      not_null<serialization::ContinuousTrajectory*> const message,
+      Checkpoint const& checkpoint,
+      Instant const& after) const;
   static not_null<std::unique_ptr<ContinuousTrajectory>> ReadFromMessage(
       serialization::ContinuousTrajectory const& message);
 
+  // Serializes the current state of this object to |message|, except for the
+  // series, which are written to |file| in a layout that can be memory-mapped:
+  // the number of series and a stride |s| as |int64|s, and for each series its
+  // |t_min| and |t_max| in seconds from |Instant()| as |double|s, its degree as
+  // an |int64| and |s| coefficients in SI units as triples of |double|s, padded
+  // with zeros.  The stride is one more than the largest degree.  Everything is
+  // in native byte order.
+  void WriteToPrecomputedFile(
+      not_null<serialization::ContinuousTrajectory*> const message,
+      std::ostream& file) const;
+  // Reads the series written by |WriteToPrecomputedFile| at |offset| in
+  // the |file|.  The coefficients are not copied but are evaluated directly
+  // from the |file|, which is kept alive by this object.  This trajectory must
+  // not have any series; typically it was just read from a message without
+  // series.  Returns the offset of the byte following the series, or an error,
+  // leaving this object unchanged, if the |file| is truncated or doesn't have
+  // the expected layout at |offset|.
+  StatusOr<std::int64_t> ReadSeriesFromPrecomputedFile(
+      std::shared_ptr<MappedFile const> const& file,
+      std::int64_t const offset);
+
+  // Serializes the state of this object as it existed when the |checkpoint|
+  // was taken, without any series.
+  void WriteCheckpointToMessage(
+      Checkpoint const& checkpoint,
+      not_null<serialization::ContinuousTrajectory*> const message) const;
+  // Reads a checkpoint written by |WriteCheckpointToMessage| for this object.
+  // Returns an error if the |message| doesn't designate the end of one of the
+  // series of this object.
+  StatusOr<Checkpoint> ReadCheckpointFromMessage(
+      serialization::ContinuousTrajectory const& message) const;
+
   // The only thing that clients may do with |Hint| objects is to
-  // default-initialize them.
+  // default-initialize and copy them.  A |Hint| may be used concurrently by
+  // multiple threads, e.g., when it is held by an object shared by these
+  // threads.
   class Hint {
    public:
     Hint();
+    Hint(Hint const& other);
+    Hint& operator=(Hint const& other);
+   private:
+    // A stale value is harmless since the index is always checked before use,
+    // so this is accessed with relaxed ordering.
+    std::atomic<int> index_;
+    friend class ContinuousTrajectory<Frame>;
+  };
+
+  // In addition to a |Hint| for each trajectory, a |BatchHint| holds the
+  // coefficients of the series currently in use, laid out for evaluating them
+  // together.  The only thing that clients may do with |BatchHint| objects is
+  // to default-initialize them.
+  class BatchHint {
+   public:
+    BatchHint() = default;
    private:
-    int index_;
+    std::vector<Hint> hints_;
+    // For each trajectory, the index of the series of |series_| in the
+    // |series_| of the trajectory, and the |series_generation_| of the
+    // trajectory when that index was determined.  The batch holds pointers to
+    // the series of the trajectories, so it may only be reused if neither
+    // changed.
+    std::vector<int> series_indices_;
+    std::vector<std::int64_t> series_generations_;
+    numerics::ЧебышёвSeriesBatch<Displacement<Frame>> series_;
+    // Scratch storage for the values of the |series_|.
+    std::vector<Displacement<Frame>> displacements_;
     friend class ContinuousTrajectory<Frame>;
   };
 
@@ -145,6 +262,51 @@ class ContinuousTrajectory {
   ContinuousTrajectory();
 
  private:
+  // An immutable view of the series of a trajectory.
+  struct Snapshot {
+    bool empty() const;
+    std::int64_t size() const;
+    ЧебышёвSeries<Displacement<Frame>> const& operator[](
+        std::int64_t const index) const;
+    ЧебышёвSeries<Displacement<Frame>> const& front() const;
+    ЧебышёвSeries<Displacement<Frame>> const& back() const;
+
+    // The series are [begin, end[, in increasing time order.  Their intervals
+    // are consecutive.  The |storage| is only ever appended to, without
+    // reallocation, by the thread that owns the trajectory: a snapshot remains
+    // valid while series are appended after |end|.
+    std::shared_ptr<std::vector<ЧебышёвSeries<Displacement<Frame>>>> storage;
+    ЧебышёвSeries<Displacement<Frame>> const* begin = nullptr;
+    ЧебышёвSeries<Displacement<Frame>> const* end = nullptr;
+    // Set if some of the series were read from a precomputed file, in which
+    // case their coefficients are in this file.
+    std::shared_ptr<MappedFile const> mapped_file;
+    // The time at which the trajectory starts.  Set for a nonempty snapshot.
+    // |*first_time >= front().t_min()|
+    std::experimental::optional<Instant> first_time;
+    // Incremented by each publication, which may change the series at a given
+    // index.
+    std::int64_t generation = 0;
+  };
+
+  // Acquires the current snapshot of a trajectory for the lifetime of this
+  // object, see |AcquireSnapshot|.
+  class SnapshotReader {
+   public:
+    explicit SnapshotReader(ContinuousTrajectory const& trajectory);
+    ~SnapshotReader();
+
+    SnapshotReader(SnapshotReader const&) = delete;
+    SnapshotReader& operator=(SnapshotReader const&) = delete;
+
+    Snapshot const& operator*() const;
+    Snapshot const* operator->() const;
+
+   private:
+    ContinuousTrajectory const& trajectory_;
+    Snapshot const* snapshot_;
+  };
+
   // Computes the best Newhall approximation based on the desired tolerance.
   // Adjust the |degree_| and other member variables to stay within the
   // tolerance while minimizing the computational cost and avoiding numerical
@@ -160,15 +322,45 @@ class ContinuousTrajectory {
           Instant const& t_min,
           Instant const& t_max));
 
-  // Returns an iterator to the series applicable for the given |time|, or
-  // |begin()| if |time| is before the first series or |end()| if |time| is
-  // after the last series.  Time complexity is O(N Log N).
-  typename std::vector<ЧебышёвSeries<Displacement<Frame>>>::const_iterator
-  FindSeriesForInstant(Instant const& time) const;
+  // Serializes everything but the series.
+  void WriteToMessageWithoutSeries(
+      not_null<serialization::ContinuousTrajectory*> const message,
+      Checkpoint const& checkpoint) const;
+
+  // Returns a pointer to the series of |snapshot| applicable for the given
+  // |time|, or |snapshot.begin| if |time| is before the first series or
+  // |snapshot.end| if |time| is after the last series.  Time complexity is
+  // O(1), except in degenerate cases where it falls back to O(Log N).
+  ЧебышёвSeries<Displacement<Frame>> const* FindSeriesForInstant(
+      Snapshot const& snapshot,
+      Instant const& time) const;
 
   // Returns true if the given |hint| is usable for the given |time|.  If it is,
-  // |hint->index| is the index of the series to use.
-  bool MayUseHint(Instant const& time, Hint* const hint) const;
+  // |index| is the index of the series of |snapshot| to use.  The |hint| is
+  // read only once, so the result is consistent even if another thread updates
+  // it.
+  static bool MayUseHint(Snapshot const& snapshot,
+                         Instant const& time,
+                         Hint* const hint,
+                         int& index);
+
+  // Returns the current snapshot, which is not deleted until the matching call
+  // to |ReleaseSnapshot|.  May be called on any thread, never blocks.
+  Snapshot const* AcquireSnapshot() const;
+  void ReleaseSnapshot() const;
+
+  // The current snapshot.  Must only be called on the thread that owns this
+  // trajectory, which is the only one that replaces the snapshot.
+  Snapshot const& current_snapshot() const;
+
+  // Publishes a snapshot made of the series of the current snapshot from the
+  // one at index |first| onwards, followed by the |new_series|, with the
+  // |first_time_| and |mapped_file_| of this object.  The coefficients of the
+  // |new_series| must be in |arena_| or in |mapped_file_|.  Must only be
+  // called on the thread that owns this trajectory.
+  void PublishSnapshot(
+      std::int64_t const first,
+      std::vector<ЧебышёвSeries<Displacement<Frame>>>&& new_series);
 
   // Construction parameters;
   Time const step_;
@@ -184,16 +376,31 @@ class ContinuousTrajectory {
   int degree_;
   int degree_age_;
 
-  // The series are in increasing time order.  Their intervals are consecutive.
-  std::vector<ЧебышёвSeries<Displacement<Frame>>> series_;
+  // The storage for the coefficients of the series.  They are allocated in
+  // large chunks rather than individually, which makes evaluation more
+  // cache-friendly and avoids fragmenting the heap.  The chunks are never
+  // moved, and new coefficients are written after those of the published
+  // series, so they may be allocated during an evaluation.
+  numerics::ЧебышёвSeriesArena arena_;
 
-  // The time at which this trajectory starts.  Set for a nonempty trajectory.
-  // |*first_time_ >= series_.front().t_min()|
+  // The values of the corresponding members of the next snapshot.  The
+  // coefficients of the series are in |arena_| or in |mapped_file_|.
+  std::shared_ptr<MappedFile const> mapped_file_;
   std::experimental::optional<Instant> first_time_;
 
+  // The current snapshot, and the number of evaluations that may be using a
+  // snapshot.
+  std::atomic<Snapshot const*> snapshot_;
+  mutable std::atomic<int> readers_;
+  // The snapshots that were published.  The last one is the current snapshot;
+  // the others are retired and deleted at the next publication that happens
+  // while no evaluation is in progress.  Only accessed by the thread that owns
+  // this trajectory.
+  std::vector<std::unique_ptr<Snapshot const>> snapshots_;
+
   // The points that have not yet been incorporated in a series.  Nonempty for a
   // nonempty trajectory.
-  // |last_points_.begin()->first == series_.back().t_max()|
+  // |last_points_.begin()->first == current_snapshot().back().t_max()|
   std::vector<std::pair<Instant, DegreesOfFreedom<Frame>>> last_points_;
 
   friend class ContinuousTrajectoryTest;
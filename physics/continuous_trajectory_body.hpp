@@ -2,8 +2,12 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iterator>
 #include <limits>
 #include <sstream>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -18,6 +22,7 @@ namespace physics {
 namespace internal_continuous_trajectory {
 
 using base::Error;
+using geometry::R3Element;
 using quantities::DebugString;
 using quantities::si::Metre;
 using quantities::si::Second;
@@ -30,6 +35,25 @@ int const max_degree_age = 100;
 // Only supports 8 divisions for now.
 int const divisions = 8;
 
+// The initial capacity of the storage of the series.  It is doubled whenever
+// the storage is full.
+std::int64_t const min_series_capacity = 16;
+
+// The layout of precomputed files, see |WriteToPrecomputedFile|.
+struct PrecomputedTrajectoryHeader {
+  std::int64_t number_of_series;
+  std::int64_t stride;
+};
+struct PrecomputedSeriesHeader {
+  double t_min;
+  double t_max;
+  std::int64_t degree;
+};
+static_assert(sizeof(PrecomputedTrajectoryHeader) == 16 &&
+                  sizeof(PrecomputedSeriesHeader) == 24 &&
+                  sizeof(R3Element<double>) == 24,
+              "Unexpected padding in precomputed files");
+
 template<typename Frame>
 ContinuousTrajectory<Frame>::ContinuousTrajectory(Time const& step,
                                                   Length const& tolerance)
@@ -38,44 +62,58 @@ ContinuousTrajectory<Frame>::ContinuousTrajectory(Time const& step,
       adjusted_tolerance_(tolerance_),
       is_unstable_(false),
       degree_(min_degree),
-      degree_age_(0) {
+      degree_age_(0),
+      snapshot_(nullptr),
+      readers_(0) {
   CHECK_LT(0 * Metre, tolerance_);
+  PublishSnapshot(/*first=*/0, /*new_series=*/{});
 }
 
 template<typename Frame>
 bool ContinuousTrajectory<Frame>::empty() const {
-  return series_.empty();
+  SnapshotReader const snapshot(*this);
+  return snapshot->empty();
 }
 
 template<typename Frame>
 Instant ContinuousTrajectory<Frame>::t_min() const {
-  if (empty()) {
+  SnapshotReader const snapshot(*this);
+  if (snapshot->empty()) {
     return astronomy::InfiniteFuture;
   }
-  return *first_time_;
+  return *snapshot->first_time;
 }
 
 template<typename Frame>
 Instant ContinuousTrajectory<Frame>::t_max() const {
-  if (empty()) {
+  SnapshotReader const snapshot(*this);
+  if (snapshot->empty()) {
     return astronomy::InfinitePast;
   }
-  return series_.back().t_max();
+  return snapshot->back().t_max();
 }
 
 template<typename Frame>
 double ContinuousTrajectory<Frame>::average_degree() const {
-  if (empty()) {
+  Snapshot const& snapshot = current_snapshot();
+  if (snapshot.empty()) {
     return 0;
   } else {
     double total = 0;
-    for (auto const& series : series_) {
-      total += series.degree();
+    for (auto it = snapshot.begin; it != snapshot.end; ++it) {
+      total += it->degree();
     }
-    return total / series_.size();
+    return total / snapshot.size();
   }
 }
 
+template<typename Frame>
+std::int64_t ContinuousTrajectory<Frame>::series_bytes() const {
+  return current_snapshot().storage->capacity() *
+             sizeof(ЧебышёвSeries<Displacement<Frame>>) +
+         arena_.allocated_bytes();
+}
+
 template<typename Frame>
 Status ContinuousTrajectory<Frame>::Append(
     Instant const& time,
@@ -94,10 +132,11 @@ Status ContinuousTrajectory<Frame>::Append(
 
   Status status;
   if (last_points_.size() == divisions) {
-    // These vectors are static to avoid deallocation/reallocation each time we
-    // go through this code path.
-    static std::vector<Displacement<Frame>> q(divisions + 1);
-    static std::vector<Velocity<Frame>> v(divisions + 1);
+    // These vectors are thread-local to avoid deallocation/reallocation each
+    // time we go through this code path, while letting distinct trajectories
+    // be appended to on distinct threads.
+    thread_local std::vector<Displacement<Frame>> q(divisions + 1);
+    thread_local std::vector<Velocity<Frame>> v(divisions + 1);
     q.clear();
     v.clear();
 
@@ -131,31 +170,93 @@ void ContinuousTrajectory<Frame>::ForgetBefore(Instant const& time) {
     // |FindSeriesForInstant|.
     return;
   }
-  series_.erase(series_.begin(), FindSeriesForInstant(time));
-
-  // If there are no |series_| left, clear everything.  Otherwise, update the
-  // first time.
-  if (series_.empty()) {
+  Snapshot const& snapshot = current_snapshot();
+  std::int64_t const first =
+      FindSeriesForInstant(snapshot, time) - snapshot.begin;
+
+  // If there are no series left, clear everything.  Otherwise, update the
+  // first time.  The series are released after the publication, but a
+  // concurrent evaluation may still use the previous snapshot: only the
+  // coefficients of the forgotten series are released, and evaluating them
+  // is an error anyway.
+  if (first == snapshot.size()) {
+    mapped_file_.reset();
     first_time_ = std::experimental::nullopt;
     last_points_.clear();
+    PublishSnapshot(first, /*new_series=*/{});
+    arena_ = numerics::ЧебышёвSeriesArena();
   } else {
     first_time_ = time;
+    PublishSnapshot(first, /*new_series=*/{});
+    arena_.ReleaseBefore(current_snapshot().front());
   }
 }
 
+template<typename Frame>
+not_null<std::unique_ptr<ContinuousTrajectory<Frame>>>
+ContinuousTrajectory<Frame>::MakeStaging() const {
+  not_null<std::unique_ptr<ContinuousTrajectory<Frame>>> staging =
+      std::make_unique<ContinuousTrajectory<Frame>>(step_, tolerance_);
+  staging->adjusted_tolerance_ = adjusted_tolerance_;
+  staging->is_unstable_ = is_unstable_;
+  staging->degree_ = degree_;
+  staging->degree_age_ = degree_age_;
+  staging->first_time_ = first_time_;
+  staging->last_points_ = last_points_;
+  return staging;
+}
+
+template<typename Frame>
+void ContinuousTrajectory<Frame>::Publish(
+    not_null<ContinuousTrajectory*> const staging) {
+  CHECK_EQ(step_, staging->step_);
+  CHECK_EQ(tolerance_, staging->tolerance_);
+  Snapshot const& snapshot = current_snapshot();
+  Snapshot const& staging_snapshot = staging->current_snapshot();
+  CHECK(staging_snapshot.empty() || snapshot.empty() ||
+        staging_snapshot.front().t_min() == snapshot.back().t_max())
+      << "Staging trajectory does not continue this trajectory";
+
+  // The coefficients are copied to our |arena_|, after those of the published
+  // series, so the staging series may be released.
+  std::vector<ЧебышёвSeries<Displacement<Frame>>> new_series;
+  for (auto it = staging_snapshot.begin; it != staging_snapshot.end; ++it) {
+    new_series.push_back(it->View());
+    new_series.back().MoveCoefficientsTo(&arena_);
+  }
+
+  adjusted_tolerance_ = staging->adjusted_tolerance_;
+  is_unstable_ = staging->is_unstable_;
+  degree_ = staging->degree_;
+  degree_age_ = staging->degree_age_;
+  if (!first_time_) {
+    first_time_ = staging->first_time_;
+  }
+  last_points_ = staging->last_points_;
+  PublishSnapshot(/*first=*/0, std::move(new_series));
+
+  // Nothing evaluates the |staging| trajectory.
+  staging->PublishSnapshot(/*first=*/staging_snapshot.size(),
+                           /*new_series=*/{});
+  staging->arena_ = numerics::ЧебышёвSeriesArena();
+}
+
 template<typename Frame>
 Position<Frame> ContinuousTrajectory<Frame>::EvaluatePosition(
     Instant const& time,
     Hint* const hint) const {
-  CHECK_LE(t_min(), time);
-  CHECK_GE(t_max(), time);
-  if (MayUseHint(time, hint)) {
-    return series_[hint->index_].Evaluate(time) + Frame::origin;
+  SnapshotReader const snapshot(*this);
+  CHECK(!snapshot->empty());
+  CHECK_LE(*snapshot->first_time, time);
+  CHECK_GE(snapshot->back().t_max(), time);
+  int index;
+  if (MayUseHint(*snapshot, time, hint, index)) {
+    return (*snapshot)[index].Evaluate(time) + Frame::origin;
   } else {
-    auto const it = FindSeriesForInstant(time);
-    CHECK(it != series_.end());
+    auto const it = FindSeriesForInstant(*snapshot, time);
+    CHECK(it != snapshot->end);
     if (hint != nullptr) {
-      hint->index_ = it - series_.cbegin();
+      hint->index_.store(it - snapshot->begin, std::memory_order_relaxed);
     }
     return it->Evaluate(time) + Frame::origin;
   }
@@ -165,15 +266,18 @@ template<typename Frame>
 Velocity<Frame> ContinuousTrajectory<Frame>::EvaluateVelocity(
     Instant const& time,
     Hint* const hint) const {
-  CHECK_LE(t_min(), time);
-  CHECK_GE(t_max(), time);
-  if (MayUseHint(time, hint)) {
-    return series_[hint->index_].EvaluateDerivative(time);
+  SnapshotReader const snapshot(*this);
+  CHECK(!snapshot->empty());
+  CHECK_LE(*snapshot->first_time, time);
+  CHECK_GE(snapshot->back().t_max(), time);
+  int index;
+  if (MayUseHint(*snapshot, time, hint, index)) {
+    return (*snapshot)[index].EvaluateDerivative(time);
   } else {
-    auto const it = FindSeriesForInstant(time);
-    CHECK(it != series_.end());
+    auto const it = FindSeriesForInstant(*snapshot, time);
+    CHECK(it != snapshot->end);
     if (hint != nullptr) {
-      hint->index_ = it - series_.cbegin();
+      hint->index_.store(it - snapshot->begin, std::memory_order_relaxed);
     }
     return it->EvaluateDerivative(time);
   }
@@ -183,23 +287,110 @@ template<typename Frame>
 DegreesOfFreedom<Frame> ContinuousTrajectory<Frame>::EvaluateDegreesOfFreedom(
     Instant const& time,
     Hint* const hint) const {
-  CHECK_LE(t_min(), time);
-  CHECK_GE(t_max(), time);
-  if (MayUseHint(time, hint)) {
-    ЧебышёвSeries<Displacement<Frame>> const& series = series_[hint->index_];
+  SnapshotReader const snapshot(*this);
+  CHECK(!snapshot->empty());
+  CHECK_LE(*snapshot->first_time, time);
+  CHECK_GE(snapshot->back().t_max(), time);
+  int index;
+  if (MayUseHint(*snapshot, time, hint, index)) {
+    ЧебышёвSeries<Displacement<Frame>> const& series = (*snapshot)[index];
     return DegreesOfFreedom<Frame>(series.Evaluate(time) + Frame::origin,
                                    series.EvaluateDerivative(time));
   } else {
-    auto const it = FindSeriesForInstant(time);
-    CHECK(it != series_.end());
+    auto const it = FindSeriesForInstant(*snapshot, time);
+    CHECK(it != snapshot->end);
     if (hint != nullptr) {
-      hint->index_ = it - series_.cbegin();
+      hint->index_.store(it - snapshot->begin, std::memory_order_relaxed);
     }
     return DegreesOfFreedom<Frame>(it->Evaluate(time) + Frame::origin,
                                    it->EvaluateDerivative(time));
   }
 }
 
+template<typename Frame>
+void ContinuousTrajectory<Frame>::EvaluatePositions(
+    std::vector<not_null<ContinuousTrajectory const*>> const& trajectories,
+    Instant const& time,
+    not_null<BatchHint*> const hint,
+    std::vector<Position<Frame>>& positions) {
+  std::vector<Hint>& hints = hint->hints_;
+  std::vector<int>& series_indices = hint->series_indices_;
+  std::vector<std::int64_t>& series_generations = hint->series_generations_;
+  if (hints.size() != trajectories.size()) {
+    hints.assign(trajectories.size(), Hint());
+    series_indices.clear();
+    series_generations.clear();
+  }
+
+  // Find the series to use for each trajectory.  Only if one of them changed,
+  // or if the snapshot of one of the trajectories changed, do we need to reset
+  // the batch.  The snapshots are held until the end of the evaluation.
+  std::vector<Snapshot const*> snapshots;
+  std::vector<not_null<ЧебышёвSeries<Displacement<Frame>> const*>> series;
+  std::vector<int> indices;
+  snapshots.reserve(trajectories.size());
+  series.reserve(trajectories.size());
+  indices.reserve(trajectories.size());
+  bool series_changed = series_indices.size() != trajectories.size();
+  for (std::size_t i = 0; i < trajectories.size(); ++i) {
+    ContinuousTrajectory const& trajectory = *trajectories[i];
+    snapshots.push_back(trajectory.AcquireSnapshot());
+    Snapshot const& snapshot = *snapshots.back();
+    CHECK(!snapshot.empty());
+    CHECK_LE(*snapshot.first_time, time);
+    CHECK_GE(snapshot.back().t_max(), time);
+    int index;
+    if (!MayUseHint(snapshot, time, &hints[i], index)) {
+      auto const it = trajectory.FindSeriesForInstant(snapshot, time);
+      CHECK(it != snapshot.end);
+      index = it - snapshot.begin;
+      hints[i].index_.store(index, std::memory_order_relaxed);
+    }
+    series.push_back(&snapshot[index]);
+    indices.push_back(index);
+    series_changed =
+        series_changed ||
+        series_indices[i] != index ||
+        series_generations[i] != snapshot.generation;
+  }
+  std::vector<Displacement<Frame>>& displacements = hint->displacements_;
+  if (series_changed) {
+    bool const first_use = series_indices.empty();
+    series_indices = std::move(indices);
+    series_generations.clear();
+    for (auto const snapshot : snapshots) {
+      series_generations.push_back(snapshot->generation);
+    }
+    if (first_use) {
+      // Filling the batch costs about as much as evaluating the series, so
+      // don't do it for a hint that might be used only once.  The batch will be
+      // filled if the same series are used again.
+      displacements.clear();
+      for (auto const s : series) {
+        displacements.push_back(s->Evaluate(time));
+      }
+      hint->series_.Reset({});
+    } else {
+      hint->series_.Reset(series);
+      hint->series_.Evaluate(time, displacements);
+    }
+  } else {
+    if (hint->series_.size() != series.size()) {
+      hint->series_.Reset(series);
+    }
+    hint->series_.Evaluate(time, displacements);
+  }
+  for (std::size_t i = 0; i < trajectories.size(); ++i) {
+    trajectories[i]->ReleaseSnapshot();
+  }
+
+  positions.clear();
+  positions.reserve(displacements.size());
+  for (auto const& displacement : displacements) {
+    positions.push_back(displacement + Frame::origin);
+  }
+}
+
 template<typename Frame>
 typename ContinuousTrajectory<Frame>::Checkpoint
 ContinuousTrajectory<Frame>::GetCheckpoint() const {
@@ -221,16 +412,20 @@ template<typename Frame>
 void ContinuousTrajectory<Frame>::WriteToMessage(
       not_null<serialization::ContinuousTrajectory*> const message,
       Checkpoint const& checkpoint) const {
+  WriteToMessage(message, checkpoint, astronomy::InfinitePast);
+}
+
+template<typename Frame>
+void ContinuousTrajectory<Frame>::WriteToMessage(
+      not_null<serialization::ContinuousTrajectory*> const message,
+      Checkpoint const& checkpoint,
+      Instant const& after) const {
   LOG(INFO) << __FUNCTION__;
-  step_.WriteToMessage(message->mutable_step());
-  tolerance_.WriteToMessage(message->mutable_tolerance());
-  checkpoint.adjusted_tolerance_.WriteToMessage(
-      message->mutable_adjusted_tolerance());
-  message->set_is_unstable(checkpoint.is_unstable_);
-  message->set_degree(checkpoint.degree_);
-  message->set_degree_age(checkpoint.degree_age_);
-  for (auto const& s : series_) {
-    if (s.t_max() <= checkpoint.t_max_) {
+  WriteToMessageWithoutSeries(message, checkpoint);
+  Snapshot const& snapshot = current_snapshot();
+  for (auto it = snapshot.begin; it != snapshot.end; ++it) {
+    auto const& s = *it;
+    if (after < s.t_max() && s.t_max() <= checkpoint.t_max_) {
       s.WriteToMessage(message->add_series());
     }
     if (s.t_max() == checkpoint.t_max_) {
@@ -238,19 +433,6 @@ void ContinuousTrajectory<Frame>::WriteToMessage(
     }
     CHECK_LT(s.t_max(), checkpoint.t_max_);
   }
-  if (first_time_) {
-    first_time_->WriteToMessage(message->mutable_first_time());
-  }
-  for (auto const& pair : checkpoint.last_points_) {
-    Instant const& instant = pair.first;
-    DegreesOfFreedom<Frame> const& degrees_of_freedom = pair.second;
-    not_null<
-        serialization::ContinuousTrajectory::InstantaneousDegreesOfFreedom*>
-        const instantaneous_degrees_of_freedom = message->add_last_point();
-    instant.WriteToMessage(instantaneous_degrees_of_freedom->mutable_instant());
-    degrees_of_freedom.WriteToMessage(
-        instantaneous_degrees_of_freedom->mutable_degrees_of_freedom());
-  }
   LOG(INFO) << NAMED(this);
   LOG(INFO) << NAMED(message->SpaceUsed());
   LOG(INFO) << NAMED(message->ByteSize());
@@ -269,14 +451,16 @@ ContinuousTrajectory<Frame>::ReadFromMessage(
   continuous_trajectory->is_unstable_ = message.is_unstable();
   continuous_trajectory->degree_ = message.degree();
   continuous_trajectory->degree_age_ = message.degree_age();
+  std::vector<ЧебышёвSeries<Displacement<Frame>>> series;
   for (auto const& s : message.series()) {
-    continuous_trajectory->series_.push_back(
-        ЧебышёвSeries<Displacement<Frame>>::ReadFromMessage(s));
+    series.push_back(ЧебышёвSeries<Displacement<Frame>>::ReadFromMessage(s));
+    series.back().MoveCoefficientsTo(&continuous_trajectory->arena_);
   }
   if (message.has_first_time()) {
     continuous_trajectory->first_time_ =
         Instant::ReadFromMessage(message.first_time());
   }
+  continuous_trajectory->PublishSnapshot(/*first=*/0, std::move(series));
   for (auto const& l : message.last_point()) {
     continuous_trajectory->last_points_.push_back(
         {Instant::ReadFromMessage(l.instant()),
@@ -285,10 +469,211 @@ ContinuousTrajectory<Frame>::ReadFromMessage(
   return continuous_trajectory;
 }
 
+template<typename Frame>
+void ContinuousTrajectory<Frame>::WriteToPrecomputedFile(
+    not_null<serialization::ContinuousTrajectory*> const message,
+    std::ostream& file) const {
+  WriteToMessageWithoutSeries(message, GetCheckpoint());
+  Snapshot const& snapshot = current_snapshot();
+
+  int stride = 0;
+  for (auto it = snapshot.begin; it != snapshot.end; ++it) {
+    stride = std::max(stride, it->degree() + 1);
+  }
+  PrecomputedTrajectoryHeader const trajectory_header{snapshot.size(), stride};
+  file.write(reinterpret_cast<char const*>(&trajectory_header),
+             sizeof(trajectory_header));
+
+  std::vector<R3Element<double>> coefficients(stride);
+  for (auto it = snapshot.begin; it != snapshot.end; ++it) {
+    auto const& s = *it;
+    PrecomputedSeriesHeader const series_header{
+        (s.t_min() - Instant()) / SIUnit<Time>(),
+        (s.t_max() - Instant()) / SIUnit<Time>(),
+        s.degree()};
+    file.write(reinterpret_cast<char const*>(&series_header),
+               sizeof(series_header));
+    std::fill(coefficients.begin(), coefficients.end(), R3Element<double>());
+    s.WriteCoefficients(coefficients.data());
+    file.write(reinterpret_cast<char const*>(coefficients.data()),
+               stride * sizeof(R3Element<double>));
+  }
+  CHECK(file.good());
+}
+
+template<typename Frame>
+StatusOr<std::int64_t>
+ContinuousTrajectory<Frame>::ReadSeriesFromPrecomputedFile(
+    std::shared_ptr<MappedFile const> const& file,
+    std::int64_t const offset) {
+  CHECK(current_snapshot().empty());
+  // All the sizes are compared as signed integers, and the comparisons are
+  // written so that a corrupted header cannot cause an overflow.
+  std::int64_t const file_size = file->size();
+  std::int64_t const trajectory_header_size =
+      sizeof(PrecomputedTrajectoryHeader);
+  std::int64_t const series_header_size = sizeof(PrecomputedSeriesHeader);
+  std::int64_t const coefficient_size = sizeof(R3Element<double>);
+  if (offset < 0 ||
+      offset % static_cast<std::int64_t>(sizeof(double)) != 0 ||
+      offset > file_size - trajectory_header_size) {
+    return Status(Error::DATA_LOSS,
+                  "No trajectory header at offset " + std::to_string(offset));
+  }
+  std::int64_t position = offset;
+  auto const& trajectory_header =
+      *reinterpret_cast<PrecomputedTrajectoryHeader const*>(file->data() +
+                                                            position);
+  position += trajectory_header_size;
+  if (trajectory_header.stride <= 0 ||
+      trajectory_header.stride > file_size / coefficient_size ||
+      trajectory_header.number_of_series < 0) {
+    return Status(Error::DATA_LOSS,
+                  "Invalid trajectory header at offset " +
+                      std::to_string(offset));
+  }
+  std::int64_t const series_size =
+      series_header_size + trajectory_header.stride * coefficient_size;
+  if (trajectory_header.number_of_series >
+          (file_size - position) / series_size) {
+    return Status(Error::DATA_LOSS,
+                  "Truncated series after offset " + std::to_string(offset));
+  }
+
+  std::vector<ЧебышёвSeries<Displacement<Frame>>> series;
+  series.reserve(trajectory_header.number_of_series);
+  for (std::int64_t i = 0;
+       i < trajectory_header.number_of_series;
+       ++i, position += series_size) {
+    auto const& series_header =
+        *reinterpret_cast<PrecomputedSeriesHeader const*>(file->data() +
+                                                          position);
+    Instant const t_min = Instant() + series_header.t_min * SIUnit<Time>();
+    Instant const t_max = Instant() + series_header.t_max * SIUnit<Time>();
+    // The negated comparisons reject NaNs.
+    if (series_header.degree < 0 ||
+        series_header.degree >= trajectory_header.stride ||
+        !(t_min < t_max) ||
+        (!series.empty() && series.back().t_max() != t_min)) {
+      return Status(Error::DATA_LOSS,
+                    "Invalid series at offset " + std::to_string(position));
+    }
+    series.push_back(ЧебышёвSeries<Displacement<Frame>>::ViewCoefficients(
+        reinterpret_cast<R3Element<double> const*>(file->data() + position +
+                                                   series_header_size),
+        series_header.degree,
+        t_min,
+        t_max));
+  }
+  mapped_file_ = file;
+  PublishSnapshot(/*first=*/0, std::move(series));
+  return position;
+}
+
+template<typename Frame>
+void ContinuousTrajectory<Frame>::WriteCheckpointToMessage(
+    Checkpoint const& checkpoint,
+    not_null<serialization::ContinuousTrajectory*> const message) const {
+  WriteToMessageWithoutSeries(message, checkpoint);
+}
+
+template<typename Frame>
+StatusOr<typename ContinuousTrajectory<Frame>::Checkpoint>
+ContinuousTrajectory<Frame>::ReadCheckpointFromMessage(
+    serialization::ContinuousTrajectory const& message) const {
+  std::vector<std::pair<Instant, DegreesOfFreedom<Frame>>> last_points;
+  for (auto const& l : message.last_point()) {
+    last_points.push_back(
+        {Instant::ReadFromMessage(l.instant()),
+         DegreesOfFreedom<Frame>::ReadFromMessage(l.degrees_of_freedom())});
+  }
+  if (last_points.empty()) {
+    return Status(Error::DATA_LOSS, "Checkpoint without points");
+  }
+  // A checkpoint is taken at the end of a series, which is where its last
+  // points start, see |last_points_|.
+  Instant const& t_max = last_points.front().first;
+  Snapshot const& snapshot = current_snapshot();
+  auto const it = FindSeriesForInstant(snapshot, t_max);
+  if (it == snapshot.end || it->t_max() != t_max) {
+    return Status(Error::DATA_LOSS, "Checkpoint not at the end of a series");
+  }
+  return Checkpoint(t_max,
+                    Length::ReadFromMessage(message.adjusted_tolerance()),
+                    message.is_unstable(),
+                    message.degree(),
+                    message.degree_age(),
+                    last_points);
+}
+
 template<typename Frame>
 ContinuousTrajectory<Frame>::Hint::Hint()
     : index_(std::numeric_limits<int>::max()) {}
 
+template<typename Frame>
+ContinuousTrajectory<Frame>::Hint::Hint(Hint const& other)
+    : index_(other.index_.load(std::memory_order_relaxed)) {}
+
+template<typename Frame>
+typename ContinuousTrajectory<Frame>::Hint&
+ContinuousTrajectory<Frame>::Hint::operator=(Hint const& other) {
+  index_.store(other.index_.load(std::memory_order_relaxed),
+               std::memory_order_relaxed);
+  return *this;
+}
+
+template<typename Frame>
+bool ContinuousTrajectory<Frame>::Snapshot::empty() const {
+  return begin == end;
+}
+
+template<typename Frame>
+std::int64_t ContinuousTrajectory<Frame>::Snapshot::size() const {
+  return end - begin;
+}
+
+template<typename Frame>
+ЧебышёвSeries<Displacement<Frame>> const&
+ContinuousTrajectory<Frame>::Snapshot::operator[](
+    std::int64_t const index) const {
+  return begin[index];
+}
+
+template<typename Frame>
+ЧебышёвSeries<Displacement<Frame>> const&
+ContinuousTrajectory<Frame>::Snapshot::front() const {
+  return *begin;
+}
+
+template<typename Frame>
+ЧебышёвSeries<Displacement<Frame>> const&
+ContinuousTrajectory<Frame>::Snapshot::back() const {
+  return *(end - 1);
+}
+
+template<typename Frame>
+ContinuousTrajectory<Frame>::SnapshotReader::SnapshotReader(
+    ContinuousTrajectory const& trajectory)
+    : trajectory_(trajectory),
+      snapshot_(trajectory.AcquireSnapshot()) {}
+
+template<typename Frame>
+ContinuousTrajectory<Frame>::SnapshotReader::~SnapshotReader() {
+  trajectory_.ReleaseSnapshot();
+}
+
+template<typename Frame>
+typename ContinuousTrajectory<Frame>::Snapshot const&
+ContinuousTrajectory<Frame>::SnapshotReader::operator*() const {
+  return *snapshot_;
+}
+
+template<typename Frame>
+typename ContinuousTrajectory<Frame>::Snapshot const*
+ContinuousTrajectory<Frame>::SnapshotReader::operator->() const {
+  return snapshot_;
+}
+
 template<typename Frame>
 ContinuousTrajectory<Frame>::Checkpoint::Checkpoint(
     Instant const& t_max,
@@ -305,7 +690,11 @@ ContinuousTrajectory<Frame>::Checkpoint::Checkpoint(
       last_points_(last_points) {}
 
 template<typename Frame>
-ContinuousTrajectory<Frame>::ContinuousTrajectory() {}
+ContinuousTrajectory<Frame>::ContinuousTrajectory()
+    : snapshot_(nullptr),
+      readers_(0) {
+  PublishSnapshot(/*first=*/0, /*new_series=*/{});
+}
 
 template<typename Frame>
 Status ContinuousTrajectory<Frame>::ComputeBestNewhallApproximation(
@@ -331,13 +720,14 @@ Status ContinuousTrajectory<Frame>::ComputeBestNewhallApproximation(
     degree_age_ = 0;
   }
 
-  // Compute the approximation with the current degree.
-  series_.push_back(
-      newhall_approximation(degree_, q, v, last_points_.cbegin()->first, time));
+  // Compute the approximation with the current degree.  It is only published
+  // once its degree has been chosen.
+  ЧебышёвSeries<Displacement<Frame>> series =
+      newhall_approximation(degree_, q, v, last_points_.cbegin()->first, time);
 
   // Estimate the error.  For initializing |previous_error_estimate|, any value
   // greater than |error_estimate| will do.
-  Length error_estimate = series_.back().last_coefficient().Norm();
+  Length error_estimate = series.last_coefficient().Norm();
   Length previous_error_estimate = error_estimate + error_estimate;
 
   // If we are in the zone of numerical instabilities and we exceeded the
@@ -365,11 +755,10 @@ Status ContinuousTrajectory<Frame>::ComputeBestNewhallApproximation(
     ++degree_;
     VLOG(1) << "Increasing degree for " << this << " to " <<degree_
             << " because error estimate was " << error_estimate;
-    series_.back() =
-        newhall_approximation(
-            degree_, q, v, last_points_.cbegin()->first, time);
+    series = newhall_approximation(
+                 degree_, q, v, last_points_.cbegin()->first, time);
     previous_error_estimate = error_estimate;
-    error_estimate = series_.back().last_coefficient().Norm();
+    error_estimate = series.last_coefficient().Norm();
   }
 
   // If we have entered the zone of numerical instability, go back to the
@@ -391,6 +780,10 @@ Status ContinuousTrajectory<Frame>::ComputeBestNewhallApproximation(
   }
 
   ++degree_age_;
+  series.MoveCoefficientsTo(&arena_);
+  std::vector<ЧебышёвSeries<Displacement<Frame>>> new_series;
+  new_series.push_back(std::move(series));
+  PublishSnapshot(/*first=*/0, std::move(new_series));
 
   // Check that the tolerance did not explode.
   if (adjusted_tolerance_ < 1e6 * previous_adjusted_tolerance) {
@@ -409,13 +802,66 @@ Status ContinuousTrajectory<Frame>::ComputeBestNewhallApproximation(
 }
 
 template<typename Frame>
-typename std::vector<ЧебышёвSeries<Displacement<Frame>>>::const_iterator
-ContinuousTrajectory<Frame>::FindSeriesForInstant(Instant const& time) const {
+void ContinuousTrajectory<Frame>::WriteToMessageWithoutSeries(
+      not_null<serialization::ContinuousTrajectory*> const message,
+      Checkpoint const& checkpoint) const {
+  step_.WriteToMessage(message->mutable_step());
+  tolerance_.WriteToMessage(message->mutable_tolerance());
+  checkpoint.adjusted_tolerance_.WriteToMessage(
+      message->mutable_adjusted_tolerance());
+  message->set_is_unstable(checkpoint.is_unstable_);
+  message->set_degree(checkpoint.degree_);
+  message->set_degree_age(checkpoint.degree_age_);
+  if (first_time_) {
+    first_time_->WriteToMessage(message->mutable_first_time());
+  }
+  for (auto const& pair : checkpoint.last_points_) {
+    Instant const& instant = pair.first;
+    DegreesOfFreedom<Frame> const& degrees_of_freedom = pair.second;
+    not_null<
+        serialization::ContinuousTrajectory::InstantaneousDegreesOfFreedom*>
+        const instantaneous_degrees_of_freedom = message->add_last_point();
+    instant.WriteToMessage(instantaneous_degrees_of_freedom->mutable_instant());
+    degrees_of_freedom.WriteToMessage(
+        instantaneous_degrees_of_freedom->mutable_degrees_of_freedom());
+  }
+}
+
+template<typename Frame>
+ЧебышёвSeries<Displacement<Frame>> const*
+ContinuousTrajectory<Frame>::FindSeriesForInstant(Snapshot const& snapshot,
+                                                  Instant const& time) const {
+  if (snapshot.empty() || time > snapshot.back().t_max()) {
+    return snapshot.end;
+  }
+
+  // All the series span |divisions * step_|, so the index of the series is
+  // normally obtained by a division.  Rounding may put us in a neighbouring
+  // series if |time| is close to a boundary, so we check the result and fall
+  // back to a binary search if it doesn't pan out.
+  if (time <= snapshot.front().t_max()) {
+    return snapshot.begin;
+  }
+  // Returns true if |time| is in the series at |index|, with the same
+  // convention as the |lower_bound| below.
+  auto const is_series_for_instant = [&snapshot, &time](int const index) {
+    return index >= 1 && index < snapshot.size() &&
+           snapshot[index - 1].t_max() < time &&
+           time <= snapshot[index].t_max();
+  };
+  int const index = static_cast<int>(
+      std::floor((time - snapshot.front().t_min()) / (divisions * step_)));
+  for (int const i : {index, index - 1, index + 1}) {
+    if (is_series_for_instant(i)) {
+      return snapshot.begin + i;
+    }
+  }
+
   // Need to use |lower_bound|, not |upper_bound|, because it allows
   // heterogeneous arguments.  This returns the first series |s| such that
   // |time <= s.t_max()|.
   auto const it = std::lower_bound(
-                      series_.begin(), series_.end(), time,
+                      snapshot.begin, snapshot.end, time,
                       [](ЧебышёвSeries<Displacement<Frame>> const& left,
                          Instant const& right) {
                         return left.t_max() < right;
@@ -424,19 +870,21 @@ ContinuousTrajectory<Frame>::FindSeriesForInstant(Instant const& time) const {
 }
 
 template<typename Frame>
-bool ContinuousTrajectory<Frame>::MayUseHint(Instant const& time,
-                                             Hint* const hint) const {
+bool ContinuousTrajectory<Frame>::MayUseHint(Snapshot const& snapshot,
+                                             Instant const& time,
+                                             Hint* const hint,
+                                             int& index) {
   if (hint != nullptr) {
-    // A shorthand for the index held by the |hint|.
-    int& index = hint->index_;
-    if (index < series_.size() && series_[index].t_min() <= time) {
-      if (time <= series_[index].t_max()) {
+    index = hint->index_.load(std::memory_order_relaxed);
+    if (index < snapshot.size() && snapshot[index].t_min() <= time) {
+      if (time <= snapshot[index].t_max()) {
         // Use this interval.
         return true;
-      } else if (index < series_.size() - 1 &&
-                 time <= series_[index + 1].t_max()) {
+      } else if (index < snapshot.size() - 1 &&
+                 time <= snapshot[index + 1].t_max()) {
         // Move to the next interval.
         ++index;
+        hint->index_.store(index, std::memory_order_relaxed);
         return true;
       }
     }
@@ -444,6 +892,85 @@ bool ContinuousTrajectory<Frame>::MayUseHint(Instant const& time,
   return false;
 }
 
+template<typename Frame>
+typename ContinuousTrajectory<Frame>::Snapshot const*
+ContinuousTrajectory<Frame>::AcquireSnapshot() const {
+  // The increment must be ordered before the load, and the store of the
+  // snapshot in |PublishSnapshot| before the load of |readers_|: either
+  // |PublishSnapshot| sees this reader, or this reader sees the new snapshot.
+  readers_.fetch_add(1, std::memory_order_seq_cst);
+  return snapshot_.load(std::memory_order_seq_cst);
+}
+
+template<typename Frame>
+void ContinuousTrajectory<Frame>::ReleaseSnapshot() const {
+  readers_.fetch_sub(1, std::memory_order_release);
+}
+
+template<typename Frame>
+typename ContinuousTrajectory<Frame>::Snapshot const&
+ContinuousTrajectory<Frame>::current_snapshot() const {
+  return *snapshots_.back();
+}
+
+template<typename Frame>
+void ContinuousTrajectory<Frame>::PublishSnapshot(
+    std::int64_t const first,
+    std::vector<ЧебышёвSeries<Displacement<Frame>>>&& new_series) {
+  auto snapshot = std::make_unique<Snapshot>();
+  if (snapshots_.empty()) {
+    CHECK_EQ(0, first);
+  } else {
+    Snapshot const& current = current_snapshot();
+    CHECK_LE(0, first);
+    CHECK_LE(first, current.size());
+    *snapshot = current;
+    snapshot->begin += first;
+    ++snapshot->generation;
+  }
+  snapshot->mapped_file = mapped_file_;
+  snapshot->first_time = first_time_;
+
+  auto& storage = snapshot->storage;
+  if (snapshot->begin == snapshot->end && new_series.empty()) {
+    storage.reset();
+    snapshot->begin = nullptr;
+    snapshot->end = nullptr;
+  } else if (!new_series.empty()) {
+    std::int64_t const size = snapshot->size() + new_series.size();
+    if (storage == nullptr ||
+        storage->size() + new_series.size() > storage->capacity()) {
+      // The storage of the current snapshot is kept alive by it, so it may
+      // still be evaluated.
+      auto new_storage =
+          std::make_shared<std::vector<ЧебышёвSeries<Displacement<Frame>>>>();
+      new_storage->reserve(std::max(min_series_capacity, 2 * size));
+      for (auto it = snapshot->begin; it != snapshot->end; ++it) {
+        new_storage->push_back(it->View());
+      }
+      storage = std::move(new_storage);
+      snapshot->begin = storage->data();
+      snapshot->end = storage->data() + storage->size();
+    }
+    CHECK(snapshot->end == storage->data() + storage->size());
+    // This doesn't reallocate the |storage| and only writes after the series
+    // of the current snapshot, so it doesn't affect its evaluation.
+    storage->insert(storage->end(),
+                    std::make_move_iterator(new_series.begin()),
+                    std::make_move_iterator(new_series.end()));
+    snapshot->end = storage->data() + storage->size();
+  }
+
+  Snapshot const* const published = snapshot.get();
+  snapshots_.push_back(std::move(snapshot));
+  snapshot_.store(published, std::memory_order_seq_cst);
+  // If no evaluation is in progress, any evaluation that starts from now on
+  // sees the new snapshot, so the retired ones may be deleted.
+  if (readers_.load(std::memory_order_seq_cst) == 0) {
+    snapshots_.erase(snapshots_.begin(), snapshots_.end() - 1);
+  }
+}
+
 }  // namespace internal_continuous_trajectory
 }  // namespace physics
 }  // namespace principia
@@ -1,9 +1,12 @@
 ﻿
 #include "physics/continuous_trajectory.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <deque>
 #include <functional>
 #include <limits>
+#include <thread>
 #include <vector>
 
 #include "geometry/frame.hpp"
@@ -99,6 +102,22 @@ class ContinuousTrajectoryTest : public testing::Test {
     return trajectory_->is_unstable_;
   }
 
+  // Checks that |FindSeriesForInstant| returns the same series as a binary
+  // search.
+  void CheckFindSeriesForInstant(Instant const& time) {
+    auto const& snapshot = trajectory_->current_snapshot();
+    auto const expected = std::lower_bound(
+        snapshot.begin, snapshot.end, time,
+        [](ЧебышёвSeries<Displacement<World>> const& left,
+           Instant const& right) {
+          return left.t_max() < right;
+        });
+    EXPECT_EQ(expected - snapshot.begin,
+              trajectory_->FindSeriesForInstant(snapshot, time) -
+                  snapshot.begin)
+        << time;
+  }
+
   void ResetBestNewhallApproximation() {
     trajectory_->degree_age_ = std::numeric_limits<int>::max();
   }
@@ -421,6 +440,222 @@ TEST_F(ContinuousTrajectoryTest, Continuity) {
   EXPECT_THAT(p1, AlmostEquals(p3, 0, 2));
 }
 
+TEST_F(ContinuousTrajectoryTest, FindSeriesForInstant) {
+  int const number_of_steps = 1000;
+  Length const distance = 1 * Kilo(Metre);
+  Time const period = 10 * Second;
+  Time const step = 10 * Milli(Second);
+  AngularFrequency const ω = 2 * π * Radian / period;
+
+  trajectory_ = std::make_unique<ContinuousTrajectory<World>>(
+                    step,
+                    /*tolerance=*/1 * Milli(Metre));
+  FillTrajectory(
+      number_of_steps,
+      step,
+      [this, distance, ω](Instant const t) {
+        Angle const angle = ω * (t - t0_);
+        return World::origin + Displacement<World>({distance * Cos(angle),
+                                                    distance * Sin(angle),
+                                                    0 * Metre});
+      },
+      [this, distance, ω](Instant const t) {
+        Angle const angle = ω * (t - t0_);
+        return Velocity<World>({-ω * distance * Sin(angle) / Radian,
+                                ω * distance * Cos(angle) / Radian,
+                                0 * Metre / Second});
+      },
+      t0_);
+
+  // Exactly at the boundaries of the series, in between, and outside of the
+  // trajectory.
+  for (int i = -2; i <= number_of_steps + 2; ++i) {
+    CheckFindSeriesForInstant(t0_ + i * step);
+    CheckFindSeriesForInstant(t0_ + (i + 1.0 / 3.0) * step);
+  }
+
+  // After |ForgetBefore| the first series starts before |t_min()|.
+  trajectory_->ForgetBefore(t0_ + 123.4 * step);
+  for (int i = -2; i <= number_of_steps + 2; ++i) {
+    CheckFindSeriesForInstant(t0_ + i * step);
+    CheckFindSeriesForInstant(t0_ + (i + 2.0 / 3.0) * step);
+  }
+}
+
+TEST_F(ContinuousTrajectoryTest, EvaluatePositions) {
+  int const number_of_steps = 1000;
+  Length const distance = 1 * Kilo(Metre);
+  Time const step = 10 * Milli(Second);
+
+  // Circular motions with different periods, which result in series of
+  // different degrees.
+  std::vector<std::unique_ptr<ContinuousTrajectory<World>>> trajectories;
+  std::vector<not_null<ContinuousTrajectory<World> const*>>
+      const_trajectories;
+  for (Time const period : {1 * Second, 10 * Second, 100 * Second}) {
+    trajectories.push_back(std::make_unique<ContinuousTrajectory<World>>(
+                               step,
+                               /*tolerance=*/1 * Milli(Metre)));
+    AngularFrequency const ω = 2 * π * Radian / period;
+    for (int i = 0; i < number_of_steps; ++i) {
+      Instant const ti = t0_ + (i + 1) * step;
+      Angle const angle = ω * (ti - t0_);
+      trajectories.back()->Append(
+          ti,
+          DegreesOfFreedom<World>(
+              World::origin + Displacement<World>({distance * Cos(angle),
+                                                   distance * Sin(angle),
+                                                   0 * Metre}),
+              Velocity<World>({-ω * distance * Sin(angle) / Radian,
+                               ω * distance * Cos(angle) / Radian,
+                               0 * Metre / Second})));
+    }
+    const_trajectories.push_back(trajectories.back().get());
+  }
+
+  ContinuousTrajectory<World>::BatchHint hint;
+  std::vector<ContinuousTrajectory<World>::Hint> expected_hints(
+      trajectories.size());
+  std::vector<Position<World>> positions;
+  for (Instant time = trajectories.front()->t_min();
+       time <= trajectories.front()->t_max();
+       time += step / 3) {
+    ContinuousTrajectory<World>::EvaluatePositions(
+        const_trajectories, time, &hint, positions);
+    ASSERT_EQ(trajectories.size(), positions.size());
+    for (int i = 0; i < trajectories.size(); ++i) {
+      EXPECT_EQ(trajectories[i]->EvaluatePosition(time, &expected_hints[i]),
+                positions[i]) << i;
+    }
+  }
+}
+
+// Checks that a |BatchHint| is not reused after the series of its trajectories
+// have been reallocated or shifted.
+TEST_F(ContinuousTrajectoryTest, EvaluatePositionsAfterModification) {
+  Length const distance = 1 * Kilo(Metre);
+  Time const step = 10 * Milli(Second);
+  AngularFrequency const ω = 2 * π * Radian / (1 * Second);
+  auto const degrees_of_freedom = [this, distance, ω](Instant const& t) {
+    Angle const angle = ω * (t - t0_);
+    return DegreesOfFreedom<World>(
+        World::origin + Displacement<World>({distance * Cos(angle),
+                                             distance * Sin(angle),
+                                             0 * Metre}),
+        Velocity<World>({-ω * distance * Sin(angle) / Radian,
+                         ω * distance * Cos(angle) / Radian,
+                         0 * Metre / Second}));
+  };
+
+  trajectory_ = std::make_unique<ContinuousTrajectory<World>>(
+                    step,
+                    /*tolerance=*/1 * Milli(Metre));
+  int i = 0;
+  auto const append = [this, &degrees_of_freedom, &i, step](int const steps) {
+    for (int const last = i + steps; i < last; ++i) {
+      Instant const ti = t0_ + (i + 1) * step;
+      trajectory_->Append(ti, degrees_of_freedom(ti));
+    }
+  };
+  append(100);
+
+  std::vector<not_null<ContinuousTrajectory<World> const*>> const
+      trajectories = {trajectory_.get()};
+  ContinuousTrajectory<World>::BatchHint hint;
+  std::vector<Position<World>> positions;
+  auto const check = [this, &hint, &positions, &trajectories](
+                         Instant const& t) {
+    ContinuousTrajectory<World>::EvaluatePositions(
+        trajectories, t, &hint, positions);
+    EXPECT_EQ(trajectory_->EvaluatePosition(t, /*hint=*/nullptr),
+              positions[0]);
+  };
+
+  // Fill the batch.
+  Instant const t = t0_ + 50.5 * step;
+  check(t);
+  check(t);
+
+  // This reallocates the series.
+  append(10000);
+  check(t);
+
+  // This shifts the series, so the index in the hint designates another one.
+  trajectory_->ForgetBefore(t0_ + 20.5 * step);
+  check(t);
+  check(t + 10 * step);
+}
+
+// Checks that the trajectory may be evaluated on another thread while series
+// are published and forgotten.
+TEST_F(ContinuousTrajectoryTest, ConcurrentEvaluation) {
+  Length const distance = 1 * Kilo(Metre);
+  Time const step = 10 * Milli(Second);
+  AngularFrequency const ω = 2 * π * Radian / (1 * Second);
+  auto const degrees_of_freedom = [this, distance, ω](Instant const& t) {
+    Angle const angle = ω * (t - t0_);
+    return DegreesOfFreedom<World>(
+        World::origin + Displacement<World>({distance * Cos(angle),
+                                             distance * Sin(angle),
+                                             0 * Metre}),
+        Velocity<World>({-ω * distance * Sin(angle) / Radian,
+                         ω * distance * Cos(angle) / Radian,
+                         0 * Metre / Second}));
+  };
+
+  trajectory_ = std::make_unique<ContinuousTrajectory<World>>(
+                    step,
+                    /*tolerance=*/1 * Milli(Metre));
+  for (int i = 0; i < 100; ++i) {
+    Instant const ti = t0_ + (i + 1) * step;
+    trajectory_->Append(ti, degrees_of_freedom(ti));
+  }
+  Instant const t = t0_ + 90.5 * step;
+  Position<World> const expected_position =
+      trajectory_->EvaluatePosition(t, /*hint=*/nullptr);
+
+  // The reader evaluates at a time that is never forgotten, and at the end of
+  // the trajectory.
+  std::atomic<bool> stop(false);
+  std::atomic<int> evaluations(0);
+  std::thread reader([this, &evaluations, &expected_position, &stop, t]() {
+    ContinuousTrajectory<World>::Hint hint;
+    Instant previous_t_max = trajectory_->t_max();
+    while (!stop) {
+      EXPECT_EQ(expected_position, trajectory_->EvaluatePosition(t, &hint));
+      Instant const t_max = trajectory_->t_max();
+      EXPECT_LE(previous_t_max, t_max);
+      trajectory_->EvaluateDegreesOfFreedom(t_max, /*hint=*/nullptr);
+      previous_t_max = t_max;
+      ++evaluations;
+    }
+  });
+
+  // Alternate between appending directly, publishing a staging trajectory and
+  // forgetting the beginning of the trajectory.
+  int i = 100;
+  for (int round = 0; round < 100; ++round) {
+    for (int const last = i + 40; i < last; ++i) {
+      Instant const ti = t0_ + (i + 1) * step;
+      trajectory_->Append(ti, degrees_of_freedom(ti));
+    }
+    auto const staging = trajectory_->MakeStaging();
+    for (int const last = i + 40; i < last; ++i) {
+      Instant const ti = t0_ + (i + 1) * step;
+      staging->Append(ti, degrees_of_freedom(ti));
+    }
+    trajectory_->Publish(staging.get());
+    trajectory_->ForgetBefore(t0_ + (round + 1) * 0.5 * step);
+  }
+  while (evaluations < 100) {
+    std::this_thread::yield();
+  }
+  stop = true;
+  reader.join();
+  EXPECT_EQ(t0_ + 50 * step, trajectory_->t_min());
+  EXPECT_LE(t0_ + (i - divisions) * step, trajectory_->t_max());
+}
+
 TEST_F(ContinuousTrajectoryTest, Serialization) {
   int const number_of_steps = 20;
   int const number_of_substeps = 50;
@@ -1,9 +1,10 @@
 ﻿
 #pragma once
 
+#include <cstdint>
+#include <experimental/optional>
 #include <functional>
 #include <list>
-#include <map>
 #include <memory>
 #include <vector>
 
@@ -12,6 +13,7 @@
 #include "geometry/named_quantities.hpp"
 #include "physics/degrees_of_freedom.hpp"
 #include "physics/forkable.hpp"
+#include "physics/timeline.hpp"
 #include "quantities/named_quantities.hpp"
 #include "serialization/physics.pb.h"
 
@@ -40,7 +42,7 @@ using internal_discrete_trajectory::DiscreteTrajectory;
 template<typename Frame>
 struct ForkableTraits<DiscreteTrajectory<Frame>> {
   using TimelineConstIterator =
-      typename std::map<Instant, DegreesOfFreedom<Frame>>::const_iterator;
+      typename Timeline<DegreesOfFreedom<Frame>>::const_iterator;
   static Instant const& time(TimelineConstIterator const it);
 };
 
@@ -66,7 +68,6 @@ using internal_forkable::DiscreteTrajectoryIterator;
 template <typename Frame>
 class DiscreteTrajectory : public Forkable<DiscreteTrajectory<Frame>,
                                            DiscreteTrajectoryIterator<Frame>> {
-  using Timeline = std::map<Instant, DegreesOfFreedom<Frame>>;
   using TimelineConstIterator = typename Forkable<
       DiscreteTrajectory<Frame>,
       DiscreteTrajectoryIterator<Frame>>::TimelineConstIterator;
@@ -118,6 +119,30 @@ class DiscreteTrajectory : public Forkable<DiscreteTrajectory<Frame>,
   void Append(Instant const& time,
               DegreesOfFreedom<Frame> const& degrees_of_freedom);
 
+  // Starts downsampling this trajectory, which must be a root.  Whenever
+  // |max_dense_intervals| intervals have been appended since the last
+  // downsampling, the points of these intervals are thinned out: a point is
+  // removed if the cubic Hermite interpolation between the retained points
+  // around it reproduces its position within |length_tolerance| and its
+  // velocity within |speed_tolerance|.  The fork points are always retained.
+  // The points present when this function is called are not downsampled.
+  // Each point goes through a single downsampling pass, so the cost of
+  // downsampling doesn't grow with the length of the trajectory.  Downsampling
+  // moves the points that follow the first removed point (see
+  // |Timeline::erase_if|): it invalidates all the iterators to these points,
+  // except the positions of the forks in this trajectory, which are relinked.
+  // The downsampling state is serialized with the trajectory.
+  void SetDownsampling(std::int64_t max_dense_intervals,
+                       Length const& length_tolerance,
+                       Speed const& speed_tolerance);
+  void ClearDownsampling();
+
+  // Returns the time of the last point of this trajectory that downsampling
+  // will not remove, i.e., of the last point that may not change as long as
+  // points are only appended to this trajectory.  This trajectory must be a
+  // nonempty root.
+  Instant last_stable_time() const;
+
   // Removes all data for times (strictly) greater than |time|, as well as all
   // child trajectories forked at times (strictly) greater than |time|.  |time|
   // must be at or after the fork time, if any.
@@ -135,6 +160,12 @@ class DiscreteTrajectory : public Forkable<DiscreteTrajectory<Frame>,
       not_null<serialization::DiscreteTrajectory*> const message,
       std::vector<DiscreteTrajectory<Frame>*> const& forks)
       const;
+  // Same as above, except that only the points of this trajectory (strictly)
+  // after |after| are serialized.  The forks are serialized in full.
+  void WriteToMessage(
+      not_null<serialization::DiscreteTrajectory*> const message,
+      std::vector<DiscreteTrajectory<Frame>*> const& forks,
+      Instant const& after) const;
 
   // |forks| must have a size appropriate for the |message| being deserialized
   // and the orders of the |forks| must be consistent during serialization and
@@ -144,6 +175,17 @@ class DiscreteTrajectory : public Forkable<DiscreteTrajectory<Frame>,
       serialization::DiscreteTrajectory const& message,
       std::vector<DiscreteTrajectory<Frame>**> const& forks);
 
+  // Appends the points of |message| to this trajectory, which must be a root,
+  // and reads its forks.  The points of |message| must be after those of this
+  // trajectory; typically |message| was written by |WriteToMessage| with an
+  // |after| time that is the time of the last point of this trajectory.  The
+  // requirements on |forks| are the same as for |ReadFromMessage|.  The points
+  // of |message| are not downsampled, and the downsampling state of this
+  // trajectory is replaced by that of |message|.
+  void AppendFromMessage(
+      serialization::DiscreteTrajectory const& message,
+      std::vector<DiscreteTrajectory<Frame>**> const& forks);
+
  protected:
   // The API inherited from Forkable.
   not_null<DiscreteTrajectory*> that() override;
@@ -155,6 +197,7 @@ class DiscreteTrajectory : public Forkable<DiscreteTrajectory<Frame>,
   TimelineConstIterator timeline_lower_bound(
                             Instant const& time) const override;
   bool timeline_empty() const override;
+  void timeline_clear(std::int64_t retained_capacity) override;
 
  private:
   // This trajectory need not be a root.
@@ -166,7 +209,44 @@ class DiscreteTrajectory : public Forkable<DiscreteTrajectory<Frame>,
       serialization::DiscreteTrajectory const& message,
       std::vector<DiscreteTrajectory<Frame>**> const& forks);
 
-  Timeline timeline_;
+  // The compact encoding of the timeline written by |WriteSubTreeToMessage|.
+  // Each point is stored as the differences between its time and coordinates
+  // and their predictions from the previous two points: a linear extrapolation
+  // for the time, a cubic Hermite extrapolation for the degrees of freedom.
+  // The predictions are a fixed sequence of IEEE 754 operations on the same
+  // inputs when reading and writing, so the encoding is exact.  Only the points
+  // from |first| onward are written.
+  void WritePackedTimelineToMessage(
+      TimelineConstIterator const first,
+      not_null<serialization::DiscreteTrajectory::PackedTimeline*> const
+          message) const;
+  void FillPackedTimelineFromMessage(
+      serialization::DiscreteTrajectory::PackedTimeline const& message);
+
+  struct Downsampling {
+    std::int64_t max_dense_intervals;
+    Length length_tolerance;
+    Speed speed_tolerance;
+    // The time of the first point of the part of the timeline that has not
+    // been downsampled yet, which we call the dense timeline.  Null if the
+    // timeline is empty.
+    std::experimental::optional<Instant> start_of_dense_timeline;
+    // The number of intervals in the dense timeline.
+    std::int64_t dense_intervals;
+  };
+
+  // Removes the points of the dense timeline that are not needed to
+  // reconstruct it within the tolerances, and starts a new dense timeline at
+  // the last point.
+  void Downsample();
+
+  void WriteDownsamplingToMessage(
+      not_null<serialization::DiscreteTrajectory::Downsampling*> message) const;
+  void FillDownsamplingFromMessage(
+      serialization::DiscreteTrajectory::Downsampling const& message);
+
+  Timeline<DegreesOfFreedom<Frame>> timeline_;
+  std::experimental::optional<Downsampling> downsampling_;
 
   template<typename, typename>
   friend class internal_forkable::ForkableIterator;
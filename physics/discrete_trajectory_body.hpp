@@ -4,12 +4,22 @@
 #include "physics/discrete_trajectory.hpp"
 
 #include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
 #include <list>
-#include <map>
+#include <utility>
 #include <vector>
 
+#include "astronomy/epoch.hpp"
 #include "geometry/named_quantities.hpp"
 #include "glog/logging.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "numerics/hermite3.hpp"
+#include "quantities/si.hpp"
 
 namespace principia {
 namespace physics {
@@ -51,7 +61,159 @@ DiscreteTrajectoryIterator<Frame>::that() const {
 namespace internal_discrete_trajectory {
 
 using base::make_not_null_unique;
+using geometry::Displacement;
 using geometry::Instant;
+using geometry::Position;
+using numerics::Hermite3;
+using quantities::si::Metre;
+using quantities::si::Second;
+
+// Returns an integer whose bits are those of |x|, except that the magnitude
+// bits of negative numbers are flipped, so that the order of the integers is
+// that of the doubles.  Thus, nearby doubles map to nearby integers, even on
+// either side of a power of 2.  This is an involution on the bits.
+inline std::int64_t OrderedBits(double const x) {
+  std::int64_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  return bits < 0 ? bits ^ std::numeric_limits<std::int64_t>::max() : bits;
+}
+
+inline double FromOrderedBits(std::int64_t const ordered_bits) {
+  std::int64_t const bits =
+      ordered_bits < 0
+          ? ordered_bits ^ std::numeric_limits<std::int64_t>::max()
+          : ordered_bits;
+  double x;
+  std::memcpy(&x, &bits, sizeof(x));
+  return x;
+}
+
+// The difference between the ordered bits of |actual| and those of
+// |prediction|, zigzagged so that small differences of either sign have a short
+// varint encoding.  The arithmetic is modulo 2^64, so this is exact.
+inline std::uint64_t PackedResidual(double const actual,
+                                    double const prediction) {
+  std::uint64_t const difference =
+      static_cast<std::uint64_t>(OrderedBits(actual)) -
+      static_cast<std::uint64_t>(OrderedBits(prediction));
+  return (difference << 1) ^ (0 - (difference >> 63));
+}
+
+inline double UnpackResidual(std::uint64_t const residual,
+                             double const prediction) {
+  std::uint64_t const difference = (residual >> 1) ^ (0 - (residual & 1));
+  return FromOrderedBits(static_cast<std::int64_t>(
+      static_cast<std::uint64_t>(OrderedBits(prediction)) + difference));
+}
+
+// The coordinates of the position and velocity of |degrees_of_freedom|, in SI
+// units.
+template<typename Frame>
+std::array<double, 6> PackedCoordinates(
+    DegreesOfFreedom<Frame> const& degrees_of_freedom) {
+  auto const q = (degrees_of_freedom.position() - Frame::origin).coordinates();
+  auto const v = degrees_of_freedom.velocity().coordinates();
+  return {q.x / Metre,
+          q.y / Metre,
+          q.z / Metre,
+          v.x / (Metre / Second),
+          v.y / (Metre / Second),
+          v.z / (Metre / Second)};
+}
+
+// A point of a packed timeline: its time in seconds since |Instant()| and the
+// |PackedCoordinates| of its degrees of freedom.
+struct PackedPoint {
+  double time;
+  std::array<double, 6> coordinates;
+};
+
+// The predictions below are evaluated identically when writing and reading, so
+// they must give the same bits on all platforms: each product is a separate
+// statement, to prevent contraction into a fused multiply-add (the Makefile
+// also passes -ffp-contract=off), and the sums are parenthesized.
+
+// Predicts the time of the point that follows |previous1|, itself preceded by
+// |previous2|.  Either may be null if the timeline has fewer points.
+inline double PredictPackedTime(
+    std::experimental::optional<PackedPoint> const& previous2,
+    std::experimental::optional<PackedPoint> const& previous1) {
+  if (!previous1) {
+    return 0;
+  } else if (!previous2) {
+    return previous1->time;
+  } else {
+    double const Δt = previous1->time - previous2->time;
+    return previous1->time + Δt;
+  }
+}
+
+// Predicts the coordinates at |time| of the point that follows |previous1|,
+// itself preceded by |previous2|.  With two points, this is the cubic Hermite
+// extrapolation of the positions and its derivative for the velocities, written
+// in terms of u = (time - t₂) / (t₁ - t₂), where t₁ and t₂ are the times of
+// |previous1| and |previous2|.
+inline std::array<double, 6> PredictPackedCoordinates(
+    std::experimental::optional<PackedPoint> const& previous2,
+    std::experimental::optional<PackedPoint> const& previous1,
+    double const time) {
+  std::array<double, 6> result{};
+  if (!previous1) {
+    return result;
+  }
+  std::array<double, 6> const& x1 = previous1->coordinates;
+  if (!previous2) {
+    double const Δt = time - previous1->time;
+    for (int i = 0; i < 3; ++i) {
+      double const v1_Δt = x1[i + 3] * Δt;
+      result[i] = x1[i] + v1_Δt;
+      result[i + 3] = x1[i + 3];
+    }
+    return result;
+  }
+  std::array<double, 6> const& x2 = previous2->coordinates;
+  double const h = previous1->time - previous2->time;
+  double const u = (time - previous2->time) / h;
+  double const u² = u * u;
+  double const u³ = u² * u;
+  double const two_u = 2.0 * u;
+  double const four_u = 4.0 * u;
+  double const six_u = 6.0 * u;
+  double const two_u² = 2.0 * u²;
+  double const three_u² = 3.0 * u²;
+  double const six_u² = 6.0 * u²;
+  double const two_u³ = 2.0 * u³;
+  // Hermite basis polynomials (the fourth one is h01 = 1 - h00) and their
+  // derivatives with respect to u.
+  double const h00 = (two_u³ - three_u²) + 1.0;
+  double const h10 = (u³ - two_u²) + u;
+  double const h11 = u³ - u²;
+  double const dh01 = six_u - six_u²;
+  double const dh10 = (three_u² - four_u) + 1.0;
+  double const dh11 = three_u² - two_u;
+  // The weights of the velocities in the position, and of the position
+  // difference in the velocity.  Since h00 + h01 = 1, the position is computed
+  // from that of |previous1| and the position difference.
+  double const h10_h = h10 * h;
+  double const h11_h = h11 * h;
+  double const dh01_over_h = dh01 / h;
+  for (int i = 0; i < 3; ++i) {
+    double const q2 = x2[i];
+    double const q1 = x1[i];
+    double const v2 = x2[i + 3];
+    double const v1 = x1[i + 3];
+    double const Δq = q1 - q2;
+    double const h00_Δq = h00 * Δq;
+    double const h10_h_v2 = h10_h * v2;
+    double const h11_h_v1 = h11_h * v1;
+    result[i] = q1 + ((h10_h_v2 + h11_h_v1) - h00_Δq);
+    double const dh01_Δq_over_h = dh01_over_h * Δq;
+    double const dh10_v2 = dh10 * v2;
+    double const dh11_v1 = dh11 * v1;
+    result[i + 3] = (dh01_Δq_over_h + dh10_v2) + dh11_v1;
+  }
+  return result;
+}
 
 template<typename Frame>
 typename DiscreteTrajectory<Frame>::Iterator
@@ -72,7 +234,9 @@ DiscreteTrajectory<Frame>::NewForkWithCopy(Instant const& time) {
 
   // Copy the tail of the trajectory in the child object.
   if (timeline_it != timeline_.end()) {
-    fork->timeline_.insert(++timeline_it, timeline_.end());
+    for (++timeline_it; timeline_it != timeline_.end(); ++timeline_it) {
+      fork->timeline_.emplace_back(timeline_it->first, timeline_it->second);
+    }
   }
   return fork;
 }
@@ -127,9 +291,8 @@ DiscreteTrajectory<Frame>::DetachFork() {
   // Insert a new point in the timeline for the fork time.  It should go at the
   // beginning of the timeline.
   auto const fork_it = this->Fork();
-  auto const begin_it = timeline_.emplace_hint(
-      timeline_.begin(), fork_it.time(), fork_it.degrees_of_freedom());
-  CHECK(begin_it == timeline_.begin());
+  CHECK(timeline_.empty() || fork_it.time() < timeline_.front().first);
+  timeline_.emplace_front(fork_it.time(), fork_it.degrees_of_freedom());
 
   // Detach this trajectory and tell the caller that it owns the pieces.
   return this->DetachForkWithCopiedBegin();
@@ -139,21 +302,29 @@ template<typename Frame>
 void DiscreteTrajectory<Frame>::Append(
     Instant const& time,
     DegreesOfFreedom<Frame> const& degrees_of_freedom) {
-  CHECK(this->is_root() || time > this->Fork().time())
+  CHECK(this->is_root() || time > this->ForkTime())
        << "Append at " << time << " which is before fork time "
-       << this->Fork().time();
+       << this->ForkTime();
 
-  if (!timeline_.empty() && timeline_.cbegin()->first == time) {
+  if (!timeline_.empty() && (timeline_.front().first == time ||
+                              timeline_.back().first == time)) {
     LOG(WARNING) << "Append at existing time " << time
                  << ", time range = [" << this->Begin().time() << ", "
                  << last().time() << "]";
     return;
   }
-  auto it = timeline_.emplace_hint(timeline_.end(),
-                                   time,
-                                   degrees_of_freedom);
-  // Decrementing |end()| is much faster than incrementing |it|.  Don't ask.
-  CHECK(--timeline_.end() == it) << "Append out of order at " << time;
+  CHECK(timeline_.empty() || timeline_.back().first < time)
+      << "Append out of order at " << time;
+  timeline_.emplace_back(time, degrees_of_freedom);
+
+  if (downsampling_) {
+    if (!downsampling_->start_of_dense_timeline) {
+      downsampling_->start_of_dense_timeline = time;
+    } else if (++downsampling_->dense_intervals >=
+                   downsampling_->max_dense_intervals) {
+      Downsample();
+    }
+  }
 }
 
 template<typename Frame>
@@ -164,7 +335,22 @@ void DiscreteTrajectory<Frame>::ForgetAfter(Instant const& time) {
   // entry and all the entries that follow it.  This preserves any entry with
   // time == |time|.
   auto const it = timeline_.upper_bound(time);
+  std::int64_t const size = timeline_.size();
   timeline_.erase(it, timeline_.end());
+  if (downsampling_) {
+    if (timeline_.empty()) {
+      downsampling_->start_of_dense_timeline = std::experimental::nullopt;
+      downsampling_->dense_intervals = 0;
+    } else if (time < *downsampling_->start_of_dense_timeline) {
+      // The dense timeline was entirely removed, start a new one at the last
+      // point.
+      downsampling_->start_of_dense_timeline = timeline_.back().first;
+      downsampling_->dense_intervals = 0;
+    } else {
+      // The points that were removed were all in the dense timeline.
+      downsampling_->dense_intervals -= size - timeline_.size();
+    }
+  }
 }
 
 template<typename Frame>
@@ -175,6 +361,56 @@ void DiscreteTrajectory<Frame>::ForgetBefore(Instant const& time) {
   // the entries that precede it.  This preserves any entry with time == |time|.
   auto it = timeline_.lower_bound(time);
   timeline_.erase(timeline_.begin(), it);
+  if (downsampling_) {
+    if (timeline_.empty()) {
+      downsampling_->start_of_dense_timeline = std::experimental::nullopt;
+      downsampling_->dense_intervals = 0;
+    } else if (*downsampling_->start_of_dense_timeline <
+                   timeline_.front().first) {
+      // The start of the dense timeline was removed, so all the remaining
+      // points are in the dense timeline.
+      downsampling_->start_of_dense_timeline = timeline_.front().first;
+      downsampling_->dense_intervals = timeline_.size() - 1;
+    }
+  }
+}
+
+template<typename Frame>
+void DiscreteTrajectory<Frame>::SetDownsampling(
+    std::int64_t const max_dense_intervals,
+    Length const& length_tolerance,
+    Speed const& speed_tolerance) {
+  CHECK(this->is_root());
+  CHECK_LT(0, max_dense_intervals);
+  CHECK_LT(Length(), length_tolerance);
+  CHECK_LT(Speed(), speed_tolerance);
+  // The existing points are not downsampled.
+  std::experimental::optional<Instant> start_of_dense_timeline;
+  if (!timeline_.empty()) {
+    start_of_dense_timeline = timeline_.back().first;
+  }
+  downsampling_ = Downsampling{max_dense_intervals,
+                               length_tolerance,
+                               speed_tolerance,
+                               start_of_dense_timeline,
+                               /*dense_intervals=*/0};
+}
+
+template<typename Frame>
+void DiscreteTrajectory<Frame>::ClearDownsampling() {
+  downsampling_ = std::experimental::nullopt;
+}
+
+template<typename Frame>
+Instant DiscreteTrajectory<Frame>::last_stable_time() const {
+  CHECK(this->is_root());
+  CHECK(!timeline_.empty());
+  if (downsampling_) {
+    // The first point of the dense timeline is always retained.
+    return *downsampling_->start_of_dense_timeline;
+  } else {
+    return timeline_.back().first;
+  }
 }
 
 template<typename Frame>
@@ -182,11 +418,27 @@ void DiscreteTrajectory<Frame>::WriteToMessage(
     not_null<serialization::DiscreteTrajectory*> const message,
     std::vector<DiscreteTrajectory<Frame>*> const& forks)
     const {
+  WriteToMessage(message, forks, astronomy::InfinitePast);
+}
+
+template<typename Frame>
+void DiscreteTrajectory<Frame>::WriteToMessage(
+    not_null<serialization::DiscreteTrajectory*> const message,
+    std::vector<DiscreteTrajectory<Frame>*> const& forks,
+    Instant const& after) const {
   LOG(INFO) << __FUNCTION__;
   CHECK(this->is_root());
 
   std::vector<DiscreteTrajectory<Frame>*> mutable_forks = forks;
-  WriteSubTreeToMessage(message, mutable_forks);
+  Forkable<DiscreteTrajectory, Iterator>::WriteSubTreeToMessage(message,
+                                                                mutable_forks);
+  auto const first = timeline_.upper_bound(after);
+  if (first != timeline_.end()) {
+    WritePackedTimelineToMessage(first, message->mutable_packed_timeline());
+  }
+  if (downsampling_) {
+    WriteDownsamplingToMessage(message->mutable_downsampling());
+  }
   CHECK(std::all_of(mutable_forks.begin(),
                     mutable_forks.end(),
                     [](DiscreteTrajectory<Frame>* const fork) {
@@ -210,9 +462,30 @@ DiscreteTrajectory<Frame>::ReadFromMessage(
                       return fork != nullptr && *fork == nullptr;
                     }));
   trajectory->FillSubTreeFromMessage(message, forks);
+  if (message.has_downsampling()) {
+    trajectory->FillDownsamplingFromMessage(message.downsampling());
+  }
   return trajectory;
 }
 
+template<typename Frame>
+void DiscreteTrajectory<Frame>::AppendFromMessage(
+    serialization::DiscreteTrajectory const& message,
+    std::vector<DiscreteTrajectory<Frame>**> const& forks) {
+  CHECK(this->is_root());
+  CHECK(std::all_of(forks.begin(),
+                    forks.end(),
+                    [](DiscreteTrajectory<Frame>** const fork) {
+                      return fork != nullptr && *fork == nullptr;
+                    }));
+  // The points of |message| were already downsampled when it was written.
+  downsampling_ = std::experimental::nullopt;
+  FillSubTreeFromMessage(message, forks);
+  if (message.has_downsampling()) {
+    FillDownsamplingFromMessage(message.downsampling());
+  }
+}
+
 template<typename Frame>
 not_null<DiscreteTrajectory<Frame>*> DiscreteTrajectory<Frame>::that() {
   return this;
@@ -253,25 +526,157 @@ bool DiscreteTrajectory<Frame>::timeline_empty() const {
   return timeline_.empty();
 }
 
+template<typename Frame>
+void DiscreteTrajectory<Frame>::timeline_clear(
+    std::int64_t const retained_capacity) {
+  timeline_.clear();
+  timeline_.shrink(retained_capacity);
+}
+
+template<typename Frame>
+void DiscreteTrajectory<Frame>::Downsample() {
+  CHECK(this->is_root());
+  Instant const start_of_dense_timeline =
+      *downsampling_->start_of_dense_timeline;
+  Length const& length_tolerance = downsampling_->length_tolerance;
+  Speed const& speed_tolerance = downsampling_->speed_tolerance;
+
+  std::vector<TimelineConstIterator> dense_points;
+  for (auto it = timeline_.find(start_of_dense_timeline);
+       it != timeline_.end();
+       ++it) {
+    dense_points.push_back(it);
+  }
+  int const size = dense_points.size();
+
+  // The ends of the dense timeline and the fork points are always retained.
+  std::vector<bool> retained(size, false);
+  retained.front() = true;
+  retained.back() = true;
+  for (Instant const& fork_time :
+           this->ForkTimesNotBefore(start_of_dense_timeline)) {
+    auto const it = std::lower_bound(
+        dense_points.begin(),
+        dense_points.end(),
+        fork_time,
+        [](TimelineConstIterator const& point, Instant const& time) {
+          return point->first < time;
+        });
+    CHECK(it != dense_points.end() && (*it)->first == fork_time);
+    retained[it - dense_points.begin()] = true;
+  }
+
+  // A Douglas-Peucker pass between each pair of consecutive retained points:
+  // if the worst reconstructed point of the segment is outside the tolerances,
+  // retain it and split the segment there.  The segments are the pairs of
+  // indices in |dense_points| of their ends.
+  std::vector<std::pair<int, int>> segments;
+  for (int first = 0, i = 1; i < size; ++i) {
+    if (retained[i]) {
+      segments.emplace_back(first, i);
+      first = i;
+    }
+  }
+  while (!segments.empty()) {
+    int const first = segments.back().first;
+    int const last = segments.back().second;
+    segments.pop_back();
+    if (last - first < 2) {
+      continue;
+    }
+    auto const& first_point = *dense_points[first];
+    auto const& last_point = *dense_points[last];
+    Hermite3<Instant, Position<Frame>> const interpolation(
+        {first_point.first, last_point.first},
+        {first_point.second.position(), last_point.second.position()},
+        {first_point.second.velocity(), last_point.second.velocity()});
+    double worst_error = 0;
+    int worst_point = first;
+    for (int i = first + 1; i < last; ++i) {
+      auto const& point = *dense_points[i];
+      double const error = std::max(
+          (interpolation.Evaluate(point.first) -
+               point.second.position()).Norm() / length_tolerance,
+          (interpolation.EvaluateDerivative(point.first) -
+               point.second.velocity()).Norm() / speed_tolerance);
+      if (error > worst_error) {
+        worst_error = error;
+        worst_point = i;
+      }
+    }
+    if (worst_error > 1) {
+      retained[worst_point] = true;
+      segments.emplace_back(first, worst_point);
+      segments.emplace_back(worst_point, last);
+    }
+  }
+
+  int index = 0;
+  timeline_.erase_if(
+      dense_points.front(),
+      [&index, &retained](
+          typename Timeline<DegreesOfFreedom<Frame>>::value_type const&) {
+        return !retained[index++];
+      });
+  this->RelinkForksNotBefore(start_of_dense_timeline);
+
+  downsampling_->start_of_dense_timeline = timeline_.back().first;
+  downsampling_->dense_intervals = 0;
+}
+
 template<typename Frame>
 void DiscreteTrajectory<Frame>::WriteSubTreeToMessage(
     not_null<serialization::DiscreteTrajectory*> const message,
     std::vector<DiscreteTrajectory<Frame>*>& forks) const {
   Forkable<DiscreteTrajectory, Iterator>::WriteSubTreeToMessage(message, forks);
-  for (auto const& pair : timeline_) {
-    Instant const& instant = pair.first;
-    DegreesOfFreedom<Frame> const& degrees_of_freedom = pair.second;
-    auto const instantaneous_degrees_of_freedom = message->add_timeline();
-    instant.WriteToMessage(instantaneous_degrees_of_freedom->mutable_instant());
-    degrees_of_freedom.WriteToMessage(
-        instantaneous_degrees_of_freedom->mutable_degrees_of_freedom());
+  if (!timeline_.empty()) {
+    WritePackedTimelineToMessage(timeline_.begin(),
+                                 message->mutable_packed_timeline());
+  }
+}
+
+template<typename Frame>
+void DiscreteTrajectory<Frame>::WriteDownsamplingToMessage(
+    not_null<serialization::DiscreteTrajectory::Downsampling*> const message)
+    const {
+  message->set_max_dense_intervals(downsampling_->max_dense_intervals);
+  downsampling_->length_tolerance.WriteToMessage(
+      message->mutable_length_tolerance());
+  downsampling_->speed_tolerance.WriteToMessage(
+      message->mutable_speed_tolerance());
+  if (downsampling_->start_of_dense_timeline) {
+    downsampling_->start_of_dense_timeline->WriteToMessage(
+        message->mutable_start_of_dense_timeline());
+  }
+  message->set_dense_intervals(downsampling_->dense_intervals);
+}
+
+template<typename Frame>
+void DiscreteTrajectory<Frame>::FillDownsamplingFromMessage(
+    serialization::DiscreteTrajectory::Downsampling const& message) {
+  std::experimental::optional<Instant> start_of_dense_timeline;
+  if (message.has_start_of_dense_timeline()) {
+    start_of_dense_timeline =
+        Instant::ReadFromMessage(message.start_of_dense_timeline());
   }
+  CHECK_EQ(timeline_.empty(), !start_of_dense_timeline);
+  downsampling_ = Downsampling{
+      message.max_dense_intervals(),
+      Length::ReadFromMessage(message.length_tolerance()),
+      Speed::ReadFromMessage(message.speed_tolerance()),
+      start_of_dense_timeline,
+      message.dense_intervals()};
 }
 
 template<typename Frame>
 void DiscreteTrajectory<Frame>::FillSubTreeFromMessage(
     serialization::DiscreteTrajectory const& message,
     std::vector<DiscreteTrajectory<Frame>**> const& forks) {
+  if (message.has_packed_timeline()) {
+    CHECK_EQ(0, message.timeline_size());
+    FillPackedTimelineFromMessage(message.packed_timeline());
+  }
+  // Older saves use one message per point.
   for (auto timeline_it = message.timeline().begin();
        timeline_it != message.timeline().end();
        ++timeline_it) {
@@ -283,6 +688,78 @@ void DiscreteTrajectory<Frame>::FillSubTreeFromMessage(
                                                                  forks);
 }
 
+template<typename Frame>
+void DiscreteTrajectory<Frame>::WritePackedTimelineToMessage(
+    TimelineConstIterator const first,
+    not_null<serialization::DiscreteTrajectory::PackedTimeline*> const
+        message) const {
+  Frame::WriteToMessage(message->mutable_frame());
+  std::int64_t size = 0;
+  google::protobuf::io::StringOutputStream string_stream(
+      message->mutable_residuals());
+  // The destructor of |stream| trims |residuals| to the data actually written.
+  google::protobuf::io::CodedOutputStream stream(&string_stream);
+  std::experimental::optional<PackedPoint> previous2;
+  std::experimental::optional<PackedPoint> previous1;
+  for (auto it = first; it != timeline_.end(); ++it) {
+    PackedPoint const point{(it->first - Instant()) / Second,
+                            PackedCoordinates(it->second)};
+    stream.WriteVarint64(
+        PackedResidual(point.time, PredictPackedTime(previous2, previous1)));
+    auto const prediction =
+        PredictPackedCoordinates(previous2, previous1, point.time);
+    for (std::size_t i = 0; i < point.coordinates.size(); ++i) {
+      stream.WriteVarint64(
+          PackedResidual(point.coordinates[i], prediction[i]));
+    }
+    previous2 = previous1;
+    previous1 = point;
+    ++size;
+  }
+  message->set_size(size);
+}
+
+template<typename Frame>
+void DiscreteTrajectory<Frame>::FillPackedTimelineFromMessage(
+    serialization::DiscreteTrajectory::PackedTimeline const& message) {
+  Frame::ReadFromMessage(message.frame());
+  std::string const& residuals = message.residuals();
+  google::protobuf::io::CodedInputStream stream(
+      reinterpret_cast<std::uint8_t const*>(residuals.data()),
+      static_cast<int>(residuals.size()));
+  auto const read_residual = [&stream]() {
+    std::uint64_t residual;
+    CHECK(stream.ReadVarint64(&residual));
+    return residual;
+  };
+  std::experimental::optional<PackedPoint> previous2;
+  std::experimental::optional<PackedPoint> previous1;
+  for (std::int64_t i = 0; i < message.size(); ++i) {
+    PackedPoint point;
+    point.time = UnpackResidual(read_residual(),
+                                PredictPackedTime(previous2, previous1));
+    auto const prediction =
+        PredictPackedCoordinates(previous2, previous1, point.time);
+    for (std::size_t j = 0; j < point.coordinates.size(); ++j) {
+      point.coordinates[j] = UnpackResidual(read_residual(), prediction[j]);
+    }
+    std::array<double, 6> const& x = point.coordinates;
+    Append(Instant() + point.time * Second,
+           DegreesOfFreedom<Frame>(
+               Frame::origin + Displacement<Frame>({x[0] * Metre,
+                                                    x[1] * Metre,
+                                                    x[2] * Metre}),
+               Velocity<Frame>({x[3] * (Metre / Second),
+                                x[4] * (Metre / Second),
+                                x[5] * (Metre / Second)})));
+    // The predictions use the values read rather than the points of the
+    // timeline, which may be moved or erased by downsampling.
+    previous2 = previous1;
+    previous1 = point;
+  }
+  CHECK_EQ(static_cast<int>(residuals.size()), stream.CurrentPosition());
+}
+
 }  // namespace internal_discrete_trajectory
 }  // namespace physics
 }  // namespace principia
@@ -2,6 +2,7 @@
 #include "physics/discrete_trajectory.hpp"
 
 #include <functional>
+#include <iterator>
 #include <list>
 #include <map>
 #include <string>
@@ -14,6 +15,8 @@
 #include "geometry/r3_element.hpp"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "numerics/hermite3.hpp"
+#include "quantities/elementary_functions.hpp"
 #include "quantities/quantities.hpp"
 #include "quantities/si.hpp"
 
@@ -28,16 +31,25 @@ using geometry::Point;
 using geometry::Position;
 using geometry::R3Element;
 using geometry::Vector;
+using numerics::Hermite3;
+using quantities::AngularFrequency;
+using quantities::Cos;
 using quantities::Length;
 using quantities::Speed;
 using quantities::SIUnit;
+using quantities::Sin;
 using quantities::si::Metre;
+using quantities::si::Milli;
+using quantities::si::Radian;
 using quantities::si::Second;
 using ::std::placeholders::_1;
 using ::std::placeholders::_2;
 using ::std::placeholders::_3;
+using ::testing::AllOf;
 using ::testing::ElementsAre;
 using ::testing::Eq;
+using ::testing::Ge;
+using ::testing::Le;
 using ::testing::Pair;
 using ::testing::Ref;
 
@@ -679,55 +691,153 @@ TEST_F(DiscreteTrajectoryTest, TrajectorySerializationSuccess) {
                                            deserialized_fork2});
   EXPECT_EQ(reference_message.SerializeAsString(), message.SerializeAsString());
   EXPECT_THAT(message.children_size(), Eq(2));
-  EXPECT_THAT(message.timeline_size(), Eq(3));
-  EXPECT_THAT(Instant::ReadFromMessage(message.timeline(0).instant()), Eq(t1_));
-  EXPECT_THAT(Instant::ReadFromMessage(message.timeline(1).instant()), Eq(t2_));
-  EXPECT_THAT(Instant::ReadFromMessage(message.timeline(2).instant()), Eq(t3_));
-  EXPECT_THAT(
-      DegreesOfFreedom<World>::ReadFromMessage(
-          message.timeline(0).degrees_of_freedom()), Eq(d1_));
-  EXPECT_THAT(
-        DegreesOfFreedom<World>::ReadFromMessage(
-            message.timeline(1).degrees_of_freedom()), Eq(d2_));
-  EXPECT_THAT(
-        DegreesOfFreedom<World>::ReadFromMessage(
-            message.timeline(2).degrees_of_freedom()), Eq(d3_));
+  EXPECT_THAT(message.timeline_size(), Eq(0));
+  EXPECT_THAT(message.packed_timeline().size(), Eq(3));
   EXPECT_THAT(message.children(0).trajectories_size(), Eq(2));
   EXPECT_THAT(message.children(0).trajectories(0).children_size(), Eq(0));
-  EXPECT_THAT(message.children(0).trajectories(0).timeline_size(), Eq(1));
   EXPECT_THAT(
-      Instant::ReadFromMessage(
-          message.children(0).trajectories(0).timeline(0).instant()), Eq(t3_));
-  EXPECT_THAT(
-      DegreesOfFreedom<World>::ReadFromMessage(
-          message.children(0).trajectories(0).timeline(0).degrees_of_freedom()),
-      Eq(d3_));
+      message.children(0).trajectories(0).packed_timeline().size(), Eq(1));
   EXPECT_THAT(message.children(0).trajectories(1).children_size(), Eq(0));
-  EXPECT_THAT(message.children(0).trajectories(1).timeline_size(), Eq(2));
-  EXPECT_THAT(
-      Instant::ReadFromMessage(
-          message.children(0).trajectories(1).timeline(0).instant()), Eq(t3_));
-  EXPECT_THAT(
-      DegreesOfFreedom<World>::ReadFromMessage(
-          message.children(0).trajectories(1).timeline(0).degrees_of_freedom()),
-      Eq(d3_));
   EXPECT_THAT(
-      Instant::ReadFromMessage(
-          message.children(0).trajectories(1).timeline(1).instant()), Eq(t4_));
-  EXPECT_THAT(
-      DegreesOfFreedom<World>::ReadFromMessage(
-          message.children(0).trajectories(1).timeline(1).degrees_of_freedom()),
-      Eq(d4_));
+      message.children(0).trajectories(1).packed_timeline().size(), Eq(2));
   EXPECT_THAT(message.children(1).trajectories_size(), Eq(1));
   EXPECT_THAT(message.children(1).trajectories(0).children_size(), Eq(0));
-  EXPECT_THAT(message.children(1).trajectories(0).timeline_size(), Eq(1));
   EXPECT_THAT(
-      Instant::ReadFromMessage(
-          message.children(1).trajectories(0).timeline(0).instant()), Eq(t4_));
+      message.children(1).trajectories(0).packed_timeline().size(), Eq(1));
+
+  EXPECT_THAT(Positions(*deserialized_trajectory),
+              ElementsAre(Pair(t1_, q1_), Pair(t2_, q2_), Pair(t3_, q3_)));
+  EXPECT_THAT(Velocities(*deserialized_trajectory),
+              ElementsAre(Pair(t1_, p1_), Pair(t2_, p2_), Pair(t3_, p3_)));
+  EXPECT_THAT(Positions(*deserialized_fork1),
+              ElementsAre(Pair(t1_, q1_), Pair(t2_, q2_), Pair(t3_, q3_)));
+  EXPECT_THAT(Velocities(*deserialized_fork2),
+              ElementsAre(Pair(t1_, p1_),
+                          Pair(t2_, p2_),
+                          Pair(t3_, p3_),
+                          Pair(t4_, p4_)));
+  EXPECT_THAT(Positions(*deserialized_fork3),
+              ElementsAre(Pair(t1_, q1_),
+                          Pair(t2_, q2_),
+                          Pair(t3_, q3_),
+                          Pair(t4_, q4_)));
+}
+
+// Saves written before the introduction of |packed_timeline| remain readable.
+TEST_F(DiscreteTrajectoryTest, TrajectorySerializationPreviousLayout) {
+  serialization::DiscreteTrajectory message;
+  for (auto const& point : {std::make_pair(t1_, d1_),
+                            std::make_pair(t2_, d2_),
+                            std::make_pair(t3_, d3_)}) {
+    auto* const instantaneous_degrees_of_freedom = message.add_timeline();
+    point.first.WriteToMessage(
+        instantaneous_degrees_of_freedom->mutable_instant());
+    point.second.WriteToMessage(
+        instantaneous_degrees_of_freedom->mutable_degrees_of_freedom());
+  }
+  auto const litter = message.add_children();
+  t2_.WriteToMessage(litter->mutable_fork_time());
+  auto* const instantaneous_degrees_of_freedom =
+      litter->add_trajectories()->add_timeline();
+  t4_.WriteToMessage(instantaneous_degrees_of_freedom->mutable_instant());
+  d4_.WriteToMessage(
+      instantaneous_degrees_of_freedom->mutable_degrees_of_freedom());
+  message.add_fork_position(0);
+
+  DiscreteTrajectory<World>* deserialized_fork = nullptr;
+  not_null<std::unique_ptr<DiscreteTrajectory<World>>> const
+      deserialized_trajectory =
+          DiscreteTrajectory<World>::ReadFromMessage(message,
+                                                     {&deserialized_fork});
+  EXPECT_THAT(Positions(*deserialized_trajectory),
+              ElementsAre(Pair(t1_, q1_), Pair(t2_, q2_), Pair(t3_, q3_)));
+  EXPECT_THAT(Velocities(*deserialized_fork),
+              ElementsAre(Pair(t1_, p1_), Pair(t2_, p2_), Pair(t4_, p4_)));
+
+  // Rewriting the trajectory uses the packed layout.
+  message.Clear();
+  deserialized_trajectory->WriteToMessage(&message, {deserialized_fork});
+  EXPECT_THAT(message.timeline_size(), Eq(0));
+  EXPECT_THAT(message.packed_timeline().size(), Eq(3));
+  EXPECT_THAT(message.children(0).trajectories(0).timeline_size(), Eq(0));
   EXPECT_THAT(
-      DegreesOfFreedom<World>::ReadFromMessage(
-          message.children(1).trajectories(0).timeline(0).degrees_of_freedom()),
-      Eq(d4_));
+      message.children(0).trajectories(0).packed_timeline().size(), Eq(1));
+}
+
+// The packed layout is exact and compact for a trajectory sampled like the
+// histories of the vessels.
+TEST_F(DiscreteTrajectoryTest, TrajectorySerializationPacked) {
+  Length const r = 7e6 * Metre;
+  AngularFrequency const ω = 1.07e-3 * Radian / Second;
+  Instant const t_start = t0_ + 123'456.789 * Second;
+  int const points = 1000;
+  for (int i = 0; i < points; ++i) {
+    Instant const t = t_start + i * 10 * Second;
+    auto const θ = ω * (t - t0_);
+    massive_trajectory_->Append(
+        t,
+        DegreesOfFreedom<World>(
+            World::origin +
+                Displacement<World>({r * Cos(θ), r * Sin(θ), 0 * Metre}),
+            Velocity<World>({-r * ω * Sin(θ) / Radian,
+                             r * ω * Cos(θ) / Radian,
+                             0 * Metre / Second})));
+  }
+  serialization::DiscreteTrajectory message;
+  massive_trajectory_->WriteToMessage(&message, /*forks=*/{});
+  not_null<std::unique_ptr<DiscreteTrajectory<World>>> const
+      deserialized_trajectory =
+          DiscreteTrajectory<World>::ReadFromMessage(message, /*forks=*/{});
+  EXPECT_EQ(Positions(*massive_trajectory_),
+            Positions(*deserialized_trajectory));
+  EXPECT_EQ(Velocities(*massive_trajectory_),
+            Velocities(*deserialized_trajectory));
+
+  // Each point takes 56 bytes in memory and 154 bytes in the previous layout.
+  EXPECT_THAT(message.ByteSize(), Le(points * 25));
+}
+
+// The packed layout is part of the save format: the predictions must not
+// change, and must give the same bits on all platforms.
+TEST_F(DiscreteTrajectoryTest, TrajectorySerializationPackedBytes) {
+  double const times[] = {-12.5, 17.25, 47.125, 77.375};
+  double const coordinates[][6] = {
+      {6.5e6, -1.25e5, 3.0e3, 10.0, 7.5e3, -2.0},
+      {6.499e6, 9.7e4, 2.97e3, -14.75, 7.4985e3, -2.125},
+      {6.4944e6, 3.2e5, 2.91e3, -40.5, 7.4925e3, -2.25},
+      {6.4868e6, 5.43e5, 2.84e3, -65.25, 7.4845e3, -2.375}};
+  for (int i = 0; i < 4; ++i) {
+    double const* const x = coordinates[i];
+    massive_trajectory_->Append(
+        t0_ + times[i] * Second,
+        DegreesOfFreedom<World>(
+            World::origin +
+                Displacement<World>({x[0] * Metre, x[1] * Metre, x[2] * Metre}),
+            Velocity<World>({x[3] * Metre / Second,
+                             x[4] * Metre / Second,
+                             x[5] * Metre / Second})));
+  }
+  serialization::DiscreteTrajectory message;
+  massive_trajectory_->WriteToMessage(&message, /*forks=*/{});
+  EXPECT_THAT(message.packed_timeline().size(), Eq(4));
+  std::string const expected_residuals(
+      "\x81\x80\x80\x80\x80\x80\x80\xa9\x80\x01\x80\x80\x80\x80\x80\xea"
+      "\xe5\xd8\x82\x01\x81\x80\x80\x80\x80\xa0\xc2\xfe\x81\x01\x80\x80"
+      "\x80\x80\x80\x80\xb8\xa7\x81\x01\x80\x80\x80\x80\x80\x80\x80\xa4"
+      "\x80\x01\x80\x80\x80\x80\x80\x80\xa6\xbd\x81\x01\x81\x80\x80\x80"
+      "\x80\x80\x80\x80\x80\x01\xfd\xff\xff\xff\xff\xff\xdf\xa5\xff\x01"
+      "\xff\xff\xff\xff\x8b\x51\xff\xff\xff\xff\xff\x93\x23\x80\x80\x80"
+      "\x80\x80\xc0\x1d\xfe\xff\xff\xff\xff\xff\xbf\xae\xff\x01\xff\xff"
+      "\xff\xff\xff\x5f\xff\xff\xff\xff\xff\xff\x7f\x80\x80\x80\x80\x80"
+      "\x80\x08\x99\xd0\xf8\xbe\x8e\x92\x04\xcf\xdd\xa4\xf3\xb2\xa4\x33"
+      "\xa0\xce\x96\xdd\x83\xdf\xa3\x01\x84\xed\x9d\xc7\xe7\x81\xd3\xc6"
+      "\xfe\x01\xcf\xf9\xe1\xee\xa2\x85\xe2\x01\xc6\x80\x9b\xe4\xec\xe0"
+      "\xfa\x2b\x80\x80\x80\x80\x80\x80\x0c\xa5\xf0\xd9\xe6\x9f\xb5\x0c"
+      "\xbb\xfd\x8a\x9e\xea\xc8\x20\xbc\xf7\xed\xc3\x98\xc6\x1b\xbe\xb8"
+      "\x94\xd0\x8a\xb5\xcb\x98\xfe\x01\xcf\xc9\xd4\xa4\x89\xf0\xbe\x01"
+      "\x90\xe1\xd9\xc2\xae\x99\xa2\x0f",
+      232);
+  EXPECT_EQ(expected_residuals, message.packed_timeline().residuals());
 }
 
 TEST_F(DiscreteTrajectoryDeathTest, LastError) {
@@ -793,6 +903,122 @@ TEST_F(DiscreteTrajectoryTest, IteratorSuccess) {
   EXPECT_TRUE(it == fork->End());
 }
 
+TEST_F(DiscreteTrajectoryTest, Downsampling) {
+  // A circular motion sampled every 10 s.
+  Length const r = 1e6 * Metre;
+  AngularFrequency const ω = 1e-3 * Radian / Second;
+  auto const circular_motion = [this, r, ω](Instant const& t) {
+    auto const φ = ω * (t - t0_);
+    return DegreesOfFreedom<World>(
+        World::origin + Displacement<World>({r * Cos(φ), r * Sin(φ), 0 * r}),
+        Velocity<World>({-r * ω * Sin(φ) / Radian,
+                         r * ω * Cos(φ) / Radian,
+                         0 * Metre / Second}));
+  };
+  Length const length_tolerance = 1 * Metre;
+  Speed const speed_tolerance = 10 * Milli(Metre) / Second;
+  massive_trajectory_->SetDownsampling(/*max_dense_intervals=*/100,
+                                       length_tolerance,
+                                       speed_tolerance);
+
+  std::vector<Instant> sampled_times;
+  DiscreteTrajectory<World>* fork = nullptr;
+  for (int i = 0; i <= 1050; ++i) {
+    Instant const t = t0_ + i * 10 * Second;
+    sampled_times.push_back(t);
+    massive_trajectory_->Append(t, circular_motion(t));
+    if (i == 432) {
+      fork = massive_trajectory_->NewForkWithCopy(t - 20 * Second);
+      fork->Append(t + 1 * Second, d1_);
+    }
+  }
+  EXPECT_THAT(Times(*massive_trajectory_).size(), AllOf(Ge(200), Le(300)));
+
+  // The fork point is retained and the fork is not affected.
+  Instant const fork_time = t0_ + 4300 * Second;
+  EXPECT_EQ(fork_time, fork->Fork().time());
+  EXPECT_EQ(circular_motion(fork_time), fork->Fork().degrees_of_freedom());
+  std::list<Instant> const fork_times = Times(*fork);
+  EXPECT_THAT(std::vector<Instant>(std::prev(fork_times.end(), 4),
+                                   fork_times.end()),
+              ElementsAre(fork_time,
+                          fork_time + 10 * Second,
+                          fork_time + 20 * Second,
+                          fork_time + 21 * Second));
+
+  // All the sampled points can be reconstructed within the tolerances.
+  for (Instant const& t : sampled_times) {
+    auto const upper = massive_trajectory_->LowerBound(t);
+    if (upper.time() == t) {
+      EXPECT_EQ(circular_motion(t), upper.degrees_of_freedom());
+      continue;
+    }
+    auto lower = upper;
+    --lower;
+    Hermite3<Instant, Position<World>> const interpolation(
+        {lower.time(), upper.time()},
+        {lower.degrees_of_freedom().position(),
+         upper.degrees_of_freedom().position()},
+        {lower.degrees_of_freedom().velocity(),
+         upper.degrees_of_freedom().velocity()});
+    DegreesOfFreedom<World> const expected = circular_motion(t);
+    EXPECT_THAT((interpolation.Evaluate(t) - expected.position()).Norm(),
+                Le(length_tolerance));
+    EXPECT_THAT((interpolation.EvaluateDerivative(t) -
+                 expected.velocity()).Norm(),
+                Le(speed_tolerance));
+  }
+
+  // The points appended after the last downsampling are all retained.
+  massive_trajectory_->DeleteFork(fork);
+  massive_trajectory_->ForgetBefore(t0_ + 10000 * Second);
+  EXPECT_EQ(t0_ + 10000 * Second, massive_trajectory_->Begin().time());
+  EXPECT_EQ(51, Times(*massive_trajectory_).size());
+}
+
+TEST_F(DiscreteTrajectoryTest, DownsamplingSerialization) {
+  Length const r = 1e6 * Metre;
+  AngularFrequency const ω = 1e-3 * Radian / Second;
+  auto const circular_motion = [this, r, ω](Instant const& t) {
+    auto const φ = ω * (t - t0_);
+    return DegreesOfFreedom<World>(
+        World::origin + Displacement<World>({r * Cos(φ), r * Sin(φ), 0 * r}),
+        Velocity<World>({-r * ω * Sin(φ) / Radian,
+                         r * ω * Cos(φ) / Radian,
+                         0 * Metre / Second}));
+  };
+  massive_trajectory_->SetDownsampling(/*max_dense_intervals=*/100,
+                                       /*length_tolerance=*/1 * Metre,
+                                       /*speed_tolerance=*/
+                                           10 * Milli(Metre) / Second);
+  for (int i = 0; i <= 250; ++i) {
+    Instant const t = t0_ + i * 10 * Second;
+    massive_trajectory_->Append(t, circular_motion(t));
+  }
+  // Remove a few points of the dense timeline.
+  massive_trajectory_->ForgetAfter(t0_ + 2400 * Second);
+
+  serialization::DiscreteTrajectory message;
+  massive_trajectory_->WriteToMessage(&message, /*forks=*/{});
+  EXPECT_TRUE(message.has_downsampling());
+  auto const deserialized_trajectory =
+      DiscreteTrajectory<World>::ReadFromMessage(message, /*forks=*/{});
+  EXPECT_EQ(massive_trajectory_->last_stable_time(),
+            deserialized_trajectory->last_stable_time());
+
+  // The deserialized trajectory is downsampled at the same points as the
+  // original one.
+  for (int i = 241; i <= 500; ++i) {
+    Instant const t = t0_ + i * 10 * Second;
+    massive_trajectory_->Append(t, circular_motion(t));
+    deserialized_trajectory->Append(t, circular_motion(t));
+  }
+  EXPECT_EQ(Times(*massive_trajectory_), Times(*deserialized_trajectory));
+  EXPECT_EQ(massive_trajectory_->last_stable_time(),
+            deserialized_trajectory->last_stable_time());
+  EXPECT_LT(t0_ + 2400 * Second, massive_trajectory_->last_stable_time());
+}
+
 }  // namespace internal_discrete_trajectory
 }  // namespace physics
 }  // namespace principia
@@ -1,14 +1,23 @@
 ﻿
 #pragma once
 
+#include <condition_variable>
+#include <cstdint>
+#include <experimental/filesystem>
+#include <experimental/optional>
 #include <functional>
 #include <limits>
+#include <list>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include "base/not_null.hpp"
 #include "base/status.hpp"
+#include "base/thread_pool.hpp"
 #include "geometry/grassmann.hpp"
 #include "geometry/named_quantities.hpp"
 #include "google/protobuf/repeated_field.h"
@@ -25,11 +34,14 @@ namespace physics {
 namespace internal_ephemeris {
 
 using base::Status;
+using base::ThreadPool;
 using geometry::Position;
+using geometry::Velocity;
 using geometry::Vector;
 using integrators::AdaptiveStepSizeIntegrator;
 using integrators::FixedStepSizeIntegrator;
 using integrators::Integrator;
+using integrators::IntegrationInstance;
 using integrators::IntegrationProblem;
 using integrators::SpecialSecondOrderDifferentialEquation;
 using quantities::Acceleration;
@@ -73,6 +85,16 @@ class Ephemeris {
     void set_speed_integration_tolerance(
         Speed const& speed_integration_tolerance);
 
+    // If finite, the flows add points inside the steps of the integration,
+    // taken from the dense output of the integrator, so that the chords
+    // between consecutive points of the trajectory deviate from the solution
+    // by at most |max_chord_deviation|.  This is for trajectories that are
+    // rendered as polylines, and lets them be integrated with a tolerance
+    // looser than their rendering would otherwise need.  Infinite by default.
+    // Not serialized.
+    Length max_chord_deviation() const;
+    void set_max_chord_deviation(Length const& max_chord_deviation);
+
     void WriteToMessage(
         not_null<serialization::Ephemeris::AdaptiveStepParameters*> const
             message) const;
@@ -86,6 +108,7 @@ class Ephemeris {
     std::int64_t max_steps_;
     Length length_integration_tolerance_;
     Speed speed_integration_tolerance_;
+    Length max_chord_deviation_;
     friend class Ephemeris<Frame>;
   };
 
@@ -95,6 +118,7 @@ class Ephemeris {
         FixedStepSizeIntegrator<NewtonianMotionEquation> const& integrator,
         Time const& step);
 
+    FixedStepSizeIntegrator<NewtonianMotionEquation> const& integrator() const;
     Time const& step() const;
 
     void WriteToMessage(
@@ -119,7 +143,8 @@ class Ephemeris {
             Length const& fitting_tolerance,
             FixedStepParameters const& parameters);
 
-  virtual ~Ephemeris() = default;
+  // Stops the asynchronous prolongation, if any.
+  virtual ~Ephemeris();
 
   // Returns the bodies in the order in which they were given at construction.
   virtual std::vector<not_null<MassiveBody const*>> const& bodies() const;
@@ -141,17 +166,57 @@ class Ephemeris {
 
   virtual Status last_severe_integration_status() const;
 
+  // Counts the lookups in the cache of the positions of the massive bodies
+  // shared by the flows of massless bodies.
+  struct CelestialPositionsCacheStatistics {
+    std::int64_t hits = 0;
+    std::int64_t misses = 0;
+
+    // The proportion of lookups that were hits, 0 if there was no lookup.
+    double hit_rate() const;
+  };
+
+  virtual CelestialPositionsCacheStatistics
+  celestial_positions_cache_statistics() const;
+
+  // Sets the number of threads used to compute the accelerations between the
+  // massive bodies when prolonging.  If |workers| is 0 (the default) the
+  // accelerations are computed on the calling thread.  Otherwise the pairs of
+  // bodies are partitioned across a pool of |workers| threads owned by this
+  // object.  The partition only depends on the number of bodies, so the results
+  // are bit-for-bit identical for any positive number of |workers|.
+  virtual void set_massive_bodies_acceleration_workers(int workers);
+
   // Calls |ForgetBefore| on all trajectories.  On return |t_min() == t|.
   virtual void ForgetBefore(Instant const& t);
 
   // Prolongs the ephemeris up to at least |t|.  After the call, |t_max() >= t|.
   virtual void Prolong(Instant const& t);
 
+  // Starts prolonging the ephemeris on a background thread, so that it extends
+  // |horizon| beyond the last time passed to |Prolong|.  The series computed by
+  // that thread are only published to the trajectories by |Prolong|, which
+  // waits for them if they don't reach its argument yet.  Thus |t_max()| only
+  // reflects published data, and evaluating the trajectories never waits for
+  // the background thread.  All the members of this object, except
+  // |set_massive_bodies_acceleration_workers|, may still be called on the
+  // thread that owns it.  If the prolongation is already asynchronous, only
+  // changes the |horizon|.  The series are published as immutable snapshots of
+  // the trajectories, see |ContinuousTrajectory|, so the trajectories may be
+  // evaluated on other threads while the owning thread publishes.
+  virtual void StartAsynchronousProlongation(Time const& horizon);
+  // Stops the background thread, if any, and publishes whatever it computed.
+  // Subsequent calls to |Prolong| integrate on the calling thread.
+  virtual void StopAsynchronousProlongation();
+
   // Integrates, until exactly |t| (except for timeouts or singularities), the
   // |trajectory| followed by a massless body in the gravitational potential
   // described by |*this|.  If |t > t_max()|, calls |Prolong(t)| beforehand.
   // Prolongs the ephemeris by at most |max_ephemeris_steps|.
-  // Returns true if and only if |*trajectory| was integrated until |t|.
+  // Returns true if and only if |*trajectory| was integrated until |t|.  If the
+  // ephemeris doesn't need to be prolonged, this function may be called
+  // concurrently for distinct |trajectory|s.  The integration stops early if
+  // |base::AbortRequested()|.
   virtual bool FlowWithAdaptiveStep(
       not_null<DiscreteTrajectory<Frame>*> const trajectory,
       IntrinsicAcceleration intrinsic_acceleration,
@@ -159,6 +224,33 @@ class Ephemeris {
       AdaptiveStepParameters const& parameters,
       std::int64_t const max_ephemeris_steps);
 
+  // Same as above, but integrates several |trajectories| together, each with
+  // its own |parameters| and therefore its own step size control.  The
+  // integrators of the |parameters| must support |SolveInLockstep|.  At each
+  // stage, the evaluations of the trajectories are sorted by time and grouped:
+  // a group holds the evaluations within |time_tolerance| of its earliest one.
+  // The evaluations of a group share the degrees of freedom of the massive
+  // bodies, evaluated at the middle of the group, and their gravitational
+  // accelerations are computed together by the structure-of-arrays kernel,
+  // with the positions of the massive bodies linearly extrapolated to the time
+  // of each evaluation.  The error on these positions is thus of the order of
+  // their acceleration times |(time_tolerance / 2)²/2|.  Evaluations at the
+  // same time are never extrapolated, so if |time_tolerance| is zero the
+  // results are identical to those of |FlowWithAdaptiveStep|.  Step size
+  // control absorbs the error only if it is small compared to the integration
+  // tolerances.  |intrinsic_accelerations| may be empty.  Returns,
+  // for each trajectory, the status of its integration, which is OK if and
+  // only if it was integrated until |t|.  If the integration stopped early
+  // because the ephemeris was not prolonged enough, the status is
+  // |integrators::termination_condition::ReachedMaximalStepCount|.
+  virtual std::vector<Status> FlowWithAdaptiveStepInLockstep(
+      std::vector<not_null<DiscreteTrajectory<Frame>*>> const& trajectories,
+      IntrinsicAccelerations const& intrinsic_accelerations,
+      Instant const& t,
+      std::vector<AdaptiveStepParameters> const& parameters,
+      std::int64_t const max_ephemeris_steps,
+      Time const& time_tolerance);
+
   // Integrates, until at most |t|, the |trajectories| followed by massless
   // bodies in the gravitational potential described by |*this|.  If
   // |t > t_max()|, calls |Prolong(t)| beforehand.
@@ -222,9 +314,30 @@ class Ephemeris {
 
   virtual void WriteToMessage(
       not_null<serialization::Ephemeris*> const message) const;
+  // Same as above, except that the series of the trajectories that end at or
+  // before |after| are not serialized.
+  virtual void WriteToMessage(
+      not_null<serialization::Ephemeris*> const message,
+      Instant const& after) const;
   static not_null<std::unique_ptr<Ephemeris>> ReadFromMessage(
       serialization::Ephemeris const& message);
 
+  // Writes the current state of this ephemeris to the file at |path|.  The
+  // coefficients of the series are stored with a fixed stride so that they may
+  // be memory-mapped by |ReadFromPrecomputedFile|.  The format is not portable
+  // across architectures.
+  void WriteToPrecomputedFile(
+      std::experimental::filesystem::path const& path) const;
+  // Reads an ephemeris written by |WriteToPrecomputedFile|.  The coefficients
+  // are not deserialized; they are evaluated directly from a memory mapping of
+  // the file, so the cost does not depend on the length of the ephemeris.  The
+  // result may be prolonged as usual.  Its serialization only contains the
+  // series up to the first checkpoint that follows the time passed to
+  // |ForgetBefore|.  Returns null, after logging the reason, if the file
+  // cannot be read or is not a valid precomputed ephemeris.
+  static std::unique_ptr<Ephemeris> ReadFromPrecomputedFile(
+      std::experimental::filesystem::path const& path);
+
   // Compatibility method for construction an ephemeris from pre-Bourbaki data.
   static std::unique_ptr<Ephemeris> ReadFromPreBourbakiMessages(
       google::protobuf::RepeatedPtrField<
@@ -242,17 +355,50 @@ class Ephemeris {
   // particular time that we might want to use for compact serialization.
   struct Checkpoint {
     typename NewtonianMotionEquation::SystemState system_state;
+    // The states that preceded |system_state|, see |history_|.
+    std::vector<typename NewtonianMotionEquation::SystemState> history;
     std::vector<typename ContinuousTrajectory<Frame>::Checkpoint> checkpoints;
   };
 
   void AppendMassiveBodiesState(
       typename NewtonianMotionEquation::SystemState const& state);
+  // Same as above, but appends to the |staging_trajectories_|.  Called on the
+  // |prolongation_thread_|.
+  void AppendStagedMassiveBodiesState(
+      typename NewtonianMotionEquation::SystemState const& state);
+  // Appends |state| to |history|, dropping the oldest state if |history| would
+  // otherwise have more states than the |history_length()| of the planetary
+  // integrator.  Doesn't allocate once |history| is full.
+  void AppendToHistory(
+      typename NewtonianMotionEquation::SystemState const& state,
+      std::vector<typename NewtonianMotionEquation::SystemState>& history)
+      const;
   static void AppendMasslessBodiesState(
       typename NewtonianMotionEquation::SystemState const& state,
       std::vector<not_null<DiscreteTrajectory<Frame>*>> const& trajectories);
+  // Appends to |trajectory| points taken from the interpolant of a step of its
+  // integration, strictly inside the step, so that the chords between
+  // consecutive points deviate from the interpolant by at most
+  // |max_chord_deviation|.  Appends nothing if the chord of the step is close
+  // enough.  At most |max_dense_points_per_step| points are appended.
+  static void AppendMasslessBodyDenseOutput(
+      typename NewtonianMotionEquation::DenseOutput const& dense_output,
+      Length const& max_chord_deviation,
+      not_null<DiscreteTrajectory<Frame>*> const trajectory);
 
   Checkpoint GetCheckpoint();
 
+  // Records a checkpoint if we haven't done so for too long.
+  void MaybeAddCheckpoint();
+
+  // The body of the |prolongation_thread_|.
+  void ProlongAsynchronously();
+
+  // Publishes the series of the |staging_trajectories_| to the |trajectories_|
+  // and makes the |last_state_| that of the staging area.  Must be called with
+  // |prolongation_lock_| held.
+  void PublishStagedProlongation();
+
   // Computes the accelerations between one body, |body1| (with index |b1| in
   // the |positions| and |accelerations| arrays) and the bodies |bodies2| (with
   // indices [b2_begin, b2_end[ in the |bodies2|, |positions| and
@@ -272,18 +418,58 @@ class Ephemeris {
       std::vector<Position<Frame>> const& positions,
       std::vector<Vector<Acceleration, Frame>>& accelerations);
 
-  // Computes the accelerations due to one body, |body1| (with index |b1| in the
-  // |bodies_| and |trajectories_| arrays) on massless bodies at the given
-  // |positions|.  The template parameter specifies what we know about the
-  // massive body, and therefore what forces apply.
+  // The coordinates of the positions of, or of the accelerations exerted on,
+  // massless bodies, in SI units, stored in contiguous arrays.
+  struct MasslessBodiesCoordinates {
+    // Sets the size of the arrays to |size|.  Doesn't reallocate if the arrays
+    // already have enough capacity.
+    void Resize(std::size_t size);
+
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> z;
+  };
+
+  // Computes the accelerations due to one body, |body1| (located at
+  // |position1|) on massless bodies at the given |positions|.  The template
+  // parameter specifies what we know about the massive body, and therefore what
+  // forces apply.
   template<bool body1_is_oblate>
   void ComputeGravitationalAccelerationByMassiveBodyOnMasslessBodies(
-      Instant const& t,
       MassiveBody const& body1,
-      size_t const b1,
+      Position<Frame> const& position1,
       std::vector<Position<Frame>> const& positions,
-      std::vector<Vector<Acceleration, Frame>>& accelerations,
-      typename ContinuousTrajectory<Frame>::Hint& hint1) const;
+      std::vector<Vector<Acceleration, Frame>>& accelerations) const;
+
+  // Adds to |acceleration| the acceleration due to |body1| (located at
+  // |position1|) on a massless body at |position2|.  Used by the function above
+  // for each massless body.
+  template<bool body1_is_oblate>
+  static void ComputeGravitationalAccelerationByMassiveBodyOnMasslessBody(
+      MassiveBody const& body1,
+      Position<Frame> const& position1,
+      Position<Frame> const& position2,
+      Vector<Acceleration, Frame>& acceleration);
+
+  // Same as above, but the positions of the massless bodies and the
+  // accelerations exerted on them are given as structures of arrays of SI
+  // coordinates, which lets the computation use SIMD instructions.  The results
+  // are bit-for-bit identical to those of the function above.
+  template<bool body1_is_oblate>
+  void ComputeGravitationalAccelerationByMassiveBodyOnMasslessBodies(
+      MassiveBody const& body1,
+      Position<Frame> const& position1,
+      MasslessBodiesCoordinates const& positions,
+      MasslessBodiesCoordinates& accelerations) const;
+
+  // Computes the accelerations between the bodies of |bodies_| with indices in
+  // [b1_begin, b1_end[ and all the bodies that follow them in |bodies_|.  The
+  // accelerations are added to |accelerations|.
+  void ComputeGravitationalAccelerationsBetweenMassiveBodies(
+      std::size_t const b1_begin,
+      std::size_t const b1_end,
+      std::vector<Position<Frame>> const& positions,
+      std::vector<Vector<Acceleration, Frame>>& accelerations) const;
 
   // Computes the accelerations between all the massive bodies in |bodies_|.
   void ComputeMassiveBodiesGravitationalAccelerations(
@@ -291,16 +477,93 @@ class Ephemeris {
       std::vector<Position<Frame>> const& positions,
       std::vector<Vector<Acceleration, Frame>>& accelerations) const;
 
+  // The state that a flow keeps from one computation of the accelerations of
+  // its massless bodies to the next.  Each flow owns its workspace and uses it
+  // on a single thread, so no lock is needed, and a workspace only lives as
+  // long as its flow, so it never outlives a change of the trajectories.
+  struct MasslessBodiesWorkspace {
+    // The positions of the bodies of |bodies_|, indexed like |bodies_|, at the
+    // last time where the flow evaluated them, together with the hint used to
+    // evaluate them.
+    typename ContinuousTrajectory<Frame>::BatchHint hint;
+    std::experimental::optional<Instant> time;
+    std::vector<Position<Frame>> positions;
+    // Scratch buffers for the structure-of-arrays computation, reused from one
+    // call to the next so that the right-hand side doesn't allocate.
+    MasslessBodiesCoordinates positions_coordinates;
+    MasslessBodiesCoordinates accelerations_coordinates;
+    // Scratch buffers for the grouping of the evaluations of an integration in
+    // lockstep.
+    std::vector<int> evaluation_order;
+    std::vector<Position<Frame>> group_positions;
+    std::vector<Time> group_time_offsets;
+    std::vector<Vector<Acceleration, Frame>> group_accelerations;
+    // The velocities of the bodies of |bodies_| at the middle of the last group
+    // spanning several times, and the hints used to evaluate them.
+    std::vector<typename ContinuousTrajectory<Frame>::Hint> velocity_hints;
+    std::vector<Velocity<Frame>> velocities;
+    MasslessBodiesCoordinates extrapolated_positions_coordinates;
+  };
+
+  // A bounded cache of the positions of the bodies of |bodies_|, indexed like
+  // |bodies_|, at the times where the accelerations on massless bodies were
+  // most recently computed.  The integrators evaluate the accelerations at the
+  // same stage times for all the trajectories flowed with the same parameters,
+  // so repeated flows don't need to evaluate the continuous trajectories again.
+  // The cache is shared by all the flows and is thread-safe.
+  class CelestialPositionsCache {
+   public:
+    // If the cache has an entry for |t|, sets |positions| to it and returns
+    // true.  Otherwise returns false and sets |generation| to the value to pass
+    // to |Insert|.
+    bool Find(Instant const& t,
+              std::vector<Position<Frame>>& positions,
+              std::int64_t& generation);
+
+    // Adds an entry for |t|, evicting the least recently used entry if the
+    // cache is full.  Does nothing if the cache was cleared since the call to
+    // |Find| that returned |generation|, since the |positions| may then be
+    // stale.
+    void Insert(Instant const& t,
+                std::vector<Position<Frame>> const& positions,
+                std::int64_t generation);
+
+    // Empties the cache.  Must be called whenever the trajectories of the
+    // bodies change.
+    void Clear();
+
+    CelestialPositionsCacheStatistics statistics() const;
+
+   private:
+    using Entry = std::pair<Instant, std::vector<Position<Frame>>>;
+
+    mutable std::mutex lock_;
+    // Ordered from the most recently used to the least recently used entry.
+    std::list<Entry> entries_;
+    std::map<Instant, typename std::list<Entry>::iterator> index_;
+    // Incremented by |Clear|.
+    std::int64_t generation_ = 0;
+    CelestialPositionsCacheStatistics statistics_;
+  };
+
+  // Returns the positions of the bodies of |bodies_| at time |t|.  The
+  // positions held by the |workspace| are reused if they were evaluated at
+  // |t|, otherwise they are taken from the |celestial_positions_cache_| or
+  // evaluated, and stored in the |workspace|.
+  std::vector<Position<Frame>> const& EvaluateCelestialPositions(
+      Instant const& t,
+      MasslessBodiesWorkspace& workspace) const;
+
   // Computes the acceleration exerted by the massive bodies in |bodies_| on
   // massless bodies.  The massless bodies are at the given |positions|.  The
-  // |hints| are passed to
-  // ComputeGravitationalAccelerationByMassiveBodyOnMasslessBody for efficient
-  // computation of the positions of the massive bodies.
+  // |workspace| is passed to |EvaluateCelestialPositions| for efficient
+  // computation of the positions of the massive bodies, and holds the buffers
+  // of the computation.
   void ComputeMasslessBodiesGravitationalAccelerations(
       Instant const& t,
       std::vector<Position<Frame>> const& positions,
       std::vector<Vector<Acceleration, Frame>>& accelerations,
-      std::vector<typename ContinuousTrajectory<Frame>::Hint>& hints) const;
+      MasslessBodiesWorkspace& workspace) const;
 
   // Same as above, but the massless bodies have intrinsic accelerations.
   // |intrinsic_accelerations| may be empty.
@@ -309,7 +572,38 @@ class Ephemeris {
       Instant const& t,
       std::vector<Position<Frame>> const& positions,
       std::vector<Vector<Acceleration, Frame>>& accelerations,
-      std::vector<typename ContinuousTrajectory<Frame>::Hint>& hints) const;
+      MasslessBodiesWorkspace& workspace) const;
+
+  // Same as above for a single massless body at |position|, whose
+  // |intrinsic_acceleration| may be null.  Returns the total acceleration.
+  // Used by |FlowWithAdaptiveStep|, where it is inlined in the integrator.
+  Vector<Acceleration, Frame> ComputeMasslessBodyTotalAcceleration(
+      IntrinsicAcceleration const& intrinsic_acceleration,
+      Instant const& t,
+      Position<Frame> const& position,
+      MasslessBodiesWorkspace& workspace) const;
+
+  // Same as |ComputeMasslessBodiesGravitationalAccelerations|, but each
+  // massless body has its own time, |t| plus the corresponding entry of
+  // |time_offsets|.  The positions of the massive bodies at that time are
+  // linearly extrapolated from their degrees of freedom at |t|.
+  void ComputeMasslessBodiesGravitationalAccelerationsWithTimeOffsets(
+      Instant const& t,
+      std::vector<Position<Frame>> const& positions,
+      std::vector<Time> const& time_offsets,
+      std::vector<Vector<Acceleration, Frame>>& accelerations,
+      MasslessBodiesWorkspace& workspace) const;
+
+  // Same as |ComputeMasslessBodiesTotalAccelerations|, for the |evaluations|
+  // of several systems of massless bodies integrated in lockstep, grouped as
+  // described in |FlowWithAdaptiveStepInLockstep|.  |intrinsic_accelerations|
+  // is indexed by the |system| of the evaluations and may be empty.
+  void ComputeMasslessBodiesTotalAccelerationsInLockstep(
+      std::vector<IntrinsicAcceleration> const& intrinsic_accelerations,
+      Time const& time_tolerance,
+      std::vector<typename NewtonianMotionEquation::RightHandSideEvaluation>
+          const& evaluations,
+      MasslessBodiesWorkspace& workspace) const;
 
   // Computes an estimate of the ratio |tolerance / error|.
   static double ToleranceToErrorRatio(
@@ -338,17 +632,64 @@ class Ephemeris {
   FixedStepParameters const parameters_;
   Length const fitting_tolerance_;
   typename NewtonianMotionEquation::SystemState last_state_;
+  // The last states of the integration that preceded |last_state_|, in
+  // chronological order.  They let a multistep integrator resume the
+  // integration without a startup, after deserialization or after an
+  // asynchronous prolongation.
+  std::vector<typename NewtonianMotionEquation::SystemState> history_;
+  // The instance used by |Prolong| to integrate the massive bodies from
+  // |last_state_|.  It is kept across calls so that a multistep integrator
+  // keeps its previous steps, and it is reset whenever |last_state_| is set by
+  // other means.  Null if |Prolong| hasn't integrated yet.
+  std::unique_ptr<IntegrationInstance> instance_;
 
   // These are the states other that the last which we preserve in order to
   // implement compact serialization.  The vector is time-ordered.
   std::vector<Checkpoint> checkpoints_;
+  // True if this ephemeris was read from a precomputed file.  Its trajectories
+  // then extend far beyond its first checkpoint, and its serialization must not
+  // cause the reader to integrate that far.
+  bool is_precomputed_ = false;
 
   int number_of_oblate_bodies_ = 0;
   int number_of_spherical_bodies_ = 0;
 
+  // The boundaries of the ranges of |b1| indices which are processed by a
+  // single task when the accelerations between the massive bodies are computed
+  // in parallel.  The ranges have roughly the same number of pairs of bodies.
+  std::vector<std::size_t> massive_bodies_partitions_;
+  // The threads are started once by |set_massive_bodies_acceleration_workers|
+  // and reused for each evaluation of the right-hand side.  Null if the
+  // accelerations are computed on the calling thread.
+  std::unique_ptr<ThreadPool<void>> massive_bodies_acceleration_pool_;
+
   NewtonianMotionEquation massive_bodies_equation_;
 
+  mutable CelestialPositionsCache celestial_positions_cache_;
+
   Status last_severe_integration_status_;
+
+  // The state of the asynchronous prolongation.  The thread that owns this
+  // object only reads the |staging_trajectories_|, which are indexed like
+  // |trajectories_|, and the |staging_state_| when publishing them.  The
+  // |prolongation_thread_| never touches the |trajectories_|.  Everything but
+  // the thread is guarded by |prolongation_lock_|.
+  std::mutex prolongation_lock_;
+  // Notified when the |prolongation_target_| or the |staged_t_max_| change, or
+  // when the thread must stop.
+  std::condition_variable prolongation_changed_;
+  std::thread prolongation_thread_;
+  bool stop_prolongation_ = false;
+  Time prolongation_horizon_;
+  Instant prolongation_target_;
+  std::vector<not_null<std::unique_ptr<ContinuousTrajectory<Frame>>>>
+      staging_trajectories_;
+  typename NewtonianMotionEquation::SystemState staging_state_;
+  std::vector<typename NewtonianMotionEquation::SystemState> staging_history_;
+  // The time up to which the series computed by the |prolongation_thread_| go,
+  // whether or not they have been published.
+  Instant staged_t_max_;
+  Status staging_status_;
 };
 
 }  // namespace internal_ephemeris
@@ -4,15 +4,28 @@
 #include "physics/ephemeris.hpp"
 
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
 #include <functional>
+#include <future>
+#include <iterator>
 #include <limits>
+#include <list>
+#include <map>
+#include <mutex>
+#include <numeric>
 #include <set>
+#include <string>
 #include <vector>
 
 #include "astronomy/epoch.hpp"
 #include "base/macros.hpp"
 #include "base/map_util.hpp"
+#include "base/mapped_file.hpp"
 #include "base/not_null.hpp"
+#include "base/thread_pool.hpp"
 #include "geometry/grassmann.hpp"
 #include "geometry/r3_element.hpp"
 #include "numerics/hermite3.hpp"
@@ -22,6 +35,10 @@
 #include "quantities/quantities.hpp"
 #include "quantities/si.hpp"
 
+#if PRINCIPIA_USE_SSE2 || PRINCIPIA_USE_AVX
+#include <immintrin.h>
+#endif
+
 namespace principia {
 namespace physics {
 namespace internal_ephemeris {
@@ -29,19 +46,24 @@ namespace internal_ephemeris {
 using astronomy::J2000;
 using base::FindOrDie;
 using base::make_not_null_unique;
+using base::MappedFile;
+using base::StatusOr;
 using geometry::Displacement;
 using geometry::InnerProduct;
 using geometry::Position;
 using geometry::R3Element;
 using geometry::Velocity;
 using integrators::AdaptiveStepSize;
-using integrators::IntegrationInstance;
+using integrators::DormandElMikkawyPrince1986RKN434FM;
 using integrators::IntegrationProblem;
 using numerics::Bisect;
 using numerics::Hermite3;
 using quantities::Abs;
 using quantities::Exponentiation;
 using quantities::GravitationalParameter;
+using quantities::IsFinite;
+using quantities::Order2ZonalCoefficient;
+using quantities::SIUnit;
 using quantities::Quotient;
 using quantities::Square;
 using quantities::Time;
@@ -53,6 +75,36 @@ using ::std::placeholders::_3;
 
 Time const max_time_between_checkpoints = 180 * Day;
 
+// Below this number of massless bodies, the accelerations are computed on
+// |Quantity| objects rather than on structures of arrays.
+std::size_t const min_massless_bodies_for_coordinates = 4;
+
+// The number of tasks among which the pairs of massive bodies are distributed
+// when their accelerations are computed in parallel.
+int const massive_bodies_acceleration_partitions = 16;
+
+// The maximum number of times for which the positions of the massive bodies are
+// cached.  This covers the stages of a few steps of the integrators that we
+// use.
+std::size_t const celestial_positions_cache_size = 64;
+
+// The maximum number of points taken from the dense output that are added
+// inside a step of the integration of a massless body, so that an extremely
+// long step doesn't result in a huge trajectory.
+int const max_dense_points_per_step = 64;
+
+// The header of a precomputed file.  It is followed by the series of the
+// trajectories (see |ContinuousTrajectory::WriteToPrecomputedFile|) and by a
+// |serialization::Ephemeris| message holding the rest of the state.
+struct PrecomputedFileHeader {
+  char magic[8];
+  std::int64_t message_offset;
+  std::int64_t message_size;
+};
+char const precomputed_file_magic[] = "PrEphem1";
+static_assert(sizeof(PrecomputedFileHeader) % sizeof(double) == 0,
+              "The series would be misaligned");
+
 // If j is a unit vector along the axis of rotation, and r a vector from the
 // center of |body| to some point in space, the acceleration computed here is:
 //
@@ -87,6 +139,228 @@ Order2ZonalAcceleration(OblateBody<Frame> const& body,
   return axis_effect + radial_effect;
 }
 
+// The following functions add to |ax|, |ay|, |az| the accelerations exerted by
+// a massive body at |position1| on the massless bodies at |x|, |y|, |z|.  All
+// the arguments are in SI units.  |axis| and |j2_over_μ| are only used if
+// |body1_is_oblate|.  The floating-point operations are exactly those performed
+// on |Quantity| objects by
+// |Ephemeris::ComputeGravitationalAccelerationByMassiveBodyOnMasslessBodies|
+// and |Order2ZonalAcceleration|, and in the same order, so the results are
+// identical irrespective of the instruction set.
+template<bool body1_is_oblate>
+FORCE_INLINE void AddGravitationalAccelerationByMassiveBodyOnMasslessBody(
+    double const μ1,
+    double const position1[3],
+    double const axis[3],
+    double const j2_over_μ,
+    double const x,
+    double const y,
+    double const z,
+    double& ax,
+    double& ay,
+    double& az) {
+  double const Δq_x = position1[0] - x;
+  double const Δq_y = position1[1] - y;
+  double const Δq_z = position1[2] - z;
+  double const Δq_squared = Δq_x * Δq_x + Δq_y * Δq_y + Δq_z * Δq_z;
+  double const one_over_Δq_cubed =
+      std::sqrt(Δq_squared) / (Δq_squared * Δq_squared);
+  double const μ1_over_Δq_cubed = μ1 * one_over_Δq_cubed;
+  ax += Δq_x * μ1_over_Δq_cubed;
+  ay += Δq_y * μ1_over_Δq_cubed;
+  az += Δq_z * μ1_over_Δq_cubed;
+  if (body1_is_oblate) {
+    double const one_over_Δq_squared = 1 / Δq_squared;
+    double const r_x = -Δq_x;
+    double const r_y = -Δq_y;
+    double const r_z = -Δq_z;
+    double const r_axis_projection =
+        axis[0] * r_x + axis[1] * r_y + axis[2] * r_z;
+    double const j2_over_r_fifth =
+        j2_over_μ * one_over_Δq_cubed * one_over_Δq_squared;
+    double const axis_factor = -3 * j2_over_r_fifth * r_axis_projection;
+    double const radial_factor =
+        j2_over_r_fifth * (-1.5 + 7.5 * r_axis_projection * r_axis_projection *
+                                      one_over_Δq_squared);
+    ax += μ1 * (axis_factor * axis[0] + radial_factor * r_x);
+    ay += μ1 * (axis_factor * axis[1] + radial_factor * r_y);
+    az += μ1 * (axis_factor * axis[2] + radial_factor * r_z);
+  }
+}
+
+template<bool body1_is_oblate>
+void AddGravitationalAccelerationsByMassiveBodyOnMasslessBodies(
+    double const μ1,
+    double const position1[3],
+    double const axis[3],
+    double const j2_over_μ,
+    std::size_t const size,
+    double const* const x,
+    double const* const y,
+    double const* const z,
+    double* const ax,
+    double* const ay,
+    double* const az) {
+  std::size_t i = 0;
+#if PRINCIPIA_USE_AVX
+  {
+    __m256d const μ1_lanes = _mm256_set1_pd(μ1);
+    __m256d const q1_x = _mm256_set1_pd(position1[0]);
+    __m256d const q1_y = _mm256_set1_pd(position1[1]);
+    __m256d const q1_z = _mm256_set1_pd(position1[2]);
+    for (; i + 4 <= size; i += 4) {
+      __m256d const Δq_x = _mm256_sub_pd(q1_x, _mm256_loadu_pd(x + i));
+      __m256d const Δq_y = _mm256_sub_pd(q1_y, _mm256_loadu_pd(y + i));
+      __m256d const Δq_z = _mm256_sub_pd(q1_z, _mm256_loadu_pd(z + i));
+      __m256d const Δq_squared =
+          _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(Δq_x, Δq_x),
+                                      _mm256_mul_pd(Δq_y, Δq_y)),
+                        _mm256_mul_pd(Δq_z, Δq_z));
+      __m256d const one_over_Δq_cubed =
+          _mm256_div_pd(_mm256_sqrt_pd(Δq_squared),
+                        _mm256_mul_pd(Δq_squared, Δq_squared));
+      __m256d const μ1_over_Δq_cubed =
+          _mm256_mul_pd(μ1_lanes, one_over_Δq_cubed);
+      __m256d a_x = _mm256_add_pd(_mm256_loadu_pd(ax + i),
+                                  _mm256_mul_pd(Δq_x, μ1_over_Δq_cubed));
+      __m256d a_y = _mm256_add_pd(_mm256_loadu_pd(ay + i),
+                                  _mm256_mul_pd(Δq_y, μ1_over_Δq_cubed));
+      __m256d a_z = _mm256_add_pd(_mm256_loadu_pd(az + i),
+                                  _mm256_mul_pd(Δq_z, μ1_over_Δq_cubed));
+      if (body1_is_oblate) {
+        __m256d const one_over_Δq_squared =
+            _mm256_div_pd(_mm256_set1_pd(1), Δq_squared);
+        __m256d const sign_bit = _mm256_set1_pd(-0.0);
+        __m256d const r_x = _mm256_xor_pd(Δq_x, sign_bit);
+        __m256d const r_y = _mm256_xor_pd(Δq_y, sign_bit);
+        __m256d const r_z = _mm256_xor_pd(Δq_z, sign_bit);
+        __m256d const axis_x = _mm256_set1_pd(axis[0]);
+        __m256d const axis_y = _mm256_set1_pd(axis[1]);
+        __m256d const axis_z = _mm256_set1_pd(axis[2]);
+        __m256d const r_axis_projection =
+            _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(axis_x, r_x),
+                                        _mm256_mul_pd(axis_y, r_y)),
+                          _mm256_mul_pd(axis_z, r_z));
+        __m256d const j2_over_r_fifth =
+            _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(j2_over_μ),
+                                        one_over_Δq_cubed),
+                          one_over_Δq_squared);
+        __m256d const axis_factor =
+            _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(-3), j2_over_r_fifth),
+                          r_axis_projection);
+        __m256d const radial_factor = _mm256_mul_pd(
+            j2_over_r_fifth,
+            _mm256_add_pd(
+                _mm256_set1_pd(-1.5),
+                _mm256_mul_pd(
+                    _mm256_mul_pd(
+                        _mm256_mul_pd(_mm256_set1_pd(7.5), r_axis_projection),
+                        r_axis_projection),
+                    one_over_Δq_squared)));
+        a_x = _mm256_add_pd(
+            a_x,
+            _mm256_mul_pd(μ1_lanes,
+                          _mm256_add_pd(_mm256_mul_pd(axis_factor, axis_x),
+                                        _mm256_mul_pd(radial_factor, r_x))));
+        a_y = _mm256_add_pd(
+            a_y,
+            _mm256_mul_pd(μ1_lanes,
+                          _mm256_add_pd(_mm256_mul_pd(axis_factor, axis_y),
+                                        _mm256_mul_pd(radial_factor, r_y))));
+        a_z = _mm256_add_pd(
+            a_z,
+            _mm256_mul_pd(μ1_lanes,
+                          _mm256_add_pd(_mm256_mul_pd(axis_factor, axis_z),
+                                        _mm256_mul_pd(radial_factor, r_z))));
+      }
+      _mm256_storeu_pd(ax + i, a_x);
+      _mm256_storeu_pd(ay + i, a_y);
+      _mm256_storeu_pd(az + i, a_z);
+    }
+  }
+#endif
+#if PRINCIPIA_USE_SSE2
+  {
+    __m128d const μ1_lanes = _mm_set1_pd(μ1);
+    __m128d const q1_x = _mm_set1_pd(position1[0]);
+    __m128d const q1_y = _mm_set1_pd(position1[1]);
+    __m128d const q1_z = _mm_set1_pd(position1[2]);
+    for (; i + 2 <= size; i += 2) {
+      __m128d const Δq_x = _mm_sub_pd(q1_x, _mm_loadu_pd(x + i));
+      __m128d const Δq_y = _mm_sub_pd(q1_y, _mm_loadu_pd(y + i));
+      __m128d const Δq_z = _mm_sub_pd(q1_z, _mm_loadu_pd(z + i));
+      __m128d const Δq_squared =
+          _mm_add_pd(_mm_add_pd(_mm_mul_pd(Δq_x, Δq_x),
+                                _mm_mul_pd(Δq_y, Δq_y)),
+                     _mm_mul_pd(Δq_z, Δq_z));
+      __m128d const one_over_Δq_cubed =
+          _mm_div_pd(_mm_sqrt_pd(Δq_squared),
+                     _mm_mul_pd(Δq_squared, Δq_squared));
+      __m128d const μ1_over_Δq_cubed = _mm_mul_pd(μ1_lanes, one_over_Δq_cubed);
+      __m128d a_x = _mm_add_pd(_mm_loadu_pd(ax + i),
+                               _mm_mul_pd(Δq_x, μ1_over_Δq_cubed));
+      __m128d a_y = _mm_add_pd(_mm_loadu_pd(ay + i),
+                               _mm_mul_pd(Δq_y, μ1_over_Δq_cubed));
+      __m128d a_z = _mm_add_pd(_mm_loadu_pd(az + i),
+                               _mm_mul_pd(Δq_z, μ1_over_Δq_cubed));
+      if (body1_is_oblate) {
+        __m128d const one_over_Δq_squared =
+            _mm_div_pd(_mm_set1_pd(1), Δq_squared);
+        __m128d const sign_bit = _mm_set1_pd(-0.0);
+        __m128d const r_x = _mm_xor_pd(Δq_x, sign_bit);
+        __m128d const r_y = _mm_xor_pd(Δq_y, sign_bit);
+        __m128d const r_z = _mm_xor_pd(Δq_z, sign_bit);
+        __m128d const axis_x = _mm_set1_pd(axis[0]);
+        __m128d const axis_y = _mm_set1_pd(axis[1]);
+        __m128d const axis_z = _mm_set1_pd(axis[2]);
+        __m128d const r_axis_projection =
+            _mm_add_pd(_mm_add_pd(_mm_mul_pd(axis_x, r_x),
+                                  _mm_mul_pd(axis_y, r_y)),
+                       _mm_mul_pd(axis_z, r_z));
+        __m128d const j2_over_r_fifth =
+            _mm_mul_pd(_mm_mul_pd(_mm_set1_pd(j2_over_μ), one_over_Δq_cubed),
+                       one_over_Δq_squared);
+        __m128d const axis_factor =
+            _mm_mul_pd(_mm_mul_pd(_mm_set1_pd(-3), j2_over_r_fifth),
+                       r_axis_projection);
+        __m128d const radial_factor = _mm_mul_pd(
+            j2_over_r_fifth,
+            _mm_add_pd(
+                _mm_set1_pd(-1.5),
+                _mm_mul_pd(_mm_mul_pd(_mm_mul_pd(_mm_set1_pd(7.5),
+                                                 r_axis_projection),
+                                      r_axis_projection),
+                           one_over_Δq_squared)));
+        a_x = _mm_add_pd(
+            a_x,
+            _mm_mul_pd(μ1_lanes,
+                       _mm_add_pd(_mm_mul_pd(axis_factor, axis_x),
+                                  _mm_mul_pd(radial_factor, r_x))));
+        a_y = _mm_add_pd(
+            a_y,
+            _mm_mul_pd(μ1_lanes,
+                       _mm_add_pd(_mm_mul_pd(axis_factor, axis_y),
+                                  _mm_mul_pd(radial_factor, r_y))));
+        a_z = _mm_add_pd(
+            a_z,
+            _mm_mul_pd(μ1_lanes,
+                       _mm_add_pd(_mm_mul_pd(axis_factor, axis_z),
+                                  _mm_mul_pd(radial_factor, r_z))));
+      }
+      _mm_storeu_pd(ax + i, a_x);
+      _mm_storeu_pd(ay + i, a_y);
+      _mm_storeu_pd(az + i, a_z);
+    }
+  }
+#endif
+  for (; i < size; ++i) {
+    AddGravitationalAccelerationByMassiveBodyOnMasslessBody<body1_is_oblate>(
+        μ1, position1, axis, j2_over_μ,
+        x[i], y[i], z[i],
+        ax[i], ay[i], az[i]);
+  }
+}
+
 // For mocking purposes.
 template<typename Frame>
 class DummyIntegrator
@@ -115,6 +389,73 @@ class DummyIntegrator
   }
 };
 
+template<typename Frame>
+void Ephemeris<Frame>::MasslessBodiesCoordinates::Resize(
+    std::size_t const size) {
+  x.resize(size);
+  y.resize(size);
+  z.resize(size);
+}
+
+template<typename Frame>
+double
+Ephemeris<Frame>::CelestialPositionsCacheStatistics::hit_rate() const {
+  std::int64_t const lookups = hits + misses;
+  return lookups == 0 ? 0 : static_cast<double>(hits) / lookups;
+}
+
+template<typename Frame>
+bool Ephemeris<Frame>::CelestialPositionsCache::Find(
+    Instant const& t,
+    std::vector<Position<Frame>>& positions,
+    std::int64_t& generation) {
+  std::unique_lock<std::mutex> l(lock_);
+  auto const it = index_.find(t);
+  if (it == index_.end()) {
+    ++statistics_.misses;
+    generation = generation_;
+    return false;
+  }
+  ++statistics_.hits;
+  // Move the entry to the front of the list, it is now the most recently used.
+  entries_.splice(entries_.begin(), entries_, it->second);
+  positions = it->second->second;
+  return true;
+}
+
+template<typename Frame>
+void Ephemeris<Frame>::CelestialPositionsCache::Insert(
+    Instant const& t,
+    std::vector<Position<Frame>> const& positions,
+    std::int64_t const generation) {
+  std::unique_lock<std::mutex> l(lock_);
+  // Another thread may have inserted the same time in the meantime.
+  if (generation != generation_ || index_.count(t) > 0) {
+    return;
+  }
+  if (entries_.size() == celestial_positions_cache_size) {
+    index_.erase(entries_.back().first);
+    entries_.pop_back();
+  }
+  entries_.emplace_front(t, positions);
+  index_.emplace(t, entries_.begin());
+}
+
+template<typename Frame>
+void Ephemeris<Frame>::CelestialPositionsCache::Clear() {
+  std::unique_lock<std::mutex> l(lock_);
+  entries_.clear();
+  index_.clear();
+  ++generation_;
+}
+
+template<typename Frame>
+typename Ephemeris<Frame>::CelestialPositionsCacheStatistics
+Ephemeris<Frame>::CelestialPositionsCache::statistics() const {
+  std::unique_lock<std::mutex> l(lock_);
+  return statistics_;
+}
+
 template<typename Frame>
 Ephemeris<Frame>::AdaptiveStepParameters::AdaptiveStepParameters(
     AdaptiveStepSizeIntegrator<NewtonianMotionEquation> const& integrator,
@@ -124,7 +465,9 @@ Ephemeris<Frame>::AdaptiveStepParameters::AdaptiveStepParameters(
     : integrator_(&integrator),
       max_steps_(max_steps),
       length_integration_tolerance_(length_integration_tolerance),
-      speed_integration_tolerance_(speed_integration_tolerance) {
+      speed_integration_tolerance_(speed_integration_tolerance),
+      max_chord_deviation_(std::numeric_limits<double>::infinity() *
+                           SIUnit<Length>()) {
   CHECK_LT(0, max_steps_);
   CHECK_LT(Length(), length_integration_tolerance_);
   CHECK_LT(Speed(), speed_integration_tolerance_);
@@ -159,6 +502,18 @@ void Ephemeris<Frame>::AdaptiveStepParameters::set_speed_integration_tolerance(
   speed_integration_tolerance_ = speed_integration_tolerance;
 }
 
+template<typename Frame>
+Length Ephemeris<Frame>::AdaptiveStepParameters::max_chord_deviation() const {
+  return max_chord_deviation_;
+}
+
+template<typename Frame>
+void Ephemeris<Frame>::AdaptiveStepParameters::set_max_chord_deviation(
+    Length const& max_chord_deviation) {
+  CHECK_LT(Length(), max_chord_deviation);
+  max_chord_deviation_ = max_chord_deviation;
+}
+
 template<typename Frame>
 void Ephemeris<Frame>::AdaptiveStepParameters::WriteToMessage(
     not_null<serialization::Ephemeris::AdaptiveStepParameters*> const message)
@@ -192,6 +547,13 @@ Ephemeris<Frame>::FixedStepParameters::FixedStepParameters(
   CHECK_LT(Time(), step);
 }
 
+template<typename Frame>
+FixedStepSizeIntegrator<
+    typename Ephemeris<Frame>::NewtonianMotionEquation> const&
+Ephemeris<Frame>::FixedStepParameters::integrator() const {
+  return *integrator_;
+}
+
 template<typename Frame>
 inline Time const& Ephemeris<Frame>::FixedStepParameters::step() const {
   return step_;
@@ -267,11 +629,34 @@ Ephemeris<Frame>::Ephemeris(
     }
   }
 
+  // Body |b1| interacts with the |bodies_.size() - b1 - 1| bodies that follow
+  // it.  Cut the range of |b1| so that each partition has about the same number
+  // of pairs.
+  std::size_t const number_of_bodies = bodies_.size();
+  std::size_t const number_of_pairs =
+      number_of_bodies * (number_of_bodies - 1) / 2;
+  massive_bodies_partitions_.push_back(0);
+  std::size_t pairs_so_far = 0;
+  for (std::size_t b1 = 0; b1 < number_of_bodies; ++b1) {
+    pairs_so_far += number_of_bodies - b1 - 1;
+    std::size_t const partition = massive_bodies_partitions_.size();
+    if (pairs_so_far * massive_bodies_acceleration_partitions >=
+            partition * number_of_pairs ||
+        b1 + 1 == number_of_bodies) {
+      massive_bodies_partitions_.push_back(b1 + 1);
+    }
+  }
+
   massive_bodies_equation_.compute_acceleration =
       std::bind(&Ephemeris::ComputeMassiveBodiesGravitationalAccelerations,
                 this, _1, _2, _3);
 }
 
+template<typename Frame>
+Ephemeris<Frame>::~Ephemeris() {
+  StopAsynchronousProlongation();
+}
+
 template<typename Frame>
 std::vector<not_null<MassiveBody const*>> const&
 Ephemeris<Frame>::bodies() const {
@@ -331,6 +716,25 @@ Status Ephemeris<Frame>::last_severe_integration_status() const {
   return last_severe_integration_status_;
 }
 
+template<typename Frame>
+typename Ephemeris<Frame>::CelestialPositionsCacheStatistics
+Ephemeris<Frame>::celestial_positions_cache_statistics() const {
+  return celestial_positions_cache_.statistics();
+}
+
+template<typename Frame>
+void Ephemeris<Frame>::set_massive_bodies_acceleration_workers(
+    int const workers) {
+  CHECK_LE(0, workers);
+  if (workers == 0) {
+    massive_bodies_acceleration_pool_.reset();
+  } else if (massive_bodies_acceleration_pool_ == nullptr ||
+             massive_bodies_acceleration_pool_->size() != workers) {
+    massive_bodies_acceleration_pool_ =
+        std::make_unique<ThreadPool<void>>(workers);
+  }
+}
+
 template<typename Frame>
 void Ephemeris<Frame>::ForgetBefore(Instant const& t) {
   auto it = std::upper_bound(
@@ -343,6 +747,7 @@ void Ephemeris<Frame>::ForgetBefore(Instant const& t) {
   }
   CHECK_LT(t, it->system_state.time.value);
 
+  celestial_positions_cache_.Clear();
   for (auto& pair : bodies_to_trajectories_) {
     ContinuousTrajectory<Frame>& trajectory = *pair.second;
     trajectory.ForgetBefore(t);
@@ -352,14 +757,39 @@ void Ephemeris<Frame>::ForgetBefore(Instant const& t) {
 
 template<typename Frame>
 void Ephemeris<Frame>::Prolong(Instant const& t) {
-  IntegrationProblem<NewtonianMotionEquation> problem;
-  problem.equation = massive_bodies_equation_;
-  problem.initial_state = &last_state_;
+  if (prolongation_thread_.joinable()) {
+    std::unique_lock<std::mutex> l(prolongation_lock_, std::defer_lock);
+    if (t_max() < t) {
+      l.lock();
+      prolongation_target_ =
+          std::max(prolongation_target_, t + prolongation_horizon_);
+      prolongation_changed_.notify_all();
+      prolongation_changed_.wait(l, [this, &t]() {
+        return staged_t_max_ >= t;
+      });
+    } else if (l.try_lock()) {
+      // We don't need new series, but we may publish those that are ready
+      // without waiting.
+      prolongation_target_ =
+          std::max(prolongation_target_, t + prolongation_horizon_);
+      prolongation_changed_.notify_all();
+    } else {
+      return;
+    }
+    PublishStagedProlongation();
+    return;
+  }
 
-  auto const instance = parameters_.integrator_->NewInstance(
-      problem,
-      std::bind(&Ephemeris::AppendMassiveBodiesState, this, _1),
-      parameters_.step_);
+  if (instance_ == nullptr) {
+    IntegrationProblem<NewtonianMotionEquation> problem;
+    problem.equation = massive_bodies_equation_;
+    problem.initial_state = &last_state_;
+    instance_ = parameters_.integrator_->NewInstance(
+        problem,
+        std::bind(&Ephemeris::AppendMassiveBodiesState, this, _1),
+        parameters_.step_,
+        history_);
+  }
 
   // Note that |t| may be before the last time that we integrated and still
   // after |t_max()|.  In this case we want to make sure that the integrator
@@ -371,18 +801,61 @@ void Ephemeris<Frame>::Prolong(Instant const& t) {
     t_final = t;
   }
 
+  if (t_max() < t) {
+    celestial_positions_cache_.Clear();
+  }
+
   // Perform the integration.  Note that we may have to iterate until |t_max()|
   // actually reaches |t| because the last series may not be fully determined
   // after the first integration.
   while (t_max() < t) {
-    parameters_.integrator_->Solve(t_final, *instance);
-    // Here |problem.initial_state| still points at |last_state_|, which is the
-    // state at the end of the previous call to |Solve|.  It is therefore the
-    // right initial state for the next call to |Solve|, if any.
+    // The state of the |instance_| is |last_state_|, the state at the end of
+    // the previous call to |Solve|.
+    parameters_.integrator_->Solve(t_final, *instance_);
     t_final += parameters_.step_;
   }
 }
 
+template<typename Frame>
+void Ephemeris<Frame>::StartAsynchronousProlongation(Time const& horizon) {
+  if (prolongation_thread_.joinable()) {
+    std::unique_lock<std::mutex> l(prolongation_lock_);
+    prolongation_horizon_ = horizon;
+    return;
+  }
+
+  // No need to lock, the thread doesn't exist yet.
+  staging_trajectories_.clear();
+  for (auto const& trajectory : trajectories_) {
+    staging_trajectories_.push_back(trajectory->MakeStaging());
+  }
+  staging_state_ = last_state_;
+  staging_history_ = history_;
+  staged_t_max_ = t_max();
+  staging_status_ = Status::OK;
+  stop_prolongation_ = false;
+  prolongation_horizon_ = horizon;
+  prolongation_target_ = last_state_.time.value + horizon;
+  prolongation_thread_ = std::thread(&Ephemeris::ProlongAsynchronously, this);
+}
+
+template<typename Frame>
+void Ephemeris<Frame>::StopAsynchronousProlongation() {
+  if (!prolongation_thread_.joinable()) {
+    return;
+  }
+  {
+    std::unique_lock<std::mutex> l(prolongation_lock_);
+    stop_prolongation_ = true;
+    prolongation_changed_.notify_all();
+  }
+  prolongation_thread_.join();
+
+  // The thread is gone, no need to lock.
+  PublishStagedProlongation();
+  staging_trajectories_.clear();
+}
+
 template<typename Frame>
 bool Ephemeris<Frame>::FlowWithAdaptiveStep(
     not_null<DiscreteTrajectory<Frame>*> const trajectory,
@@ -408,15 +881,19 @@ bool Ephemeris<Frame>::FlowWithAdaptiveStep(
                             max_ephemeris_steps * parameters_.step(),
                         trajectory_last_time + parameters_.step()),
                t);
-  Prolong(t_final);
+  // Don't call |Prolong| needlessly: when the ephemeris is long enough, flows
+  // only read it, so they may run concurrently.
+  if (empty() || t_final > t_max()) {
+    Prolong(t_final);
+  }
 
-  std::vector<typename ContinuousTrajectory<Frame>::Hint> hints(bodies_.size());
+  MasslessBodiesWorkspace workspace;
   NewtonianMotionEquation massless_body_equation;
   massless_body_equation.compute_acceleration =
       std::bind(&Ephemeris::ComputeMasslessBodiesTotalAccelerations,
                 this,
                 std::cref(intrinsic_accelerations), _1, _2, _3,
-                std::ref(hints));
+                std::ref(workspace));
 
   typename NewtonianMotionEquation::SystemState initial_state;
   auto const trajectory_last = trajectory->last();
@@ -442,13 +919,42 @@ bool Ephemeris<Frame>::FlowWithAdaptiveStep(
                 _1, _2);
   step_size.max_steps = parameters.max_steps_;
 
+  IntegrationInstance::AppendDenseOutput<NewtonianMotionEquation>
+      append_dense_output;
+  if (IsFinite(parameters.max_chord_deviation_)) {
+    append_dense_output = std::bind(&Ephemeris::AppendMasslessBodyDenseOutput,
+                                    _1,
+                                    std::cref(parameters.max_chord_deviation_),
+                                    trajectory);
+  }
+
   auto const instance = parameters.integrator_->NewInstance(
       problem,
       std::bind(
           &Ephemeris::AppendMasslessBodiesState, _1, std::cref(trajectories)),
+      std::move(append_dense_output),
       step_size);
 
-  auto const status = parameters.integrator_->Solve(t_final, *instance);
+  // The integration of a single body by the integrator that the plugin uses is
+  // specialized, with a right-hand side that is inlined in the stages.
+  Status status;
+  auto const& single_body_integrator =
+      DormandElMikkawyPrince1986RKN434FM<Position<Frame>>();
+  if (&*parameters.integrator_ == &single_body_integrator) {
+    IntrinsicAcceleration const& intrinsic_acceleration =
+        intrinsic_accelerations.front();
+    status = single_body_integrator.SolveSingleBody(
+        t_final,
+        *instance,
+        [this, &intrinsic_acceleration, &workspace](
+            Instant const& t,
+            Position<Frame> const& position) {
+          return ComputeMasslessBodyTotalAcceleration(
+              intrinsic_acceleration, t, position, workspace);
+        });
+  } else {
+    status = parameters.integrator_->Solve(t_final, *instance);
+  }
   // TODO(egg): when we have events in trajectories, we should add a singularity
   // event at the end if the outcome indicates a singularity
   // (|VanishingStepSize|).  We should not have an event on the trajectory if
@@ -457,6 +963,153 @@ bool Ephemeris<Frame>::FlowWithAdaptiveStep(
   return status.ok() && t_final == t;
 }
 
+template<typename Frame>
+std::vector<Status> Ephemeris<Frame>::FlowWithAdaptiveStepInLockstep(
+    std::vector<not_null<DiscreteTrajectory<Frame>*>> const& trajectories,
+    IntrinsicAccelerations const& intrinsic_accelerations,
+    Instant const& t,
+    std::vector<AdaptiveStepParameters> const& parameters,
+    std::int64_t const max_ephemeris_steps,
+    Time const& time_tolerance) {
+  CHECK_EQ(trajectories.size(), parameters.size());
+  CHECK(intrinsic_accelerations.empty() ||
+        intrinsic_accelerations.size() == trajectories.size());
+  CHECK_LE(Time(), time_tolerance);
+  std::vector<Status> statuses(trajectories.size());
+
+  // The indices of the trajectories that need to be integrated, and the times
+  // until which they are integrated, computed as in |FlowWithAdaptiveStep|.
+  std::vector<int> flowed;
+  std::vector<Instant> t_finals(trajectories.size());
+  for (int i = 0; i < trajectories.size(); ++i) {
+    Instant const& trajectory_last_time = trajectories[i]->last().time();
+    if (trajectory_last_time != t) {
+      flowed.push_back(i);
+      t_finals[i] = std::min(std::max(last_state_.time.value +
+                                          max_ephemeris_steps *
+                                              parameters_.step(),
+                                      trajectory_last_time +
+                                          parameters_.step()),
+                             t);
+    }
+  }
+  if (flowed.empty()) {
+    return statuses;
+  }
+  Instant t_final = t_finals[flowed.front()];
+  for (int const i : flowed) {
+    t_final = std::max(t_final, t_finals[i]);
+  }
+  if (empty() || t_final > t_max()) {
+    Prolong(t_final);
+  }
+
+  // Only the trajectories that use the same integrator may be integrated in
+  // lockstep.
+  std::map<AdaptiveStepSizeIntegrator<NewtonianMotionEquation> const*,
+           std::vector<int>> lanes_per_integrator;
+  for (int const i : flowed) {
+    lanes_per_integrator[parameters[i].integrator_].push_back(i);
+  }
+
+  MasslessBodiesWorkspace workspace;
+  for (auto const& pair : lanes_per_integrator) {
+    AdaptiveStepSizeIntegrator<NewtonianMotionEquation> const& integrator =
+        *pair.first;
+    std::vector<int> const& lanes = pair.second;
+
+    // These vectors are sized upfront because the instances hold pointers to
+    // their elements.
+    std::vector<std::vector<not_null<DiscreteTrajectory<Frame>*>>>
+        lane_trajectories;
+    std::vector<typename NewtonianMotionEquation::SystemState> initial_states(
+        lanes.size());
+    lane_trajectories.reserve(lanes.size());
+    // Indexed by the |system| of the evaluations.
+    IntrinsicAccelerations lane_intrinsic_accelerations;
+
+    std::vector<Instant> lane_t_finals;
+    std::vector<not_null<std::unique_ptr<IntegrationInstance>>> instances;
+    std::vector<not_null<IntegrationInstance*>> lane_instances;
+    for (int l = 0; l < lanes.size(); ++l) {
+      int const i = lanes[l];
+      lane_trajectories.push_back({trajectories[i]});
+      lane_intrinsic_accelerations.push_back(
+          intrinsic_accelerations.empty() ? nullptr
+                                          : intrinsic_accelerations[i]);
+
+      auto& initial_state = initial_states[l];
+      auto const trajectory_last = trajectories[i]->last();
+      auto const last_degrees_of_freedom = trajectory_last.degrees_of_freedom();
+      initial_state.time = trajectory_last.time();
+      initial_state.positions.push_back(last_degrees_of_freedom.position());
+      initial_state.velocities.push_back(last_degrees_of_freedom.velocity());
+
+      // The equation is not used by |SolveInLockstep|.
+      IntegrationProblem<NewtonianMotionEquation> problem;
+      problem.initial_state = &initial_state;
+
+      AdaptiveStepSize<NewtonianMotionEquation> step_size;
+      step_size.first_time_step = t_finals[i] - initial_state.time.value;
+      CHECK_GT(step_size.first_time_step, 0 * Second)
+          << "Flow back to the future: " << t_finals[i]
+          << " <= " << initial_state.time.value;
+      step_size.safety_factor = 0.9;
+      step_size.tolerance_to_error_ratio =
+          std::bind(&Ephemeris<Frame>::ToleranceToErrorRatio,
+                    std::cref(parameters[i].length_integration_tolerance_),
+                    std::cref(parameters[i].speed_integration_tolerance_),
+                    _1, _2);
+      step_size.max_steps = parameters[i].max_steps_;
+
+      IntegrationInstance::AppendDenseOutput<NewtonianMotionEquation>
+          append_dense_output;
+      if (IsFinite(parameters[i].max_chord_deviation_)) {
+        append_dense_output =
+            std::bind(&Ephemeris::AppendMasslessBodyDenseOutput,
+                      _1,
+                      std::cref(parameters[i].max_chord_deviation_),
+                      trajectories[i]);
+      }
+
+      instances.push_back(integrator.NewInstance(
+          problem,
+          std::bind(&Ephemeris::AppendMasslessBodiesState,
+                    _1,
+                    std::cref(lane_trajectories.back())),
+          std::move(append_dense_output),
+          step_size));
+      lane_instances.push_back(instances.back().get());
+      lane_t_finals.push_back(t_finals[i]);
+    }
+
+    auto const lane_statuses = integrator.SolveInLockstep(
+        lane_t_finals,
+        lane_instances,
+        std::bind(
+            &Ephemeris::ComputeMasslessBodiesTotalAccelerationsInLockstep,
+            this,
+            std::cref(lane_intrinsic_accelerations),
+            std::cref(time_tolerance),
+            _1,
+            std::ref(workspace)));
+    for (int l = 0; l < lanes.size(); ++l) {
+      int const i = lanes[l];
+      if (lane_statuses[l].ok() && t_finals[i] != t) {
+        statuses[i] = Status(
+            integrators::termination_condition::ReachedMaximalStepCount,
+            "Reached maximum ephemeris step count " +
+                std::to_string(max_ephemeris_steps) + " at time " +
+                DebugString(t_finals[i]) + "; requested t is " +
+                DebugString(t) + ".");
+      } else {
+        statuses[i] = lane_statuses[l];
+      }
+    }
+  }
+  return statuses;
+}
+
 template<typename Frame>
 void Ephemeris<Frame>::FlowWithFixedStep(
     std::vector<not_null<DiscreteTrajectory<Frame>*>> const& trajectories,
@@ -468,13 +1121,13 @@ void Ephemeris<Frame>::FlowWithFixedStep(
     Prolong(t);
   }
 
-  std::vector<typename ContinuousTrajectory<Frame>::Hint> hints(bodies_.size());
+  MasslessBodiesWorkspace workspace;
   NewtonianMotionEquation massless_body_equation;
   massless_body_equation.compute_acceleration =
       std::bind(&Ephemeris::ComputeMasslessBodiesTotalAccelerations,
                 this,
                 std::cref(intrinsic_accelerations), _1, _2, _3,
-                std::ref(hints));
+                std::ref(workspace));
 
   typename NewtonianMotionEquation::SystemState initial_state;
   for (auto const& trajectory : trajectories) {
@@ -523,12 +1176,12 @@ ComputeGravitationalAccelerationOnMasslessBody(
     Position<Frame> const& position,
     Instant const& t) const {
   std::vector<Vector<Acceleration, Frame>> accelerations(1);
-  std::vector<typename ContinuousTrajectory<Frame>::Hint> hints(bodies_.size());
+  MasslessBodiesWorkspace workspace;
   ComputeMasslessBodiesGravitationalAccelerations(
       t,
       {position},
       accelerations,
-      hints);
+      workspace);
 
   return accelerations[0];
 }
@@ -791,6 +1444,13 @@ not_null<MassiveBody const*> Ephemeris<Frame>::body_for_serialization_index(
 template<typename Frame>
 void Ephemeris<Frame>::WriteToMessage(
     not_null<serialization::Ephemeris*> const message) const {
+  WriteToMessage(message, astronomy::InfinitePast);
+}
+
+template<typename Frame>
+void Ephemeris<Frame>::WriteToMessage(
+    not_null<serialization::Ephemeris*> const message,
+    Instant const& after) const {
   LOG(INFO) << __FUNCTION__;
   // The bodies are serialized in the order in which they were given at
   // construction.
@@ -799,21 +1459,41 @@ void Ephemeris<Frame>::WriteToMessage(
   }
   // The trajectories are serialized in the order resulting from the separation
   // between oblate and spherical bodies.
+  std::vector<typename ContinuousTrajectory<Frame>::Checkpoint> checkpoints;
   if (checkpoints_.empty()) {
     for (auto const& trajectory : trajectories_) {
-      trajectory->WriteToMessage(message->add_trajectory());
+      checkpoints.push_back(trajectory->GetCheckpoint());
     }
-    last_state_.WriteToMessage(message->mutable_last_state());
   } else {
-    auto const& checkpoints = checkpoints_.front().checkpoints;
-    CHECK_EQ(trajectories_.size(), checkpoints.size());
-    for (int i = 0; i < trajectories_.size(); ++i) {
-      trajectories_[i]->WriteToMessage(message->add_trajectory(),
-                                       checkpoints[i]);
+    checkpoints = checkpoints_.front().checkpoints;
+  }
+  CHECK_EQ(trajectories_.size(), checkpoints.size());
+
+  for (int i = 0; i < trajectories_.size(); ++i) {
+    trajectories_[i]->WriteToMessage(message->add_trajectory(),
+                                     checkpoints[i],
+                                     after);
+  }
+
+  if (checkpoints_.empty()) {
+    last_state_.WriteToMessage(message->mutable_last_state());
+    for (auto const& state : history_) {
+      state.WriteToMessage(message->add_history());
     }
+  } else {
     checkpoints_.front().system_state.WriteToMessage(
         message->mutable_last_state());
-    t_max().WriteToMessage(message->mutable_t_max());
+    for (auto const& state : checkpoints_.front().history) {
+      state.WriteToMessage(message->add_history());
+    }
+    if (is_precomputed_) {
+      // The reader recomputes the trajectories up to |t_max|, and it doesn't
+      // have the precomputed file.
+      checkpoints_.front().system_state.time.value.WriteToMessage(
+          message->mutable_t_max());
+    } else {
+      t_max().WriteToMessage(message->mutable_t_max());
+    }
   }
   parameters_.WriteToMessage(message->mutable_fixed_step_parameters());
   fitting_tolerance_.WriteToMessage(message->mutable_fitting_tolerance());
@@ -860,6 +1540,10 @@ not_null<std::unique_ptr<Ephemeris<Frame>>> Ephemeris<Frame>::ReadFromMessage(
   ephemeris->last_state_ =
       NewtonianMotionEquation::SystemState::ReadFromMessage(
           message.last_state());
+  for (auto const& state : message.history()) {
+    ephemeris->history_.push_back(
+        NewtonianMotionEquation::SystemState::ReadFromMessage(state));
+  }
   int index = 0;
   ephemeris->bodies_to_trajectories_.clear();
   ephemeris->trajectories_.clear();
@@ -880,6 +1564,162 @@ not_null<std::unique_ptr<Ephemeris<Frame>>> Ephemeris<Frame>::ReadFromMessage(
   return ephemeris;
 }
 
+template<typename Frame>
+void Ephemeris<Frame>::WriteToPrecomputedFile(
+    std::experimental::filesystem::path const& path) const {
+  LOG(INFO) << __FUNCTION__ << " " << path;
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  CHECK(file.good()) << path;
+
+  // The header is filled once we know where the message is.
+  PrecomputedFileHeader header{};
+  std::memcpy(header.magic, precomputed_file_magic, sizeof(header.magic));
+  file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+
+  // This is like |WriteToMessage| for an ephemeris without checkpoints, except
+  // that the series are written to the |file|, in the order of the
+  // trajectories in the message.
+  serialization::Ephemeris message;
+  for (auto const& unowned_body : unowned_bodies_) {
+    unowned_body->WriteToMessage(message.add_body());
+  }
+  for (auto const& trajectory : trajectories_) {
+    trajectory->WriteToPrecomputedFile(message.add_trajectory(), file);
+  }
+  last_state_.WriteToMessage(message.mutable_last_state());
+  for (auto const& state : history_) {
+    state.WriteToMessage(message.add_history());
+  }
+  parameters_.WriteToMessage(message.mutable_fixed_step_parameters());
+  fitting_tolerance_.WriteToMessage(message.mutable_fitting_tolerance());
+  // The checkpoints let the reader serialize the ephemeris up to about the
+  // current time, instead of up to the end of the file.
+  for (auto const& checkpoint : checkpoints_) {
+    auto* const checkpoint_message = message.add_checkpoint();
+    checkpoint.system_state.WriteToMessage(
+        checkpoint_message->mutable_system_state());
+    for (auto const& state : checkpoint.history) {
+      state.WriteToMessage(checkpoint_message->add_history());
+    }
+    for (int i = 0; i < trajectories_.size(); ++i) {
+      trajectories_[i]->WriteCheckpointToMessage(
+          checkpoint.checkpoints[i], checkpoint_message->add_trajectory());
+    }
+  }
+
+  std::string const bytes = message.SerializeAsString();
+  header.message_offset = file.tellp();
+  header.message_size = bytes.size();
+  file.write(bytes.data(), bytes.size());
+  file.seekp(0);
+  file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+  CHECK(file.good()) << path;
+}
+
+template<typename Frame>
+std::unique_ptr<Ephemeris<Frame>> Ephemeris<Frame>::ReadFromPrecomputedFile(
+    std::experimental::filesystem::path const& path) {
+  LOG(INFO) << __FUNCTION__ << " " << path;
+  std::shared_ptr<MappedFile const> const file = MappedFile::Open(path);
+  if (file == nullptr) {
+    return nullptr;
+  }
+  // All the sizes are compared as signed integers, and the comparisons are
+  // written so that a corrupted header cannot cause an overflow.
+  std::int64_t const file_size = file->size();
+  std::int64_t const file_header_size = sizeof(PrecomputedFileHeader);
+  if (file_size < file_header_size) {
+    LOG(WARNING) << path << " is too short for a precomputed ephemeris";
+    return nullptr;
+  }
+  auto const& header =
+      *reinterpret_cast<PrecomputedFileHeader const*>(file->data());
+  if (std::memcmp(header.magic,
+                  precomputed_file_magic,
+                  sizeof(header.magic)) != 0) {
+    LOG(WARNING) << path << " is not a precomputed ephemeris";
+    return nullptr;
+  }
+  if (header.message_offset < file_header_size ||
+      header.message_size < 0 ||
+      header.message_size > std::numeric_limits<int>::max() ||
+      header.message_offset > file_size - header.message_size) {
+    LOG(WARNING) << path << " is truncated or corrupted";
+    return nullptr;
+  }
+
+  serialization::Ephemeris message;
+  if (!message.ParseFromArray(file->data() + header.message_offset,
+                              static_cast<int>(header.message_size)) ||
+      message.has_t_max() ||
+      !message.has_fixed_step_parameters() ||
+      message.trajectory_size() != message.body_size() ||
+      message.last_state().position_size() != message.body_size()) {
+    LOG(WARNING) << path << " has an invalid ephemeris message";
+    return nullptr;
+  }
+  std::unique_ptr<Ephemeris> ephemeris = ReadFromMessage(message);
+
+  // The series follow the header, in the order of the trajectories.
+  std::int64_t offset = file_header_size;
+  for (auto const trajectory : ephemeris->trajectories_) {
+    StatusOr<std::int64_t> const next_offset =
+        trajectory->ReadSeriesFromPrecomputedFile(file, offset);
+    if (!next_offset.ok()) {
+      LOG(WARNING) << path << ": " << next_offset.status();
+      return nullptr;
+    }
+    offset = next_offset.ValueOrDie();
+  }
+  if (offset != header.message_offset) {
+    LOG(WARNING) << path << " has unexpected data after the series";
+    return nullptr;
+  }
+
+  // Restore the checkpoints so that the serialization of the ephemeris may be
+  // truncated near the current time, see |WriteToMessage|.  The last one, at
+  // |t_max()|, lets the ephemeris be forgotten up to there.
+  for (auto const& checkpoint_message : message.checkpoint()) {
+    if (checkpoint_message.trajectory_size() != message.body_size()) {
+      LOG(WARNING) << path << " has an invalid checkpoint";
+      return nullptr;
+    }
+    Checkpoint checkpoint{
+        NewtonianMotionEquation::SystemState::ReadFromMessage(
+            checkpoint_message.system_state()),
+        /*history=*/{},
+        /*checkpoints=*/{}};
+    for (auto const& state : checkpoint_message.history()) {
+      checkpoint.history.push_back(
+          NewtonianMotionEquation::SystemState::ReadFromMessage(state));
+    }
+    for (int i = 0; i < ephemeris->trajectories_.size(); ++i) {
+      auto const trajectory_checkpoint =
+          ephemeris->trajectories_[i]->ReadCheckpointFromMessage(
+              checkpoint_message.trajectory(i));
+      if (!trajectory_checkpoint.ok()) {
+        LOG(WARNING) << path << ": " << trajectory_checkpoint.status();
+        return nullptr;
+      }
+      checkpoint.checkpoints.push_back(trajectory_checkpoint.ValueOrDie());
+    }
+    if (!ephemeris->checkpoints_.empty() &&
+        ephemeris->checkpoints_.back().system_state.time.value >=
+            checkpoint.system_state.time.value) {
+      LOG(WARNING) << path << " has out-of-order checkpoints";
+      return nullptr;
+    }
+    ephemeris->checkpoints_.push_back(std::move(checkpoint));
+  }
+  if (ephemeris->checkpoints_.empty() ||
+      ephemeris->checkpoints_.back().system_state.time.value <
+          ephemeris->last_state_.time.value) {
+    ephemeris->checkpoints_.push_back(ephemeris->GetCheckpoint());
+  }
+  ephemeris->is_precomputed_ = true;
+  return ephemeris;
+}
+
 template<typename Frame>
 std::unique_ptr<Ephemeris<Frame>> Ephemeris<Frame>::ReadFromPreBourbakiMessages(
     google::protobuf::RepeatedPtrField<
@@ -975,6 +1815,7 @@ Ephemeris<Frame>::Ephemeris()
 template<typename Frame>
 void Ephemeris<Frame>::AppendMassiveBodiesState(
     typename NewtonianMotionEquation::SystemState const& state) {
+  AppendToHistory(last_state_, history_);
   last_state_ = state;
   int index = 0;
   for (int i = 0; i < trajectories_.size(); ++i) {
@@ -996,14 +1837,57 @@ void Ephemeris<Frame>::AppendMassiveBodiesState(
     ++index;
   }
 
-  // Record an intermediate state if we haven't done so for too long.
-  CHECK(!trajectories_.empty());
-  Instant const t_last_intermediate_state =
-      checkpoints_.empty()
-          ? astronomy::InfinitePast
-          : checkpoints_.back().system_state.time.value;
-  if (t_max() - t_last_intermediate_state > max_time_between_checkpoints) {
-    checkpoints_.push_back(GetCheckpoint());
+  MaybeAddCheckpoint();
+}
+
+template<typename Frame>
+void Ephemeris<Frame>::AppendStagedMassiveBodiesState(
+    typename NewtonianMotionEquation::SystemState const& state) {
+  std::unique_lock<std::mutex> l(prolongation_lock_);
+  AppendToHistory(staging_state_, staging_history_);
+  staging_state_ = state;
+  Instant staged_t_max = astronomy::InfiniteFuture;
+  for (int i = 0; i < staging_trajectories_.size(); ++i) {
+    auto const& trajectory = staging_trajectories_[i];
+    auto const status = trajectory->Append(
+        state.time.value,
+        DegreesOfFreedom<Frame>(state.positions[i].value,
+                                state.velocities[i].value));
+
+    // Handle the apocalypse.
+    if (!status.ok()) {
+      staging_status_ =
+          Status(status.error(),
+                 "Error extending trajectory for " + bodies_[i]->name() + ". " +
+                     status.message());
+      LOG(ERROR) << "New Apocalypse: " << staging_status_;
+    }
+
+    staged_t_max = std::min(staged_t_max, trajectory->t_max());
+  }
+
+  // The staging trajectories have no series right after a publication.
+  if (staged_t_max > staged_t_max_) {
+    staged_t_max_ = staged_t_max;
+    prolongation_changed_.notify_all();
+  }
+}
+
+template<typename Frame>
+void Ephemeris<Frame>::AppendToHistory(
+    typename NewtonianMotionEquation::SystemState const& state,
+    std::vector<typename NewtonianMotionEquation::SystemState>& history)
+    const {
+  int const history_length = parameters_.integrator_->history_length();
+  if (history_length == 0) {
+    return;
+  }
+  if (history.size() < history_length) {
+    history.push_back(state);
+  } else {
+    // Reuse the storage of the oldest state.
+    std::rotate(history.begin(), history.begin() + 1, history.end());
+    history.back() = state;
   }
 }
 
@@ -1021,13 +1905,110 @@ void Ephemeris<Frame>::AppendMasslessBodiesState(
   }
 }
 
+template<typename Frame>
+void Ephemeris<Frame>::AppendMasslessBodyDenseOutput(
+    typename NewtonianMotionEquation::DenseOutput const& dense_output,
+    Length const& max_chord_deviation,
+    not_null<DiscreteTrajectory<Frame>*> const trajectory) {
+  Instant const& t0 = dense_output.first_time();
+  Instant const t1 = dense_output.last_time();
+  Position<Frame> const q0 = dense_output.EvaluatePosition(t0, 0);
+  Position<Frame> const q1 = dense_output.EvaluatePosition(t1, 0);
+  Instant const t_middle = t0 + 0.5 * (t1 - t0);
+  Length const deviation =
+      (Barycentre<Position<Frame>, double>({q0, q1}, {1, 1}) -
+       dense_output.EvaluatePosition(t_middle, 0)).Norm();
+  if (deviation <= max_chord_deviation) {
+    return;
+  }
+  // The deviation of a chord is O(h²), so splitting the step in |intervals|
+  // divides it by |intervals²|.
+  int const intervals = std::min(
+      max_dense_points_per_step + 1,
+      static_cast<int>(std::ceil(Sqrt(deviation / max_chord_deviation))));
+  for (int i = 1; i < intervals; ++i) {
+    Instant const t = t0 + (t1 - t0) * i / intervals;
+    trajectory->Append(t,
+                       DegreesOfFreedom<Frame>(
+                           dense_output.EvaluatePosition(t, 0),
+                           dense_output.EvaluateVelocity(t, 0)));
+  }
+}
+
 template<typename Frame>
 typename Ephemeris<Frame>::Checkpoint Ephemeris<Frame>::GetCheckpoint() {
   std::vector<typename ContinuousTrajectory<Frame>::Checkpoint> checkpoints;
   for (auto const& trajectory : trajectories_) {
     checkpoints.push_back(trajectory->GetCheckpoint());
   }
-  return Checkpoint({last_state_, checkpoints});
+  return Checkpoint({last_state_, history_, checkpoints});
+}
+
+template<typename Frame>
+void Ephemeris<Frame>::MaybeAddCheckpoint() {
+  // Record an intermediate state if we haven't done so for too long.
+  CHECK(!trajectories_.empty());
+  Instant const t_last_intermediate_state =
+      checkpoints_.empty()
+          ? astronomy::InfinitePast
+          : checkpoints_.back().system_state.time.value;
+  if (t_max() - t_last_intermediate_state > max_time_between_checkpoints) {
+    checkpoints_.push_back(GetCheckpoint());
+  }
+}
+
+template<typename Frame>
+void Ephemeris<Frame>::ProlongAsynchronously() {
+  // The |staging_state_| is only written by this thread, so it may be read
+  // without locking.
+  IntegrationProblem<NewtonianMotionEquation> problem;
+  problem.equation = massive_bodies_equation_;
+  problem.initial_state = &staging_state_;
+
+  auto const instance = parameters_.integrator_->NewInstance(
+      problem,
+      std::bind(&Ephemeris::AppendStagedMassiveBodiesState, this, _1),
+      parameters_.step_,
+      staging_history_);
+
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> l(prolongation_lock_);
+      prolongation_changed_.wait(l, [this]() {
+        return stop_prolongation_ || staged_t_max_ < prolongation_target_;
+      });
+      if (stop_prolongation_) {
+        return;
+      }
+    }
+    // Integrate a single step, so that a request to stop is honoured at the
+    // next step.  The fixed-step integrators don't go beyond |t_final| and have
+    // no way to be interrupted by their |append_state|, which is why we don't
+    // check |stop_prolongation_| there.  Aiming for one step and a half does
+    // exactly one step irrespective of the rounding of the times.
+    parameters_.integrator_->Solve(
+        staging_state_.time.value + 1.5 * parameters_.step_,
+        *instance);
+  }
+}
+
+template<typename Frame>
+void Ephemeris<Frame>::PublishStagedProlongation() {
+  if (staging_state_.time.value == last_state_.time.value) {
+    return;
+  }
+  celestial_positions_cache_.Clear();
+  for (int i = 0; i < trajectories_.size(); ++i) {
+    trajectories_[i]->Publish(staging_trajectories_[i].get());
+  }
+  last_state_ = staging_state_;
+  history_ = staging_history_;
+  // The |instance_| is behind the |last_state_|.
+  instance_.reset();
+  if (!staging_status_.ok()) {
+    last_severe_integration_status_ = staging_status_;
+  }
+  MaybeAddCheckpoint();
 }
 
 template<typename Frame>
@@ -1103,52 +2084,96 @@ template<typename Frame>
 template<bool body1_is_oblate>
 void Ephemeris<Frame>::
 ComputeGravitationalAccelerationByMassiveBodyOnMasslessBodies(
-    Instant const& t,
     MassiveBody const& body1,
-    size_t const b1,
+    Position<Frame> const& position1,
     std::vector<Position<Frame>> const& positions,
-    std::vector<Vector<Acceleration, Frame>>& accelerations,
-    typename ContinuousTrajectory<Frame>::Hint& hint1) const {
-  GravitationalParameter const& μ1 = body1.gravitational_parameter();
-  Position<Frame> const position1 =
-      trajectories_[b1]->EvaluatePosition(t, &hint1);
-
+    std::vector<Vector<Acceleration, Frame>>& accelerations) const {
   for (size_t b2 = 0; b2 < positions.size(); ++b2) {
-    // A vector from the center of |b2| to the center of |b1|.
-    Displacement<Frame> const Δq = position1 - positions[b2];
+    ComputeGravitationalAccelerationByMassiveBodyOnMasslessBody<
+        body1_is_oblate>(body1, position1, positions[b2], accelerations[b2]);
+  }
+}
 
-    Square<Length> const Δq_squared = InnerProduct(Δq, Δq);
-    // NOTE(phl): Don't try to compute one_over_Δq_squared here, it makes the
-    // non-oblate path slower.
-    Exponentiation<Length, -3> const one_over_Δq_cubed =
-        Sqrt(Δq_squared) / (Δq_squared * Δq_squared);
+template<typename Frame>
+template<bool body1_is_oblate>
+FORCE_INLINE void Ephemeris<Frame>::
+ComputeGravitationalAccelerationByMassiveBodyOnMasslessBody(
+    MassiveBody const& body1,
+    Position<Frame> const& position1,
+    Position<Frame> const& position2,
+    Vector<Acceleration, Frame>& acceleration) {
+  GravitationalParameter const& μ1 = body1.gravitational_parameter();
 
-    auto const μ1_over_Δq_cubed = μ1 * one_over_Δq_cubed;
-    accelerations[b2] += Δq * μ1_over_Δq_cubed;
+  // A vector from the center of |b2| to the center of |b1|.
+  Displacement<Frame> const Δq = position1 - position2;
+
+  Square<Length> const Δq_squared = InnerProduct(Δq, Δq);
+  // NOTE(phl): Don't try to compute one_over_Δq_squared here, it makes the
+  // non-oblate path slower.
+  Exponentiation<Length, -3> const one_over_Δq_cubed =
+      Sqrt(Δq_squared) / (Δq_squared * Δq_squared);
+
+  auto const μ1_over_Δq_cubed = μ1 * one_over_Δq_cubed;
+  acceleration += Δq * μ1_over_Δq_cubed;
+
+  if (body1_is_oblate) {
+    Exponentiation<Length, -2> const one_over_Δq_squared = 1 / Δq_squared;
+    Vector<Quotient<Acceleration,
+                    GravitationalParameter>, Frame> const
+        order_2_zonal_effect1 =
+            Order2ZonalAcceleration<Frame>(
+                static_cast<OblateBody<Frame> const &>(body1),
+                -Δq,
+                one_over_Δq_squared,
+                one_over_Δq_cubed);
+    acceleration += μ1 * order_2_zonal_effect1;
+  }
+}
 
-    if (body1_is_oblate) {
-      Exponentiation<Length, -2> const one_over_Δq_squared = 1 / Δq_squared;
-      Vector<Quotient<Acceleration,
-                      GravitationalParameter>, Frame> const
-          order_2_zonal_effect1 =
-              Order2ZonalAcceleration<Frame>(
-                  static_cast<OblateBody<Frame> const &>(body1),
-                  -Δq,
-                  one_over_Δq_squared,
-                  one_over_Δq_cubed);
-      accelerations[b2] += μ1 * order_2_zonal_effect1;
-    }
+template<typename Frame>
+template<bool body1_is_oblate>
+void Ephemeris<Frame>::
+ComputeGravitationalAccelerationByMassiveBodyOnMasslessBodies(
+    MassiveBody const& body1,
+    Position<Frame> const& position1,
+    MasslessBodiesCoordinates const& positions,
+    MasslessBodiesCoordinates& accelerations) const {
+  R3Element<Length> const coordinates1 = (position1 - Frame::origin).
+                                              coordinates();
+  double const position1_coordinates[3] = {coordinates1.x / SIUnit<Length>(),
+                                           coordinates1.y / SIUnit<Length>(),
+                                           coordinates1.z / SIUnit<Length>()};
+  double axis_coordinates[3] = {0, 0, 0};
+  double j2_over_μ = 0;
+  if (body1_is_oblate) {
+    auto const& oblate_body1 = static_cast<OblateBody<Frame> const&>(body1);
+    R3Element<double> const& axis = oblate_body1.polar_axis().coordinates();
+    axis_coordinates[0] = axis.x;
+    axis_coordinates[1] = axis.y;
+    axis_coordinates[2] = axis.z;
+    j2_over_μ = oblate_body1.j2_over_μ() /
+                SIUnit<Quotient<Order2ZonalCoefficient,
+                                GravitationalParameter>>();
   }
+  AddGravitationalAccelerationsByMassiveBodyOnMasslessBodies<body1_is_oblate>(
+      body1.gravitational_parameter() / SIUnit<GravitationalParameter>(),
+      position1_coordinates,
+      axis_coordinates,
+      j2_over_μ,
+      positions.x.size(),
+      positions.x.data(), positions.y.data(), positions.z.data(),
+      accelerations.x.data(), accelerations.y.data(), accelerations.z.data());
 }
 
 template<typename Frame>
-void Ephemeris<Frame>::ComputeMassiveBodiesGravitationalAccelerations(
-    Instant const& t,
+void Ephemeris<Frame>::ComputeGravitationalAccelerationsBetweenMassiveBodies(
+    std::size_t const b1_begin,
+    std::size_t const b1_end,
     std::vector<Position<Frame>> const& positions,
     std::vector<Vector<Acceleration, Frame>>& accelerations) const {
-  accelerations.assign(accelerations.size(), Vector<Acceleration, Frame>());
-
-  for (std::size_t b1 = 0; b1 < number_of_oblate_bodies_; ++b1) {
+  std::size_t const oblate_end =
+      std::min<std::size_t>(b1_end, number_of_oblate_bodies_);
+  for (std::size_t b1 = b1_begin; b1 < oblate_end; ++b1) {
     MassiveBody const& body1 = *bodies_[b1];
     ComputeGravitationalAccelerationByMassiveBodyOnMassiveBodies<
         /*body1_is_oblate=*/true,
@@ -1169,9 +2194,9 @@ void Ephemeris<Frame>::ComputeMassiveBodiesGravitationalAccelerations(
         positions,
         accelerations);
   }
-  for (std::size_t b1 = number_of_oblate_bodies_;
-       b1 < number_of_oblate_bodies_ +
-            number_of_spherical_bodies_;
+  for (std::size_t b1 = std::max<std::size_t>(b1_begin,
+                                               number_of_oblate_bodies_);
+       b1 < b1_end;
        ++b1) {
     MassiveBody const& body1 = *bodies_[b1];
     ComputeGravitationalAccelerationByMassiveBodyOnMassiveBodies<
@@ -1186,24 +2211,135 @@ void Ephemeris<Frame>::ComputeMassiveBodiesGravitationalAccelerations(
   }
 }
 
+template<typename Frame>
+void Ephemeris<Frame>::ComputeMassiveBodiesGravitationalAccelerations(
+    Instant const& t,
+    std::vector<Position<Frame>> const& positions,
+    std::vector<Vector<Acceleration, Frame>>& accelerations) const {
+  accelerations.assign(accelerations.size(), Vector<Acceleration, Frame>());
+
+  if (massive_bodies_acceleration_pool_ == nullptr) {
+    ComputeGravitationalAccelerationsBetweenMassiveBodies(
+        /*b1_begin=*/0, /*b1_end=*/bodies_.size(), positions, accelerations);
+    return;
+  }
+
+  // Each partition accumulates in its own vector, and the partial results are
+  // added in the order of the partitions, so that the result doesn't depend on
+  // the scheduling of the tasks.
+  int const partitions = massive_bodies_partitions_.size() - 1;
+  std::vector<std::vector<Vector<Acceleration, Frame>>> partial_accelerations(
+      partitions,
+      std::vector<Vector<Acceleration, Frame>>(accelerations.size()));
+  std::vector<std::future<void>> futures;
+  for (int p = 0; p < partitions; ++p) {
+    futures.push_back(massive_bodies_acceleration_pool_->Add(
+        [this, p, &positions, &partial_accelerations]() {
+          ComputeGravitationalAccelerationsBetweenMassiveBodies(
+              /*b1_begin=*/massive_bodies_partitions_[p],
+              /*b1_end=*/massive_bodies_partitions_[p + 1],
+              positions,
+              partial_accelerations[p]);
+        }));
+  }
+  for (auto& future : futures) {
+    future.wait();
+  }
+
+  for (auto const& partial : partial_accelerations) {
+    for (std::size_t b = 0; b < accelerations.size(); ++b) {
+      accelerations[b] += partial[b];
+    }
+  }
+}
+
+template<typename Frame>
+std::vector<Position<Frame>> const&
+Ephemeris<Frame>::EvaluateCelestialPositions(
+    Instant const& t,
+    MasslessBodiesWorkspace& workspace) const {
+  if (workspace.time != t) {
+    std::int64_t generation;
+    if (!celestial_positions_cache_.Find(t, workspace.positions, generation)) {
+      // Evaluate the positions without holding the lock of the cache, this is
+      // the expensive part.
+      std::vector<not_null<ContinuousTrajectory<Frame> const*>> const
+          trajectories(trajectories_.begin(), trajectories_.end());
+      ContinuousTrajectory<Frame>::EvaluatePositions(
+          trajectories, t, &workspace.hint, workspace.positions);
+      celestial_positions_cache_.Insert(t, workspace.positions, generation);
+    }
+    workspace.time = t;
+  }
+  return workspace.positions;
+}
+
 template<typename Frame>
 void Ephemeris<Frame>::ComputeMasslessBodiesGravitationalAccelerations(
       Instant const& t,
       std::vector<Position<Frame>> const& positions,
       std::vector<Vector<Acceleration, Frame>>& accelerations,
-      std::vector<typename ContinuousTrajectory<Frame>::Hint>& hints) const {
+      MasslessBodiesWorkspace& workspace) const {
   CHECK_EQ(positions.size(), accelerations.size());
+
+  std::vector<Position<Frame>> const& celestial_positions =
+      EvaluateCelestialPositions(t, workspace);
+
+  if (positions.size() >= min_massless_bodies_for_coordinates) {
+    // Many massless bodies, typically vessels integrated together: lay out
+    // their coordinates contiguously so that the computation vectorizes.
+    MasslessBodiesCoordinates& positions_coordinates =
+        workspace.positions_coordinates;
+    MasslessBodiesCoordinates& accelerations_coordinates =
+        workspace.accelerations_coordinates;
+    positions_coordinates.Resize(positions.size());
+    accelerations_coordinates.x.assign(positions.size(), 0);
+    accelerations_coordinates.y.assign(positions.size(), 0);
+    accelerations_coordinates.z.assign(positions.size(), 0);
+    for (std::size_t i = 0; i < positions.size(); ++i) {
+      R3Element<Length> const position =
+          (positions[i] - Frame::origin).coordinates();
+      positions_coordinates.x[i] = position.x / SIUnit<Length>();
+      positions_coordinates.y[i] = position.y / SIUnit<Length>();
+      positions_coordinates.z[i] = position.z / SIUnit<Length>();
+    }
+    for (std::size_t b1 = 0; b1 < number_of_oblate_bodies_; ++b1) {
+      ComputeGravitationalAccelerationByMassiveBodyOnMasslessBodies<
+          /*body1_is_oblate=*/true>(
+          *bodies_[b1],
+          celestial_positions[b1],
+          positions_coordinates,
+          accelerations_coordinates);
+    }
+    for (std::size_t b1 = number_of_oblate_bodies_;
+         b1 < number_of_oblate_bodies_ + number_of_spherical_bodies_;
+         ++b1) {
+      ComputeGravitationalAccelerationByMassiveBodyOnMasslessBodies<
+          /*body1_is_oblate=*/false>(
+          *bodies_[b1],
+          celestial_positions[b1],
+          positions_coordinates,
+          accelerations_coordinates);
+    }
+    for (std::size_t i = 0; i < accelerations.size(); ++i) {
+      accelerations[i] = Vector<Acceleration, Frame>(
+          {accelerations_coordinates.x[i] * SIUnit<Acceleration>(),
+           accelerations_coordinates.y[i] * SIUnit<Acceleration>(),
+           accelerations_coordinates.z[i] * SIUnit<Acceleration>()});
+    }
+    return;
+  }
+
   accelerations.assign(accelerations.size(), Vector<Acceleration, Frame>());
 
   for (std::size_t b1 = 0; b1 < number_of_oblate_bodies_; ++b1) {
     MassiveBody const& body1 = *bodies_[b1];
     ComputeGravitationalAccelerationByMassiveBodyOnMasslessBodies<
         /*body1_is_oblate=*/true>(
-        t,
-        body1, b1,
+        body1,
+        celestial_positions[b1],
         positions,
-        accelerations,
-        hints[b1]);
+        accelerations);
   }
   for (std::size_t b1 = number_of_oblate_bodies_;
        b1 < number_of_oblate_bodies_ +
@@ -1212,11 +2348,10 @@ void Ephemeris<Frame>::ComputeMasslessBodiesGravitationalAccelerations(
     MassiveBody const& body1 = *bodies_[b1];
     ComputeGravitationalAccelerationByMassiveBodyOnMasslessBodies<
         /*body1_is_oblate=*/false>(
-        t,
-        body1, b1,
+        body1,
+        celestial_positions[b1],
         positions,
-        accelerations,
-        hints[b1]);
+        accelerations);
   }
 }
 
@@ -1226,11 +2361,11 @@ void Ephemeris<Frame>::ComputeMasslessBodiesTotalAccelerations(
     Instant const& t,
     std::vector<Position<Frame>> const& positions,
     std::vector<Vector<Acceleration, Frame>>& accelerations,
-    std::vector<typename ContinuousTrajectory<Frame>::Hint>& hints) const {
+    MasslessBodiesWorkspace& workspace) const {
   // First, the acceleration due to the gravitational field of the
   // massive bodies.
   ComputeMasslessBodiesGravitationalAccelerations(
-      t, positions, accelerations, hints);
+      t, positions, accelerations, workspace);
 
   // Then, the intrinsic accelerations, if any.
   if (!intrinsic_accelerations.empty()) {
@@ -1243,6 +2378,207 @@ void Ephemeris<Frame>::ComputeMasslessBodiesTotalAccelerations(
   }
 }
 
+template<typename Frame>
+FORCE_INLINE Vector<Acceleration, Frame> Ephemeris<Frame>::
+ComputeMasslessBodyTotalAcceleration(
+    IntrinsicAcceleration const& intrinsic_acceleration,
+    Instant const& t,
+    Position<Frame> const& position,
+    MasslessBodiesWorkspace& workspace) const {
+  std::vector<Position<Frame>> const& celestial_positions =
+      EvaluateCelestialPositions(t, workspace);
+
+  // The same operations as |ComputeMasslessBodiesTotalAccelerations| for a
+  // single body, in the same order, so the results are identical.
+  Vector<Acceleration, Frame> acceleration;
+  for (std::size_t b1 = 0; b1 < number_of_oblate_bodies_; ++b1) {
+    ComputeGravitationalAccelerationByMassiveBodyOnMasslessBody<
+        /*body1_is_oblate=*/true>(
+        *bodies_[b1], celestial_positions[b1], position, acceleration);
+  }
+  for (std::size_t b1 = number_of_oblate_bodies_;
+       b1 < number_of_oblate_bodies_ + number_of_spherical_bodies_;
+       ++b1) {
+    ComputeGravitationalAccelerationByMassiveBodyOnMasslessBody<
+        /*body1_is_oblate=*/false>(
+        *bodies_[b1], celestial_positions[b1], position, acceleration);
+  }
+  if (intrinsic_acceleration != nullptr) {
+    acceleration += intrinsic_acceleration(t);
+  }
+  return acceleration;
+}
+
+template<typename Frame>
+void Ephemeris<Frame>::
+ComputeMasslessBodiesGravitationalAccelerationsWithTimeOffsets(
+    Instant const& t,
+    std::vector<Position<Frame>> const& positions,
+    std::vector<Time> const& time_offsets,
+    std::vector<Vector<Acceleration, Frame>>& accelerations,
+    MasslessBodiesWorkspace& workspace) const {
+  CHECK_EQ(positions.size(), time_offsets.size());
+  CHECK_EQ(positions.size(), accelerations.size());
+
+  std::vector<Position<Frame>> const& celestial_positions =
+      EvaluateCelestialPositions(t, workspace);
+  std::vector<Velocity<Frame>>& celestial_velocities = workspace.velocities;
+  workspace.velocity_hints.resize(trajectories_.size());
+  celestial_velocities.clear();
+  for (std::size_t b1 = 0; b1 < trajectories_.size(); ++b1) {
+    celestial_velocities.push_back(trajectories_[b1]->EvaluateVelocity(
+        t, &workspace.velocity_hints[b1]));
+  }
+
+  MasslessBodiesCoordinates& positions_coordinates =
+      workspace.positions_coordinates;
+  MasslessBodiesCoordinates& extrapolated_positions_coordinates =
+      workspace.extrapolated_positions_coordinates;
+  MasslessBodiesCoordinates& accelerations_coordinates =
+      workspace.accelerations_coordinates;
+  positions_coordinates.Resize(positions.size());
+  extrapolated_positions_coordinates.Resize(positions.size());
+  accelerations_coordinates.x.assign(positions.size(), 0);
+  accelerations_coordinates.y.assign(positions.size(), 0);
+  accelerations_coordinates.z.assign(positions.size(), 0);
+  for (std::size_t i = 0; i < positions.size(); ++i) {
+    R3Element<Length> const position =
+        (positions[i] - Frame::origin).coordinates();
+    positions_coordinates.x[i] = position.x / SIUnit<Length>();
+    positions_coordinates.y[i] = position.y / SIUnit<Length>();
+    positions_coordinates.z[i] = position.z / SIUnit<Length>();
+  }
+
+  // The kernel only depends on the displacement between the massive body and
+  // the massless bodies, so instead of extrapolating the position of |b1| to
+  // the time of each massless body, we move the massless bodies by the
+  // opposite displacement.  A zero offset leaves a position unchanged.
+  auto const add_acceleration_by_massive_body = [&](std::size_t const b1) {
+    R3Element<Speed> const velocity = celestial_velocities[b1].coordinates();
+    double const vx = velocity.x / SIUnit<Speed>();
+    double const vy = velocity.y / SIUnit<Speed>();
+    double const vz = velocity.z / SIUnit<Speed>();
+    for (std::size_t i = 0; i < positions.size(); ++i) {
+      double const dt = time_offsets[i] / SIUnit<Time>();
+      extrapolated_positions_coordinates.x[i] =
+          positions_coordinates.x[i] - vx * dt;
+      extrapolated_positions_coordinates.y[i] =
+          positions_coordinates.y[i] - vy * dt;
+      extrapolated_positions_coordinates.z[i] =
+          positions_coordinates.z[i] - vz * dt;
+    }
+    if (b1 < number_of_oblate_bodies_) {
+      ComputeGravitationalAccelerationByMassiveBodyOnMasslessBodies<
+          /*body1_is_oblate=*/true>(
+          *bodies_[b1],
+          celestial_positions[b1],
+          extrapolated_positions_coordinates,
+          accelerations_coordinates);
+    } else {
+      ComputeGravitationalAccelerationByMassiveBodyOnMasslessBodies<
+          /*body1_is_oblate=*/false>(
+          *bodies_[b1],
+          celestial_positions[b1],
+          extrapolated_positions_coordinates,
+          accelerations_coordinates);
+    }
+  };
+  for (std::size_t b1 = 0;
+       b1 < number_of_oblate_bodies_ + number_of_spherical_bodies_;
+       ++b1) {
+    add_acceleration_by_massive_body(b1);
+  }
+  for (std::size_t i = 0; i < accelerations.size(); ++i) {
+    accelerations[i] = Vector<Acceleration, Frame>(
+        {accelerations_coordinates.x[i] * SIUnit<Acceleration>(),
+         accelerations_coordinates.y[i] * SIUnit<Acceleration>(),
+         accelerations_coordinates.z[i] * SIUnit<Acceleration>()});
+  }
+}
+
+template<typename Frame>
+void Ephemeris<Frame>::ComputeMasslessBodiesTotalAccelerationsInLockstep(
+    IntrinsicAccelerations const& intrinsic_accelerations,
+    Time const& time_tolerance,
+    std::vector<typename NewtonianMotionEquation::RightHandSideEvaluation>
+        const& evaluations,
+    MasslessBodiesWorkspace& workspace) const {
+  // Sort the evaluations by time (stably, for reproducibility) so that those
+  // that are close in time are contiguous.
+  std::vector<int>& order = workspace.evaluation_order;
+  order.resize(evaluations.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(),
+                   order.end(),
+                   [&evaluations](int const left, int const right) {
+                     return evaluations[left].time < evaluations[right].time;
+                   });
+
+  std::vector<Position<Frame>>& positions = workspace.group_positions;
+  std::vector<Time>& time_offsets = workspace.group_time_offsets;
+  std::vector<Vector<Acceleration, Frame>>& accelerations =
+      workspace.group_accelerations;
+  auto first = order.cbegin();
+  while (first != order.cend()) {
+    // The group extends to the last evaluation within |time_tolerance| of the
+    // first one.  Concatenate the positions of all its massless bodies.
+    Instant const& t_first = evaluations[*first].time;
+    positions.clear();
+    auto last = first;
+    for (; last != order.cend() &&
+               evaluations[*last].time - t_first <= time_tolerance;
+         ++last) {
+      auto const& evaluation_positions = *evaluations[*last].positions;
+      positions.insert(positions.end(),
+                       evaluation_positions.begin(),
+                       evaluation_positions.end());
+    }
+    Instant const& t_last = evaluations[*std::prev(last)].time;
+
+    // Compute the gravitational accelerations of the group together.  If the
+    // group spans several times, the degrees of freedom of the massive bodies
+    // are evaluated at its middle and extrapolated to each evaluation.
+    accelerations.resize(positions.size());
+    if (t_first == t_last) {
+      ComputeMasslessBodiesGravitationalAccelerations(
+          t_first, positions, accelerations, workspace);
+    } else {
+      Instant const t_middle = t_first + (t_last - t_first) / 2;
+      time_offsets.clear();
+      for (auto it = first; it != last; ++it) {
+        auto const& evaluation = evaluations[*it];
+        time_offsets.insert(time_offsets.end(),
+                            evaluation.positions->size(),
+                            evaluation.time - t_middle);
+      }
+      ComputeMasslessBodiesGravitationalAccelerationsWithTimeOffsets(
+          t_middle, positions, time_offsets, accelerations, workspace);
+    }
+
+    // Scatter the accelerations and add the intrinsic accelerations, if any,
+    // at the time of each evaluation.
+    auto acceleration = accelerations.cbegin();
+    for (auto it = first; it != last; ++it) {
+      auto const& evaluation = evaluations[*it];
+      auto& evaluation_accelerations = *evaluation.accelerations;
+      std::copy(acceleration,
+                acceleration + evaluation_accelerations.size(),
+                evaluation_accelerations.begin());
+      acceleration += evaluation_accelerations.size();
+      if (!intrinsic_accelerations.empty()) {
+        auto const& intrinsic_acceleration =
+            intrinsic_accelerations[evaluation.system];
+        if (intrinsic_acceleration != nullptr) {
+          for (auto& evaluation_acceleration : evaluation_accelerations) {
+            evaluation_acceleration += intrinsic_acceleration(evaluation.time);
+          }
+        }
+      }
+    }
+    first = last;
+  }
+}
+
 template<typename Frame>
 double Ephemeris<Frame>::ToleranceToErrorRatio(
     Length const& length_integration_tolerance,
@@ -1,9 +1,15 @@
 ﻿
 #include "physics/ephemeris.hpp"
 
+#include <cstring>
+#include <experimental/filesystem>
+#include <fstream>
+#include <iterator>
 #include <limits>
 #include <map>
 #include <set>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include "astronomy/frames.hpp"
@@ -13,6 +19,7 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "integrators/embedded_explicit_runge_kutta_nyström_integrator.hpp"
+#include "integrators/symmetric_linear_multistep_integrator.hpp"
 #include "integrators/symplectic_runge_kutta_nyström_integrator.hpp"
 #include "physics/kepler_orbit.hpp"
 #include "physics/massive_body.hpp"
@@ -43,6 +50,7 @@ using geometry::Rotation;
 using geometry::Velocity;
 using integrators::DormandElMikkawyPrince1986RKN434FM;
 using integrators::McLachlanAtela1992Order5Optimal;
+using integrators::QuinlanTremaine1990Order12;
 using quantities::Abs;
 using quantities::ArcTan;
 using quantities::Area;
@@ -54,6 +62,7 @@ using quantities::astronomy::LunarDistance;
 using quantities::astronomy::SolarMass;
 using quantities::constants::GravitationalConstant;
 using quantities::si::AstronomicalUnit;
+using quantities::si::Day;
 using quantities::si::Hour;
 using quantities::si::Kilo;
 using quantities::si::Kilogram;
@@ -70,7 +79,9 @@ using testing_utilities::VanishesBefore;
 using ::testing::AnyOf;
 using ::testing::Eq;
 using ::testing::Gt;
+using ::testing::IsNull;
 using ::testing::Lt;
+using ::testing::NotNull;
 using ::testing::Ref;
 
 namespace {
@@ -518,6 +529,235 @@ TEST_F(EphemerisTest, EarthProbe) {
   EXPECT_THAT(trajectory.last().time(), Eq(old_t_max));
 }
 
+// Three probes around the Earth, with different tolerances, integrated in
+// lockstep.  The result is the same as if they were integrated separately.
+TEST_F(EphemerisTest, EarthProbesInLockstep) {
+  std::vector<not_null<std::unique_ptr<MassiveBody const>>> bodies;
+  std::vector<DegreesOfFreedom<ICRFJ2000Equator>> initial_state;
+  Position<ICRFJ2000Equator> centre_of_mass;
+  Time period;
+  SetUpEarthMoonSystem(&bodies, &initial_state, &centre_of_mass, &period);
+
+  bodies.erase(bodies.begin() + 1);
+  initial_state.erase(initial_state.begin() + 1);
+
+  MassiveBody const* const earth = bodies[0].get();
+  Position<ICRFJ2000Equator> const earth_position =
+      initial_state[0].position();
+  Velocity<ICRFJ2000Equator> const earth_velocity =
+      initial_state[0].velocity();
+
+  Ephemeris<ICRFJ2000Equator>
+      ephemeris(
+          std::move(bodies),
+          initial_state,
+          t0_,
+          5 * Milli(Metre),
+          Ephemeris<ICRFJ2000Equator>::FixedStepParameters(
+              McLachlanAtela1992Order5Optimal<Position<ICRFJ2000Equator>>(),
+              period / 100));
+
+  std::vector<Length> const distances =
+      {1e8 * Metre, 2e8 * Metre, 5e8 * Metre};
+  std::vector<Length> const length_tolerances =
+      {1e-2 * Metre, 1e-4 * Metre, 1e-2 * Metre};
+  Ephemeris<ICRFJ2000Equator>::IntrinsicAccelerations const
+      intrinsic_accelerations = {
+          Ephemeris<ICRFJ2000Equator>::NoIntrinsicAcceleration,
+          [earth](Instant const& t) {
+            return Vector<Acceleration, ICRFJ2000Equator>(
+                {0 * SIUnit<Acceleration>(),
+                 earth->gravitational_parameter() / Pow<2>(1e9 * Metre),
+                 0 * SIUnit<Acceleration>()});
+          },
+          Ephemeris<ICRFJ2000Equator>::NoIntrinsicAcceleration};
+  std::vector<Ephemeris<ICRFJ2000Equator>::AdaptiveStepParameters> parameters;
+  std::vector<std::unique_ptr<DiscreteTrajectory<ICRFJ2000Equator>>>
+      expected_trajectories;
+  std::vector<std::unique_ptr<DiscreteTrajectory<ICRFJ2000Equator>>>
+      trajectories;
+  std::vector<not_null<DiscreteTrajectory<ICRFJ2000Equator>*>>
+      trajectory_pointers;
+  for (int i = 0; i < distances.size(); ++i) {
+    parameters.emplace_back(
+        DormandElMikkawyPrince1986RKN434FM<Position<ICRFJ2000Equator>>(),
+        max_steps,
+        length_tolerances[i],
+        length_tolerances[i] / Second);
+    DegreesOfFreedom<ICRFJ2000Equator> const degrees_of_freedom(
+        earth_position + Vector<Length, ICRFJ2000Equator>(
+                             {0 * Metre, distances[i], 0 * Metre}),
+        earth_velocity + Velocity<ICRFJ2000Equator>(
+                             {Sqrt(earth->gravitational_parameter() /
+                                   distances[i]),
+                              0 * Metre / Second,
+                              0 * Metre / Second}));
+    expected_trajectories.push_back(
+        std::make_unique<DiscreteTrajectory<ICRFJ2000Equator>>());
+    expected_trajectories.back()->Append(t0_, degrees_of_freedom);
+    trajectories.push_back(
+        std::make_unique<DiscreteTrajectory<ICRFJ2000Equator>>());
+    trajectories.back()->Append(t0_, degrees_of_freedom);
+    trajectory_pointers.push_back(trajectories.back().get());
+  }
+
+  for (int i = 0; i < distances.size(); ++i) {
+    EXPECT_TRUE(ephemeris.FlowWithAdaptiveStep(
+        expected_trajectories[i].get(),
+        intrinsic_accelerations[i],
+        t0_ + period,
+        parameters[i],
+        Ephemeris<ICRFJ2000Equator>::unlimited_max_ephemeris_steps));
+  }
+  auto const statuses = ephemeris.FlowWithAdaptiveStepInLockstep(
+      trajectory_pointers,
+      intrinsic_accelerations,
+      t0_ + period,
+      parameters,
+      Ephemeris<ICRFJ2000Equator>::unlimited_max_ephemeris_steps,
+      /*time_tolerance=*/0 * Second);
+
+  ASSERT_EQ(distances.size(), statuses.size());
+  for (int i = 0; i < distances.size(); ++i) {
+    EXPECT_TRUE(statuses[i].ok()) << statuses[i];
+    ASSERT_EQ(expected_trajectories[i]->Size(), trajectories[i]->Size());
+    for (auto it1 = expected_trajectories[i]->Begin(),
+              it2 = trajectories[i]->Begin();
+         it1 != expected_trajectories[i]->End();
+         ++it1, ++it2) {
+      EXPECT_EQ(it1.time(), it2.time());
+      EXPECT_EQ(it1.degrees_of_freedom(), it2.degrees_of_freedom());
+    }
+  }
+  // The tolerances result in different step sizes.
+  EXPECT_THAT(trajectories[1]->Size(), Gt(trajectories[0]->Size()));
+
+  // A trajectory that is already at the final time is not integrated, the
+  // others stop early if the ephemeris may not be prolonged.
+  Instant const old_t_max = ephemeris.t_max();
+  trajectories.front()->ForgetAfter(old_t_max);
+  trajectories.front()->Append(
+      old_t_max + period,
+      trajectories.front()->last().degrees_of_freedom());
+  auto const cut_short_statuses = ephemeris.FlowWithAdaptiveStepInLockstep(
+      trajectory_pointers,
+      intrinsic_accelerations,
+      old_t_max + period,
+      parameters,
+      /*max_ephemeris_steps=*/0,
+      /*time_tolerance=*/0 * Second);
+  EXPECT_TRUE(cut_short_statuses[0].ok());
+  for (int i = 1; i < distances.size(); ++i) {
+    EXPECT_EQ(integrators::termination_condition::ReachedMaximalStepCount,
+              cut_short_statuses[i].error());
+    EXPECT_THAT(trajectories[i]->last().time(), Eq(old_t_max));
+  }
+  EXPECT_THAT(ephemeris.t_max(), Eq(old_t_max));
+}
+
+// Probes around the Earth, in the Earth-Moon system, integrated in lockstep
+// with a time tolerance.  The evaluations whose times are close share the
+// degrees of freedom of the Earth and the Moon, which makes the results
+// slightly different from those of separate integrations.
+TEST_F(EphemerisTest, EarthProbesInLockstepWithTimeTolerance) {
+  std::vector<not_null<std::unique_ptr<MassiveBody const>>> bodies;
+  std::vector<DegreesOfFreedom<ICRFJ2000Equator>> initial_state;
+  Position<ICRFJ2000Equator> centre_of_mass;
+  Time period;
+  SetUpEarthMoonSystem(&bodies, &initial_state, &centre_of_mass, &period);
+
+  MassiveBody const* const earth = bodies[1].get();
+  Position<ICRFJ2000Equator> const earth_position =
+      initial_state[1].position();
+  Velocity<ICRFJ2000Equator> const earth_velocity =
+      initial_state[1].velocity();
+
+  Ephemeris<ICRFJ2000Equator>
+      ephemeris(
+          std::move(bodies),
+          initial_state,
+          t0_,
+          5 * Milli(Metre),
+          Ephemeris<ICRFJ2000Equator>::FixedStepParameters(
+              McLachlanAtela1992Order5Optimal<Position<ICRFJ2000Equator>>(),
+              period / 100));
+
+  // Probes on circular orbits around the Earth, with tolerances such that
+  // their step sizes are close but not identical.
+  int const number_of_probes = 8;
+  Instant const t_final = t0_ + 1 * Day;
+  std::vector<Ephemeris<ICRFJ2000Equator>::AdaptiveStepParameters> parameters;
+  std::vector<DiscreteTrajectory<ICRFJ2000Equator>> expected_trajectories(
+      number_of_probes);
+  std::vector<DiscreteTrajectory<ICRFJ2000Equator>> trajectories(
+      number_of_probes);
+  std::vector<not_null<DiscreteTrajectory<ICRFJ2000Equator>*>>
+      trajectory_pointers;
+  for (int i = 0; i < number_of_probes; ++i) {
+    Length const distance = (1e7 + 1e5 * i) * Metre;
+    Length const length_tolerance = (1 + 0.01 * i) * Milli(Metre);
+    parameters.emplace_back(
+        DormandElMikkawyPrince1986RKN434FM<Position<ICRFJ2000Equator>>(),
+        max_steps,
+        length_tolerance,
+        length_tolerance / Second);
+    DegreesOfFreedom<ICRFJ2000Equator> const degrees_of_freedom(
+        earth_position + Vector<Length, ICRFJ2000Equator>(
+                             {0 * Metre, distance, 0 * Metre}),
+        earth_velocity + Velocity<ICRFJ2000Equator>(
+                             {Sqrt(earth->gravitational_parameter() /
+                                   distance),
+                              0 * Metre / Second,
+                              0 * Metre / Second}));
+    expected_trajectories[i].Append(t0_, degrees_of_freedom);
+    trajectories[i].Append(t0_, degrees_of_freedom);
+    trajectory_pointers.push_back(&trajectories[i]);
+  }
+
+  auto const lookups = [&ephemeris]() {
+    auto const statistics = ephemeris.celestial_positions_cache_statistics();
+    return statistics.hits + statistics.misses;
+  };
+  std::int64_t const lookups_before_separate_flows = lookups();
+  for (int i = 0; i < number_of_probes; ++i) {
+    EXPECT_TRUE(ephemeris.FlowWithAdaptiveStep(
+        &expected_trajectories[i],
+        Ephemeris<ICRFJ2000Equator>::NoIntrinsicAcceleration,
+        t_final,
+        parameters[i],
+        Ephemeris<ICRFJ2000Equator>::unlimited_max_ephemeris_steps));
+  }
+  std::int64_t const separate_lookups =
+      lookups() - lookups_before_separate_flows;
+
+  std::int64_t const lookups_before_lockstep = lookups();
+  auto const statuses = ephemeris.FlowWithAdaptiveStepInLockstep(
+      trajectory_pointers,
+      Ephemeris<ICRFJ2000Equator>::NoIntrinsicAccelerations,
+      t_final,
+      parameters,
+      Ephemeris<ICRFJ2000Equator>::unlimited_max_ephemeris_steps,
+      /*time_tolerance=*/10 * Second);
+  std::int64_t const lockstep_lookups = lookups() - lookups_before_lockstep;
+
+  ASSERT_EQ(number_of_probes, statuses.size());
+  Length max_error;
+  for (int i = 0; i < number_of_probes; ++i) {
+    EXPECT_TRUE(statuses[i].ok()) << statuses[i];
+    EXPECT_EQ(t_final, trajectories[i].last().time());
+    max_error = std::max(
+        max_error,
+        (trajectories[i].last().degrees_of_freedom().position() -
+         expected_trajectories[i].last().degrees_of_freedom().position())
+            .Norm());
+  }
+  // The grouping saves evaluations of the massive bodies, and the
+  // extrapolation of their positions keeps the error of the order of the
+  // integration tolerances.
+  EXPECT_LT(lockstep_lookups, separate_lookups);
+  EXPECT_THAT(max_error, Lt(2 * Milli(Metre)));
+}
+
 // The Earth and two massless probes, similar to the previous test but flowing
 // with a fixed step.
 TEST_F(EphemerisTest, EarthTwoProbes) {
@@ -657,6 +897,196 @@ TEST_F(EphemerisTest, EarthTwoProbes) {
               Eq(q_probe2));
 }
 
+// Check that flowing many probes together, which uses the structure-of-arrays
+// computation of the accelerations, yields exactly the same trajectories as
+// flowing them one at a time.
+TEST_F(EphemerisTest, ManyProbes) {
+  int const number_of_probes = 11;
+  auto const ephemeris = solar_system_.MakeEphemeris(
+      /*fitting_tolerance=*/5 * Milli(Metre),
+      Ephemeris<ICRFJ2000Equator>::FixedStepParameters(
+          McLachlanAtela1992Order5Optimal<Position<ICRFJ2000Equator>>(),
+          /*step=*/10 * Minute));
+  Instant const t_final = t0_ + 1 * Hour;
+  ephemeris->Prolong(t_final);
+  DegreesOfFreedom<ICRFJ2000Equator> const earth_degrees_of_freedom =
+      solar_system_.trajectory(*ephemeris, "Earth").EvaluateDegreesOfFreedom(
+          t0_, /*hint=*/nullptr);
+  Ephemeris<ICRFJ2000Equator>::FixedStepParameters const parameters(
+      McLachlanAtela1992Order5Optimal<Position<ICRFJ2000Equator>>(),
+      /*step=*/10 * Second);
+
+  std::vector<std::unique_ptr<DiscreteTrajectory<ICRFJ2000Equator>>>
+      together;
+  std::vector<std::unique_ptr<DiscreteTrajectory<ICRFJ2000Equator>>>
+      one_at_a_time;
+  std::vector<not_null<DiscreteTrajectory<ICRFJ2000Equator>*>> trajectories;
+  for (int i = 0; i < number_of_probes; ++i) {
+    Length const altitude = (7000 + 1000 * i) * Kilo(Metre);
+    DegreesOfFreedom<ICRFJ2000Equator> const probe_degrees_of_freedom(
+        earth_degrees_of_freedom.position() +
+            Displacement<ICRFJ2000Equator>({altitude, 0 * Metre, altitude}),
+        earth_degrees_of_freedom.velocity() +
+            Velocity<ICRFJ2000Equator>({0 * Metre / Second,
+                                        7 * Kilo(Metre) / Second,
+                                        0 * Metre / Second}));
+    together.push_back(
+        std::make_unique<DiscreteTrajectory<ICRFJ2000Equator>>());
+    together.back()->Append(t0_, probe_degrees_of_freedom);
+    trajectories.push_back(together.back().get());
+    one_at_a_time.push_back(
+        std::make_unique<DiscreteTrajectory<ICRFJ2000Equator>>());
+    one_at_a_time.back()->Append(t0_, probe_degrees_of_freedom);
+    ephemeris->FlowWithFixedStep(
+        {one_at_a_time.back().get()},
+        Ephemeris<ICRFJ2000Equator>::NoIntrinsicAccelerations,
+        t_final,
+        parameters);
+  }
+  ephemeris->FlowWithFixedStep(
+      trajectories,
+      Ephemeris<ICRFJ2000Equator>::NoIntrinsicAccelerations,
+      t_final,
+      parameters);
+
+  for (int i = 0; i < number_of_probes; ++i) {
+    EXPECT_EQ(one_at_a_time[i]->last().time(), together[i]->last().time());
+    EXPECT_EQ(one_at_a_time[i]->last().degrees_of_freedom(),
+              together[i]->last().degrees_of_freedom()) << i;
+  }
+}
+
+TEST_F(EphemerisTest, CelestialPositionsCache) {
+  auto const ephemeris = solar_system_.MakeEphemeris(
+      /*fitting_tolerance=*/5 * Milli(Metre),
+      Ephemeris<ICRFJ2000Equator>::FixedStepParameters(
+          McLachlanAtela1992Order5Optimal<Position<ICRFJ2000Equator>>(),
+          /*step=*/10 * Minute));
+  Instant const t_final = t0_ + 1 * Minute;
+  ephemeris->Prolong(t_final);
+  DegreesOfFreedom<ICRFJ2000Equator> const earth_degrees_of_freedom =
+      solar_system_.trajectory(*ephemeris, "Earth").EvaluateDegreesOfFreedom(
+          t0_, /*hint=*/nullptr);
+  DegreesOfFreedom<ICRFJ2000Equator> const probe_degrees_of_freedom(
+      earth_degrees_of_freedom.position() +
+          Displacement<ICRFJ2000Equator>(
+              {7000 * Kilo(Metre), 0 * Metre, 0 * Metre}),
+      earth_degrees_of_freedom.velocity() +
+          Velocity<ICRFJ2000Equator>({0 * Metre / Second,
+                                      7 * Kilo(Metre) / Second,
+                                      0 * Metre / Second}));
+  Ephemeris<ICRFJ2000Equator>::FixedStepParameters const parameters(
+      McLachlanAtela1992Order5Optimal<Position<ICRFJ2000Equator>>(),
+      /*step=*/10 * Second);
+  auto const flow = [&ephemeris, &parameters, &probe_degrees_of_freedom, this,
+                     t_final](DiscreteTrajectory<ICRFJ2000Equator>& trajectory) {
+    trajectory.Append(t0_, probe_degrees_of_freedom);
+    ephemeris->FlowWithFixedStep(
+        {&trajectory},
+        Ephemeris<ICRFJ2000Equator>::NoIntrinsicAccelerations,
+        t_final,
+        parameters);
+  };
+
+  EXPECT_EQ(0, ephemeris->celestial_positions_cache_statistics().hits);
+  EXPECT_EQ(0, ephemeris->celestial_positions_cache_statistics().misses);
+  EXPECT_EQ(0, ephemeris->celestial_positions_cache_statistics().hit_rate());
+
+  DiscreteTrajectory<ICRFJ2000Equator> trajectory1;
+  flow(trajectory1);
+  auto const statistics1 = ephemeris->celestial_positions_cache_statistics();
+  EXPECT_EQ(0, statistics1.hits);
+  EXPECT_LT(0, statistics1.misses);
+
+  // The second flow evaluates the accelerations at the same times as the first
+  // one, so it doesn't miss.
+  DiscreteTrajectory<ICRFJ2000Equator> trajectory2;
+  flow(trajectory2);
+  auto const statistics2 = ephemeris->celestial_positions_cache_statistics();
+  EXPECT_EQ(statistics1.misses, statistics2.misses);
+  EXPECT_EQ(statistics1.misses, statistics2.hits);
+  EXPECT_EQ(0.5, statistics2.hit_rate());
+  EXPECT_EQ(trajectory1.last().time(), trajectory2.last().time());
+  EXPECT_EQ(trajectory1.last().degrees_of_freedom(),
+            trajectory2.last().degrees_of_freedom());
+
+  // Prolonging the ephemeris empties the cache.
+  ephemeris->Prolong(ephemeris->t_max() + 1 * Hour);
+  DiscreteTrajectory<ICRFJ2000Equator> trajectory3;
+  flow(trajectory3);
+  auto const statistics3 = ephemeris->celestial_positions_cache_statistics();
+  EXPECT_EQ(2 * statistics1.misses, statistics3.misses);
+  EXPECT_EQ(trajectory1.last().degrees_of_freedom(),
+            trajectory3.last().degrees_of_freedom());
+}
+
+// Flows that don't prolong the ephemeris only read it, and they share a
+// thread-safe cache of the positions of the celestials, so they may run
+// concurrently.
+TEST_F(EphemerisTest, ConcurrentFlows) {
+  auto const ephemeris = solar_system_.MakeEphemeris(
+      /*fitting_tolerance=*/5 * Milli(Metre),
+      Ephemeris<ICRFJ2000Equator>::FixedStepParameters(
+          McLachlanAtela1992Order5Optimal<Position<ICRFJ2000Equator>>(),
+          /*step=*/10 * Minute));
+  Instant const t_final = t0_ + 1 * Hour;
+  ephemeris->Prolong(t_final);
+  DegreesOfFreedom<ICRFJ2000Equator> const earth_degrees_of_freedom =
+      solar_system_.trajectory(*ephemeris, "Earth").EvaluateDegreesOfFreedom(
+          t0_, /*hint=*/nullptr);
+  Ephemeris<ICRFJ2000Equator>::FixedStepParameters const parameters(
+      McLachlanAtela1992Order5Optimal<Position<ICRFJ2000Equator>>(),
+      /*step=*/10 * Second);
+
+  int const number_of_probes = 4;
+  std::vector<DiscreteTrajectory<ICRFJ2000Equator>> sequential_trajectories(
+      number_of_probes);
+  std::vector<DiscreteTrajectory<ICRFJ2000Equator>> concurrent_trajectories(
+      number_of_probes);
+  for (int i = 0; i < number_of_probes; ++i) {
+    DegreesOfFreedom<ICRFJ2000Equator> const probe_degrees_of_freedom(
+        earth_degrees_of_freedom.position() +
+            Displacement<ICRFJ2000Equator>(
+                {(7000 + 1000 * i) * Kilo(Metre), 0 * Metre, 0 * Metre}),
+        earth_degrees_of_freedom.velocity() +
+            Velocity<ICRFJ2000Equator>({0 * Metre / Second,
+                                        7 * Kilo(Metre) / Second,
+                                        0 * Metre / Second}));
+    sequential_trajectories[i].Append(t0_, probe_degrees_of_freedom);
+    concurrent_trajectories[i].Append(t0_, probe_degrees_of_freedom);
+  }
+
+  for (auto& trajectory : sequential_trajectories) {
+    ephemeris->FlowWithFixedStep(
+        {&trajectory},
+        Ephemeris<ICRFJ2000Equator>::NoIntrinsicAccelerations,
+        t_final,
+        parameters);
+  }
+  std::vector<std::thread> threads;
+  for (auto& trajectory : concurrent_trajectories) {
+    threads.emplace_back([&ephemeris, &parameters, &trajectory, t_final]() {
+      ephemeris->FlowWithFixedStep(
+          {&trajectory},
+          Ephemeris<ICRFJ2000Equator>::NoIntrinsicAccelerations,
+          t_final,
+          parameters);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (int i = 0; i < number_of_probes; ++i) {
+    EXPECT_EQ(sequential_trajectories[i].Size(),
+              concurrent_trajectories[i].Size());
+    EXPECT_EQ(sequential_trajectories[i].last().time(),
+              concurrent_trajectories[i].last().time());
+    EXPECT_EQ(sequential_trajectories[i].last().degrees_of_freedom(),
+              concurrent_trajectories[i].last().degrees_of_freedom());
+  }
+}
+
 TEST_F(EphemerisTest, Serialization) {
   std::vector<not_null<std::unique_ptr<MassiveBody const>>> bodies;
   std::vector<DegreesOfFreedom<ICRFJ2000Equator>> initial_state;
@@ -718,6 +1148,327 @@ TEST_F(EphemerisTest, Serialization) {
       << "SECOND\n" << second_message.DebugString();
 }
 
+TEST_F(EphemerisTest, PrecomputedFile) {
+  std::vector<not_null<std::unique_ptr<MassiveBody const>>> bodies;
+  std::vector<DegreesOfFreedom<ICRFJ2000Equator>> initial_state;
+  Position<ICRFJ2000Equator> centre_of_mass;
+  Time period;
+  SetUpEarthMoonSystem(&bodies, &initial_state, &centre_of_mass, &period);
+
+  Ephemeris<ICRFJ2000Equator>
+      ephemeris(
+          std::move(bodies),
+          initial_state,
+          t0_,
+          5 * Milli(Metre),
+          Ephemeris<ICRFJ2000Equator>::FixedStepParameters(
+              McLachlanAtela1992Order5Optimal<Position<ICRFJ2000Equator>>(),
+              period / 100));
+  ephemeris.Prolong(t0_ + period);
+
+  std::experimental::filesystem::path const path =
+      "ephemeris_test.precomputed";
+  ephemeris.WriteToPrecomputedFile(path);
+  // A scope to unmap the file before removing it.
+  {
+    auto const ephemeris_read =
+        Ephemeris<ICRFJ2000Equator>::ReadFromPrecomputedFile(path);
+
+    auto const check_same_trajectories = [&ephemeris, &ephemeris_read]() {
+      EXPECT_EQ(ephemeris.t_min(), ephemeris_read->t_min());
+      EXPECT_EQ(ephemeris.t_max(), ephemeris_read->t_max());
+      for (int i = 0; i < ephemeris.bodies().size(); ++i) {
+        auto const trajectory = ephemeris.trajectory(ephemeris.bodies()[i]);
+        auto const trajectory_read =
+            ephemeris_read->trajectory(ephemeris_read->bodies()[i]);
+        for (Instant time = ephemeris.t_min();
+             time <= ephemeris.t_max();
+             time += (ephemeris.t_max() - ephemeris.t_min()) / 100) {
+          EXPECT_EQ(
+              trajectory->EvaluateDegreesOfFreedom(time, /*hint=*/nullptr),
+              trajectory_read->EvaluateDegreesOfFreedom(time,
+                                                        /*hint=*/nullptr));
+        }
+      }
+    };
+
+    check_same_trajectories();
+
+    // The ephemeris that was read can be prolonged, and it produces the same
+    // results as the original one.
+    ephemeris.Prolong(t0_ + 2 * period);
+    ephemeris_read->Prolong(t0_ + 2 * period);
+    check_same_trajectories();
+
+    ephemeris_read->ForgetBefore(t0_ + 0.5 * period);
+    EXPECT_EQ(t0_ + 0.5 * period, ephemeris_read->t_min());
+  }
+  std::experimental::filesystem::remove(path);
+}
+
+// The serialization of an ephemeris read from a precomputed file only goes up
+// to the checkpoint that follows the current time, not to the end of the file.
+TEST_F(EphemerisTest, PrecomputedFileSerialization) {
+  std::vector<not_null<std::unique_ptr<MassiveBody const>>> bodies;
+  std::vector<DegreesOfFreedom<ICRFJ2000Equator>> initial_state;
+  Position<ICRFJ2000Equator> centre_of_mass;
+  Time period;
+  SetUpEarthMoonSystem(&bodies, &initial_state, &centre_of_mass, &period);
+
+  Ephemeris<ICRFJ2000Equator>
+      ephemeris(
+          std::move(bodies),
+          initial_state,
+          t0_,
+          5 * Milli(Metre),
+          Ephemeris<ICRFJ2000Equator>::FixedStepParameters(
+              McLachlanAtela1992Order5Optimal<Position<ICRFJ2000Equator>>(),
+              period / 100));
+  ephemeris.Prolong(t0_ + 30 * period);
+
+  std::experimental::filesystem::path const path =
+      "ephemeris_test_serialization.precomputed";
+  ephemeris.WriteToPrecomputedFile(path);
+  {
+    auto const ephemeris_read =
+        Ephemeris<ICRFJ2000Equator>::ReadFromPrecomputedFile(path);
+    ASSERT_THAT(ephemeris_read, NotNull());
+    Instant const now = t0_ + 10 * period;
+    ephemeris_read->ForgetBefore(now);
+
+    serialization::Ephemeris message;
+    ephemeris_read->WriteToMessage(&message);
+    // Checkpoints are at most 180 days apart.
+    Instant const first_checkpoint_bound = now + 180 * Day + period;
+    ASSERT_LT(first_checkpoint_bound, ephemeris_read->t_max());
+    for (auto const& trajectory : message.trajectory()) {
+      ASSERT_LT(0, trajectory.series_size());
+      EXPECT_LT(Instant::ReadFromMessage(
+                    trajectory.series(trajectory.series_size() - 1).t_max()),
+                first_checkpoint_bound);
+    }
+    EXPECT_LT(Instant::ReadFromMessage(message.t_max()),
+              first_checkpoint_bound);
+
+    // The deserialized ephemeris integrates from the checkpoint and agrees with
+    // the precomputed one.
+    auto const ephemeris_deserialized =
+        Ephemeris<ICRFJ2000Equator>::ReadFromMessage(message);
+    EXPECT_LT(ephemeris_deserialized->t_max(), first_checkpoint_bound);
+    ephemeris_deserialized->Prolong(t0_ + 20 * period);
+    for (int i = 0; i < ephemeris_read->bodies().size(); ++i) {
+      auto const trajectory =
+          ephemeris_read->trajectory(ephemeris_read->bodies()[i]);
+      auto const trajectory_deserialized = ephemeris_deserialized->trajectory(
+          ephemeris_deserialized->bodies()[i]);
+      for (Instant time = now; time <= t0_ + 20 * period; time += period) {
+        EXPECT_EQ(trajectory->EvaluatePosition(time, /*hint=*/nullptr),
+                  trajectory_deserialized->EvaluatePosition(time,
+                                                            /*hint=*/nullptr));
+      }
+    }
+  }
+  std::experimental::filesystem::remove(path);
+}
+
+// Reading an invalid precomputed file returns null instead of crashing.
+TEST_F(EphemerisTest, PrecomputedFileInvalid) {
+  std::vector<not_null<std::unique_ptr<MassiveBody const>>> bodies;
+  std::vector<DegreesOfFreedom<ICRFJ2000Equator>> initial_state;
+  Position<ICRFJ2000Equator> centre_of_mass;
+  Time period;
+  SetUpEarthMoonSystem(&bodies, &initial_state, &centre_of_mass, &period);
+
+  Ephemeris<ICRFJ2000Equator>
+      ephemeris(
+          std::move(bodies),
+          initial_state,
+          t0_,
+          5 * Milli(Metre),
+          Ephemeris<ICRFJ2000Equator>::FixedStepParameters(
+              McLachlanAtela1992Order5Optimal<Position<ICRFJ2000Equator>>(),
+              period / 100));
+  ephemeris.Prolong(t0_ + period);
+
+  std::experimental::filesystem::path const path =
+      "ephemeris_test_invalid.precomputed";
+  EXPECT_THAT(Ephemeris<ICRFJ2000Equator>::ReadFromPrecomputedFile(path),
+              IsNull());
+
+  ephemeris.WriteToPrecomputedFile(path);
+  std::string bytes;
+  {
+    std::ifstream file(path, std::ios::binary);
+    bytes.assign(std::istreambuf_iterator<char>(file),
+                 std::istreambuf_iterator<char>());
+  }
+  auto const read_modified = [&path](std::string const& modified_bytes) {
+    {
+      std::ofstream file(path, std::ios::binary | std::ios::trunc);
+      file.write(modified_bytes.data(), modified_bytes.size());
+    }
+    return Ephemeris<ICRFJ2000Equator>::ReadFromPrecomputedFile(path);
+  };
+
+  EXPECT_THAT(read_modified(bytes), NotNull());
+  // Empty.
+  EXPECT_THAT(read_modified(""), IsNull());
+  // Truncated in the header, in the series, and in the message.
+  EXPECT_THAT(read_modified(bytes.substr(0, 10)), IsNull());
+  EXPECT_THAT(read_modified(bytes.substr(0, bytes.size() / 2)), IsNull());
+  EXPECT_THAT(read_modified(bytes.substr(0, bytes.size() - 1)), IsNull());
+  // Wrong magic.
+  std::string wrong_magic = bytes;
+  wrong_magic[0] = 'X';
+  EXPECT_THAT(read_modified(wrong_magic), IsNull());
+  // A series with an invalid degree, right after the header of the first
+  // trajectory.
+  std::string wrong_degree = bytes;
+  std::int64_t const invalid_degree = std::numeric_limits<std::int64_t>::max();
+  std::memcpy(&wrong_degree[24 + 16 + 16], &invalid_degree,
+              sizeof(invalid_degree));
+  EXPECT_THAT(read_modified(wrong_degree), IsNull());
+  // A trajectory with a huge number of series.
+  std::string wrong_number_of_series = bytes;
+  std::memcpy(&wrong_number_of_series[24], &invalid_degree,
+              sizeof(invalid_degree));
+  EXPECT_THAT(read_modified(wrong_number_of_series), IsNull());
+
+  std::experimental::filesystem::remove(path);
+}
+
+TEST_F(EphemerisTest, ParallelMassiveBodiesAccelerations) {
+  auto const make_ephemeris = [this](int const workers) {
+    auto ephemeris = solar_system_.MakeEphemeris(
+        /*fitting_tolerance=*/5 * Milli(Metre),
+        Ephemeris<ICRFJ2000Equator>::FixedStepParameters(
+            McLachlanAtela1992Order5Optimal<Position<ICRFJ2000Equator>>(),
+            /*step=*/10 * Minute));
+    ephemeris->set_massive_bodies_acceleration_workers(workers);
+    ephemeris->Prolong(t0_ + 10 * Day);
+    return ephemeris;
+  };
+
+  auto const sequential = make_ephemeris(/*workers=*/0);
+  auto const one_worker = make_ephemeris(/*workers=*/1);
+  auto const four_workers = make_ephemeris(/*workers=*/4);
+  Instant const t = t0_ + 10 * Day;
+  for (auto const& name : solar_system_.names()) {
+    auto const expected =
+        solar_system_.trajectory(*sequential, name).EvaluateDegreesOfFreedom(
+            t, /*hint=*/nullptr);
+    auto const actual1 =
+        solar_system_.trajectory(*one_worker, name).EvaluateDegreesOfFreedom(
+            t, /*hint=*/nullptr);
+    auto const actual4 =
+        solar_system_.trajectory(*four_workers, name).EvaluateDegreesOfFreedom(
+            t, /*hint=*/nullptr);
+    // The partition of the bodies doesn't depend on the number of workers.
+    EXPECT_EQ(actual1, actual4) << name;
+    // The order of the summations differs from the sequential computation.
+    EXPECT_THAT((actual1.position() - expected.position()).Norm(),
+                Lt(1 * Metre)) << name;
+  }
+}
+
+TEST_F(EphemerisTest, AsynchronousProlongation) {
+  auto const make_ephemeris = [this]() {
+    return solar_system_.MakeEphemeris(
+        /*fitting_tolerance=*/5 * Milli(Metre),
+        Ephemeris<ICRFJ2000Equator>::FixedStepParameters(
+            McLachlanAtela1992Order5Optimal<Position<ICRFJ2000Equator>>(),
+            /*step=*/10 * Minute));
+  };
+
+  auto const synchronous = make_ephemeris();
+  auto const asynchronous = make_ephemeris();
+  asynchronous->StartAsynchronousProlongation(/*horizon=*/3 * Day);
+  for (int i = 1; i <= 10; ++i) {
+    Instant const t = t0_ + i * Day;
+    synchronous->Prolong(t);
+    asynchronous->Prolong(t);
+    EXPECT_LE(t, asynchronous->t_max());
+  }
+  // Let the background thread finish and continue on this thread.
+  asynchronous->StopAsynchronousProlongation();
+  EXPECT_LE(t0_ + 10 * Day, asynchronous->t_max());
+  synchronous->Prolong(t0_ + 20 * Day);
+  asynchronous->Prolong(t0_ + 20 * Day);
+
+  // The series don't depend on how the integration was split.
+  for (Instant t = t0_; t <= t0_ + 20 * Day; t += 1 * Hour) {
+    for (auto const& name : solar_system_.names()) {
+      EXPECT_EQ(
+          solar_system_.trajectory(*synchronous, name)
+              .EvaluateDegreesOfFreedom(t, /*hint=*/nullptr),
+          solar_system_.trajectory(*asynchronous, name)
+              .EvaluateDegreesOfFreedom(t, /*hint=*/nullptr)) << name;
+    }
+  }
+}
+
+// A multistep integration is not restarted by |Prolong| nor by serialization,
+// so the series don't depend on how the integration was split.
+TEST_F(EphemerisTest, MultistepHistory) {
+  auto const make_ephemeris = [this]() {
+    std::vector<not_null<std::unique_ptr<MassiveBody const>>> bodies;
+    std::vector<DegreesOfFreedom<ICRFJ2000Equator>> initial_state;
+    Position<ICRFJ2000Equator> centre_of_mass;
+    Time period;
+    SetUpEarthMoonSystem(&bodies, &initial_state, &centre_of_mass, &period);
+    return std::make_pair(
+        make_not_null_unique<Ephemeris<ICRFJ2000Equator>>(
+            std::move(bodies),
+            initial_state,
+            t0_,
+            5 * Milli(Metre),
+            Ephemeris<ICRFJ2000Equator>::FixedStepParameters(
+                QuinlanTremaine1990Order12<Position<ICRFJ2000Equator>>(),
+                period / 100)),
+        period);
+  };
+
+  auto const reference_and_period = make_ephemeris();
+  auto const& reference = reference_and_period.first;
+  Time const period = reference_and_period.second;
+  reference->Prolong(t0_ + 20 * period);
+
+  auto const split = make_ephemeris().first;
+  for (int i = 1; i <= 15; ++i) {
+    split->Prolong(t0_ + i * period);
+  }
+  // The first checkpoint is during the startup of the integrator, forget it
+  // so that the ephemeris is serialized with a complete history.
+  split->ForgetBefore(t0_ + 8 * period);
+  serialization::Ephemeris message;
+  split->WriteToMessage(&message);
+  EXPECT_EQ(QuinlanTremaine1990Order12<Position<ICRFJ2000Equator>>().
+                history_length(),
+            message.history_size());
+  auto const read = Ephemeris<ICRFJ2000Equator>::ReadFromMessage(message);
+
+  split->Prolong(t0_ + 20 * period);
+  read->Prolong(t0_ + 20 * period);
+  EXPECT_EQ(reference->t_max(), split->t_max());
+  EXPECT_EQ(reference->t_max(), read->t_max());
+  for (int b = 0; b < reference->bodies().size(); ++b) {
+    auto const& reference_trajectory =
+        *reference->trajectory(reference->bodies()[b]);
+    auto const& split_trajectory = *split->trajectory(split->bodies()[b]);
+    auto const& read_trajectory = *read->trajectory(read->bodies()[b]);
+    for (Instant t = read->t_min(); t <= reference->t_max(); t += 1 * Day) {
+      EXPECT_EQ(reference_trajectory.EvaluateDegreesOfFreedom(
+                    t, /*hint=*/nullptr),
+                split_trajectory.EvaluateDegreesOfFreedom(t, /*hint=*/nullptr))
+          << reference->bodies()[b]->name() << " " << t;
+      EXPECT_EQ(reference_trajectory.EvaluateDegreesOfFreedom(
+                    t, /*hint=*/nullptr),
+                read_trajectory.EvaluateDegreesOfFreedom(t, /*hint=*/nullptr))
+          << reference->bodies()[b]->name() << " " << t;
+    }
+  }
+}
+
 // The gravitational acceleration on at elephant located at the pole.
 TEST_F(EphemerisTest, ComputeGravitationalAccelerationMasslessBody) {
   Time const duration = 1 * Second;
@@ -1019,6 +1770,90 @@ TEST_F(EphemerisTest, ComputeApsidesDiscreteTrajectory) {
   }
 }
 
+// A probe on a circular orbit, integrated with a tolerance that results in long
+// steps.  Points are added inside the steps so that the trajectory may be
+// rendered as a polyline.
+TEST_F(EphemerisTest, FlowWithAdaptiveStepMaxChordDeviation) {
+  Instant const t0;
+  GravitationalParameter const μ = 3.986004418e14 * Pow<3>(Metre) /
+                                   Pow<2>(Second);
+  auto const b = new MassiveBody(μ);
+
+  std::vector<not_null<std::unique_ptr<MassiveBody const>>> bodies;
+  std::vector<DegreesOfFreedom<World>> initial_state;
+  bodies.emplace_back(std::unique_ptr<MassiveBody const>(b));
+  initial_state.emplace_back(World::origin, Velocity<World>());
+
+  Ephemeris<World>
+      ephemeris(
+          std::move(bodies),
+          initial_state,
+          t0,
+          5 * Milli(Metre),
+          Ephemeris<World>::FixedStepParameters(
+              McLachlanAtela1992Order5Optimal<Position<World>>(),
+              1 * Hour));
+
+  Length const r = 7000 * Kilo(Metre);
+  Speed const v = Sqrt(μ / r);
+  Time const period = 2 * π * r / v;
+  DegreesOfFreedom<World> const initial_degrees_of_freedom(
+      World::origin + Displacement<World>({r, 0 * Metre, 0 * Metre}),
+      Velocity<World>({0 * Metre / Second, v, 0 * Metre / Second}));
+
+  Ephemeris<World>::AdaptiveStepParameters parameters(
+      DormandElMikkawyPrince1986RKN434FM<Position<World>>(),
+      std::numeric_limits<std::int64_t>::max(),
+      1 * Metre,
+      1 * Metre / Second);
+
+  DiscreteTrajectory<World> coarse_trajectory;
+  coarse_trajectory.Append(t0, initial_degrees_of_freedom);
+  EXPECT_TRUE(ephemeris.FlowWithAdaptiveStep(
+      &coarse_trajectory,
+      Ephemeris<World>::NoIntrinsicAcceleration,
+      t0 + period,
+      parameters,
+      Ephemeris<World>::unlimited_max_ephemeris_steps));
+
+  Length const max_chord_deviation = 100 * Metre;
+  parameters.set_max_chord_deviation(max_chord_deviation);
+  DiscreteTrajectory<World> dense_trajectory;
+  dense_trajectory.Append(t0, initial_degrees_of_freedom);
+  EXPECT_TRUE(ephemeris.FlowWithAdaptiveStep(
+      &dense_trajectory,
+      Ephemeris<World>::NoIntrinsicAcceleration,
+      t0 + period,
+      parameters,
+      Ephemeris<World>::unlimited_max_ephemeris_steps));
+
+  // The added points don't change the integration.
+  EXPECT_GT(dense_trajectory.Size(), 4 * coarse_trajectory.Size());
+  EXPECT_EQ(coarse_trajectory.last().degrees_of_freedom(),
+            dense_trajectory.last().degrees_of_freedom());
+
+  auto const max_chord_deviation_from_circle =
+      [r](DiscreteTrajectory<World> const& trajectory) {
+        Length max_deviation;
+        auto previous = trajectory.Begin();
+        for (auto it = trajectory.Begin(); ++it != trajectory.End();) {
+          Position<World> const middle =
+              Barycentre<Position<World>, double>(
+                  {previous.degrees_of_freedom().position(),
+                   it.degrees_of_freedom().position()},
+                  {1, 1});
+          max_deviation =
+              std::max(max_deviation, r - (middle - World::origin).Norm());
+          previous = it;
+        }
+        return max_deviation;
+      };
+  EXPECT_THAT(max_chord_deviation_from_circle(coarse_trajectory),
+              Gt(10 * max_chord_deviation));
+  EXPECT_THAT(max_chord_deviation_from_circle(dense_trajectory),
+              Lt(max_chord_deviation));
+}
+
 TEST_F(EphemerisTest, ComputeApsidesContinuousTrajectory) {
   SolarSystem<ICRFJ2000Equator> solar_system;
   solar_system.Initialize(
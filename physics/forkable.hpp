@@ -1,6 +1,7 @@
 ﻿
 #pragma once
 
+#include <cstdint>
 #include <deque>
 #include <experimental/optional>  // NOLINT
 #include <map>
@@ -140,6 +141,11 @@ class Forkable {
   // object is a root.
   It3rator Fork() const;
 
+  // Returns the time of the fork point of this object.  Cheaper than
+  // |Fork().time()| as it doesn't construct an iterator.  Fails if this object
+  // is a root.
+  Instant const& ForkTime() const;
+
   // Returns the number of points in this object.  Complexity is O(|length| +
   // |depth|).
   int Size() const;
@@ -163,6 +169,10 @@ class Forkable {
   virtual TimelineConstIterator timeline_lower_bound(
                                     Instant const& time) const = 0;
   virtual bool timeline_empty() const = 0;
+  // Removes all the points of the timeline.  Called when this object is
+  // recycled; it may retain the memory of at most |retained_capacity| points to
+  // make future insertions cheaper, and must release the rest.
+  virtual void timeline_clear(std::int64_t retained_capacity) = 0;
 
  protected:
   // The API that subclasses may use to implement their public operations.
@@ -198,6 +208,16 @@ class Forkable {
   // This trajectory must be a root.
   void CheckNoForksBefore(Instant const& time);
 
+  // Returns the times of the forks of this trajectory at or after |time|, in
+  // increasing order.  There may be repetitions.
+  std::vector<Instant> ForkTimesNotBefore(Instant const& time) const;
+
+  // Must be called after the points of the timeline at or after |time| have
+  // been moved (e.g., by compacting the timeline), to update the positions of
+  // the forks at or after |time| in the timeline.  The fork times must still
+  // be in the timeline.
+  void RelinkForksNotBefore(Instant const& time);
+
   // This trajectory need not be a root.  As forks are encountered during tree
   // traversal their pointer is nulled-out in |forks|.
   void WriteSubTreeToMessage(
@@ -217,6 +237,16 @@ class Forkable {
       not_null<Tr4jectory const*> const ancestor,
       TimelineConstIterator const position_in_ancestor_timeline) const;
 
+  // Returns a fresh object to be used as a child of this trajectory.  The
+  // object is taken from the pool of the root if it is not empty.
+  std::unique_ptr<Tr4jectory> NewChild();
+
+  // Gives |child|, which must have been a child of this trajectory, and its
+  // descendants back to the pool of the root, after clearing them and
+  // releasing most of the memory of their timelines.  The pool has a bounded
+  // size, objects that don't fit are deleted.
+  void Recycle(std::unique_ptr<Tr4jectory> child);
+
   // There may be several forks starting from the same time, hence the multimap.
   // A level of indirection is needed to avoid referencing an incomplete type in
   // CRTP.
@@ -235,6 +265,12 @@ class Forkable {
       position_in_parent_timeline_;
   Children children_;
 
+  // The trajectories which were deleted from the tree rooted at this object
+  // and may be reused by |NewChild|.  Empty if this object is not a root.
+  // Creating and deleting forks is frequent (e.g., predictions are recomputed
+  // at every frame) so this saves allocations.
+  std::vector<std::unique_ptr<Tr4jectory>> pool_;
+
   template<typename, typename>
   friend class ForkableIterator;
 };
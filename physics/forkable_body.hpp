@@ -9,6 +9,12 @@ namespace principia {
 namespace physics {
 namespace internal_forkable {
 
+// The maximum number of objects in the pool of a root trajectory.
+constexpr int max_pooled_forks = 16;
+// The maximum number of points for which a pooled object retains memory, so
+// that the pool doesn't hold on to the memory of long-gone forks.
+constexpr std::int64_t max_points_retained_by_pooled_fork = 1024;
+
 template<typename Tr4jectory, typename It3rator>
 bool ForkableIterator<Tr4jectory, It3rator>::operator==(
     It3rator const& right) const {
@@ -120,6 +126,7 @@ void Forkable<Tr4jectory, It3rator>::DeleteFork(Tr4jectory*& trajectory) {
       children_.equal_range(ForkableTraits<Tr4jectory>::time(fork_it.current_));
   for (auto it = range.first; it != range.second; ++it) {
     if (it->second.get() == trajectory) {
+      Recycle(std::move(it->second));
       children_.erase(it);
       trajectory = nullptr;
       return;
@@ -239,6 +246,12 @@ It3rator Forkable<Tr4jectory, It3rator>::Fork() const {
   return Wrap(ancestor, position_in_ancestor_timeline);
 }
 
+template<typename Tr4jectory, typename It3rator>
+Instant const& Forkable<Tr4jectory, It3rator>::ForkTime() const {
+  CHECK(!is_root());
+  return (*position_in_parent_children_)->first;
+}
+
 template<typename Tr4jectory, typename It3rator>
 int Forkable<Tr4jectory, It3rator>::Size() const {
   int result = 0;
@@ -279,7 +292,7 @@ not_null<Tr4jectory*> Forkable<Tr4jectory, It3rator>::NewFork(
   } else {
     time = ForkableTraits<Tr4jectory>::time(timeline_it);
   }
-  auto const child_it = children_.emplace(time, std::make_unique<Tr4jectory>());
+  auto const child_it = children_.emplace(time, NewChild());
 
   // Now set the members of the child object.
   std::unique_ptr<Tr4jectory> const& child_forkable = child_it->second;
@@ -315,6 +328,9 @@ void Forkable<Tr4jectory, It3rator>::AttachForkToCopiedBegin(
       ForkableTraits<Tr4jectory>::time(fork_timeline_begin),
       std::move(fork));
 
+  // The pool of a non-root is never used.
+  child_it->second->pool_.clear();
+
   // Set the pointer into this object.  Note that |fork| is no longer usable.
   child_it->second->parent_ = that();
   child_it->second->position_in_parent_children_ = child_it;
@@ -356,6 +372,9 @@ void Forkable<Tr4jectory, It3rator>::DeleteAllForksAfter(Instant const& time) {
   CHECK(is_root() || time >= ForkableTraits<Tr4jectory>::time(Fork().current_))
       << "DeleteAllForksAfter before the fork time";
   auto const it = children_.upper_bound(time);
+  for (auto recycled_it = it; recycled_it != children_.end(); ++recycled_it) {
+    Recycle(std::move(recycled_it->second));
+  }
   children_.erase(it, children_.end());
 }
 
@@ -370,6 +389,28 @@ void Forkable<Tr4jectory, It3rator>::CheckNoForksBefore(Instant const& time) {
                                  << " forks before " << time;
 }
 
+template<typename Tr4jectory, typename It3rator>
+std::vector<Instant> Forkable<Tr4jectory, It3rator>::ForkTimesNotBefore(
+    Instant const& time) const {
+  std::vector<Instant> fork_times;
+  for (auto it = children_.lower_bound(time); it != children_.end(); ++it) {
+    fork_times.push_back(it->first);
+  }
+  return fork_times;
+}
+
+template<typename Tr4jectory, typename It3rator>
+void Forkable<Tr4jectory, It3rator>::RelinkForksNotBefore(
+    Instant const& time) {
+  for (auto it = children_.lower_bound(time); it != children_.end(); ++it) {
+    Instant const& fork_time = it->first;
+    auto const position_in_timeline = timeline_find(fork_time);
+    CHECK(position_in_timeline != timeline_end())
+        << "Fork time " << fork_time << " is no longer in the timeline";
+    it->second->position_in_parent_timeline_ = position_in_timeline;
+  }
+}
+
 template<typename Tr4jectory, typename It3rator>
 void Forkable<Tr4jectory, It3rator>::WriteSubTreeToMessage(
     not_null<serialization::DiscreteTrajectory*> const message,
@@ -448,6 +489,37 @@ It3rator Forkable<Tr4jectory, It3rator>::Wrap(
   base::noreturn();
 }
 
+template<typename Tr4jectory, typename It3rator>
+std::unique_ptr<Tr4jectory> Forkable<Tr4jectory, It3rator>::NewChild() {
+  auto& pool = root()->pool_;
+  if (pool.empty()) {
+    return std::make_unique<Tr4jectory>();
+  } else {
+    std::unique_ptr<Tr4jectory> child = std::move(pool.back());
+    pool.pop_back();
+    return child;
+  }
+}
+
+template<typename Tr4jectory, typename It3rator>
+void Forkable<Tr4jectory, It3rator>::Recycle(
+    std::unique_ptr<Tr4jectory> child) {
+  // The descendants of |child| go to the pool too, in case we have room.
+  for (auto& pair : child->children_) {
+    Recycle(std::move(pair.second));
+  }
+  child->children_.clear();
+  child->timeline_clear(max_points_retained_by_pooled_fork);
+  child->parent_ = nullptr;
+  child->position_in_parent_children_ = std::experimental::nullopt;
+  child->position_in_parent_timeline_ = std::experimental::nullopt;
+
+  auto& pool = root()->pool_;
+  if (static_cast<int>(pool.size()) < max_pooled_forks) {
+    pool.push_back(std::move(child));
+  }
+}
+
 }  // namespace internal_forkable
 }  // namespace physics
 }  // namespace principia
@@ -17,6 +17,7 @@ using base::make_not_null_unique;
 using geometry::Instant;
 using quantities::si::Second;
 using ::testing::ElementsAre;
+using ::testing::UnorderedElementsAre;
 
 class FakeTrajectory;
 
@@ -59,6 +60,7 @@ class FakeTrajectory : public Forkable<FakeTrajectory,
   TimelineConstIterator timeline_lower_bound(
                             Instant const& time) const override;
   bool timeline_empty() const override;
+  void timeline_clear(std::int64_t retained_capacity) override;
 
  protected:
   not_null<FakeTrajectory*> that() override;
@@ -133,6 +135,10 @@ bool FakeTrajectory::timeline_empty() const {
   return timeline_.empty();
 }
 
+void FakeTrajectory::timeline_clear(std::int64_t const retained_capacity) {
+  timeline_.clear();
+}
+
 not_null<FakeTrajectory*> FakeTrajectory::that() {
   return this;
 }
@@ -227,6 +233,7 @@ TEST_F(ForkableTest, ForkAtLast) {
   EXPECT_THAT(times, ElementsAre(t1_, t2_, t3_));
   EXPECT_EQ(t3_, LastTime(fork2));
   EXPECT_EQ(t3_, *fork2->Fork().current());
+  EXPECT_EQ(t3_, fork2->ForkTime());
 
   auto after = After(fork3, t3_);
   EXPECT_THAT(after, ElementsAre(t3_));
@@ -287,6 +294,37 @@ TEST_F(ForkableTest, DeleteForkSuccess) {
   EXPECT_THAT(times, ElementsAre(t1_, t2_, t4_));
 }
 
+TEST_F(ForkableTest, DeleteForkRecycling) {
+  trajectory_.push_back(t1_);
+  trajectory_.push_back(t2_);
+  FakeTrajectory* fork1 = trajectory_.NewFork(trajectory_.timeline_find(t2_));
+  fork1->push_back(t3_);
+  not_null<FakeTrajectory*> const fork2 =
+      fork1->NewFork(fork1->timeline_find(t3_));
+  fork2->push_back(t4_);
+  FakeTrajectory const* const old_fork1 = fork1;
+  FakeTrajectory const* const old_fork2 = fork2;
+
+  // Deleting |fork1| also deletes |fork2|.  Both objects are reused, cleared,
+  // by the forks created later anywhere in the tree.
+  trajectory_.DeleteFork(fork1);
+  not_null<FakeTrajectory*> const fork3 =
+      trajectory_.NewFork(trajectory_.timeline_find(t1_));
+  not_null<FakeTrajectory*> const fork4 =
+      fork3->NewFork(fork3->timeline_find(t1_));
+  not_null<FakeTrajectory*> const fork5 =
+      fork4->NewFork(fork4->timeline_find(t1_));
+  EXPECT_THAT((std::vector<FakeTrajectory const*>{fork3, fork4}),
+              UnorderedElementsAre(old_fork1, old_fork2));
+  EXPECT_NE(old_fork1, fork5);
+  EXPECT_NE(old_fork2, fork5);
+  EXPECT_THAT(Times(fork4), ElementsAre(t1_));
+  EXPECT_EQ(&trajectory_, fork4->root());
+  fork4->push_back(t2_);
+  EXPECT_THAT(Times(fork4), ElementsAre(t1_, t2_));
+  EXPECT_THAT(Times(fork5), ElementsAre(t1_));
+}
+
 TEST_F(ForkableDeathTest, AttachForkWithCopiedBeginError) {
   EXPECT_DEATH({
     trajectory_.push_back(t1_);
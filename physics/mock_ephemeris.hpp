@@ -33,6 +33,8 @@ class MockEphemeris : public Ephemeris<Frame> {
 
   MOCK_METHOD1_T(ForgetBefore, void(Instant const& t));
   MOCK_METHOD1_T(Prolong, void(Instant const& t));
+  MOCK_METHOD1_T(StartAsynchronousProlongation, void(Time const& horizon));
+  MOCK_METHOD0_T(StopAsynchronousProlongation, void());
   MOCK_METHOD5_T(
       FlowWithAdaptiveStep,
       bool(not_null<DiscreteTrajectory<Frame>*> const trajectory,
@@ -41,6 +43,17 @@ class MockEphemeris : public Ephemeris<Frame> {
            Instant const& t,
            AdaptiveStepParameters const& parameters,
            std::int64_t const max_ephemeris_steps));
+  MOCK_METHOD6_T(
+      FlowWithAdaptiveStepInLockstep,
+      std::vector<Status>(
+          std::vector<not_null<DiscreteTrajectory<Frame>*>> const&
+              trajectories,
+          typename Ephemeris<Frame>::IntrinsicAccelerations const&
+              intrinsic_accelerations,
+          Instant const& t,
+          std::vector<AdaptiveStepParameters> const& parameters,
+          std::int64_t const max_ephemeris_steps,
+          Time const& time_tolerance));
   MOCK_METHOD4_T(
       FlowWithFixedStep,
       void(std::vector<not_null<DiscreteTrajectory<Frame>*>> const&
@@ -78,6 +91,9 @@ class MockEphemeris : public Ephemeris<Frame> {
 
   MOCK_CONST_METHOD1_T(WriteToMessage,
                        void(not_null<serialization::Ephemeris*> const message));
+  MOCK_CONST_METHOD2_T(WriteToMessage,
+                       void(not_null<serialization::Ephemeris*> const message,
+                            Instant const& after));
 };
 
 }  // namespace internal_ephemeris
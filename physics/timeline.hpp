@@ -0,0 +1,171 @@
+﻿
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "geometry/named_quantities.hpp"
+
+namespace principia {
+namespace physics {
+namespace internal_timeline {
+
+using geometry::Instant;
+
+// A sequence of (time, value) pairs sorted by strictly increasing time, tuned
+// for the way trajectories use their timelines: points are appended at the end,
+// erased at either end, looked up by time and iterated over.  The points are
+// stored contiguously in fixed-size chunks, so appending is amortized O(1),
+// lookups are binary searches and no point ever moves once inserted (references
+// to points remain valid until they are erased).
+// The iterators are indices in the sequence of all the points ever inserted,
+// not pointers, so they remain valid when points are inserted or erased, as
+// long as the point they denote is not erased.  In particular, an iterator at
+// |end()| keeps comparing equal to |end()| after insertions.  This is what
+// makes it possible for a fork to hold an iterator in the timeline of its
+// parent.
+template<typename Value>
+class Timeline {
+ public:
+  using value_type = std::pair<Instant, Value>;
+
+  class ConstIterator {
+   public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = typename Timeline::value_type;
+    using difference_type = std::int64_t;
+    using pointer = value_type const*;
+    using reference = value_type const&;
+
+    ConstIterator() = default;
+
+    reference operator*() const;
+    pointer operator->() const;
+
+    ConstIterator& operator++();
+    ConstIterator& operator--();
+    ConstIterator operator++(int);
+    ConstIterator operator--(int);
+
+    bool operator==(ConstIterator const& right) const;
+    bool operator!=(ConstIterator const& right) const;
+
+   private:
+    ConstIterator(Timeline const* timeline, std::int64_t index);
+
+    Timeline const* timeline_ = nullptr;
+    std::int64_t index_ = end_index;
+
+    friend class Timeline;
+  };
+
+  using const_iterator = ConstIterator;
+
+  Timeline() = default;
+  ~Timeline();
+
+  // Cannot be moved or copied because iterators point to this object.
+  Timeline(Timeline const&) = delete;
+  Timeline(Timeline&&) = delete;
+  Timeline& operator=(Timeline const&) = delete;
+  Timeline& operator=(Timeline&&) = delete;
+
+  ConstIterator begin() const;
+  ConstIterator end() const;
+
+  bool empty() const;
+  std::int64_t size() const;
+  // The number of points that the timeline may hold without allocating.
+  std::int64_t capacity() const;
+
+  // The timeline must not be empty.
+  value_type const& front() const;
+  value_type const& back() const;
+
+  // Same semantics as the functions of |std::map|.  Complexity is
+  // O(log(size())).
+  ConstIterator find(Instant const& time) const;
+  ConstIterator lower_bound(Instant const& time) const;
+  ConstIterator upper_bound(Instant const& time) const;
+
+  // |time| must be (strictly) after the last time of this timeline.
+  ConstIterator emplace_back(Instant const& time, Value const& value);
+  // |time| must be (strictly) before the first time of this timeline.
+  ConstIterator emplace_front(Instant const& time, Value const& value);
+
+  // Either |first| must be |begin()| or |last| must be |end()|: points may only
+  // be erased at the ends of the timeline.
+  void erase(ConstIterator first, ConstIterator last);
+  void erase(ConstIterator it);
+
+  // Erases the points at or after |first| for which |predicate| returns true.
+  // |predicate| is called exactly once for each of these points, in increasing
+  // time order.  The remaining points are moved to keep the storage contiguous,
+  // so this is the only operation that invalidates the iterators (and the
+  // references) to points that are not erased: those after the first erased
+  // point.  Complexity is O(distance(first, end())).
+  template<typename Predicate>
+  void erase_if(ConstIterator first, Predicate predicate);
+
+  // Erases all the points but retains the memory that they used, so that
+  // refilling the timeline doesn't allocate.  Invalidates all the iterators.
+  void clear();
+
+  // Releases the memory that is not needed to hold the points of the timeline,
+  // except for what is needed to hold |capacity| points (rounded up to a whole
+  // chunk).  Doesn't invalidate any iterator.
+  void shrink(std::int64_t capacity);
+
+ private:
+  // The number of points in a chunk.  A power of 2 to make the divisions cheap.
+  static constexpr std::int64_t chunk_size = 64;
+  // The index of an iterator at end.
+  static constexpr std::int64_t end_index =
+      std::numeric_limits<std::int64_t>::max();
+
+  using Slot = typename std::aligned_storage<sizeof(value_type),
+                                             alignof(value_type)>::type;
+  struct Chunk {
+    Slot slots[chunk_size];
+  };
+
+  // Returns the point at the given |offset| from the first point.
+  value_type const& at(std::int64_t offset) const;
+  value_type& at(std::int64_t offset);
+
+  // Returns the offset from the first point of the first point whose time is
+  // not less than (if |strict| is false) or greater than (if |strict| is true)
+  // |time|.  Returns |size_| if there is no such point.
+  std::int64_t Search(Instant const& time, bool strict) const;
+
+  ConstIterator MakeIterator(std::int64_t offset) const;
+  std::int64_t OffsetOf(ConstIterator const& it) const;
+
+  // Destroys the points in the range of offsets [first, last).
+  void Destroy(std::int64_t first, std::int64_t last);
+
+  // May have unused chunks at the end after |clear()|.
+  std::vector<std::unique_ptr<Chunk>> chunks_;
+  // The position of the first point in |chunks_.front()|, in
+  // [0, chunk_size[.
+  std::int64_t first_position_ = 0;
+  // The index of the first point in the sequence of all the points ever
+  // inserted.  Decremented by |emplace_front|, incremented when points are
+  // erased at the beginning.
+  std::int64_t first_index_ = 0;
+  std::int64_t size_ = 0;
+};
+
+}  // namespace internal_timeline
+
+using internal_timeline::Timeline;
+
+}  // namespace physics
+}  // namespace principia
+
+#include "physics/timeline_body.hpp"
@@ -0,0 +1,322 @@
+﻿
+#pragma once
+
+#include "physics/timeline.hpp"
+
+#include <algorithm>
+#include <new>
+
+#include "glog/logging.h"
+
+namespace principia {
+namespace physics {
+namespace internal_timeline {
+
+template<typename Value>
+constexpr std::int64_t Timeline<Value>::chunk_size;
+
+template<typename Value>
+constexpr std::int64_t Timeline<Value>::end_index;
+
+template<typename Value>
+typename Timeline<Value>::ConstIterator::reference
+Timeline<Value>::ConstIterator::operator*() const {
+  return timeline_->at(timeline_->OffsetOf(*this));
+}
+
+template<typename Value>
+typename Timeline<Value>::ConstIterator::pointer
+Timeline<Value>::ConstIterator::operator->() const {
+  return &timeline_->at(timeline_->OffsetOf(*this));
+}
+
+template<typename Value>
+typename Timeline<Value>::ConstIterator&
+Timeline<Value>::ConstIterator::operator++() {
+  DCHECK_NE(index_, end_index);
+  ++index_;
+  if (index_ == timeline_->first_index_ + timeline_->size_) {
+    index_ = end_index;
+  }
+  return *this;
+}
+
+template<typename Value>
+typename Timeline<Value>::ConstIterator&
+Timeline<Value>::ConstIterator::operator--() {
+  if (index_ == end_index) {
+    index_ = timeline_->first_index_ + timeline_->size_;
+  }
+  DCHECK_GT(index_, timeline_->first_index_);
+  --index_;
+  return *this;
+}
+
+template<typename Value>
+typename Timeline<Value>::ConstIterator
+Timeline<Value>::ConstIterator::operator++(int) {
+  ConstIterator const result = *this;
+  ++*this;
+  return result;
+}
+
+template<typename Value>
+typename Timeline<Value>::ConstIterator
+Timeline<Value>::ConstIterator::operator--(int) {
+  ConstIterator const result = *this;
+  --*this;
+  return result;
+}
+
+template<typename Value>
+bool Timeline<Value>::ConstIterator::operator==(
+    ConstIterator const& right) const {
+  return timeline_ == right.timeline_ && index_ == right.index_;
+}
+
+template<typename Value>
+bool Timeline<Value>::ConstIterator::operator!=(
+    ConstIterator const& right) const {
+  return !(*this == right);
+}
+
+template<typename Value>
+Timeline<Value>::ConstIterator::ConstIterator(Timeline const* const timeline,
+                                              std::int64_t const index)
+    : timeline_(timeline),
+      index_(index) {}
+
+template<typename Value>
+Timeline<Value>::~Timeline() {
+  Destroy(0, size_);
+}
+
+template<typename Value>
+typename Timeline<Value>::ConstIterator Timeline<Value>::begin() const {
+  return MakeIterator(0);
+}
+
+template<typename Value>
+typename Timeline<Value>::ConstIterator Timeline<Value>::end() const {
+  return MakeIterator(size_);
+}
+
+template<typename Value>
+bool Timeline<Value>::empty() const {
+  return size_ == 0;
+}
+
+template<typename Value>
+std::int64_t Timeline<Value>::size() const {
+  return size_;
+}
+
+template<typename Value>
+std::int64_t Timeline<Value>::capacity() const {
+  return static_cast<std::int64_t>(chunks_.size()) * chunk_size -
+         first_position_;
+}
+
+template<typename Value>
+typename Timeline<Value>::value_type const& Timeline<Value>::front() const {
+  CHECK(!empty());
+  return at(0);
+}
+
+template<typename Value>
+typename Timeline<Value>::value_type const& Timeline<Value>::back() const {
+  CHECK(!empty());
+  return at(size_ - 1);
+}
+
+template<typename Value>
+typename Timeline<Value>::ConstIterator Timeline<Value>::find(
+    Instant const& time) const {
+  std::int64_t const offset = Search(time, /*strict=*/false);
+  if (offset < size_ && at(offset).first == time) {
+    return MakeIterator(offset);
+  } else {
+    return end();
+  }
+}
+
+template<typename Value>
+typename Timeline<Value>::ConstIterator Timeline<Value>::lower_bound(
+    Instant const& time) const {
+  return MakeIterator(Search(time, /*strict=*/false));
+}
+
+template<typename Value>
+typename Timeline<Value>::ConstIterator Timeline<Value>::upper_bound(
+    Instant const& time) const {
+  return MakeIterator(Search(time, /*strict=*/true));
+}
+
+template<typename Value>
+typename Timeline<Value>::ConstIterator Timeline<Value>::emplace_back(
+    Instant const& time,
+    Value const& value) {
+  DCHECK(empty() || back().first < time);
+  std::int64_t const position = first_position_ + size_;
+  if (position == static_cast<std::int64_t>(chunks_.size()) * chunk_size) {
+    chunks_.push_back(std::make_unique<Chunk>());
+  }
+  new (&chunks_[position / chunk_size]->slots[position % chunk_size])
+      value_type(time, value);
+  ++size_;
+  return MakeIterator(size_ - 1);
+}
+
+template<typename Value>
+typename Timeline<Value>::ConstIterator Timeline<Value>::emplace_front(
+    Instant const& time,
+    Value const& value) {
+  DCHECK(empty() || time < front().first);
+  if (first_position_ == 0) {
+    // This moves the pointers to the chunks, not the points.
+    chunks_.insert(chunks_.begin(), std::make_unique<Chunk>());
+    first_position_ = chunk_size;
+  }
+  --first_position_;
+  new (&chunks_.front()->slots[first_position_]) value_type(time, value);
+  --first_index_;
+  ++size_;
+  return begin();
+}
+
+template<typename Value>
+void Timeline<Value>::erase(ConstIterator const first,
+                            ConstIterator const last) {
+  std::int64_t const first_offset = OffsetOf(first);
+  std::int64_t const last_offset = OffsetOf(last);
+  CHECK_LE(first_offset, last_offset);
+  if (first_offset == last_offset) {
+    return;
+  }
+  Destroy(first_offset, last_offset);
+  if (last_offset == size_) {
+    size_ = first_offset;
+  } else {
+    CHECK_EQ(0, first_offset) << "Erasure in the middle of a timeline";
+    first_position_ += last_offset;
+    first_index_ += last_offset;
+    size_ -= last_offset;
+    chunks_.erase(chunks_.begin(),
+                  chunks_.begin() + first_position_ / chunk_size);
+    first_position_ %= chunk_size;
+  }
+  if (size_ == 0) {
+    chunks_.clear();
+    first_position_ = 0;
+  } else {
+    chunks_.resize((first_position_ + size_ + chunk_size - 1) / chunk_size);
+  }
+}
+
+template<typename Value>
+void Timeline<Value>::erase(ConstIterator const it) {
+  ConstIterator next = it;
+  erase(it, ++next);
+}
+
+template<typename Value>
+template<typename Predicate>
+void Timeline<Value>::erase_if(ConstIterator const first,
+                               Predicate predicate) {
+  // The offset where the next retained point goes.
+  std::int64_t retained = OffsetOf(first);
+  for (std::int64_t offset = retained; offset < size_; ++offset) {
+    value_type& point = at(offset);
+    if (!predicate(static_cast<value_type const&>(point))) {
+      if (retained != offset) {
+        at(retained) = std::move(point);
+      }
+      ++retained;
+    }
+  }
+  erase(MakeIterator(retained), end());
+}
+
+template<typename Value>
+void Timeline<Value>::clear() {
+  Destroy(0, size_);
+  first_position_ = 0;
+  size_ = 0;
+}
+
+template<typename Value>
+void Timeline<Value>::shrink(std::int64_t const capacity) {
+  std::int64_t const used_chunks =
+      (first_position_ + size_ + chunk_size - 1) / chunk_size;
+  std::int64_t const retained_chunks =
+      std::max(used_chunks, (capacity + chunk_size - 1) / chunk_size);
+  if (retained_chunks < static_cast<std::int64_t>(chunks_.size())) {
+    chunks_.resize(retained_chunks);
+    chunks_.shrink_to_fit();
+  }
+}
+
+template<typename Value>
+typename Timeline<Value>::value_type const& Timeline<Value>::at(
+    std::int64_t const offset) const {
+  DCHECK_LE(0, offset);
+  DCHECK_LT(offset, size_);
+  std::int64_t const position = first_position_ + offset;
+  return *reinterpret_cast<value_type const*>(
+             &chunks_[position / chunk_size]->slots[position % chunk_size]);
+}
+
+template<typename Value>
+typename Timeline<Value>::value_type& Timeline<Value>::at(
+    std::int64_t const offset) {
+  return const_cast<value_type&>(
+      static_cast<Timeline const&>(*this).at(offset));
+}
+
+template<typename Value>
+std::int64_t Timeline<Value>::Search(Instant const& time,
+                                     bool const strict) const {
+  // Trajectories are mostly searched near their end, so check the last point
+  // before doing a binary search.
+  if (size_ == 0 || (strict ? back().first <= time : back().first < time)) {
+    return size_;
+  }
+  std::int64_t lower = 0;
+  std::int64_t upper = size_ - 1;
+  // Invariant: the result is in [lower, upper].
+  while (lower < upper) {
+    std::int64_t const middle = lower + (upper - lower) / 2;
+    Instant const& middle_time = at(middle).first;
+    if (strict ? middle_time <= time : middle_time < time) {
+      lower = middle + 1;
+    } else {
+      upper = middle;
+    }
+  }
+  return lower;
+}
+
+template<typename Value>
+typename Timeline<Value>::ConstIterator Timeline<Value>::MakeIterator(
+    std::int64_t const offset) const {
+  return ConstIterator(this,
+                       offset == size_ ? end_index : first_index_ + offset);
+}
+
+template<typename Value>
+std::int64_t Timeline<Value>::OffsetOf(ConstIterator const& it) const {
+  DCHECK_EQ(this, it.timeline_);
+  return it.index_ == end_index ? size_ : it.index_ - first_index_;
+}
+
+template<typename Value>
+void Timeline<Value>::Destroy(std::int64_t const first,
+                              std::int64_t const last) {
+  for (std::int64_t offset = first; offset < last; ++offset) {
+    at(offset).~value_type();
+  }
+}
+
+}  // namespace internal_timeline
+}  // namespace physics
+}  // namespace principia
@@ -0,0 +1,225 @@
+﻿
+#include "physics/timeline.hpp"
+
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "geometry/named_quantities.hpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "quantities/si.hpp"
+
+namespace principia {
+namespace physics {
+namespace internal_timeline {
+
+using geometry::Instant;
+using quantities::si::Second;
+using ::testing::ElementsAre;
+
+class TimelineTest : public testing::Test {
+ protected:
+  // Returns the values of the |timeline_|, in order.
+  std::vector<int> Values() const {
+    std::vector<int> values;
+    for (auto const& pair : timeline_) {
+      values.push_back(pair.second);
+    }
+    return values;
+  }
+
+  Instant const t0_;
+  Timeline<int> timeline_;
+};
+
+TEST_F(TimelineTest, Empty) {
+  EXPECT_TRUE(timeline_.empty());
+  EXPECT_EQ(0, timeline_.size());
+  EXPECT_TRUE(timeline_.begin() == timeline_.end());
+  EXPECT_TRUE(timeline_.find(t0_) == timeline_.end());
+  EXPECT_TRUE(timeline_.lower_bound(t0_) == timeline_.end());
+  EXPECT_TRUE(timeline_.upper_bound(t0_) == timeline_.end());
+}
+
+TEST_F(TimelineTest, AppendAndSearch) {
+  // Enough points to fill several chunks.
+  for (int i = 0; i < 1000; ++i) {
+    timeline_.emplace_back(t0_ + 2 * i * Second, i);
+  }
+  EXPECT_EQ(1000, timeline_.size());
+  EXPECT_EQ(1000, std::distance(timeline_.begin(), timeline_.end()));
+  EXPECT_EQ(0, timeline_.front().second);
+  EXPECT_EQ(999, timeline_.back().second);
+  EXPECT_EQ(999, (--timeline_.end())->second);
+
+  for (int i = 0; i < 1000; ++i) {
+    Instant const t = t0_ + 2 * i * Second;
+    EXPECT_EQ(i, timeline_.find(t)->second);
+    EXPECT_EQ(i, timeline_.lower_bound(t)->second);
+    EXPECT_TRUE(timeline_.find(t + 1 * Second) == timeline_.end());
+    EXPECT_EQ(i, timeline_.lower_bound(t - 1 * Second)->second);
+    if (i < 999) {
+      EXPECT_EQ(i + 1, timeline_.upper_bound(t)->second);
+    } else {
+      EXPECT_TRUE(timeline_.upper_bound(t) == timeline_.end());
+    }
+  }
+  EXPECT_TRUE(timeline_.find(t0_ - 1 * Second) == timeline_.end());
+  EXPECT_EQ(0, timeline_.lower_bound(t0_ - 1 * Second)->second);
+  EXPECT_TRUE(timeline_.lower_bound(t0_ + 2000 * Second) == timeline_.end());
+}
+
+TEST_F(TimelineTest, IteratorStability) {
+  auto const end = timeline_.end();
+  auto const it5 = timeline_.emplace_back(t0_ + 5 * Second, 5);
+  Instant const& time5 = it5->first;
+  for (int i = 6; i < 500; ++i) {
+    timeline_.emplace_back(t0_ + i * Second, i);
+  }
+  EXPECT_TRUE(end == timeline_.end());
+  EXPECT_EQ(5, it5->second);
+  EXPECT_EQ(&time5, &it5->first);
+
+  // Insertions and erasures at both ends don't affect the iterators to other
+  // points.
+  auto const it4 = timeline_.emplace_front(t0_ + 4 * Second, 4);
+  timeline_.emplace_front(t0_ + 3 * Second, 3);
+  auto const it7 = timeline_.find(t0_ + 7 * Second);
+  timeline_.erase(timeline_.upper_bound(t0_ + 7 * Second), timeline_.end());
+  timeline_.erase(timeline_.begin());
+  EXPECT_TRUE(timeline_.begin() == it4);
+  EXPECT_TRUE(--timeline_.end() == it7);
+  EXPECT_TRUE(end == timeline_.end());
+  EXPECT_EQ(5, it5->second);
+  EXPECT_EQ(&time5, &it5->first);
+  EXPECT_THAT(Values(), ElementsAre(4, 5, 6, 7));
+
+  timeline_.emplace_back(t0_ + 8 * Second, 8);
+  EXPECT_EQ(8, (++timeline_.find(t0_ + 7 * Second))->second);
+  EXPECT_THAT(Values(), ElementsAre(4, 5, 6, 7, 8));
+}
+
+TEST_F(TimelineTest, Erase) {
+  for (int i = 0; i < 300; ++i) {
+    timeline_.emplace_back(t0_ + i * Second, i);
+  }
+  timeline_.erase(timeline_.begin(),
+                  timeline_.lower_bound(t0_ + 150 * Second));
+  timeline_.erase(timeline_.upper_bound(t0_ + 152 * Second), timeline_.end());
+  EXPECT_THAT(Values(), ElementsAre(150, 151, 152));
+  EXPECT_EQ(3, timeline_.size());
+
+  timeline_.erase(timeline_.begin(), timeline_.end());
+  EXPECT_TRUE(timeline_.empty());
+  EXPECT_TRUE(timeline_.begin() == timeline_.end());
+  timeline_.emplace_front(t0_, 0);
+  timeline_.emplace_back(t0_ + 1 * Second, 1);
+  EXPECT_THAT(Values(), ElementsAre(0, 1));
+}
+
+TEST_F(TimelineTest, EraseIf) {
+  for (int i = 0; i < 300; ++i) {
+    timeline_.emplace_back(t0_ + i * Second, i);
+  }
+  auto const it100 = timeline_.find(t0_ + 100 * Second);
+  auto const& address100 = *it100;
+
+  // Keep the multiples of 50 after 100.
+  std::vector<int> visited;
+  timeline_.erase_if(it100, [&visited](std::pair<Instant, int> const& point) {
+    visited.push_back(point.second);
+    return point.second % 50 != 0;
+  });
+  EXPECT_EQ(300 - 100, visited.size());
+  EXPECT_EQ(100, visited.front());
+  EXPECT_EQ(299, visited.back());
+  EXPECT_EQ(104, timeline_.size());
+  EXPECT_EQ(&address100, &*it100);
+  EXPECT_EQ(99, (--timeline_.find(t0_ + 100 * Second))->second);
+  EXPECT_EQ(150, (++timeline_.find(t0_ + 100 * Second))->second);
+  EXPECT_EQ(250, timeline_.back().second);
+  EXPECT_TRUE(timeline_.find(t0_ + 101 * Second) == timeline_.end());
+
+  // Appending after a compaction reuses the freed slots.
+  timeline_.emplace_back(t0_ + 300 * Second, 300);
+  EXPECT_EQ(300, timeline_.back().second);
+  EXPECT_EQ(105, timeline_.size());
+}
+
+TEST_F(TimelineTest, Clear) {
+  for (int i = 0; i < 200; ++i) {
+    timeline_.emplace_back(t0_ + i * Second, i);
+  }
+  auto const& address = timeline_.front();
+  timeline_.clear();
+  EXPECT_TRUE(timeline_.empty());
+  EXPECT_TRUE(timeline_.begin() == timeline_.end());
+
+  // The memory is reused.
+  timeline_.emplace_back(t0_ + 1 * Second, 1);
+  EXPECT_EQ(&address, &timeline_.front());
+  for (int i = 2; i < 200; ++i) {
+    timeline_.emplace_back(t0_ + i * Second, i);
+  }
+  timeline_.emplace_front(t0_, 0);
+  EXPECT_EQ(200, timeline_.size());
+  EXPECT_EQ(0, timeline_.front().second);
+  EXPECT_EQ(199, timeline_.back().second);
+}
+
+TEST_F(TimelineTest, Shrink) {
+  for (int i = 0; i < 1000; ++i) {
+    timeline_.emplace_back(t0_ + i * Second, i);
+  }
+  EXPECT_LE(1000, timeline_.capacity());
+
+  // The memory used by the points is never released.
+  timeline_.erase(timeline_.find(t0_ + 100 * Second), timeline_.end());
+  timeline_.shrink(0);
+  EXPECT_LE(100, timeline_.capacity());
+  EXPECT_GT(200, timeline_.capacity());
+  EXPECT_EQ(99, timeline_.back().second);
+
+  timeline_.clear();
+  EXPECT_LE(100, timeline_.capacity());
+  timeline_.shrink(10);
+  EXPECT_LE(10, timeline_.capacity());
+  EXPECT_GT(100, timeline_.capacity());
+  timeline_.shrink(0);
+  EXPECT_EQ(0, timeline_.capacity());
+
+  timeline_.emplace_back(t0_, 0);
+  EXPECT_EQ(1, timeline_.size());
+  EXPECT_LE(1, timeline_.capacity());
+}
+
+TEST_F(TimelineTest, NonTrivialValues) {
+  Timeline<std::string> timeline;
+  for (int i = 0; i < 100; ++i) {
+    timeline.emplace_back(t0_ + i * Second, std::string(100, 'a' + i % 26));
+  }
+  timeline.erase(timeline.begin(), timeline.find(t0_ + 70 * Second));
+  timeline.erase(timeline.find(t0_ + 80 * Second), timeline.end());
+  timeline.emplace_front(t0_, "first");
+  EXPECT_EQ("first", timeline.front().second);
+  EXPECT_EQ(std::string(100, 'a' + 79 % 26), timeline.back().second);
+}
+
+using TimelineDeathTest = TimelineTest;
+
+TEST_F(TimelineDeathTest, Errors) {
+  EXPECT_DEATH({
+    timeline_.front();
+  }, "empty");
+  EXPECT_DEATH({
+    for (int i = 0; i < 3; ++i) {
+      timeline_.emplace_back(t0_ + i * Second, i);
+    }
+    timeline_.erase(timeline_.find(t0_ + 1 * Second));
+  }, "middle");
+}
+
+}  // namespace internal_timeline
+}  // namespace physics
+}  // namespace principia
@@ -1,7 +1,9 @@
 $msbuild = join-path -path (Get-ItemProperty "HKLM:\software\Microsoft\MSBuild\ToolsVersions\14.0")."MSBuildToolsPath" -childpath "msbuild.exe"
+$zlib = join-path -path (gi -path .).FullName -childpath "Google\zlib"
 $dependencies = @(".\Google\glog\google-glog.sln",
                   ".\Google\googletest\msvc\gtest.sln",
                   ".\Google\googlemock\msvc\2015\gmock.sln",
+                  ".\Google\zlib\contrib\vstudio\vc14\zlibvc.sln",
                   ".\Google\protobuf\vsprojects\protobuf.sln",
                   ".\Google\benchmark\msvc\google-benchmark.sln")
 
@@ -9,8 +11,23 @@ function build_solutions($solutions) {
   foreach ($configuration in "Debug", "Release") {
     foreach ($platform in "Win32", "x64") {
       foreach ($solution in $solutions) {
+        # protobuf must be built with zlib for its gzip streams.  The
+        # environment variables CL and LINK are read by the compiler and the
+        # linker.
+        if ($solution -like "*protobuf.sln") {
+          if ($platform -eq "Win32") {
+            $zlib_platform = "x86"
+          } else {
+            $zlib_platform = "x64"
+          }
+          $env:CL = "/DHAVE_ZLIB /DZLIB_WINAPI /I`"$zlib`""
+          $env:LINK = "zlibstat.lib /LIBPATH:`"$zlib\contrib\vstudio\vc14\$zlib_platform\ZlibStat$configuration`""
+        }
         &$msbuild /t:"Clean;Build" /m /property:VisualStudioVersion=14.0 /property:Configuration=$configuration /property:Platform=$platform $solution
-        if (!$?) {
+        $succeeded = $?
+        remove-item env:CL -erroraction silentlycontinue
+        remove-item env:LINK -erroraction silentlycontinue
+        if (!$succeeded) {
           exit 1
         }
       }
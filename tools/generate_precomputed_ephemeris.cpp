@@ -0,0 +1,83 @@
+﻿
+#include "tools/generate_precomputed_ephemeris.hpp"
+
+#include <experimental/filesystem>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "astronomy/frames.hpp"
+#include "geometry/named_quantities.hpp"
+#include "glog/logging.h"
+#include "integrators/symplectic_runge_kutta_nyström_integrator.hpp"
+#include "ksp_plugin/frames.hpp"
+#include "physics/degrees_of_freedom.hpp"
+#include "physics/ephemeris.hpp"
+#include "physics/massive_body.hpp"
+#include "physics/solar_system.hpp"
+#include "quantities/si.hpp"
+
+namespace principia {
+
+using astronomy::ICRFJ2000Equator;
+using base::not_null;
+using geometry::Position;
+using integrators::McLachlanAtela1992Order5Optimal;
+using ksp_plugin::Barycentric;
+using physics::DegreesOfFreedom;
+using physics::Ephemeris;
+using physics::MassiveBody;
+using physics::SolarSystem;
+using quantities::si::Milli;
+using quantities::si::Metre;
+using quantities::si::Minute;
+
+namespace {
+constexpr char ephemeris[] = "ephemeris";
+constexpr char proto_txt[] = "proto.txt";
+}  // namespace
+
+namespace tools {
+
+void GeneratePrecomputedEphemeris(Time const& duration,
+                                  std::string const& gravity_model_stem,
+                                  std::string const& initial_state_stem) {
+  std::experimental::filesystem::path const directory =
+      SOLUTION_DIR / "astronomy";
+  SolarSystem<ICRFJ2000Equator> solar_system;
+  solar_system.Initialize(
+      (directory / gravity_model_stem).replace_extension(proto_txt),
+      (directory / initial_state_stem).replace_extension(proto_txt));
+
+  // The plugin reads the configuration generated from these files as
+  // |Barycentric| coordinates, so the ephemeris must be in |Barycentric| for
+  // the plugin to use it.
+  std::vector<not_null<std::unique_ptr<MassiveBody const>>> bodies;
+  std::vector<DegreesOfFreedom<Barycentric>> initial_state;
+  for (std::string const& name : solar_system.names()) {
+    bodies.emplace_back(SolarSystem<Barycentric>::MakeMassiveBody(
+        solar_system.gravity_model_message(name)));
+    initial_state.push_back(SolarSystem<Barycentric>::MakeDegreesOfFreedom(
+        solar_system.initial_state_message(name)));
+  }
+
+  // Same parameters as in the plugin.
+  auto const solar_system_ephemeris = std::make_unique<Ephemeris<Barycentric>>(
+      std::move(bodies),
+      initial_state,
+      solar_system.epoch(),
+      /*fitting_tolerance=*/1 * Milli(Metre),
+      Ephemeris<Barycentric>::FixedStepParameters(
+          McLachlanAtela1992Order5Optimal<Position<Barycentric>>(),
+          /*step=*/45 * Minute));
+  solar_system_ephemeris->Prolong(solar_system.epoch() + duration);
+  LOG(INFO) << "Integrated " << initial_state_stem << " until "
+            << solar_system_ephemeris->t_max();
+
+  solar_system_ephemeris->WriteToPrecomputedFile(
+      (directory / initial_state_stem).replace_extension(ephemeris));
+}
+
+}  // namespace tools
+}  // namespace principia
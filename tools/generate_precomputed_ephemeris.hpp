@@ -0,0 +1,24 @@
+﻿
+#pragma once
+
+#include <string>
+
+#include "quantities/quantities.hpp"
+
+namespace principia {
+
+using quantities::Time;
+
+namespace tools {
+
+// Integrates the solar system described by the given files for |duration| from
+// its epoch, using the parameters of the plugin, and writes the resulting
+// ephemeris to a precomputed file next to the initial state.  The plugin reads
+// that file at initialization if the |principia_initial_state| configuration
+// names it in its |precomputed_ephemeris| value.
+void GeneratePrecomputedEphemeris(Time const& duration,
+                                  std::string const& gravity_model_stem,
+                                  std::string const& initial_state_stem);
+
+}  // namespace tools
+}  // namespace principia
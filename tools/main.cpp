@@ -7,6 +7,7 @@
 #include "glog/logging.h"
 #include "quantities/parser.hpp"
 #include "tools/generate_configuration.hpp"
+#include "tools/generate_precomputed_ephemeris.hpp"
 #include "tools/generate_profiles.hpp"
 
 int main(int argc, char const* argv[]) {
@@ -42,9 +43,27 @@ int main(int argc, char const* argv[]) {
     }
     principia::tools::GenerateProfiles();
     return 0;
+  } else if (command == "generate_precomputed_ephemeris") {
+    if (argc != 5) {
+      // tools.exe generate_precomputed_ephemeris "36525 d" gravity_model
+      //     initial_state_jd_2433282_500000000
+      std::cerr << "Usage: " << argv[0] << " " << argv[1] << " "
+                << "duration gravity_model_stem initial_state_stem\n";
+      return 5;
+    }
+    principia::quantities::Time const duration =
+        principia::quantities::ParseQuantity<principia::quantities::Time>(
+            argv[2]);
+    std::string const gravity_model_stem = argv[3];
+    std::string const initial_state_stem = argv[4];
+    principia::tools::GeneratePrecomputedEphemeris(duration,
+                                                   gravity_model_stem,
+                                                   initial_state_stem);
+    return 0;
   } else {
     std::cerr << "Usage: " << argv[0]
-              << " generate_configuration|generate_profiles\n";
+              << " generate_configuration|generate_profiles|"
+              << "generate_precomputed_ephemeris\n";
     return 4;
   }
 }